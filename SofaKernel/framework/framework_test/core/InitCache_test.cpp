@@ -0,0 +1,278 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/core/InitCache.h>
+using sofa::core::InitCache ;
+
+#include <sofa/core/DataEngine.h>
+#include <sofa/core/objectmodel/DataFileName.h>
+using sofa::core::objectmodel::ComponentState ;
+
+#include <sofa/helper/system/FileSystem.h>
+using sofa::helper::system::FileSystem ;
+
+#include <sofa/helper/system/SetDirectory.h>
+using sofa::helper::system::SetDirectory ;
+
+#include <sofa/helper/testing/BaseTest.h>
+using sofa::helper::testing::BaseTest ;
+
+#include <fstream>
+
+namespace sofa {
+
+/// Component whose init() computes the size of a file
+class FileSizeComponent : public core::objectmodel::BaseObject
+{
+public:
+    SOFA_CLASS(FileSizeComponent, core::objectmodel::BaseObject);
+
+    core::objectmodel::DataFileName d_filename;
+    Data< int > d_size;
+    int m_nbInit;
+
+    FileSizeComponent()
+        : d_filename(initData(&d_filename, "filename", "filename"))
+        , d_size(initData(&d_size, -1, "size", "size of the file"))
+        , m_nbInit(0)
+    {}
+
+    void init() override
+    {
+        ++m_nbInit;
+        std::ifstream file(d_filename.getFullPath().c_str(), std::ios::binary | std::ios::ate);
+        d_size.setValue(int(file.tellg()));
+        m_componentstate = ComponentState::Valid;
+    }
+};
+
+/// Engine squaring its input values
+class SquareEngine : public core::DataEngine
+{
+public:
+    SOFA_CLASS(SquareEngine, core::DataEngine);
+
+    Data< helper::vector<double> > d_values;
+    Data< helper::vector<double> > d_squares;
+    int m_nbUpdate;
+
+    SquareEngine()
+        : d_values(initData(&d_values, "values", "values"))
+        , d_squares(initData(&d_squares, "squares", "squares of the values"))
+        , m_nbUpdate(0)
+    {}
+
+    void init() override
+    {
+        addInput(&d_values);
+        addOutput(&d_squares);
+        setDirtyValue();
+    }
+
+    void doUpdate() override
+    {
+        ++m_nbUpdate;
+        helper::WriteOnlyAccessor< Data< helper::vector<double> > > squares = d_squares;
+        const helper::vector<double>& values = d_values.getValue();
+        squares.resize(values.size());
+        for (size_t i = 0; i < values.size(); ++i)
+            squares[i] = values[i] * values[i];
+    }
+};
+
+struct InitCache_test: public BaseTest
+{
+    std::string m_directory;
+    std::string m_file;
+
+    void SetUp() override
+    {
+        m_directory = SetDirectory::GetCurrentDir() + "/InitCache_test";
+        if (FileSystem::exists(m_directory))
+            FileSystem::removeAll(m_directory);
+        InitCache::getInstance()->setDirectory(m_directory);
+        InitCache::getInstance()->resetStatistics();
+
+        m_file = m_directory + "/input.txt";
+        writeFile("0123456789");
+    }
+
+    void TearDown() override
+    {
+        InitCache::getInstance()->setDirectory("");
+        FileSystem::removeAll(m_directory);
+    }
+
+    void writeFile(const std::string& content)
+    {
+        writeFile(m_file, content);
+    }
+
+    static void writeFile(const std::string& filename, const std::string& content)
+    {
+        std::ofstream file(filename.c_str(), std::ios::binary);
+        file << content;
+    }
+
+    /// The keys are chained from the beginning of the scene loading, each test scene restarts the chain
+    static void newScene(InitCache::Hash sceneHash = 0)
+    {
+        InitCache::getInstance()->setSceneHash(sceneHash);
+    }
+
+    FileSizeComponent::SPtr createComponent(bool tagged = true, const std::string& filename = "")
+    {
+        FileSizeComponent::SPtr c = sofa::core::objectmodel::New<FileSizeComponent>();
+        c->setName("fileSize");
+        c->d_filename.setValue(filename.empty() ? m_file : filename);
+        if (tagged)
+            c->addTag(InitCache::getTag());
+        return c;
+    }
+};
+
+TEST_F(InitCache_test, restoreInit)
+{
+    newScene();
+    FileSizeComponent::SPtr first = createComponent();
+    InitCache::getInstance()->initObject(first.get());
+    EXPECT_EQ(1, first->m_nbInit);
+    EXPECT_EQ(10, first->d_size.getValue());
+    EXPECT_EQ(1u, InitCache::getInstance()->getNbStored());
+
+    newScene();
+    FileSizeComponent::SPtr second = createComponent();
+    InitCache::getInstance()->initObject(second.get());
+    EXPECT_EQ(0, second->m_nbInit);
+    EXPECT_EQ(10, second->d_size.getValue());
+    EXPECT_EQ(ComponentState::Valid, second->getComponentState());
+    EXPECT_EQ(1u, InitCache::getInstance()->getNbRestored());
+}
+
+TEST_F(InitCache_test, changedInputs)
+{
+    newScene();
+    FileSizeComponent::SPtr first = createComponent();
+    InitCache::getInstance()->initObject(first.get());
+
+    // same Data, different file content
+    writeFile("0123");
+    newScene();
+    FileSizeComponent::SPtr second = createComponent();
+    InitCache::getInstance()->initObject(second.get());
+    EXPECT_EQ(1, second->m_nbInit);
+    EXPECT_EQ(4, second->d_size.getValue());
+
+    // different Data
+    newScene();
+    FileSizeComponent::SPtr third = createComponent();
+    third->setName("other");
+    InitCache::getInstance()->initObject(third.get());
+    EXPECT_EQ(1, third->m_nbInit);
+
+    // different scene
+    newScene(42);
+    FileSizeComponent::SPtr fourth = createComponent();
+    InitCache::getInstance()->initObject(fourth.get());
+    EXPECT_EQ(1, fourth->m_nbInit);
+    newScene();
+
+    EXPECT_EQ(0u, InitCache::getInstance()->getNbRestored());
+}
+
+TEST_F(InitCache_test, changedUpstream)
+{
+    // the second component does not read the first file, but may depend on the first component through the context
+    const std::string otherFile = m_directory + "/other.txt";
+    writeFile(otherFile, "01234");
+
+    newScene();
+    FileSizeComponent::SPtr upstream = createComponent();
+    FileSizeComponent::SPtr downstream = createComponent(true, otherFile);
+    downstream->setName("downstream");
+    InitCache::getInstance()->initObject(upstream.get());
+    InitCache::getInstance()->initObject(downstream.get());
+    EXPECT_EQ(2u, InitCache::getInstance()->getNbStored());
+
+    // the upstream input changed, both stages are run again
+    writeFile("0123");
+    newScene();
+    upstream = createComponent();
+    downstream = createComponent(true, otherFile);
+    downstream->setName("downstream");
+    InitCache::getInstance()->initObject(upstream.get());
+    InitCache::getInstance()->initObject(downstream.get());
+    EXPECT_EQ(1, upstream->m_nbInit);
+    EXPECT_EQ(1, downstream->m_nbInit);
+    EXPECT_EQ(0u, InitCache::getInstance()->getNbRestored());
+
+    // nothing changed, both stages are restored
+    newScene();
+    upstream = createComponent();
+    downstream = createComponent(true, otherFile);
+    downstream->setName("downstream");
+    InitCache::getInstance()->initObject(upstream.get());
+    InitCache::getInstance()->initObject(downstream.get());
+    EXPECT_EQ(0, upstream->m_nbInit);
+    EXPECT_EQ(0, downstream->m_nbInit);
+    EXPECT_EQ(5, downstream->d_size.getValue());
+    EXPECT_EQ(2u, InitCache::getInstance()->getNbRestored());
+}
+
+TEST_F(InitCache_test, untagged)
+{
+    FileSizeComponent::SPtr first = createComponent(false);
+    InitCache::getInstance()->initObject(first.get());
+    FileSizeComponent::SPtr second = createComponent(false);
+    InitCache::getInstance()->initObject(second.get());
+    EXPECT_EQ(1, second->m_nbInit);
+    EXPECT_EQ(0u, InitCache::getInstance()->getNbStored());
+    EXPECT_EQ(0u, InitCache::getInstance()->getNbRestored());
+}
+
+TEST_F(InitCache_test, engine)
+{
+    const helper::vector<double> values = { 1.0, 2.0, 3.0 };
+
+    newScene();
+    SquareEngine::SPtr first = sofa::core::objectmodel::New<SquareEngine>();
+    first->addTag(InitCache::getTag());
+    first->d_values.setValue(values);
+    InitCache::getInstance()->initObject(first.get());
+    EXPECT_EQ(1, first->m_nbUpdate);
+
+    newScene();
+    SquareEngine::SPtr second = sofa::core::objectmodel::New<SquareEngine>();
+    second->addTag(InitCache::getTag());
+    second->d_values.setValue(values);
+    InitCache::getInstance()->initObject(second.get());
+    ASSERT_EQ(3u, second->d_squares.getValue().size());
+    EXPECT_EQ(9.0, second->d_squares.getValue()[2]);
+    EXPECT_EQ(0, second->m_nbUpdate);
+
+    // the restored engine still tracks its inputs
+    second->d_values.setValue(helper::vector<double>(1, 4.0));
+    ASSERT_EQ(1u, second->d_squares.getValue().size());
+    EXPECT_EQ(16.0, second->d_squares.getValue()[0]);
+    EXPECT_EQ(1, second->m_nbUpdate);
+}
+
+} // namespace sofa
@@ -22,6 +22,8 @@
 #include <sofa/core/objectmodel/Data.h>
 #include <sofa/helper/vectorData.h>
 #include <sofa/core/objectmodel/DataFileName.h>
+#include <sofa/defaulttype/VecTypes.h>
+#include <sofa/defaulttype/RigidTypes.h>
 
 #include <sofa/helper/testing/BaseTest.h>
 using sofa::helper::testing::BaseTest ;
@@ -147,4 +149,95 @@ TEST_F(DataFileNameVector_test , read_spaces )
 }
 
 
+/////////////////////////////////
+
+
+/** Test suite for the binary serialization of Data
+ */
+struct DataBinary_test: public ::testing::Test
+{
+    template<class T1, class T2>
+    static bool copyBinary(const Data<T1>& src, Data<T2>& dst, std::size_t* nbBytes = nullptr)
+    {
+        std::stringstream stream;
+        src.writeBinary(stream);
+        if (nbBytes)
+            *nbBytes = stream.str().size();
+        return dst.readBinary(stream);
+    }
+};
+
+TEST_F(DataBinary_test , vectorOfVec_raw )
+{
+    Data<defaulttype::Vec3Types::VecCoord> src, dst;
+    defaulttype::Vec3Types::VecCoord values;
+    for (int i=0; i<100; ++i)
+        values.push_back(defaulttype::Vec3d(i, 0.5*i, -1.0/(i+1)));
+    src.setValue(values);
+
+    EXPECT_TRUE(src.getValueTypeInfo()->ContiguousValues());
+    std::size_t nbBytes = 0;
+    ASSERT_TRUE(copyBinary(src, dst, &nbBytes));
+    EXPECT_EQ(nbBytes, 10u + 300*sizeof(double));
+    EXPECT_EQ(dst.getValue(), values);
+}
+
+TEST_F(DataBinary_test , vectorOfRigid_raw )
+{
+    Data<defaulttype::Rigid3Types::VecCoord> src, dst;
+    defaulttype::Rigid3Types::VecCoord values(3);
+    values[1].getCenter() = defaulttype::Vec3d(1, 2, 3);
+    values[2].getOrientation() = defaulttype::Quat(0, 0, 1, 0);
+    src.setValue(values);
+
+    EXPECT_TRUE(src.getValueTypeInfo()->ContiguousValues());
+    ASSERT_TRUE(copyBinary(src, dst));
+    EXPECT_EQ(dst.getValue(), values);
+}
+
+TEST_F(DataBinary_test , conversion )
+{
+    Data<helper::vector<float> > floats;
+    Data<helper::vector<double> > doubles;
+    floats.setValue(helper::vector<float>{1.5f, -2.0f, 3.25f});
+    ASSERT_TRUE(copyBinary(floats, doubles));
+    EXPECT_EQ(doubles.getValue(), (helper::vector<double>{1.5, -2.0, 3.25}));
+
+    Data<helper::vector<unsigned int> > indices;
+    Data<helper::vector<int> > ints;
+    indices.setValue(helper::vector<unsigned int>{0u, 7u, 4000000000u});
+    ASSERT_TRUE(copyBinary(indices, doubles));
+    EXPECT_EQ(doubles.getValue(), (helper::vector<double>{0.0, 7.0, 4000000000.0}));
+    ints.setValue(helper::vector<int>{-3, 5});
+    ASSERT_TRUE(copyBinary(ints, doubles));
+    EXPECT_EQ(doubles.getValue(), (helper::vector<double>{-3.0, 5.0}));
+
+    // the number of values does not fit a vector of Vec3
+    Data<defaulttype::Vec3Types::VecCoord> coords;
+    ints.setValue(helper::vector<int>{1, 2, 3, 4});
+    EXPECT_FALSE(copyBinary(ints, coords));
+}
+
+TEST_F(DataBinary_test , text )
+{
+    Data<std::set<int> > src, dst;
+    src.setValue(std::set<int>{1, 4, 9});
+    EXPECT_FALSE(src.getValueTypeInfo()->ContiguousValues());
+    ASSERT_TRUE(copyBinary(src, dst));
+    EXPECT_EQ(dst.getValue(), src.getValue());
+
+    Data<std::string> text, text2;
+    text.setValue("some text");
+    ASSERT_TRUE(copyBinary(text, text2));
+    EXPECT_EQ(text2.getValue(), "some text");
+
+    // several values in one stream
+    std::stringstream stream;
+    src.writeBinary(stream);
+    text.writeBinary(stream);
+    ASSERT_TRUE(dst.readBinary(stream));
+    ASSERT_TRUE(text2.readBinary(stream));
+    EXPECT_EQ(text2.getValue(), "some text");
+}
+
 }// namespace sofa
@@ -0,0 +1,121 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/helper/testing/BaseTest.h>
+using sofa::helper::testing::BaseTest ;
+
+#include <sofa/helper/io/BinaryStateFile.h>
+using sofa::helper::io::BinaryStateFileWriter;
+using sofa::helper::io::BinaryStateFileReader;
+
+#include <cstdio>
+#include <fstream>
+
+namespace
+{
+
+class BinaryStateFile_test : public BaseTest
+{
+protected:
+    const std::string filename {"BinaryStateFile_test.bin"};
+
+    void TearDown() override
+    {
+        std::remove(filename.c_str());
+    }
+
+    /// Payload of the i-th chunk, easy to check but compressible
+    static std::vector<char> makePayload(int i)
+    {
+        std::vector<char> payload(1000 + 10*i);
+        for (std::size_t j = 0; j < payload.size(); ++j)
+            payload[j] = char((j/16 + i) % 7);
+        return payload;
+    }
+
+    void writeFile(int nbChunks, int compressionLevel, bool closeWriter)
+    {
+        BinaryStateFileWriter writer;
+        ASSERT_TRUE(writer.open(filename, compressionLevel));
+        for (int i = 0; i < nbChunks; ++i)
+            ASSERT_TRUE(writer.writeChunk(0.01*i, makePayload(i)));
+        if (!closeWriter)
+        {
+            // simulate an interrupted recording: copy the file before the index is written
+            std::ifstream in(filename.c_str(), std::ios::binary);
+            const std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            in.close();
+            writer.close();
+            std::ofstream out(filename.c_str(), std::ios::binary | std::ios::trunc);
+            out << content;
+        }
+    }
+
+    void checkFile(int nbChunks)
+    {
+        ASSERT_TRUE(BinaryStateFileReader::isBinaryStateFile(filename));
+        BinaryStateFileReader reader;
+        ASSERT_TRUE(reader.open(filename));
+        ASSERT_EQ(std::size_t(nbChunks), reader.getNbChunks());
+
+        EXPECT_EQ(-1, reader.findChunk(-0.5));
+        EXPECT_EQ(nbChunks-1, reader.findChunk(10.0));
+
+        // random access, backward
+        std::vector<char> payload;
+        for (int i = nbChunks-1; i >= 0; --i)
+        {
+            EXPECT_EQ(i, reader.findChunk(0.01*i));
+            ASSERT_TRUE(reader.readChunk(std::size_t(i), payload));
+            EXPECT_EQ(makePayload(i), payload);
+        }
+    }
+};
+
+TEST_F(BinaryStateFile_test, writeAndSeek)
+{
+    writeFile(20, 0, true);
+    checkFile(20);
+}
+
+TEST_F(BinaryStateFile_test, writeAndSeekCompressed)
+{
+    writeFile(20, 6, true);
+    checkFile(20);
+}
+
+TEST_F(BinaryStateFile_test, recoverMissingIndex)
+{
+    writeFile(20, 6, false);
+    EXPECT_MSG_EMIT(Warning);
+    checkFile(20);
+}
+
+TEST_F(BinaryStateFile_test, rejectTextFile)
+{
+    {
+        std::ofstream out(filename.c_str());
+        out << "T= 0\n  X= 0 0 0\n";
+    }
+    EXPECT_FALSE(BinaryStateFileReader::isBinaryStateFile(filename));
+}
+
+}
@@ -0,0 +1,167 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/helper/testing/BaseTest.h>
+using sofa::helper::testing::BaseTest ;
+
+#include <sofa/helper/io/MappedFile.h>
+using sofa::helper::io::MappedFile;
+
+#include <sofa/helper/io/TextTokenizer.h>
+using sofa::helper::io::TextTokenizer;
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+
+namespace
+{
+
+class TextTokenizer_test : public BaseTest
+{
+protected:
+    /// Parse text with the tokenizer and with operator>>, and check both give the same values
+    template<class T>
+    void checkSameAsStream(const std::string& text)
+    {
+        std::istringstream stream(text);
+        stream.imbue(std::locale::classic());
+        TextTokenizer tokenizer(text.data(), text.data() + text.size());
+
+        T expected, value;
+        while (stream >> expected)
+        {
+            ASSERT_TRUE(tokenizer.read(value)) << text;
+            EXPECT_EQ(expected, value) << text;
+        }
+        EXPECT_FALSE(tokenizer.read(value)) << text;
+    }
+};
+
+TEST_F(TextTokenizer_test, parseRealsLikeStream)
+{
+    checkSameAsStream<double>("0 -0 1 -1 +2 3.5 .25 7. 1e3 1E-3 -2.5e+2 0.000123 123456789 0.1 0.2 0.3");
+    checkSameAsStream<double>("1.7976931348623157e308 2.2250738585072014e-308 4.9e-324 1e400 0.30000000000000004");
+    checkSameAsStream<double>("3.14159265358979323846264338327950288 12345678901234567890123 1e-30");
+    checkSameAsStream<float>("0.1 0.2 0.3 1e10 1e-10 3.4028235e38 1.17549435e-38 16777217 0.333333343");
+
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> distribution(-1000.0, 1000.0);
+    for (int precision = 1; precision <= 17; ++precision)
+    {
+        std::ostringstream out;
+        out.precision(precision);
+        for (int i = 0; i < 200; ++i)
+            out << distribution(generator) * std::pow(10.0, (i % 40) - 20) << (i % 7 ? " " : "\n");
+        checkSameAsStream<double>(out.str());
+        checkSameAsStream<float>(out.str());
+    }
+}
+
+TEST_F(TextTokenizer_test, parseIntegersLikeStream)
+{
+    checkSameAsStream<int>("0 -1 +2 2147483647 -2147483648 42");
+    checkSameAsStream<unsigned int>("0 1 4294967295 7");
+    checkSameAsStream<long long>("9223372036854775807 -9223372036854775807 123456789012345678");
+    checkSameAsStream<short>("32767 -32768 12");
+
+    // out of range and malformed values stop the parsing, as with operator>>
+    checkSameAsStream<int>("1 2 2147483648 3");
+    checkSameAsStream<int>("4 5 x 6");
+    checkSameAsStream<double>("4 5 - 6");
+}
+
+TEST_F(TextTokenizer_test, lineAccess)
+{
+    const std::string text = "v 1 2.5 3\r\n\n  f 1/2 3//4  \ng group name\n";
+    TextTokenizer tokenizer(text.data(), text.data() + text.size());
+
+    std::string word;
+    double x = 0;
+    ASSERT_TRUE(tokenizer.nextWordInLine(word));
+    EXPECT_EQ("v", word);
+    for (double expected : {1.0, 2.5, 3.0})
+    {
+        ASSERT_TRUE(tokenizer.readInLine(x));
+        EXPECT_EQ(expected, x);
+    }
+    EXPECT_FALSE(tokenizer.readInLine(x));
+    EXPECT_TRUE(tokenizer.atEndOfLine());
+    tokenizer.skipLine();
+
+    EXPECT_FALSE(tokenizer.nextWordInLine(word));
+    tokenizer.skipLine();
+
+    std::vector<std::string> words;
+    while (tokenizer.nextWordInLine(word))
+        words.push_back(word);
+    EXPECT_EQ(std::vector<std::string>({"f", "1/2", "3//4"}), words);
+    tokenizer.skipLine();
+
+    ASSERT_TRUE(tokenizer.read(word));
+    EXPECT_EQ("g", word);
+    ASSERT_TRUE(tokenizer.read(word));
+    EXPECT_EQ("group", word);
+    ASSERT_TRUE(tokenizer.read(word));
+    EXPECT_EQ("name", word);
+    EXPECT_FALSE(tokenizer.read(word));
+    EXPECT_TRUE(tokenizer.eof());
+}
+
+TEST_F(TextTokenizer_test, mappedFile)
+{
+    const std::string filename = "TextTokenizer_test.txt";
+    const std::string content = "$Nodes\n2\n1 0 0 0\n2 1.5 0 -1\n$EndNodes\n";
+    {
+        std::ofstream out(filename.c_str(), std::ios::binary);
+        out << content;
+    }
+
+    MappedFile file;
+    ASSERT_TRUE(file.open(filename));
+    ASSERT_EQ(content.size(), file.size());
+    EXPECT_EQ(content, std::string(file.begin(), file.end()));
+
+    TextTokenizer tokenizer(file.begin(), file.end());
+    std::string word;
+    int n = 0, index = 0;
+    double x, y, z;
+    ASSERT_TRUE(tokenizer.read(word));
+    EXPECT_EQ("$Nodes", word);
+    ASSERT_TRUE(tokenizer.read(n));
+    EXPECT_EQ(2, n);
+    tokenizer.skipLine();
+    tokenizer.skipLine();
+    ASSERT_TRUE(tokenizer.read(index) && tokenizer.read(x) && tokenizer.read(y) && tokenizer.read(z));
+    EXPECT_EQ(2, index);
+    EXPECT_EQ(1.5, x);
+    EXPECT_EQ(-1.0, z);
+
+    file.close();
+    EXPECT_FALSE(file.isOpen());
+    std::remove(filename.c_str());
+
+    EXPECT_FALSE(file.open("TextTokenizer_test_missing_file.txt"));
+}
+
+}
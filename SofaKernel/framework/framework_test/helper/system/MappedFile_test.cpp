@@ -0,0 +1,62 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+
+#include <sofa/helper/system/MappedFile.h>
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+using sofa::helper::system::MappedFile;
+
+
+TEST(MappedFile_test, openMissingFile)
+{
+    MappedFile file;
+    EXPECT_FALSE(file.open("this-file-does-not-exist.bin"));
+    EXPECT_FALSE(file.isOpen());
+    EXPECT_EQ(file.size(), 0u);
+}
+
+TEST(MappedFile_test, mapContent)
+{
+    const std::string filename = "MappedFile_test.bin";
+    const double values[4] = { 1.0, -2.5, 3.25, 1e-10 };
+    {
+        std::ofstream out(filename.c_str(), std::ios::binary);
+        out.write((const char*)values, sizeof(values));
+    }
+
+    {
+        MappedFile file;
+        ASSERT_TRUE(file.open(filename));
+        EXPECT_TRUE(file.isOpen());
+        ASSERT_EQ(file.size(), sizeof(values));
+        EXPECT_EQ(std::memcmp(file.data(), values, sizeof(values)), 0);
+
+        file.close();
+        EXPECT_FALSE(file.isOpen());
+    }
+
+    std::remove(filename.c_str());
+}
@@ -2,15 +2,17 @@
 
 #include <sofa/simulation/TaskScheduler.h>
 #include <sofa/simulation/DefaultTaskScheduler.h>
+#include <sofa/simulation/WorkStealingTaskScheduler.h>
+#include <sofa/simulation/ParallelFor.h>
 #include <sofa/helper/testing/BaseTest.h>
 
 namespace sofa
 {
 
     // compute the Fibonacci number for input N
-    static int64_t Fibonacci(int64_t N, int nbThread = 0)
+    static int64_t Fibonacci(int64_t N, int nbThread = 0, const char* schedulerName = simulation::DefaultTaskScheduler::name())
     {
-        simulation::TaskScheduler* scheduler = simulation::TaskScheduler::create(simulation::DefaultTaskScheduler::name());
+        simulation::TaskScheduler* scheduler = simulation::TaskScheduler::create(schedulerName);
         scheduler->init(nbThread);
         
         simulation::CpuTask::Status status;
@@ -26,9 +28,9 @@ namespace sofa
     
     
     // compute the sum of integers from 1 to N
-    static int64_t IntSum1ToN(const int64_t N, int nbThread = 0)
+    static int64_t IntSum1ToN(const int64_t N, int nbThread = 0, const char* schedulerName = simulation::DefaultTaskScheduler::name())
     {
-        simulation::TaskScheduler* scheduler = simulation::TaskScheduler::create(simulation::DefaultTaskScheduler::name());
+        simulation::TaskScheduler* scheduler = simulation::TaskScheduler::create(schedulerName);
         scheduler->init(nbThread);
         
         simulation::CpuTask::Status status;
@@ -98,5 +100,72 @@ namespace sofa
         return;
     }
     
+    // compute the Fibonacci with the work stealing scheduler
+    TEST(TaskSchedulerTests, FibonacciWorkStealing)
+    {
+        EXPECT_EQ(Fibonacci(27, 1, simulation::WorkStealingTaskScheduler::name()), 196418);
+        EXPECT_EQ(Fibonacci(27, 4, simulation::WorkStealingTaskScheduler::name()), 196418);
+    }
+    
+    // compute the sum of integers from 1 to N with the work stealing scheduler
+    TEST(TaskSchedulerTests, IntSumWorkStealing)
+    {
+        const int64_t N = 1 << 20;
+        EXPECT_EQ(IntSum1ToN(N, 1, simulation::WorkStealingTaskScheduler::name()), (N)*(N + 1) / 2);
+        EXPECT_EQ(IntSum1ToN(N, 4, simulation::WorkStealingTaskScheduler::name()), (N)*(N + 1) / 2);
+    }
+    
+    // each index of the range is visited exactly once, whatever the scheduler and the grain size
+    TEST(TaskSchedulerTests, ParallelFor)
+    {
+        const char* schedulerNames[] = { simulation::DefaultTaskScheduler::name(), simulation::WorkStealingTaskScheduler::name() };
+        for (const char* schedulerName : schedulerNames)
+        {
+            simulation::TaskScheduler* scheduler = simulation::TaskScheduler::create(schedulerName);
+            scheduler->init(4);
+            
+            for (std::size_t grainSize : { 1, 7, 64, 5000 })
+            {
+                std::vector<int> visits(1000, 0);
+                simulation::parallelFor(scheduler, 3, visits.size(), grainSize, [&](std::size_t first, std::size_t last)
+                {
+                    EXPECT_LE(last - first, grainSize);
+                    for (std::size_t i = first; i < last; ++i)
+                        ++visits[i];
+                });
+                for (std::size_t i = 0; i < visits.size(); ++i)
+                    EXPECT_EQ(visits[i], i < 3 ? 0 : 1);
+            }
+            
+            scheduler->stop();
+        }
+    }
+    
+    // the reduction joins the chunks in order: the floating point sum does not depend on the number of threads
+    TEST(TaskSchedulerTests, ParallelReduce)
+    {
+        std::vector<double> values(100000);
+        for (std::size_t i = 0; i < values.size(); ++i)
+            values[i] = 1.0 / double(i + 1);
+        
+        auto sumRange = [&](std::size_t first, std::size_t last, double sum)
+        {
+            for (std::size_t i = first; i < last; ++i)
+                sum += values[i];
+            return sum;
+        };
+        auto join = [](double a, double b) { return a + b; };
+        
+        simulation::TaskScheduler* scheduler = simulation::TaskScheduler::create(simulation::WorkStealingTaskScheduler::name());
+        scheduler->init(1);
+        const double singleSum = simulation::parallelReduce(scheduler, 0, values.size(), 1000, 0.0, sumRange, join);
+        scheduler->init(4);
+        const double multiSum = simulation::parallelReduce(scheduler, 0, values.size(), 1000, 0.0, sumRange, join);
+        scheduler->stop();
+        
+        EXPECT_EQ(singleSum, multiSum);
+        EXPECT_NEAR(singleSum, sumRange(0, values.size(), 0.0), 1e-10);
+    }
+    
 
 } // namespace sofa
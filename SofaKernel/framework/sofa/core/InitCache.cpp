@@ -0,0 +1,363 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/core/InitCache.h>
+#include <sofa/core/objectmodel/BaseObject.h>
+#include <sofa/core/objectmodel/DataFileName.h>
+#include <sofa/helper/io/MappedFile.h>
+#include <sofa/helper/system/FileSystem.h>
+#include <sofa/helper/logging/Messaging.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <streambuf>
+
+namespace sofa
+{
+
+namespace core
+{
+
+namespace
+{
+
+const char s_magic[8] = { 'S', 'O', 'F', 'A', 'I', 'N', 'I', 'T' };
+const std::uint32_t s_version = 1;
+
+template<class T>
+void writeValue(std::ostream& out, const T& value)
+{
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<class T>
+bool readValue(const char*& cur, const char* end, T& value)
+{
+    if (std::size_t(end - cur) < sizeof(T))
+        return false;
+    std::memcpy(&value, cur, sizeof(T));
+    cur += sizeof(T);
+    return true;
+}
+
+/// Input stream buffer over a block of memory, to read the Data without copying the file
+class MemoryBuffer : public std::streambuf
+{
+public:
+    MemoryBuffer(const char* begin, const char* end)
+    {
+        char* b = const_cast<char*>(begin);
+        setg(b, b, b + (end - begin));
+    }
+};
+
+InitCache::Hash hashString(const std::string& s, InitCache::Hash h)
+{
+    const std::uint64_t size = s.size();
+    h = InitCache::hash(&size, sizeof(size), h);
+    return InitCache::hash(s.data(), s.size(), h);
+}
+
+} // namespace
+
+InitCache* InitCache::getInstance()
+{
+    static InitCache instance;
+    return &instance;
+}
+
+InitCache::InitCache()
+    : m_sceneHash(0)
+    , m_chainHash(s_initialHash)
+    , m_nbRestored(0)
+    , m_nbStored(0)
+{
+    const char* directory = std::getenv("SOFA_INIT_CACHE_DIR");
+    if (directory != nullptr && directory[0] != '\0')
+        setDirectory(directory);
+}
+
+void InitCache::setDirectory(const std::string& directory)
+{
+    m_directory = directory;
+    if (!m_directory.empty() && !helper::system::FileSystem::exists(m_directory)
+        && helper::system::FileSystem::createDirectory(m_directory))
+    {
+        msg_error("InitCache") << "Unable to create the cache directory " << m_directory;
+        m_directory.clear();
+    }
+}
+
+void InitCache::initObject(objectmodel::BaseObject* object)
+{
+    Stage cached(object, "init", m_sceneHash);
+    if (cached.isCached() && dynamic_cast<objectmodel::DDGNode*>(object) != nullptr)
+    {
+        object->init();
+        if (!cached.restore())
+            cached.store();
+    }
+    else if (!cached.restore())
+    {
+        object->init();
+        cached.store();
+    }
+}
+
+const objectmodel::Tag& InitCache::getTag()
+{
+    static const objectmodel::Tag tag("initCache");
+    return tag;
+}
+
+InitCache::Hash InitCache::hash(const void* data, std::size_t size, Hash h)
+{
+    const Hash prime = 1099511628211ULL;
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    const unsigned char* end = p + size;
+
+    // 8 bytes at a time for the large blocks (mesh files, vectors)
+    for (; end - p >= 8; p += 8)
+    {
+        std::uint64_t word;
+        std::memcpy(&word, p, 8);
+        h = (h ^ word) * prime;
+    }
+    for (; p != end; ++p)
+        h = (h ^ *p) * prime;
+    return h;
+}
+
+InitCache::Hash InitCache::hashFile(const std::string& filename)
+{
+    helper::io::MappedFile file;
+    if (filename.empty() || !file.open(filename))
+        return 0;
+    return hash(file.begin(), file.size());
+}
+
+InitCache::Stage::Stage(objectmodel::BaseObject* object, const char* name, Hash contextHash)
+    : m_object(nullptr)
+    , m_key(0)
+{
+    InitCache* cache = InitCache::getInstance();
+    if (!cache->isEnabled() || object == nullptr || !object->hasTag(InitCache::getTag()))
+        return;
+    m_object = object;
+
+    Hash h = s_initialHash;
+    h = hashString(name, h);
+    h = hashString(object->getClassName(), h);
+    h = hashString(object->getTemplateName(), h);
+    h = hashString(object->getPathName(), h);
+    h = hash(&contextHash, sizeof(contextHash), h);
+    h = hash(&cache->m_chainHash, sizeof(cache->m_chainHash), h);
+
+    const objectmodel::Base::VecData& data = object->getDataFields();
+    for (objectmodel::BaseData* d : data)
+    {
+        h = hashString(d->getName(), h);
+        // reading a dirty output would run its update before the stage
+        if (d->getParent() == nullptr && d->isDirty())
+            continue;
+
+        std::ostringstream value(std::ios::out | std::ios::binary);
+        d->writeBinary(value);
+        h = hashString(value.str(), h);
+
+        if (objectmodel::DataFileName* file = dynamic_cast<objectmodel::DataFileName*>(d))
+        {
+            const Hash fileHash = hashFile(file->getFullPath());
+            h = hash(&fileHash, sizeof(fileHash), h);
+        }
+        else if (objectmodel::DataFileNameVector* files = dynamic_cast<objectmodel::DataFileNameVector*>(d))
+        {
+            for (unsigned int i = 0; i < files->getValue().size(); ++i)
+            {
+                const Hash fileHash = hashFile(files->getFullPath(i));
+                h = hash(&fileHash, sizeof(fileHash), h);
+            }
+        }
+    }
+    m_key = h;
+
+    // the results of the stage only depend on its key, which is chained to the next stages
+    cache->m_chainHash = hash(&m_key, sizeof(m_key), cache->m_chainHash);
+
+    // the counters are read last, as reading a linked Data updates it from its parent
+    m_counters.reserve(data.size());
+    for (objectmodel::BaseData* d : data)
+        m_counters.push_back(d->getCounter());
+}
+
+std::string InitCache::Stage::getFilename() const
+{
+    char key[17];
+    std::snprintf(key, sizeof(key), "%016llx", (unsigned long long)m_key);
+    return InitCache::getInstance()->getDirectory() + "/" + key + ".initcache";
+}
+
+bool InitCache::Stage::restore()
+{
+    if (m_object == nullptr)
+        return false;
+
+    helper::io::MappedFile file;
+    if (!file.open(getFilename()))
+        return false;
+
+    // check the whole file before modifying any Data
+    const char* cur = file.begin();
+    const char* end = file.end();
+    char magic[sizeof(s_magic)];
+    std::uint32_t version = 0;
+    Hash key = 0;
+    unsigned char state = 0;
+    std::uint32_t count = 0;
+    if (!readValue(cur, end, magic) || std::memcmp(magic, s_magic, sizeof(s_magic)) != 0
+        || !readValue(cur, end, version) || version != s_version
+        || !readValue(cur, end, key) || key != m_key
+        || !readValue(cur, end, state) || !readValue(cur, end, count))
+    {
+        msg_warning(m_object) << "Invalid init cache file " << getFilename();
+        return false;
+    }
+
+    struct Entry
+    {
+        objectmodel::BaseData* data;
+        const char* begin;
+        const char* end;
+    };
+    std::vector<Entry> entries(count);
+    for (Entry& entry : entries)
+    {
+        std::uint32_t nameSize = 0;
+        std::uint64_t valueSize = 0;
+        if (!readValue(cur, end, nameSize) || std::size_t(end - cur) < nameSize)
+            return false;
+        entry.data = m_object->findData(std::string(cur, nameSize));
+        cur += nameSize;
+        if (!readValue(cur, end, valueSize) || std::uint64_t(end - cur) < valueSize)
+            return false;
+        entry.begin = cur;
+        entry.end = cur + valueSize;
+        cur = entry.end;
+        if (entry.data == nullptr || entry.data->getParent() != nullptr)
+            return false;
+    }
+
+    for (Entry& entry : entries)
+    {
+        // the value is replaced, there is no need to update it first
+        entry.data->cleanDirty();
+        MemoryBuffer buffer(entry.begin, entry.end);
+        std::istream in(&buffer);
+        if (!entry.data->readBinary(in))
+        {
+            msg_warning(m_object) << "Unable to restore Data " << entry.data->getName() << " from the init cache";
+            return false;
+        }
+    }
+
+    // restored engine outputs are up to date
+    if (objectmodel::DDGNode* node = dynamic_cast<objectmodel::DDGNode*>(m_object))
+        node->cleanDirty();
+    for (Entry& entry : entries)
+        entry.data->cleanDirty();
+
+    m_object->setComponentState(objectmodel::ComponentState(state));
+    ++InitCache::getInstance()->m_nbRestored;
+    return true;
+}
+
+void InitCache::Stage::store()
+{
+    if (m_object == nullptr)
+        return;
+
+    const objectmodel::Base::VecData& data = m_object->getDataFields();
+    if (data.size() != m_counters.size())
+        return; // Data were added by the stage, they could not be restored before the next one
+
+    // run the pending updates, so that outputs computed on demand are cached as well
+    for (objectmodel::BaseData* d : data)
+        if (d->getParent() == nullptr)
+            d->updateIfDirty();
+
+    std::ostringstream out(std::ios::out | std::ios::binary);
+    std::uint32_t count = 0;
+    for (std::size_t i = 0; i < data.size(); ++i)
+    {
+        objectmodel::BaseData* d = data[i];
+        if (d->getParent() != nullptr || d->getCounter() == m_counters[i])
+            continue;
+
+        std::ostringstream value(std::ios::out | std::ios::binary);
+        d->writeBinary(value);
+        const std::string& name = d->getName();
+        const std::string bytes = value.str();
+        writeValue(out, std::uint32_t(name.size()));
+        out.write(name.data(), std::streamsize(name.size()));
+        writeValue(out, std::uint64_t(bytes.size()));
+        out.write(bytes.data(), std::streamsize(bytes.size()));
+        ++count;
+    }
+
+    // write in a temporary file then rename it, so that concurrent runs never read a partial file
+    const std::string filename = getFilename();
+    std::ostringstream tmpname;
+    tmpname << filename << "." << std::chrono::steady_clock::now().time_since_epoch().count() << ".tmp";
+    {
+        std::ofstream file(tmpname.str().c_str(), std::ios::out | std::ios::binary);
+        file.write(s_magic, sizeof(s_magic));
+        writeValue(file, s_version);
+        writeValue(file, m_key);
+        writeValue(file, (unsigned char)m_object->getComponentState());
+        writeValue(file, count);
+        const std::string content = out.str();
+        file.write(content.data(), std::streamsize(content.size()));
+        if (!file.good())
+        {
+            file.close();
+            std::remove(tmpname.str().c_str());
+            msg_warning(m_object) << "Unable to write the init cache file " << filename;
+            return;
+        }
+    }
+#ifdef WIN32
+    std::remove(filename.c_str()); // rename does not replace an existing file
+#endif
+    if (std::rename(tmpname.str().c_str(), filename.c_str()) != 0)
+    {
+        std::remove(tmpname.str().c_str());
+        return;
+    }
+    ++InitCache::getInstance()->m_nbStored;
+}
+
+} // namespace core
+
+} // namespace sofa
@@ -0,0 +1,160 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_CORE_INITCACHE_H
+#define SOFA_CORE_INITCACHE_H
+
+#include <sofa/core/core.h>
+#include <sofa/core/objectmodel/Tag.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace sofa
+{
+
+namespace core
+{
+
+namespace objectmodel
+{
+class BaseObject;
+}
+
+/**
+ *  \brief On-disk cache of the Data computed by the loading and init() of components.
+ *
+ *  Only components tagged "initCache" are concerned. The results of a stage
+ *  (mesh loading, init()) of such a component are stored in the cache
+ *  directory, under a key hashing:
+ *  \li the class, template and path of the component,
+ *  \li the values of all its Data before the stage (Data linked to another
+ *  component are read from their parent, so that upstream changes are seen),
+ *  \li the content of the files referenced by its DataFileName,
+ *  \li for init(), the content of the scene (see setSceneHash()),
+ *  \li the keys of all the stages met before it since the scene started
+ *  loading, so that a change upstream (a mesh file read by a loader, a
+ *  topology or a state read through the context) invalidates the stages
+ *  downstream.
+ *
+ *  When the same key is met again, the stored Data values and component state
+ *  are restored instead of running the stage again.
+ *
+ *  A component should only be tagged if all the results of the stage are
+ *  stored in its Data (and not in internal members), and only depend on the
+ *  inputs above.
+ *
+ *  The cache is disabled until a directory is given, either with
+ *  setDirectory() or with the SOFA_INIT_CACHE_DIR environment variable.
+ */
+class SOFA_CORE_API InitCache
+{
+public:
+    typedef std::uint64_t Hash;
+
+    static InitCache* getInstance();
+
+    /// Directory holding the cache files (created if needed). The cache is disabled if empty.
+    void setDirectory(const std::string& directory);
+    const std::string& getDirectory() const { return m_directory; }
+    bool isEnabled() const { return !m_directory.empty(); }
+
+    /// Hash of the scene being loaded, mixed in the keys of the init() stages.
+    /// It is set when a scene starts loading, and restarts the chain of the stage keys.
+    void setSceneHash(Hash hash) { m_sceneHash = hash; m_chainHash = s_initialHash; }
+    Hash getSceneHash() const { return m_sceneHash; }
+
+    /// Call init() on the object, or restore its results from the cache.
+    /// Engines are always initialized (they declare their inputs and outputs in init()), only their first update is skipped.
+    void initObject(objectmodel::BaseObject* object);
+
+    /// Tag selecting the components to cache.
+    static const objectmodel::Tag& getTag();
+
+    /// FNV-1a hash of a block of memory, continuing from the given hash.
+    static Hash hash(const void* data, std::size_t size, Hash h = s_initialHash);
+    /// Hash of the content of a file, or 0 if it can not be read.
+    static Hash hashFile(const std::string& filename);
+
+    /// @name Statistics
+    /// @{
+    unsigned int getNbRestored() const { return m_nbRestored; }
+    unsigned int getNbStored() const { return m_nbStored; }
+    void resetStatistics() { m_nbRestored = 0; m_nbStored = 0; }
+    /// @}
+
+    static const Hash s_initialHash = 14695981039346656037ULL;
+
+    /**
+     *  \brief One stage of a component, to be run as:
+     *
+     *  \code
+     *  InitCache::Stage stage(object, "init", contextHash);
+     *  if (!stage.restore())
+     *  {
+     *      object->init();
+     *      stage.store();
+     *  }
+     *  \endcode
+     *
+     *  It does nothing if the cache is disabled or the component is not tagged.
+     */
+    class SOFA_CORE_API Stage
+    {
+    public:
+        Stage(objectmodel::BaseObject* object, const char* name, Hash contextHash = 0);
+
+        /// Return true if the component is handled by the cache.
+        bool isCached() const { return m_object != nullptr; }
+
+        /// Restore the results of the stage, return false if they are not in the cache.
+        bool restore();
+
+        /// Store the Data modified by the stage.
+        void store();
+
+        Hash getKey() const { return m_key; }
+
+    protected:
+        std::string getFilename() const;
+
+        objectmodel::BaseObject* m_object;
+        Hash m_key;
+        std::vector<int> m_counters; ///< counters of the Data before the stage
+    };
+
+protected:
+    InitCache();
+
+    std::string m_directory;
+    Hash m_sceneHash;
+    Hash m_chainHash; ///< hash of the keys of the stages met since the scene started loading
+    unsigned int m_nbRestored;
+    unsigned int m_nbStored;
+};
+
+} // namespace core
+
+} // namespace sofa
+
+#endif
@@ -82,6 +82,15 @@ void BaseMechanicalState::vMultiOp(const ExecParams* params, const VMultiOp& ops
     }
 }
 
+/// Perform a sequence of linear vector accumulation operations, then compute the scalar product between two vectors.
+///
+/// By default this method calls vMultiOp then vDot.
+SReal BaseMechanicalState::vMultiOpDot(const ExecParams* params, const VMultiOp& ops, ConstVecId a, ConstVecId b)
+{
+    vMultiOp(params, ops);
+    return vDot(params, a, b);
+}
+
 /// Handle state Changes from a given Topology
 void BaseMechanicalState::handleStateChange(core::topology::Topology* /*t*/)
 {
@@ -163,6 +163,13 @@ public:
     /// By default this method decompose the computation into multiple vOp calls.
     virtual void vMultiOp(const ExecParams* params, const VMultiOp& ops);
 
+    /// \brief Perform a sequence of linear vector accumulation operations, then compute the scalar product between two vectors.
+    ///
+    /// This is used to fuse the update of iterative solvers with the computation of their residual norm,
+    /// such as $x = x + p*alpha, r = r - q*alpha$ followed by $r.r$ in the conjugate gradient.
+    /// By default this method calls vMultiOp then vDot.
+    virtual SReal vMultiOpDot(const ExecParams* params, const VMultiOp& ops, ConstVecId a, ConstVecId b);
+
     /// Compute the scalar products between two vectors.
     virtual SReal vDot(const ExecParams* params, ConstVecId a, ConstVecId b) = 0;
 
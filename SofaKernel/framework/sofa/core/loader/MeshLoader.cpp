@@ -20,6 +20,7 @@
 * Contact information: contact@sofa-framework.org                             *
 ******************************************************************************/
 #include <sofa/core/loader/MeshLoader.h>
+#include <sofa/core/InitCache.h>
 #include <sofa/helper/io/Mesh.h>
 #include <cstdlib>
 
@@ -135,7 +136,16 @@ void MeshLoader::parse(sofa::core::objectmodel::BaseObjectDescription* arg)
 
     bool success = false;
     if (canLoad())
-        success = load(/*m_filename.getFullPath().c_str()*/);
+    {
+        InitCache::Stage cached(this, "load");
+        success = cached.restore();
+        if (!success)
+        {
+            success = load(/*m_filename.getFullPath().c_str()*/);
+            if (success)
+                cached.store();
+        }
+    }
 
     // File not loaded, component is set to invalid
     if (!success)
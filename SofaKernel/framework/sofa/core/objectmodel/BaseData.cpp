@@ -292,6 +292,40 @@ bool BaseData::copyValue(const BaseData* parent)
     return false;
 }
 
+void BaseData::writeBinary(std::ostream& out) const
+{
+    const defaulttype::AbstractTypeInfo* info = getValueTypeInfo();
+    if (info->writeBinary(getValueVoidPtr(), out))
+        return;
+
+    const std::string value = getValueString();
+    defaulttype::AbstractTypeInfo::BinaryHeader header;
+    header.encoding = defaulttype::AbstractTypeInfo::BinaryText;
+    header.valueByteSize = 1;
+    header.count = value.size();
+    defaulttype::AbstractTypeInfo::writeBinaryHeader(out, header);
+    out.write(value.data(), std::streamsize(value.size()));
+}
+
+bool BaseData::readBinary(std::istream& in)
+{
+    defaulttype::AbstractTypeInfo::BinaryHeader header;
+    if (!defaulttype::AbstractTypeInfo::readBinaryHeader(in, header))
+        return false;
+
+    if (header.encoding == defaulttype::AbstractTypeInfo::BinaryText)
+    {
+        std::string value((size_t)header.count, '\0');
+        if (header.count && !in.read(&value[0], std::streamsize(header.count)))
+            return false;
+        return read(value);
+    }
+
+    const bool success = getValueTypeInfo()->readBinary(beginEditVoidPtr(), header, in);
+    endEditVoidPtr();
+    return success;
+}
+
 bool BaseData::findDataLinkDest(DDGNode*& ptr, const std::string& path, const BaseLink* link)
 {
     return DDGNode::findDataLinkDest(ptr, path, link);
@@ -121,6 +121,16 @@ public:
     /// Get the name of the type of the value held in this %Data.
     virtual std::string getValueTypeString() const = 0;
 
+    /// Write the value of this %Data to a stream in a binary form that can be read back with readBinary().
+    /// Values made of contiguous integers or scalars, such as vectors of coordinates, are written as raw
+    /// memory in the native byte order (see AbstractTypeInfo::writeBinary()), others as their text representation.
+    void writeBinary(std::ostream& out) const;
+
+    /// Assign a value to this %Data from a stream written by writeBinary().
+    /// Binary values written from a %Data of another integer or scalar type are converted.
+    /// \return true on success.
+    bool readBinary(std::istream& in);
+
     /// Get the TypeInfo for the type of the value held in this %Data.
     ///
     /// This can be used to access the content of the %Data generically, without
@@ -460,6 +460,8 @@ public:
 
     ComponentState getComponentState() const { return m_componentstate ; }
     bool isComponentStateValid() const { return m_componentstate != ComponentState::Invalid; }
+    /// Used to restore the state of a component whose initialization is not run (see InitCache)
+    void setComponentState(ComponentState state) { m_componentstate = state; }
 
     ///@}
 
@@ -29,6 +29,9 @@
 #include <sofa/helper/types/RGBAColor.h>
 #include <sstream>
 #include <typeinfo>
+#include <limits>
+#include <cstdint>
+#include <cstring>
 #include <sofa/helper/logging/Messaging.h>
 
 namespace sofa
@@ -309,6 +312,54 @@ public:
     /// Get the type_info for this type.
     virtual const std::type_info* type_info() const = 0;
 
+    /// Encoding of the values following a BinaryHeader
+    enum BinaryEncoding
+    {
+        BinaryText = 0,            ///< characters of the text representation of the value
+        BinaryScalar = 1,          ///< floating point values
+        BinarySignedInteger = 2,
+        BinaryUnsignedInteger = 3
+    };
+
+    /// Header written before the values by writeBinary(), stored as 1+1+8 bytes in the native byte order
+    struct BinaryHeader
+    {
+        unsigned char encoding;
+        unsigned char valueByteSize; ///< size in bytes of each value, 1 for BinaryText
+        std::uint64_t count;         ///< number of values (of characters for BinaryText)
+    };
+
+    static void writeBinaryHeader(std::ostream& out, const BinaryHeader& header)
+    {
+        out.put((char)header.encoding);
+        out.put((char)header.valueByteSize);
+        out.write(reinterpret_cast<const char*>(&header.count), sizeof(header.count));
+    }
+
+    static bool readBinaryHeader(std::istream& in, BinaryHeader& header)
+    {
+        char c[2];
+        if (!in.read(c, 2) || !in.read(reinterpret_cast<char*>(&header.count), sizeof(header.count)))
+            return false;
+        header.encoding = (unsigned char)c[0];
+        header.valueByteSize = (unsigned char)c[1];
+        return true;
+    }
+
+    /// True iff the size(data) values of this type are integers or scalars stored in one contiguous
+    /// block of memory starting at getValuePtr(data), e.g. a vector of Vec or of Rigid coordinates.
+    /// The values of such types are serialized by writeBinary() as raw memory.
+    virtual bool ContiguousValues() const = 0;
+
+    /// Write a BinaryHeader followed by the raw memory of the values of \a data.
+    /// Returns false if ContiguousValues() is false, in which case nothing is written.
+    virtual bool writeBinary(const void* data, std::ostream& out) const = 0;
+
+    /// Read the values following \a header, written by writeBinary() for this type or any other type
+    /// with integer or scalar values, in which case the values are converted one by one.
+    /// Returns false if \a data cannot store the values, which are then skipped.
+    virtual bool readBinary(void* data, const BinaryHeader& header, std::istream& in) const = 0;
+
 protected: // only derived types can instantiate this class
     AbstractTypeInfo() {}
     virtual ~AbstractTypeInfo() {}
@@ -407,9 +458,113 @@ public:
 
     virtual const std::type_info* type_info() const override { return &typeid(DataType); }
 
+    bool ContiguousValues() const override
+    {
+        typedef typename Info::BaseType BaseType;
+        return Info::ValidInfo && Info::SimpleLayout && (Info::Integer || Info::Scalar) && !Info::Text
+            && DataTypeInfo<BaseType>::FixedSize
+            && sizeof(BaseType) == DataTypeInfo<BaseType>::size() * Info::byteSize();
+    }
+
+    bool writeBinary(const void* data, std::ostream& out) const override
+    {
+        if (!ContiguousValues())
+            return false;
+
+        const DataType& value = *(const DataType*)data;
+        BinaryHeader header;
+        header.encoding = binaryEncoding();
+        header.valueByteSize = (unsigned char)Info::byteSize();
+        header.count = Info::size(value);
+        writeBinaryHeader(out, header);
+        if (header.count)
+            out.write((const char*)Info::getValuePtr(value), std::streamsize(header.count * header.valueByteSize));
+        return !out.fail();
+    }
+
+    bool readBinary(void* data, const BinaryHeader& header, std::istream& in) const override
+    {
+        const size_t count = (size_t)header.count;
+        const std::streamsize nbBytes = std::streamsize(header.count * header.valueByteSize);
+        DataType& value = *(DataType*)data;
+
+        bool valid = header.encoding != BinaryText && Info::ValidInfo && (Info::Integer || Info::Scalar) && !Info::Text;
+        if (valid)
+        {
+            Info::setSize(value, count);
+            valid = (Info::size(value) == count);
+        }
+        if (!valid)
+        {
+            in.ignore(nbBytes);
+            return false;
+        }
+
+        if (ContiguousValues() && header.encoding == binaryEncoding() && header.valueByteSize == Info::byteSize())
+        {
+            if (count)
+                in.read((char*)Info::getValuePtr(value), nbBytes);
+            return !in.fail();
+        }
+
+        // values written from another type: convert them one by one
+        std::vector<char> buffer((size_t)nbBytes);
+        if (nbBytes && !in.read(&buffer[0], nbBytes))
+            return false;
+        for (size_t i=0; i<count; ++i)
+        {
+            const char* p = &buffer[i*header.valueByteSize];
+            switch (header.encoding)
+            {
+            case BinaryScalar:
+                if (header.valueByteSize == sizeof(float)) Info::setValue(value, i, (double)rawValue<float>(p));
+                else if (header.valueByteSize == sizeof(double)) Info::setValue(value, i, rawValue<double>(p));
+                else return false;
+                break;
+            case BinarySignedInteger:
+                switch (header.valueByteSize)
+                {
+                case 1: Info::setValue(value, i, (long long)rawValue<std::int8_t>(p)); break;
+                case 2: Info::setValue(value, i, (long long)rawValue<std::int16_t>(p)); break;
+                case 4: Info::setValue(value, i, (long long)rawValue<std::int32_t>(p)); break;
+                case 8: Info::setValue(value, i, (long long)rawValue<std::int64_t>(p)); break;
+                default: return false;
+                }
+                break;
+            case BinaryUnsignedInteger:
+                switch (header.valueByteSize)
+                {
+                case 1: Info::setValue(value, i, (unsigned long long)rawValue<std::uint8_t>(p)); break;
+                case 2: Info::setValue(value, i, (unsigned long long)rawValue<std::uint16_t>(p)); break;
+                case 4: Info::setValue(value, i, (unsigned long long)rawValue<std::uint32_t>(p)); break;
+                case 8: Info::setValue(value, i, (unsigned long long)rawValue<std::uint64_t>(p)); break;
+                default: return false;
+                }
+                break;
+            default:
+                return false;
+            }
+        }
+        return true;
+    }
 
 protected: // only derived types can instantiate this class
     VirtualTypeInfo() {}
+
+    static unsigned char binaryEncoding()
+    {
+        if (Info::Scalar)
+            return BinaryScalar;
+        return std::numeric_limits<typename Info::ValueType>::is_signed ? BinarySignedInteger : BinaryUnsignedInteger;
+    }
+
+    template<class T>
+    static T rawValue(const char* p)
+    {
+        T v;
+        std::memcpy(&v, p, sizeof(T));
+        return v;
+    }
 };
 
 template<class TDataType>
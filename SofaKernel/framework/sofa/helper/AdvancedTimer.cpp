@@ -33,6 +33,10 @@
 #include <stack>
 #include <algorithm>
 #include <cctype>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
 
 #define DEFAULT_INTERVAL 100
 
@@ -154,6 +158,198 @@ std::pair<AdvancedTimer::SyncCallBack,void*> AdvancedTimer::setSyncCallBack(Sync
     return old;
 }
 
+/// Events of the trace recorded by one thread. Only this thread writes in it.
+class TraceBuffer
+{
+public:
+    class Event
+    {
+    public:
+        long long time; ///< nanoseconds since the start of the trace
+        Record::Type type;
+        unsigned int name; ///< index in names
+        unsigned int obj; ///< index in names + 1, or 0 without object
+        double val;
+    };
+
+    unsigned int tid;
+    std::vector<Event> events;
+    std::vector<std::string> names;
+    /// index in names of the ids of each kind, as the ids are specific to each thread
+    std::vector<int> timerNames, stepNames, objNames, valNames;
+
+    template<class T>
+    unsigned int getName(std::vector<int>& cache, const AdvancedTimer::Id<T>& id)
+    {
+        const unsigned int i = id;
+        if (i >= cache.size())
+            cache.resize(i+1, -1);
+        if (cache[i] < 0)
+        {
+            cache[i] = (int)names.size();
+            names.push_back((std::string)id);
+        }
+        return (unsigned int)cache[i];
+    }
+};
+
+std::atomic<bool> traceEnabled(false);
+std::chrono::steady_clock::time_point traceOrigin = std::chrono::steady_clock::now();
+std::mutex traceMutex; // only used to register the buffer of a new thread and to export
+std::vector< std::unique_ptr<TraceBuffer> > traceBuffers;
+SOFA_THREAD_SPECIFIC_PTR(TraceBuffer, curTraceThread);
+
+TraceBuffer& getCurTrace()
+{
+    TraceBuffer* ptr = curTraceThread;
+    if (!ptr)
+    {
+        std::lock_guard<std::mutex> lock(traceMutex);
+        ptr = new TraceBuffer;
+        ptr->tid = (unsigned int)traceBuffers.size();
+        traceBuffers.push_back(std::unique_ptr<TraceBuffer>(ptr));
+        curTraceThread = ptr;
+    }
+    return *ptr;
+}
+
+void traceEvent(TraceBuffer& trace, Record::Type type, unsigned int name, unsigned int obj = 0, double val = 0)
+{
+    TraceBuffer::Event e;
+    e.time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - traceOrigin).count();
+    e.type = type;
+    e.name = name;
+    e.obj = obj;
+    e.val = val;
+    trace.events.push_back(e);
+}
+
+void traceTimer(Record::Type type, AdvancedTimer::IdTimer id)
+{
+    if (!traceEnabled) return;
+    TraceBuffer& trace = getCurTrace();
+    traceEvent(trace, type, trace.getName(trace.timerNames, id));
+}
+
+void traceStep(Record::Type type, AdvancedTimer::IdStep id, AdvancedTimer::IdObj obj = AdvancedTimer::IdObj())
+{
+    if (!traceEnabled) return;
+    TraceBuffer& trace = getCurTrace();
+    traceEvent(trace, type, trace.getName(trace.stepNames, id), obj ? trace.getName(trace.objNames, obj) + 1 : 0);
+}
+
+void traceVal(Record::Type type, AdvancedTimer::IdVal id, double val)
+{
+    if (!traceEnabled) return;
+    TraceBuffer& trace = getCurTrace();
+    traceEvent(trace, type, trace.getName(trace.valNames, id), 0, val);
+}
+
+void AdvancedTimer::setTraceEnabled(bool val)
+{
+    traceEnabled = val;
+}
+
+bool AdvancedTimer::isTraceEnabled()
+{
+    return traceEnabled;
+}
+
+void AdvancedTimer::clearTrace()
+{
+    std::lock_guard<std::mutex> lock(traceMutex);
+    for (auto& buffer : traceBuffers)
+        buffer->events.clear();
+}
+
+void AdvancedTimer::exportChromeTrace(std::ostream& out)
+{
+    json events = json::array();
+
+    std::lock_guard<std::mutex> lock(traceMutex);
+    for (const auto& buffer : traceBuffers)
+    {
+        const unsigned int tid = buffer->tid;
+
+        json threadName;
+        threadName["name"] = "thread_name";
+        threadName["ph"] = "M";
+        threadName["pid"] = 0;
+        threadName["tid"] = tid;
+        threadName["args"]["name"] = "Thread " + std::to_string(tid);
+        events.push_back(threadName);
+
+        // values are accumulated during each iteration of a timer, as in the records of the timers
+        std::map<unsigned int, double> valTotals;
+        for (const TraceBuffer::Event& e : buffer->events)
+        {
+            json event;
+            event["name"] = buffer->names[e.name];
+            event["pid"] = 0;
+            event["tid"] = tid;
+            event["ts"] = e.time / 1000.0; // microseconds
+            switch (e.type)
+            {
+            case Record::RBEGIN:
+                event["ph"] = "B";
+                event["cat"] = "timer";
+                valTotals.clear();
+                break;
+            case Record::REND:
+                event["ph"] = "E";
+                event["cat"] = "timer";
+                break;
+            case Record::RSTEP_BEGIN:
+                event["ph"] = "B";
+                event["cat"] = "step";
+                break;
+            case Record::RSTEP_END:
+                event["ph"] = "E";
+                event["cat"] = "step";
+                break;
+            case Record::RSTEP:
+                event["ph"] = "i";
+                event["s"] = "t";
+                event["cat"] = "step";
+                break;
+            case Record::RVAL_SET:
+            case Record::RVAL_ADD:
+                if (e.type == Record::RVAL_SET)
+                    valTotals[e.name] = e.val;
+                else
+                    valTotals[e.name] += e.val;
+                event["ph"] = "C";
+                event["cat"] = "value";
+                event["id"] = tid;
+                event["args"]["value"] = valTotals[e.name];
+                break;
+            default:
+                continue;
+            }
+            if (e.obj)
+                event["args"]["object"] = buffer->names[e.obj-1];
+            events.push_back(event);
+        }
+    }
+
+    json trace;
+    trace["traceEvents"] = events;
+    trace["displayTimeUnit"] = "ns";
+    out << trace.dump();
+}
+
+bool AdvancedTimer::exportChromeTrace(const std::string& filename)
+{
+    std::ofstream out(filename.c_str());
+    if (!out)
+    {
+        msg_error("AdvancedTimer") << "Unable to write the trace in " << filename;
+        return false;
+    }
+    exportChromeTrace(out);
+    return true;
+}
+
 void AdvancedTimer::clear()
 {
     setCurRecords(NULL);
@@ -211,6 +407,7 @@ void AdvancedTimer::setInterval(IdTimer id, int val)
 
 void AdvancedTimer::begin(IdTimer id)
 {
+    traceTimer(Record::RBEGIN, id);
     std::stack<AdvancedTimer::IdTimer>& curTimer = getCurTimer();
     curTimer.push(id);
     TimerData& data = timers[curTimer.top()];
@@ -248,6 +445,7 @@ void AdvancedTimer::end(IdTimer id, std::ostream& result)
         msg_error("AdvancedTimer::end") << "timer[" << id << "] does not correspond to last call to begin(" << curTimer.top() << ")" ;
         return;
     }
+    traceTimer(Record::REND, id);
     helper::vector<Record>* curRecords = getCurRecords();
     if (curRecords)
     {
@@ -292,6 +490,7 @@ void AdvancedTimer::end(IdTimer id)
         msg_error("AdvancedTimer::end") << "timer[" << id << "] does not correspond to last call to begin(" << curTimer.top() << ")" ;
         return;
     }
+    traceTimer(Record::REND, id);
 
     TimerData& dataT = timers[id];
     if (dataT.timerOutputType == GUI || dataT.timerOutputType == LJSON || dataT.timerOutputType == JSON)
@@ -359,6 +558,7 @@ bool AdvancedTimer::isActive()
 
 void AdvancedTimer::stepBegin(IdStep id)
 {
+    traceStep(Record::RSTEP_BEGIN, id);
     helper::vector<Record>* curRecords = getCurRecords();
     if (!curRecords) return;
     Record r;
@@ -370,6 +570,7 @@ void AdvancedTimer::stepBegin(IdStep id)
 
 void AdvancedTimer::stepBegin(IdStep id, IdObj obj)
 {
+    traceStep(Record::RSTEP_BEGIN, id, obj);
     helper::vector<Record>* curRecords = getCurRecords();
     if (!curRecords) return;
     Record r;
@@ -382,6 +583,7 @@ void AdvancedTimer::stepBegin(IdStep id, IdObj obj)
 
 void AdvancedTimer::stepEnd  (IdStep id)
 {
+    traceStep(Record::RSTEP_END, id);
     helper::vector<Record>* curRecords = getCurRecords();
     if (!curRecords) return;
     if (syncCallBack) (*syncCallBack)(syncCallBackData);
@@ -394,6 +596,7 @@ void AdvancedTimer::stepEnd  (IdStep id)
 
 void AdvancedTimer::stepEnd  (IdStep id, IdObj obj)
 {
+    traceStep(Record::RSTEP_END, id, obj);
     helper::vector<Record>* curRecords = getCurRecords();
     if (!curRecords) return;
     Record r;
@@ -406,6 +609,8 @@ void AdvancedTimer::stepEnd  (IdStep id, IdObj obj)
 
 void AdvancedTimer::stepNext (IdStep prevId, IdStep nextId)
 {
+    traceStep(Record::RSTEP_END, prevId);
+    traceStep(Record::RSTEP_BEGIN, nextId);
     helper::vector<Record>* curRecords = getCurRecords();
     if (!curRecords) return;
     Record r;
@@ -421,6 +626,7 @@ void AdvancedTimer::stepNext (IdStep prevId, IdStep nextId)
 
 void AdvancedTimer::step     (IdStep id)
 {
+    traceStep(Record::RSTEP, id);
     helper::vector<Record>* curRecords = getCurRecords();
     if (!curRecords) return;
     if (syncCallBack) (*syncCallBack)(syncCallBackData);
@@ -433,6 +639,7 @@ void AdvancedTimer::step     (IdStep id)
 
 void AdvancedTimer::step     (IdStep id, IdObj obj)
 {
+    traceStep(Record::RSTEP, id, obj);
     helper::vector<Record>* curRecords = getCurRecords();
     if (!curRecords) return;
     if (syncCallBack) (*syncCallBack)(syncCallBackData);
@@ -446,6 +653,7 @@ void AdvancedTimer::step     (IdStep id, IdObj obj)
 
 void AdvancedTimer::valSet(IdVal id, double val)
 {
+    traceVal(Record::RVAL_SET, id, val);
     helper::vector<Record>* curRecords = getCurRecords();
     if (!curRecords) return;
     Record r;
@@ -458,6 +666,7 @@ void AdvancedTimer::valSet(IdVal id, double val)
 
 void AdvancedTimer::valAdd(IdVal id, double val)
 {
+    traceVal(Record::RVAL_ADD, id, val);
     helper::vector<Record>* curRecords = getCurRecords();
     if (!curRecords) return;
     Record r;
@@ -482,85 +691,73 @@ void AdvancedTimer::end(const char* idStr)
 
 void AdvancedTimer::stepBegin(const char* idStr)
 {
-    helper::vector<Record>* curRecords = getCurRecords();
-    if (!curRecords) return;
+    if (!getCurRecords() && !traceEnabled) return;
     stepBegin(IdStep(idStr));
 }
 
 void AdvancedTimer::stepBegin(const char* idStr, const char* objStr)
 {
-    helper::vector<Record>* curRecords = getCurRecords();
-    if (!curRecords) return;
+    if (!getCurRecords() && !traceEnabled) return;
     stepBegin(IdStep(idStr), IdObj(objStr));
 }
 
 void AdvancedTimer::stepBegin(const char* idStr, const std::string& objStr)
 {
-    helper::vector<Record>* curRecords = getCurRecords();
-    if (!curRecords) return;
+    if (!getCurRecords() && !traceEnabled) return;
     stepBegin(IdStep(idStr), IdObj(objStr));
 }
 
 void AdvancedTimer::stepEnd  (const char* idStr)
 {
-    helper::vector<Record>* curRecords = getCurRecords();
-    if (!curRecords) return;
+    if (!getCurRecords() && !traceEnabled) return;
     stepEnd  (IdStep(idStr));
 }
 
 void AdvancedTimer::stepEnd  (const char* idStr, const char* objStr)
 {
-    helper::vector<Record>* curRecords = getCurRecords();
-    if (!curRecords) return;
+    if (!getCurRecords() && !traceEnabled) return;
     stepEnd  (IdStep(idStr), IdObj(objStr));
 }
 
 void AdvancedTimer::stepEnd  (const char* idStr, const std::string& objStr)
 {
-    helper::vector<Record>* curRecords = getCurRecords();
-    if (!curRecords) return;
+    if (!getCurRecords() && !traceEnabled) return;
     stepEnd  (IdStep(idStr), IdObj(objStr));
 }
 
 void AdvancedTimer::stepNext (const char* prevIdStr, const char* nextIdStr)
 {
-    helper::vector<Record>* curRecords = getCurRecords();
-    if (!curRecords) return;
+    if (!getCurRecords() && !traceEnabled) return;
     stepNext (IdStep(prevIdStr), IdStep(nextIdStr));
 }
 
 void AdvancedTimer::step     (const char* idStr)
 {
-    helper::vector<Record>* curRecords = getCurRecords();
-    if (!curRecords) return;
+    if (!getCurRecords() && !traceEnabled) return;
     step     (IdStep(idStr));
 }
 
 void AdvancedTimer::step     (const char* idStr, const char* objStr)
 {
-    helper::vector<Record>* curRecords = getCurRecords();
-    if (!curRecords) return;
+    if (!getCurRecords() && !traceEnabled) return;
     step     (IdStep(idStr), IdObj(objStr));
 }
 
 void AdvancedTimer::step     (const char* idStr, const std::string& objStr)
 {
-    helper::vector<Record>* curRecords = getCurRecords();
-    if (!curRecords) return;
+    if (!getCurRecords() && !traceEnabled) return;
     step     (IdStep(idStr), IdObj(objStr));
 }
 
 void AdvancedTimer::valSet(const char* idStr, double val)
 {
-    helper::vector<Record>* curRecords = getCurRecords();
-    if (!curRecords) return;
+    if (!getCurRecords() && !traceEnabled) return;
     valSet(IdVal(idStr),val);
 }
 
 void AdvancedTimer::valAdd(const char* idStr, double val)
 {
-    helper::vector<Record>* curRecords = getCurRecords();
-    if (!curRecords) return;
+    if (!getCurRecords() && !traceEnabled) return;
     valAdd(IdVal(idStr),val);
 }
 
@@ -1444,6 +1641,7 @@ std::string AdvancedTimer::getTimeAnalysis(IdTimer id, simulation::Node* node)
         msg_error("AdvancedTimer::end") << "timer[" << id << "] does not correspond to last call to begin(" << curTimer.top() << ")" ;
         return NULL;
     }
+    traceTimer(Record::REND, id);
     helper::vector<Record>* curRecords = getCurRecords();
     if (curRecords)
     {
@@ -119,6 +119,11 @@ namespace helper
 
   ==== END ====
 
+  * To record the steps of all the threads and view them in chrome://tracing or https://ui.perfetto.dev :
+    AdvancedTimer::setTraceEnabled(true);
+    ...
+    AdvancedTimer::exportChromeTrace("trace.json");
+
  */
 
 class Record
@@ -501,6 +506,38 @@ public:
     typedef void (*SyncCallBack)(void* userData);
     static std::pair<SyncCallBack,void*> setSyncCallBack(SyncCallBack cb, void* userData = nullptr);
 
+    /**
+     * @brief setTraceEnabled Record the timers, steps and values of all the threads in a trace.
+     * The events are stored with a nanosecond timestamp in a buffer owned by each thread, without locks,
+     * independently of the enabled timers and of their records.
+     * @param val bool, true to start recording, false to stop
+     */
+    static void setTraceEnabled(bool val);
+    static bool isTraceEnabled();
+
+    /**
+     * @brief clearTrace Remove the recorded trace events.
+     * Must not be called while other threads are recording events.
+     */
+    static void clearTrace();
+
+    /**
+     * @brief exportChromeTrace Write the recorded events in the Chrome trace event JSON format,
+     * which can be opened in chrome://tracing or Perfetto. Steps are nested B/E events, with the object
+     * name as argument, values are counters, and each thread has its own track.
+     * Must not be called while other threads are recording events.
+     * @param out std::ostream, stream where the JSON is written
+     */
+    static void exportChromeTrace(std::ostream& out);
+
+    /**
+     * @brief exportChromeTrace Write the recorded events in the Chrome trace event JSON format in a file.
+     * @param filename std::string, name of the file
+     * @return false if the file could not be written
+     */
+    static bool exportChromeTrace(const std::string& filename);
+
+
 };
 
 #if  !defined(SOFA_HELPER_ADVANCEDTIMER_CPP)
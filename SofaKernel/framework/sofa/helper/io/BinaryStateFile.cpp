@@ -0,0 +1,325 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/helper/io/BinaryStateFile.h>
+#include <sofa/helper/logging/Messaging.h>
+
+#ifdef SOFA_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+
+namespace sofa
+{
+
+namespace helper
+{
+
+namespace io
+{
+
+namespace
+{
+
+const char headerMagic[8] = { 'S','O','F','A','S','T','A','T' };
+const char footerMagic[8] = { 'S','O','F','A','I','D','X','1' };
+const std::uint32_t formatVersion = 1;
+
+enum ChunkCompression : std::uint32_t
+{
+    NoCompression = 0,
+    ZlibCompression = 1
+};
+
+struct ChunkHeader
+{
+    double time;
+    std::uint32_t compression;
+    std::uint32_t reserved;
+    std::uint64_t rawSize;
+    std::uint64_t storedSize;
+};
+
+const std::size_t headerSize = sizeof(headerMagic) + 2*sizeof(std::uint32_t);
+const std::size_t footerSize = 2*sizeof(std::uint64_t) + sizeof(footerMagic);
+
+template<class T>
+void writeValue(std::ostream& out, const T& value)
+{
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<class T>
+bool readValue(std::istream& in, T& value)
+{
+    in.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return bool(in);
+}
+
+bool readChunkHeader(std::istream& in, ChunkHeader& header)
+{
+    return readValue(in, header.time) && readValue(in, header.compression) && readValue(in, header.reserved)
+            && readValue(in, header.rawSize) && readValue(in, header.storedSize);
+}
+
+} // anonymous namespace
+
+BinaryStateFileWriter::BinaryStateFileWriter()
+    : m_compressionLevel(0)
+{
+}
+
+BinaryStateFileWriter::~BinaryStateFileWriter()
+{
+    close();
+}
+
+bool BinaryStateFileWriter::open(const std::string& filename, int compressionLevel)
+{
+    close();
+    m_file.open(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!m_file.is_open())
+        return false;
+
+#ifdef SOFA_HAVE_ZLIB
+    m_compressionLevel = std::min(compressionLevel, 9);
+#else
+    if (compressionLevel > 0)
+        msg_warning("BinaryStateFile") << "zlib is not available, chunks of " << filename << " will not be compressed";
+    m_compressionLevel = 0;
+#endif
+    m_times.clear();
+    m_offsets.clear();
+
+    m_file.write(headerMagic, sizeof(headerMagic));
+    writeValue(m_file, formatVersion);
+    writeValue(m_file, std::uint32_t(0));
+    return bool(m_file);
+}
+
+bool BinaryStateFileWriter::writeChunk(double time, const std::vector<char>& payload)
+{
+    if (!m_file.is_open())
+        return false;
+
+    ChunkHeader header;
+    header.time = time;
+    header.compression = NoCompression;
+    header.reserved = 0;
+    header.rawSize = payload.size();
+    header.storedSize = payload.size();
+    const char* stored = payload.data();
+
+#ifdef SOFA_HAVE_ZLIB
+    if (m_compressionLevel > 0 && !payload.empty())
+    {
+        uLongf compressedSize = compressBound(uLong(payload.size()));
+        m_buffer.resize(compressedSize);
+        if (compress2(reinterpret_cast<Bytef*>(m_buffer.data()), &compressedSize,
+                      reinterpret_cast<const Bytef*>(payload.data()), uLong(payload.size()), m_compressionLevel) == Z_OK
+                && compressedSize < payload.size())
+        {
+            header.compression = ZlibCompression;
+            header.storedSize = compressedSize;
+            stored = m_buffer.data();
+        }
+    }
+#endif
+
+    m_times.push_back(time);
+    m_offsets.push_back(std::uint64_t(m_file.tellp()));
+    writeValue(m_file, header.time);
+    writeValue(m_file, header.compression);
+    writeValue(m_file, header.reserved);
+    writeValue(m_file, header.rawSize);
+    writeValue(m_file, header.storedSize);
+    m_file.write(stored, std::streamsize(header.storedSize));
+    m_file.flush();
+    return bool(m_file);
+}
+
+void BinaryStateFileWriter::close()
+{
+    if (!m_file.is_open())
+        return;
+
+    const std::uint64_t indexOffset = std::uint64_t(m_file.tellp());
+    for (std::size_t i = 0; i < m_times.size(); ++i)
+    {
+        writeValue(m_file, m_times[i]);
+        writeValue(m_file, m_offsets[i]);
+    }
+    writeValue(m_file, std::uint64_t(m_times.size()));
+    writeValue(m_file, indexOffset);
+    m_file.write(footerMagic, sizeof(footerMagic));
+    m_file.close();
+    m_times.clear();
+    m_offsets.clear();
+}
+
+BinaryStateFileReader::BinaryStateFileReader()
+{
+}
+
+bool BinaryStateFileReader::isBinaryStateFile(const std::string& filename)
+{
+    std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+    char magic[sizeof(headerMagic)];
+    return file.read(magic, sizeof(magic)) && std::equal(magic, magic+sizeof(magic), headerMagic);
+}
+
+bool BinaryStateFileReader::open(const std::string& filename)
+{
+    close();
+    m_file.open(filename.c_str(), std::ios::in | std::ios::binary);
+    if (!m_file.is_open())
+        return false;
+
+    char magic[sizeof(headerMagic)];
+    std::uint32_t version = 0, reserved = 0;
+    if (!m_file.read(magic, sizeof(magic)) || !std::equal(magic, magic+sizeof(magic), headerMagic)
+            || !readValue(m_file, version) || !readValue(m_file, reserved) || version > formatVersion)
+    {
+        msg_error("BinaryStateFile") << filename << " is not a supported binary state file";
+        close();
+        return false;
+    }
+
+    if (!readIndex())
+    {
+        msg_warning("BinaryStateFile") << "No valid time index in " << filename << ", scanning chunks";
+        if (!scanChunks())
+        {
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void BinaryStateFileReader::close()
+{
+    if (m_file.is_open())
+        m_file.close();
+    m_file.clear();
+    m_times.clear();
+    m_offsets.clear();
+}
+
+bool BinaryStateFileReader::readIndex()
+{
+    m_file.clear();
+    m_file.seekg(0, std::ios::end);
+    const std::uint64_t fileSize = std::uint64_t(m_file.tellg());
+    if (fileSize < headerSize + footerSize)
+        return false;
+
+    std::uint64_t nbChunks = 0, indexOffset = 0;
+    char magic[sizeof(footerMagic)];
+    m_file.seekg(std::streamoff(fileSize - footerSize));
+    if (!readValue(m_file, nbChunks) || !readValue(m_file, indexOffset) || !m_file.read(magic, sizeof(magic))
+            || !std::equal(magic, magic+sizeof(magic), footerMagic)
+            || indexOffset < headerSize || indexOffset + nbChunks*(sizeof(double)+sizeof(std::uint64_t)) + footerSize != fileSize)
+        return false;
+
+    m_times.resize(nbChunks);
+    m_offsets.resize(nbChunks);
+    m_file.seekg(std::streamoff(indexOffset));
+    for (std::uint64_t i = 0; i < nbChunks; ++i)
+    {
+        if (!readValue(m_file, m_times[i]) || !readValue(m_file, m_offsets[i]))
+            return false;
+    }
+    return true;
+}
+
+bool BinaryStateFileReader::scanChunks()
+{
+    m_times.clear();
+    m_offsets.clear();
+    m_file.clear();
+    m_file.seekg(0, std::ios::end);
+    const std::uint64_t fileSize = std::uint64_t(m_file.tellg());
+
+    std::uint64_t offset = headerSize;
+    ChunkHeader header;
+    m_file.seekg(std::streamoff(offset));
+    while (readChunkHeader(m_file, header))
+    {
+        const std::uint64_t end = offset + sizeof(double) + 2*sizeof(std::uint32_t) + 2*sizeof(std::uint64_t) + header.storedSize;
+        if (end > fileSize)
+            break; // truncated chunk
+        m_times.push_back(header.time);
+        m_offsets.push_back(offset);
+        offset = end;
+        m_file.seekg(std::streamoff(offset));
+    }
+    m_file.clear();
+    return true;
+}
+
+int BinaryStateFileReader::findChunk(double time) const
+{
+    // chunk times are written in increasing order
+    std::vector<double>::const_iterator it = std::upper_bound(m_times.begin(), m_times.end(), time);
+    return int(it - m_times.begin()) - 1;
+}
+
+bool BinaryStateFileReader::readChunk(std::size_t index, std::vector<char>& payload)
+{
+    if (!m_file.is_open() || index >= m_offsets.size())
+        return false;
+
+    m_file.clear();
+    m_file.seekg(std::streamoff(m_offsets[index]));
+    ChunkHeader header;
+    if (!readChunkHeader(m_file, header))
+        return false;
+
+    payload.resize(header.rawSize);
+    if (header.compression == NoCompression)
+    {
+        return header.storedSize == header.rawSize
+                && m_file.read(payload.data(), std::streamsize(header.rawSize));
+    }
+#ifdef SOFA_HAVE_ZLIB
+    else if (header.compression == ZlibCompression)
+    {
+        m_buffer.resize(header.storedSize);
+        if (!m_file.read(m_buffer.data(), std::streamsize(header.storedSize)))
+            return false;
+        uLongf rawSize = uLongf(header.rawSize);
+        return uncompress(reinterpret_cast<Bytef*>(payload.data()), &rawSize,
+                          reinterpret_cast<const Bytef*>(m_buffer.data()), uLong(header.storedSize)) == Z_OK
+                && rawSize == header.rawSize;
+    }
+#endif
+    msg_error("BinaryStateFile") << "Unsupported compression for chunk " << index;
+    return false;
+}
+
+} // namespace io
+
+} // namespace helper
+
+} // namespace sofa
@@ -0,0 +1,117 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_HELPER_IO_BINARYSTATEFILE_H
+#define SOFA_HELPER_IO_BINARYSTATEFILE_H
+
+#include <sofa/helper/helper.h>
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace sofa
+{
+
+namespace helper
+{
+
+namespace io
+{
+
+/// Vector stored in a record of the chunks written by WriteState and read back by ReadState.
+/// Each record is: uint32 vector, uint32 dimension, uint32 scalar size, uint32 reserved, uint64 dof count, scalars
+enum BinaryStateVector { BINARY_X = 0, BINARY_X0 = 1, BINARY_V = 2, BINARY_F = 3 };
+
+/** Binary file made of time-stamped chunks, followed by a time index.
+ *
+ * Layout (native endianness):
+ * - header: "SOFASTAT", uint32 version, uint32 reserved
+ * - chunks: double time, uint32 compression, uint32 reserved, uint64 raw size, uint64 stored size, stored bytes
+ * - footer: (double time, uint64 offset) per chunk, uint64 chunk count, uint64 index offset, "SOFAIDX1"
+ *
+ * Each chunk payload is compressed independently, so any chunk can be read without
+ * decoding the previous ones. If the footer is missing (the writer was not closed),
+ * the reader rebuilds the index by walking the chunk headers.
+ */
+class SOFA_HELPER_API BinaryStateFileWriter
+{
+public:
+    BinaryStateFileWriter();
+    ~BinaryStateFileWriter();
+
+    /// Create the file. compressionLevel is a zlib level (0 disables compression).
+    bool open(const std::string& filename, int compressionLevel = 0);
+    bool isOpen() const { return m_file.is_open(); }
+
+    /// Append a chunk with the given time stamp
+    bool writeChunk(double time, const std::vector<char>& payload);
+
+    /// Write the time index and close the file
+    void close();
+
+protected:
+    std::ofstream m_file;
+    int m_compressionLevel;
+    std::vector<double> m_times;
+    std::vector<std::uint64_t> m_offsets;
+    std::vector<char> m_buffer;
+};
+
+class SOFA_HELPER_API BinaryStateFileReader
+{
+public:
+    BinaryStateFileReader();
+
+    /// Returns true if the file starts with the binary state file header
+    static bool isBinaryStateFile(const std::string& filename);
+
+    bool open(const std::string& filename);
+    bool isOpen() const { return m_file.is_open(); }
+    void close();
+
+    std::size_t getNbChunks() const { return m_times.size(); }
+    double getChunkTime(std::size_t index) const { return m_times[index]; }
+
+    /// Index of the last chunk with a time lower or equal to the given time, -1 if there is none
+    int findChunk(double time) const;
+
+    /// Read and uncompress the payload of the given chunk
+    bool readChunk(std::size_t index, std::vector<char>& payload);
+
+protected:
+    bool readIndex();
+    bool scanChunks();
+
+    std::ifstream m_file;
+    std::vector<double> m_times;
+    std::vector<std::uint64_t> m_offsets;
+    std::vector<char> m_buffer;
+};
+
+} // namespace io
+
+} // namespace helper
+
+} // namespace sofa
+
+#endif // SOFA_HELPER_IO_BINARYSTATEFILE_H
@@ -0,0 +1,100 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/helper/io/MappedFile.h>
+
+#include <fstream>
+
+namespace sofa
+{
+
+namespace helper
+{
+
+namespace io
+{
+
+MappedFile::MappedFile()
+    : m_data(nullptr), m_size(0), m_isOpen(false)
+{
+}
+
+MappedFile::MappedFile(const std::string& filename)
+    : m_data(nullptr), m_size(0), m_isOpen(false)
+{
+    open(filename);
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const std::string& filename)
+{
+    close();
+
+    if (m_mapping.open(filename))
+    {
+        m_data = m_mapping.data();
+        m_size = m_mapping.size();
+        m_isOpen = true;
+        return true;
+    }
+
+    // fallback: read the whole file into memory
+    std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+    if (!file.good())
+        return false;
+
+    file.seekg(0, std::ios::end);
+    const std::streamoff length = file.tellg();
+    file.seekg(0, std::ios::beg);
+    if (length < 0)
+        return false;
+
+    m_buffer.resize((std::size_t)length);
+    if (length > 0 && !file.read(&m_buffer[0], length))
+    {
+        m_buffer.clear();
+        return false;
+    }
+
+    m_data = m_buffer.empty() ? nullptr : &m_buffer[0];
+    m_size = m_buffer.size();
+    m_isOpen = true;
+    return true;
+}
+
+void MappedFile::close()
+{
+    m_mapping.close();
+    m_data = nullptr;
+    m_size = 0;
+    m_buffer.clear();
+    m_isOpen = false;
+}
+
+} // namespace io
+
+} // namespace helper
+
+} // namespace sofa
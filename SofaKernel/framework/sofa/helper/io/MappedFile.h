@@ -0,0 +1,82 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_HELPER_IO_MAPPEDFILE_H
+#define SOFA_HELPER_IO_MAPPEDFILE_H
+
+#include <sofa/helper/helper.h>
+#include <sofa/helper/system/MappedFile.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace sofa
+{
+
+namespace helper
+{
+
+namespace io
+{
+
+/** Read-only view of a whole file in memory.
+ *
+ * The file is memory-mapped (see system::MappedFile), so that parsers can scan it
+ * without copying it line by line through a stream. If the mapping fails, or the
+ * file is empty, its content is read into an internal buffer instead. The data is
+ * not null-terminated.
+ */
+class SOFA_HELPER_API MappedFile
+{
+public:
+    MappedFile();
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+
+    bool open(const std::string& filename);
+    void close();
+
+    bool isOpen() const { return m_isOpen; }
+    bool isMapped() const { return m_mapping.isOpen(); }
+
+    const char* begin() const { return m_data; }
+    const char* end() const { return m_data + m_size; }
+    std::size_t size() const { return m_size; }
+
+private:
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+    const char* m_data;
+    std::size_t m_size;
+    system::MappedFile m_mapping;
+    std::vector<char> m_buffer;
+    bool m_isOpen;
+};
+
+} // namespace io
+
+} // namespace helper
+
+} // namespace sofa
+
+#endif
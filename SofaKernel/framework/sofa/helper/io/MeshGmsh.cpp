@@ -21,6 +21,7 @@
 ******************************************************************************/
 #include <sofa/helper/io/File.h>
 #include <sofa/helper/io/MeshGmsh.h>
+#include <sofa/helper/io/MappedFile.h>
 #include <sofa/helper/system/FileRepository.h>
 #include <sofa/helper/system/SetDirectory.h>
 #include <sofa/helper/system/Locale.h>
@@ -52,35 +53,31 @@ void MeshGmsh::init (std::string filename)
     }
     loaderType = "gmsh";
 
-    std::ifstream file(filename);
-    if (!file.good()) return;
+    MappedFile file(filename);
+    if (!file.isOpen()) return;
+    TextTokenizer tokenizer(file.begin(), file.end());
 
     unsigned int gmshFormat = 0;
-    std::string cmd;
 
     // -- Looking for Gmsh version of this file.
-    std::getline(file, cmd); //Version
-    std::istringstream versionReader(cmd);
     std::string version;
-    versionReader >> version;
+    tokenizer.nextWordInLine(version);
+    tokenizer.skipLine(); //Version
     if (version == "$MeshFormat") // Reading gmsh 2.0 file
     {
         gmshFormat = 2;
-        std::string line;
-        std::getline(file, line); // we don't nedd this line
-        std::getline(file, cmd);
-        std::istringstream endMeshReader(cmd);
+        tokenizer.skipLine(); // we don't nedd this line
         std::string endMesh;
-        endMeshReader >> endMesh;
+        tokenizer.nextWordInLine(endMesh);
+        tokenizer.skipLine();
 
         if (endMesh != std::string("$EndMeshFormat")) // it should end with $EndMeshFormat
         {
-            file.close();
             return;
         }
         else
         {
-            std::getline(file, cmd); // First Command
+            tokenizer.skipLine(); // First Command
         }
     }
     else
@@ -88,8 +85,7 @@ void MeshGmsh::init (std::string filename)
         gmshFormat = 1;
     }
 
-    readGmsh(file, gmshFormat);
-    file.close();
+    readGmsh(tokenizer, gmshFormat);
 }
 
 
@@ -119,7 +115,7 @@ void MeshGmsh::normalizeGroup(helper::vector< sofa::core::loader::PrimitiveGroup
 }
 
 
-bool MeshGmsh::readGmsh(std::ifstream &file, const unsigned int gmshFormat)
+bool MeshGmsh::readGmsh(TextTokenizer& file, const unsigned int gmshFormat)
 {
     int npoints = 0;
     int nlines = 0;
@@ -322,8 +318,7 @@ bool MeshGmsh::readGmsh(std::ifstream &file, const unsigned int gmshFormat)
             break;
         default:
             //if the type is not handled, skip rest of the line
-            std::string tmp;
-            std::getline(file, tmp);
+            file.skipLine();
         }
     }
 
@@ -23,7 +23,7 @@
 #define SOFA_HELPER_IO_MESHGMSH_H
 
 #include <sofa/helper/io/Mesh.h>
-#include <istream>
+#include <sofa/helper/io/TextTokenizer.h>
 
 namespace sofa
 {
@@ -47,7 +47,7 @@ public:
 
 protected:
 
-    bool readGmsh(std::ifstream &file, const unsigned int gmshFormat);
+    bool readGmsh(TextTokenizer& file, const unsigned int gmshFormat);
 
     void addInGroup(helper::vector< sofa::core::loader::PrimitiveGroup>& group, int tag, int eid);
 
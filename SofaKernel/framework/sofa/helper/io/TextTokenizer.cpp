@@ -0,0 +1,210 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/helper/io/TextTokenizer.h>
+
+#include <cstdint>
+#include <limits>
+
+namespace sofa
+{
+
+namespace helper
+{
+
+namespace io
+{
+
+namespace
+{
+
+inline bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+/// Largest mantissa and power of ten that are exactly representable
+template<class Real> struct FastPathLimits;
+
+template<> struct FastPathLimits<double>
+{
+    static std::uint64_t maxMantissa() { return std::uint64_t(1) << 53; }
+    static int maxExponent() { return 22; }
+};
+
+template<> struct FastPathLimits<float>
+{
+    static std::uint64_t maxMantissa() { return std::uint64_t(1) << 24; }
+    static int maxExponent() { return 10; }
+};
+
+template<class Real>
+Real exactPowerOfTen(int e)
+{
+    static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                     1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+    return Real(powers[e]);
+}
+
+template<class Real>
+bool parseReal(const char*& p, const char* end, Real& value)
+{
+    const char* s = p;
+    bool negative = false;
+    if (s != end && (*s == '-' || *s == '+'))
+    {
+        negative = (*s == '-');
+        ++s;
+    }
+
+    std::uint64_t mantissa = 0;
+    int nbDigits = 0;
+    int exponent = 0;
+    bool anyDigit = false;
+    bool truncated = false;
+    for (bool fractional = false; ; ++s)
+    {
+        if (s != end && *s == '.' && !fractional)
+        {
+            fractional = true;
+            continue;
+        }
+        if (s == end || !isDigit(*s))
+            break;
+
+        anyDigit = true;
+        const unsigned int d = unsigned(*s - '0');
+        if (mantissa == 0 && d == 0)
+        {
+            if (fractional) --exponent;
+        }
+        else if (nbDigits < 19)
+        {
+            mantissa = mantissa * 10 + d;
+            ++nbDigits;
+            if (fractional) --exponent;
+        }
+        else
+        {
+            truncated = true;
+        }
+    }
+    if (!anyDigit)
+        return parseValue<Real>(p, end, value);
+
+    if (s != end && (*s == 'e' || *s == 'E'))
+    {
+        const char* e = s + 1;
+        bool negativeExponent = false;
+        if (e != end && (*e == '-' || *e == '+'))
+        {
+            negativeExponent = (*e == '-');
+            ++e;
+        }
+        if (e == end || !isDigit(*e))
+            return parseValue<Real>(p, end, value);
+
+        int exp10 = 0;
+        for (; e != end && isDigit(*e); ++e)
+            if (exp10 < 100000) exp10 = exp10 * 10 + (*e - '0');
+        exponent += negativeExponent ? -exp10 : exp10;
+        s = e;
+    }
+
+    Real result;
+    if (mantissa == 0)
+    {
+        result = Real(0);
+    }
+    else if (!truncated && mantissa <= FastPathLimits<Real>::maxMantissa()
+             && exponent >= -FastPathLimits<Real>::maxExponent() && exponent <= FastPathLimits<Real>::maxExponent())
+    {
+        result = Real(mantissa);
+        if (exponent < 0)
+            result /= exactPowerOfTen<Real>(-exponent);
+        else
+            result *= exactPowerOfTen<Real>(exponent);
+    }
+    else
+    {
+        // not exactly computable with a single rounding: let the standard library convert it
+        return parseValue<Real>(p, end, value);
+    }
+
+    value = negative ? -result : result;
+    p = s;
+    return true;
+}
+
+template<class Integer>
+bool parseInteger(const char*& p, const char* end, Integer& value)
+{
+    const char* s = p;
+    bool negative = false;
+    if (s != end && (*s == '-' || *s == '+'))
+    {
+        negative = (*s == '-');
+        ++s;
+    }
+    if (negative && !std::numeric_limits<Integer>::is_signed)
+        return parseValue<Integer>(p, end, value);
+
+    std::uint64_t magnitude = 0;
+    int nbDigits = 0;
+    for (; s != end && isDigit(*s); ++s, ++nbDigits)
+    {
+        if (nbDigits == 18) // might overflow, let the standard library handle the limits
+            return parseValue<Integer>(p, end, value);
+        magnitude = magnitude * 10 + unsigned(*s - '0');
+    }
+    if (nbDigits == 0)
+        return parseValue<Integer>(p, end, value);
+
+    const std::uint64_t maxMagnitude = (std::uint64_t)std::numeric_limits<Integer>::max() + (negative ? 1 : 0);
+    if (magnitude > maxMagnitude)
+        return parseValue<Integer>(p, end, value);
+
+    if (negative)
+        value = (Integer)(-(std::int64_t)magnitude);
+    else
+        value = (Integer)magnitude;
+    p = s;
+    return true;
+}
+
+} // anonymous namespace
+
+bool parseValue(const char*& p, const char* end, float& value) { return parseReal(p, end, value); }
+bool parseValue(const char*& p, const char* end, double& value) { return parseReal(p, end, value); }
+bool parseValue(const char*& p, const char* end, short& value) { return parseInteger(p, end, value); }
+bool parseValue(const char*& p, const char* end, unsigned short& value) { return parseInteger(p, end, value); }
+bool parseValue(const char*& p, const char* end, int& value) { return parseInteger(p, end, value); }
+bool parseValue(const char*& p, const char* end, unsigned int& value) { return parseInteger(p, end, value); }
+bool parseValue(const char*& p, const char* end, long& value) { return parseInteger(p, end, value); }
+bool parseValue(const char*& p, const char* end, unsigned long& value) { return parseInteger(p, end, value); }
+bool parseValue(const char*& p, const char* end, long long& value) { return parseInteger(p, end, value); }
+bool parseValue(const char*& p, const char* end, unsigned long long& value) { return parseInteger(p, end, value); }
+
+} // namespace io
+
+} // namespace helper
+
+} // namespace sofa
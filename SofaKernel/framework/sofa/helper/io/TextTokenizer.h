@@ -0,0 +1,211 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_HELPER_IO_TEXTTOKENIZER_H
+#define SOFA_HELPER_IO_TEXTTOKENIZER_H
+
+#include <sofa/helper/helper.h>
+
+#include <istream>
+#include <locale>
+#include <streambuf>
+#include <string>
+
+namespace sofa
+{
+
+namespace helper
+{
+
+namespace io
+{
+
+/// Non-owning std::streambuf over a memory range, used to run operator>> on a buffer without copying it
+class MemoryStreamBuffer : public std::streambuf
+{
+public:
+    MemoryStreamBuffer(const char* begin, const char* end)
+    {
+        setg(const_cast<char*>(begin), const_cast<char*>(begin), const_cast<char*>(end));
+    }
+
+    const char* current() const { return gptr(); }
+};
+
+/// Parse a value at p with operator>> in the "C" locale, and advance p past it.
+template<class T>
+bool parseValue(const char*& p, const char* end, T& value)
+{
+    MemoryStreamBuffer buffer(p, end);
+    std::istream in(&buffer);
+    in.imbue(std::locale::classic());
+    if (!(in >> value))
+        return false;
+    p = buffer.current();
+    return true;
+}
+
+/// @{
+/// Fast locale-independent number parsing, with the same syntax and results as operator>>.
+/// Leading whitespace must already be skipped. Floating point values are converted
+/// directly when the decimal mantissa and exponent are small enough for the
+/// conversion to be exact (Clinger's fast path), which covers most mesh files,
+/// and fall back to operator>> otherwise.
+SOFA_HELPER_API bool parseValue(const char*& p, const char* end, float& value);
+SOFA_HELPER_API bool parseValue(const char*& p, const char* end, double& value);
+SOFA_HELPER_API bool parseValue(const char*& p, const char* end, short& value);
+SOFA_HELPER_API bool parseValue(const char*& p, const char* end, unsigned short& value);
+SOFA_HELPER_API bool parseValue(const char*& p, const char* end, int& value);
+SOFA_HELPER_API bool parseValue(const char*& p, const char* end, unsigned int& value);
+SOFA_HELPER_API bool parseValue(const char*& p, const char* end, long& value);
+SOFA_HELPER_API bool parseValue(const char*& p, const char* end, unsigned long& value);
+SOFA_HELPER_API bool parseValue(const char*& p, const char* end, long long& value);
+SOFA_HELPER_API bool parseValue(const char*& p, const char* end, unsigned long long& value);
+/// @}
+
+/** Cursor over a text held in memory (typically a MappedFile), used by the mesh
+ * loaders instead of reading the file line by line through std::istringstream.
+ *
+ * read() behaves like operator>> on a stream (whitespace and line breaks are skipped),
+ * while the *InLine methods stop at the end of the current line. operator>> is also
+ * provided, with the same sticky failure state as a stream.
+ */
+class TextTokenizer
+{
+public:
+    TextTokenizer(const char* begin, const char* end) : m_pos(begin), m_end(end), m_failed(false) {}
+
+    bool eof() const { return m_pos >= m_end; }
+    bool fail() const { return m_failed; }
+    explicit operator bool() const { return !m_failed; }
+    const char* position() const { return m_pos; }
+    const char* end() const { return m_end; }
+    void setPosition(const char* p) { m_pos = p; }
+
+    /// Skip spaces on the current line
+    void skipSpaces()
+    {
+        while (m_pos < m_end && isSpace(*m_pos))
+            ++m_pos;
+    }
+
+    /// Skip spaces and line breaks
+    void skipWhitespace()
+    {
+        while (m_pos < m_end && (isSpace(*m_pos) || *m_pos == '\n'))
+            ++m_pos;
+    }
+
+    /// Move to the beginning of the next line
+    void skipLine()
+    {
+        while (m_pos < m_end && *m_pos != '\n')
+            ++m_pos;
+        if (m_pos < m_end)
+            ++m_pos;
+    }
+
+    /// Skip spaces, and return true if nothing else remains on the current line
+    bool atEndOfLine()
+    {
+        skipSpaces();
+        return m_pos >= m_end || *m_pos == '\n';
+    }
+
+    /// Read the next word of the current line
+    bool nextWordInLine(const char*& wordBegin, const char*& wordEnd)
+    {
+        if (atEndOfLine())
+            return false;
+        wordBegin = m_pos;
+        while (m_pos < m_end && !isSpace(*m_pos) && *m_pos != '\n')
+            ++m_pos;
+        wordEnd = m_pos;
+        return true;
+    }
+
+    bool nextWordInLine(std::string& word)
+    {
+        const char* wordBegin;
+        const char* wordEnd;
+        if (!nextWordInLine(wordBegin, wordEnd))
+            return false;
+        word.assign(wordBegin, wordEnd);
+        return true;
+    }
+
+    /// Read the next word, possibly on a following line
+    bool read(std::string& word)
+    {
+        skipWhitespace();
+        return nextWordInLine(word);
+    }
+
+    /// Read the next value, possibly on a following line
+    template<class T>
+    bool read(T& value)
+    {
+        skipWhitespace();
+        return m_pos < m_end && parseValue(m_pos, m_end, value);
+    }
+
+    template<class T>
+    TextTokenizer& operator>>(T& value)
+    {
+        if (!m_failed && !read(value))
+            m_failed = true;
+        return *this;
+    }
+
+    /// Read the next value of the current line
+    template<class T>
+    bool readInLine(T& value)
+    {
+        return !atEndOfLine() && parseValue(m_pos, lineEnd(), value);
+    }
+
+    /// End of the current line (position of the '\n' or end of the buffer)
+    const char* lineEnd() const
+    {
+        const char* p = m_pos;
+        while (p < m_end && *p != '\n')
+            ++p;
+        return p;
+    }
+
+    static bool isSpace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+protected:
+    const char* m_pos;
+    const char* m_end;
+    bool m_failed;
+};
+
+} // namespace io
+
+} // namespace helper
+
+} // namespace sofa
+
+#endif
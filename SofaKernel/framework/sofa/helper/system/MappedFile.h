@@ -0,0 +1,77 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_HELPER_SYSTEM_MAPPEDFILE_H
+#define SOFA_HELPER_SYSTEM_MAPPEDFILE_H
+
+#include <sofa/helper/helper.h>
+
+#include <cstddef>
+#include <string>
+
+namespace sofa
+{
+namespace helper
+{
+namespace system
+{
+
+/// @brief Read-only memory mapping of a whole file.
+///
+/// The pages are shared by all the processes mapping the same file, and are
+/// only loaded from the disk when they are accessed.
+/// A file must be replaced by renaming a new file on it, not rewritten in
+/// place, while it is mapped.
+class SOFA_HELPER_API MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    /// @brief Map the file read-only, unmapping the previous one.
+    /// @return false if the file can not be opened or mapped
+    bool open(const std::string& filename);
+
+    void close();
+
+    bool isOpen() const { return m_data != nullptr; }
+
+    const char* data() const { return m_data; }
+
+    std::size_t size() const { return m_size; }
+
+private:
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+    const char* m_data;
+    std::size_t m_size;
+#ifdef WIN32
+    void* m_file;
+    void* m_mapping;
+#endif
+};
+
+} // namespace system
+} // namespace helper
+} // namespace sofa
+
+#endif
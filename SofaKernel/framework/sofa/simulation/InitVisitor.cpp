@@ -24,6 +24,7 @@
 #include <sofa/simulation/Simulation.h>
 #include <sofa/core/BaseMapping.h>
 #include <sofa/core/visual/VisualModel.h>
+#include <sofa/core/InitCache.h>
 #include <sofa/defaulttype/BoundingBox.h>
 
 //#include "MechanicalIntegration.h"
@@ -47,7 +48,7 @@ Visitor::Result InitVisitor::processNodeTopDown(simulation::Node* node)
 
     for(unsigned int i=0; i<node->object.size(); ++i)
     {
-        node->object[i]->init();
+        core::InitCache::getInstance()->initObject(node->object[i].get());
         node->object[i]->computeBBox(params, true);
         nodeBBox->include(node->object[i]->f_bbox.getValue(params));
     }
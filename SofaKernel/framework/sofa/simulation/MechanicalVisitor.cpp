@@ -686,6 +686,12 @@ Visitor::Result MechanicalVDotVisitor::fwdMechanicalState(VisitorContext* ctx, c
     return RESULT_CONTINUE;
 }
 
+Visitor::Result MechanicalVMultiOpDotVisitor::fwdMechanicalState(VisitorContext* ctx, core::behavior::BaseMechanicalState* mm)
+{
+    *ctx->nodeData += mm->vMultiOpDot(this->params, ops, a.getId(mm), b.getId(mm) );
+    return RESULT_CONTINUE;
+}
+
 Visitor::Result MechanicalVNormVisitor::fwdMechanicalState(VisitorContext* /*ctx*/, core::behavior::BaseMechanicalState* mm)
 {
     if( l>0 ) accum += mm->vSum(this->params, a.getId(mm), l );
@@ -1596,6 +1602,13 @@ std::string MechanicalVMultiOpVisitor::getInfos() const
     return out.str();
 }
 
+std::string MechanicalVMultiOpDotVisitor::getInfos() const
+{
+    std::string name = MechanicalVMultiOpVisitor(this->params, ops).getInfos();
+    name += " ;   v= a*b with a[" + a.getName() + "] and b[" + b.getName() + "]";
+    return name;
+}
+
 std::string MechanicalVNormVisitor::getInfos() const
 {
    std::string name("v= norm(a) with a[");
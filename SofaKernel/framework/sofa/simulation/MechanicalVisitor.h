@@ -88,6 +88,10 @@ public:
     virtual bool writeNodeData() const
     { return false; }
 
+    /// Reductions accumulate in the root data shared by all the nodes, so they are never traversed concurrently
+    bool canTraverseConcurrently() const override
+    { return isThreadSafe() && !writeNodeData(); }
+
     virtual void setNodeData(simulation::Node* /*node*/, SReal* nodeData, const SReal* parentData)
     {
         *nodeData = (parentData == nullptr) ? 0.0 : *parentData;
@@ -843,6 +847,60 @@ public:
 #endif
 };
 
+/** Perform a sequence of linear vector accumulation operations, then compute the dot product of two vectors,
+*  in a single traversal and, when the mechanical states support it, in a single pass over their entries.
+*
+*  This is used by iterative solvers to update their iterates and compute the norm of the residual at once.
+*  As for MechanicalVDotVisitor, mapped mechanical states are not processed.
+*/
+class SOFA_SIMULATION_CORE_API MechanicalVMultiOpDotVisitor : public BaseMechanicalVisitor
+{
+public:
+    typedef core::behavior::BaseMechanicalState::VMultiOp VMultiOp;
+    sofa::core::ConstMultiVecId a;
+    sofa::core::ConstMultiVecId b;
+    MechanicalVMultiOpDotVisitor(const sofa::core::ExecParams* params, const VMultiOp& o, sofa::core::ConstMultiVecId a, sofa::core::ConstMultiVecId b, SReal* t)
+        : BaseMechanicalVisitor(params), a(a), b(b), ops(o)
+    {
+#ifdef SOFA_DUMP_VISITOR_INFO
+        setReadWriteVectors();
+#endif
+        rootData = t;
+    }
+
+    Result fwdMechanicalState(VisitorContext* ctx, core::behavior::BaseMechanicalState* mm) override;
+
+    const char* getClassName() const override { return "MechanicalVMultiOpDotVisitor"; }
+    virtual std::string getInfos() const override;
+
+    /// Specify whether this action can be parallelized.
+    bool isThreadSafe() const override
+    {
+        return true;
+    }
+    bool writeNodeData() const override
+    {
+        return true;
+    }
+#ifdef SOFA_DUMP_VISITOR_INFO
+    void setReadWriteVectors() override
+    {
+        for (unsigned int i=0; i<ops.size(); ++i)
+        {
+            addWriteVector(ops[i].first);
+            for (unsigned int j=0; j<ops[i].second.size(); ++j)
+            {
+                addReadVector(ops[i].second[j].first);
+            }
+        }
+        addReadVector(a);
+        addReadVector(b);
+    }
+#endif
+protected:
+    VMultiOp ops;
+};
+
 /** Compute the norm of a vector.
  * The type of norm is set by parameter @a l. Use 0 for the infinite norm.
  * Note that the 2-norm is more efficiently computed using the square root of the dot product.
@@ -0,0 +1,165 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef ParallelFor_h__
+#define ParallelFor_h__
+
+#include <sofa/simulation/TaskScheduler.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+
+namespace sofa
+{
+    namespace simulation
+    {
+        
+        /** Task calling a function on a range of indices.
+         *  The range is split in halves, aligned on the grain size, until it fits in one grain:
+         *  the upper halves are queued as new tasks that other threads can steal.
+         */
+        template<class Function>
+        class ParallelForTask : public CpuTask
+        {
+        public:
+            
+            ParallelForTask(CpuTask::Status* status, TaskScheduler* scheduler, std::size_t first, std::size_t last, std::size_t grainSize, const Function* function, bool dynamic)
+            : CpuTask(status)
+            , m_scheduler(scheduler)
+            , m_first(first)
+            , m_last(last)
+            , m_grainSize(grainSize)
+            , m_function(function)
+            , m_dynamic(dynamic)
+            {}
+            
+            ~ParallelForTask() override {}
+            
+            MemoryAlloc run() final
+            {
+                while (m_last - m_first > m_grainSize)
+                {
+                    const std::size_t nbGrains = (m_last - m_first + m_grainSize - 1) / m_grainSize;
+                    const std::size_t middle = m_first + (nbGrains / 2) * m_grainSize;
+                    m_scheduler->addTask(new ParallelForTask(getStatus(), m_scheduler, middle, m_last, m_grainSize, m_function, true));
+                    m_last = middle;
+                }
+                
+                (*m_function)(m_first, m_last);
+                
+                return m_dynamic ? MemoryAlloc::Dynamic : MemoryAlloc::Stack;
+            }
+            
+        private:
+            
+            TaskScheduler* m_scheduler;
+            std::size_t m_first;
+            std::size_t m_last;
+            const std::size_t m_grainSize;
+            const Function* m_function;
+            const bool m_dynamic;
+        };
+        
+        
+        /** Call function(begin, end) on sub-ranges of [first, last) of at most grainSize indices, in parallel.
+         *  The sub-ranges start at first + k * grainSize.
+         *  The function must be thread-safe for disjoint sub-ranges.
+         *  Example:
+         *  @code
+         *  parallelFor(scheduler, 0, x.size(), 256, [&](std::size_t begin, std::size_t end)
+         *  {
+         *      for (std::size_t i = begin; i < end; ++i)
+         *          y[i] = 2 * x[i];
+         *  });
+         *  @endcode
+         */
+        template<class Function>
+        void parallelFor(TaskScheduler* scheduler, std::size_t first, std::size_t last, std::size_t grainSize, const Function& function)
+        {
+            if (first >= last)
+                return;
+            
+            grainSize = std::max<std::size_t>(grainSize, 1);
+            if (last - first <= grainSize || scheduler->getThreadCount() < 2)
+            {
+                function(first, last);
+                return;
+            }
+            
+            CpuTask::Status status;
+            ParallelForTask<Function> task(&status, scheduler, first, last, grainSize, &function, false);
+            scheduler->addTask(&task);
+            scheduler->workUntilDone(&status);
+        }
+        
+        /// parallelFor using the current task scheduler
+        template<class Function>
+        void parallelFor(std::size_t first, std::size_t last, std::size_t grainSize, const Function& function)
+        {
+            parallelFor(TaskScheduler::getInstance(), first, last, grainSize, function);
+        }
+        
+        
+        /** Reduce the range [first, last) split in chunks of grainSize indices.
+         *  Each chunk is reduced in parallel by function(begin, end, identity), which returns a T.
+         *  The results of the chunks are then combined in order by join(T, T), so that the result
+         *  does not depend on the number of threads, even for floating point sums.
+         */
+        template<class T, class Function, class Join>
+        T parallelReduce(TaskScheduler* scheduler, std::size_t first, std::size_t last, std::size_t grainSize, const T& identity, const Function& function, const Join& join)
+        {
+            if (first >= last)
+                return identity;
+            
+            grainSize = std::max<std::size_t>(grainSize, 1);
+            const std::size_t nbChunks = (last - first + grainSize - 1) / grainSize;
+            std::vector<T> chunkResults(nbChunks, identity);
+            
+            parallelFor(scheduler, 0, nbChunks, 1, [&](std::size_t firstChunk, std::size_t lastChunk)
+            {
+                for (std::size_t c = firstChunk; c < lastChunk; ++c)
+                {
+                    const std::size_t begin = first + c * grainSize;
+                    chunkResults[c] = function(begin, std::min(begin + grainSize, last), identity);
+                }
+            });
+            
+            T result = identity;
+            for (std::size_t c = 0; c < nbChunks; ++c)
+                result = join(result, chunkResults[c]);
+            return result;
+        }
+        
+        /// parallelReduce using the current task scheduler
+        template<class T, class Function, class Join>
+        T parallelReduce(std::size_t first, std::size_t last, std::size_t grainSize, const T& identity, const Function& function, const Join& join)
+        {
+            return parallelReduce(TaskScheduler::getInstance(), first, last, grainSize, identity, function, join);
+        }
+        
+        
+    } // namespace simulation
+    
+} // namespace sofa
+
+#endif // ParallelFor_h__
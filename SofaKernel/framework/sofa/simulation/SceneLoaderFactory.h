@@ -24,6 +24,7 @@
 
 #include <sofa/simulation/simulationcore.h>
 #include <sofa/simulation/Node.h>
+#include <sofa/core/InitCache.h>
 #include <sofa/helper/system/SetDirectory.h>
 
 
@@ -73,6 +74,10 @@ public:
         else
             notifyLoadingSceneBefore();
 
+        // the content of the scene file is mixed in the keys of the init cache
+        sofa::core::InitCache* initCache = sofa::core::InitCache::getInstance();
+        initCache->setSceneHash(initCache->isEnabled() ? sofa::core::InitCache::hashFile(filename) : 0);
+
         sofa::simulation::Node::SPtr root = doLoad(filename, sceneArgs);
 
         if(reload)
@@ -141,7 +141,8 @@ namespace sofa
                 
                 virtual bool isBusy() const override final
                 {
-                    return (m_busy.load(std::memory_order_relaxed) > 0);
+                    // acquire: the results of the finished tasks are visible to the thread waiting for them
+                    return (m_busy.load(std::memory_order_acquire) > 0);
                 }
                 
                 virtual int setBusy(bool busy) override final
@@ -152,7 +153,7 @@ namespace sofa
                     }
                     else
                     {
-                        return m_busy.fetch_sub(1, std::memory_order_relaxed);
+                        return m_busy.fetch_sub(1, std::memory_order_release);
                     }
                 }
                 
@@ -172,6 +172,11 @@ public:
     /// Specify whether this visitor can be parallelized.
     virtual bool isThreadSafe() const { return false; }
 
+    /// Specify whether independent sibling subtrees can be traversed concurrently by this visitor instance.
+    /// Used by the DAG traversal on the nodes where parallelTraversal is enabled.
+    /// Disabled by default: a visitor must be audited before it opts in, isThreadSafe() is not enough.
+    virtual bool canTraverseConcurrently() const { return false; }
+
     /// Callback method called when decending to a new node. Recursion will stop if this method returns RESULT_PRUNE
     /// This version is offered a LocalStorage to store temporary data
     virtual Result processNodeTopDown(simulation::Node* node, LocalStorage*) { return processNodeTopDown(node); }
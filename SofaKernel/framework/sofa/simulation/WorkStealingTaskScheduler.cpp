@@ -0,0 +1,446 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/simulation/WorkStealingTaskScheduler.h>
+
+#include <sofa/simulation/Locks.h>
+#include <sofa/helper/system/thread/thread_specific_ptr.h>
+
+#include <deque>
+#include <string>
+#include <cstddef>
+
+
+namespace sofa
+{
+
+	namespace simulation
+	{
+        
+        class WorkStealingWorker
+        {
+        public:
+            
+            enum
+            {
+                Max_FreeBlocks = 1024
+            };
+            
+            WorkStealingWorker(WorkStealingTaskScheduler* scheduler, const int index)
+            : m_name((index == 0 ? "Main  " : "Worker") + std::to_string(index))
+            , m_index(index)
+            , m_scheduler(scheduler)
+            , m_seed(2463534242u + 2654435761u * unsigned(index))
+            , m_freeBlocks(nullptr)
+            , m_freeBlockCount(0)
+            {
+            }
+            
+            ~WorkStealingWorker()
+            {
+                if (m_thread.joinable())
+                {
+                    m_thread.join();
+                }
+                while (m_freeBlocks)
+                {
+                    void* next = *static_cast<void**>(m_freeBlocks);
+                    ::operator delete(m_freeBlocks);
+                    m_freeBlocks = next;
+                }
+            }
+            
+            void pushTask(Task* task)
+            {
+                simulation::ScopedLock lock(m_taskMutex);
+                m_tasks.push_back(task);
+            }
+            
+            // the owner runs the most recent task
+            bool popTask(Task** task)
+            {
+                simulation::ScopedLock lock(m_taskMutex);
+                if (m_tasks.empty())
+                    return false;
+                *task = m_tasks.back();
+                m_tasks.pop_back();
+                return true;
+            }
+            
+            // thieves take the oldest task, which is usually the largest one
+            bool stealTask(Task** task)
+            {
+                simulation::ScopedLock lock(m_taskMutex);
+                if (m_tasks.empty())
+                    return false;
+                *task = m_tasks.front();
+                m_tasks.pop_front();
+                return true;
+            }
+            
+            // xorshift random number used to choose the stolen worker
+            unsigned random()
+            {
+                m_seed ^= m_seed << 13;
+                m_seed ^= m_seed >> 17;
+                m_seed ^= m_seed << 5;
+                return m_seed;
+            }
+            
+            const std::string m_name;
+            
+            const int m_index;
+            
+            WorkStealingTaskScheduler* const m_scheduler;
+            
+            std::thread m_thread;
+            
+            unsigned m_seed;
+            
+            simulation::SpinLock m_taskMutex;
+            
+            std::deque<Task*> m_tasks;
+            
+            // pool of task memory blocks, only accessed by the thread of the worker
+            void* m_freeBlocks;
+            
+            unsigned m_freeBlockCount;
+        };
+        
+        
+        // mac clang 3.5 doesn't support thread_local vars
+        SOFA_THREAD_SPECIFIC_PTR(WorkStealingWorker, currentWorker);
+        
+        
+        /** Task allocator using the free blocks of the current worker.
+         *  The blocks freed by another thread than the allocating one go to the pool of the freeing thread.
+         *  Each allocation is prefixed by a header telling if it comes from a pool,
+         *  so that the size given to free is not needed.
+         */
+        class PooledTaskAllocator : public Task::Allocator
+        {
+        public:
+            
+            enum
+            {
+                HeaderSize = alignof(std::max_align_t) < sizeof(void*) ? sizeof(void*) : alignof(std::max_align_t),
+                BlockSize = 256
+            };
+            
+            void* allocate(std::size_t sz) final
+            {
+                WorkStealingWorker* worker = currentWorker;
+                char* block;
+                if (sz + HeaderSize <= BlockSize)
+                {
+                    if (worker && worker->m_freeBlocks)
+                    {
+                        block = static_cast<char*>(worker->m_freeBlocks);
+                        worker->m_freeBlocks = *reinterpret_cast<void**>(block);
+                        --worker->m_freeBlockCount;
+                    }
+                    else
+                    {
+                        block = static_cast<char*>(::operator new(BlockSize));
+                    }
+                    *reinterpret_cast<std::size_t*>(block) = BlockSize;
+                }
+                else
+                {
+                    block = static_cast<char*>(::operator new(sz + HeaderSize));
+                    *reinterpret_cast<std::size_t*>(block) = 0;
+                }
+                return block + HeaderSize;
+            }
+            
+            void free(void* ptr, std::size_t sz) final
+            {
+                SOFA_UNUSED(sz);
+                if (!ptr)
+                    return;
+                
+                char* block = static_cast<char*>(ptr) - HeaderSize;
+                WorkStealingWorker* worker = currentWorker;
+                if (*reinterpret_cast<std::size_t*>(block) == BlockSize && worker && worker->m_freeBlockCount < WorkStealingWorker::Max_FreeBlocks)
+                {
+                    *reinterpret_cast<void**>(block) = worker->m_freeBlocks;
+                    worker->m_freeBlocks = block;
+                    ++worker->m_freeBlockCount;
+                }
+                else
+                {
+                    ::operator delete(block);
+                }
+            }
+        };
+        
+        static PooledTaskAllocator pooledTaskAllocator;
+        
+        
+        
+        WorkStealingTaskScheduler* WorkStealingTaskScheduler::create()
+        {
+            return new WorkStealingTaskScheduler();
+        }
+        
+        WorkStealingTaskScheduler::WorkStealingTaskScheduler()
+        : TaskScheduler()
+        , m_threadCount(1)
+        , m_isInitialized(false)
+        , m_isClosing(false)
+        , m_queuedTaskCount(0)
+        , m_sleepingWorkerCount(0)
+        {
+            m_workers.push_back(new WorkStealingWorker(this, 0));
+            currentWorker = m_workers[0];
+        }
+        
+        WorkStealingTaskScheduler::~WorkStealingTaskScheduler()
+        {
+            stop();
+            
+            if (currentWorker == m_workers[0])
+            {
+                currentWorker = nullptr;
+            }
+            delete m_workers[0];
+        }
+        
+        Task::Allocator* WorkStealingTaskScheduler::getTaskAllocator()
+        {
+            return &pooledTaskAllocator;
+        }
+        
+        void WorkStealingTaskScheduler::init(const unsigned int nbThread)
+        {
+            // default number of thread: only physicsal cores. no advantage from hyperthreading.
+            unsigned threadCount = std::thread::hardware_concurrency() / 2;
+            if (nbThread > 0)
+            {
+                threadCount = nbThread;
+            }
+            if (threadCount < 1)
+            {
+                threadCount = 1;
+            }
+            
+            if (m_isInitialized && threadCount == m_threadCount)
+            {
+                return;
+            }
+            stop();
+            
+            // the thread calling init becomes the main thread
+            currentWorker = m_workers[0];
+            
+            m_isClosing = false;
+            m_threadCount = threadCount;
+            for (unsigned i = 1; i < m_threadCount; ++i)
+            {
+                WorkStealingWorker* worker = new WorkStealingWorker(this, int(i));
+                m_workers.push_back(worker);
+            }
+            // start the threads once all the workers are created, as they may steal from each other
+            for (unsigned i = 1; i < m_threadCount; ++i)
+            {
+                WorkStealingWorker* worker = m_workers[i];
+                worker->m_thread = std::thread(&WorkStealingTaskScheduler::run, this, worker);
+            }
+            
+            m_isInitialized = true;
+        }
+        
+        void WorkStealingTaskScheduler::stop()
+        {
+            if (!m_isInitialized)
+            {
+                return;
+            }
+            
+            {
+                std::lock_guard<std::mutex> guard(m_wakeUpMutex);
+                m_isClosing = true;
+            }
+            m_wakeUpEvent.notify_all();
+            
+            // join all the threads before deleting the workers, as a running thread may still try to steal from them
+            for (std::size_t i = 1; i < m_workers.size(); ++i)
+            {
+                m_workers[i]->m_thread.join();
+            }
+            for (std::size_t i = 1; i < m_workers.size(); ++i)
+            {
+                delete m_workers[i];
+            }
+            m_workers.resize(1);
+            
+            m_threadCount = 1;
+            m_isInitialized = false;
+        }
+        
+        WorkStealingWorker* WorkStealingTaskScheduler::getCurrentWorker() const
+        {
+            WorkStealingWorker* worker = currentWorker;
+            if (worker && worker->m_scheduler == this)
+            {
+                return worker;
+            }
+            return nullptr;
+        }
+        
+        const char* WorkStealingTaskScheduler::getCurrentThreadName()
+        {
+            WorkStealingWorker* worker = getCurrentWorker();
+            return worker ? worker->m_name.c_str() : "";
+        }
+        
+        int WorkStealingTaskScheduler::getCurrentThreadType()
+        {
+            return 0;
+        }
+        
+        bool WorkStealingTaskScheduler::addTask(Task* task)
+        {
+            task->getStatus()->setBusy(true);
+            
+            WorkStealingWorker* worker = getCurrentWorker();
+            if (m_threadCount < 2 || worker == nullptr)
+            {
+                // we are single thread: run the task
+                runTask(task);
+                return false;
+            }
+            
+            worker->pushTask(task);
+            m_queuedTaskCount.fetch_add(1);
+            
+            // wake up sleeping workers
+            if (m_sleepingWorkerCount.load() > 0)
+            {
+                {
+                    std::lock_guard<std::mutex> guard(m_wakeUpMutex);
+                }
+                m_wakeUpEvent.notify_one();
+            }
+            return true;
+        }
+        
+        void WorkStealingTaskScheduler::workUntilDone(Task::Status* status)
+        {
+            WorkStealingWorker* worker = getCurrentWorker();
+            while (status->isBusy())
+            {
+                Task* task;
+                if (worker && getTask(worker, &task))
+                {
+                    runTask(task);
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            }
+        }
+        
+        bool WorkStealingTaskScheduler::getTask(WorkStealingWorker* worker, Task** task)
+        {
+            if (m_queuedTaskCount.load(std::memory_order_relaxed) == 0)
+            {
+                return false;
+            }
+            if (worker->popTask(task) || stealTask(worker, task))
+            {
+                m_queuedTaskCount.fetch_sub(1);
+                return true;
+            }
+            return false;
+        }
+        
+        bool WorkStealingTaskScheduler::stealTask(WorkStealingWorker* thief, Task** task)
+        {
+            const std::size_t workerCount = m_workers.size();
+            const std::size_t first = thief->random() % workerCount;
+            for (std::size_t i = 0; i < workerCount; ++i)
+            {
+                WorkStealingWorker* victim = m_workers[(first + i) % workerCount];
+                if (victim != thief && victim->stealTask(task))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+        
+        void WorkStealingTaskScheduler::runTask(Task* task)
+        {
+            Task::Status* status = task->getStatus();
+            if (task->run() & Task::MemoryAlloc::Dynamic)
+            {
+                // pooled memory: call destructor and free
+                delete task;
+            }
+            status->setBusy(false);
+        }
+        
+        void WorkStealingTaskScheduler::run(WorkStealingWorker* worker)
+        {
+            currentWorker = worker;
+            
+            while (!m_isClosing)
+            {
+                Task* task;
+                if (getTask(worker, &task))
+                {
+                    runTask(task);
+                }
+                else
+                {
+                    idle();
+                }
+            }
+            
+            currentWorker = nullptr;
+        }
+        
+        void WorkStealingTaskScheduler::idle()
+        {
+            enum { SpinCount = 64 };
+            
+            // short spin to catch the tasks of the next parallel loop without the cost of a wake up
+            for (int i = 0; i < SpinCount; ++i)
+            {
+                if (m_queuedTaskCount.load(std::memory_order_relaxed) > 0 || m_isClosing)
+                {
+                    return;
+                }
+                std::this_thread::yield();
+            }
+            
+            std::unique_lock<std::mutex> lock(m_wakeUpMutex);
+            m_sleepingWorkerCount.fetch_add(1);
+            // cpu free wait
+            m_wakeUpEvent.wait(lock, [&] { return m_queuedTaskCount.load() > 0 || m_isClosing; });
+            m_sleepingWorkerCount.fetch_sub(1);
+        }
+
+	} // namespace simulation
+
+} // namespace sofa
@@ -0,0 +1,126 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef WorkStealingTaskScheduler_h__
+#define WorkStealingTaskScheduler_h__
+
+#include <sofa/config.h>
+#include <sofa/helper/system/config.h>
+
+#include <sofa/simulation/TaskScheduler.h>
+
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+
+namespace sofa  {
+
+    namespace simulation
+    {
+        
+        class WorkStealingWorker;
+        
+        
+        /** Task scheduler where each thread owns a queue of tasks:
+         *  a thread runs the last task it queued (LIFO), and an idle thread steals the oldest task (FIFO)
+         *  of a randomly chosen thread. Idle threads spin a short time before sleeping.
+         *  Tasks allocated with new are taken from per-thread pools of fixed size blocks.
+         */
+        class SOFA_SIMULATION_CORE_API WorkStealingTaskScheduler : public TaskScheduler
+        {
+        public:
+            
+            // interface
+            
+            virtual void init(const unsigned int nbThread = 0) final;
+            virtual void stop(void) final;
+            virtual unsigned int getThreadCount(void)  const final { return m_threadCount; }
+            virtual const char* getCurrentThreadName() override final;
+            virtual int getCurrentThreadType() override final;
+            
+            // queue task if there is space, and run it otherwise
+            bool addTask(Task* task) override final;
+            void workUntilDone(Task::Status* status) override final;
+            Task::Allocator* getTaskAllocator() override final;
+            
+        public:
+            
+            // factory methods: name, creator function
+            static const char* name() { return "_workStealing"; }
+            
+            static WorkStealingTaskScheduler* create();
+            
+            static const bool isRegistered;
+            
+        private:
+            
+            WorkStealingTaskScheduler();
+            
+            WorkStealingTaskScheduler(const WorkStealingTaskScheduler&) = delete;
+            
+            ~WorkStealingTaskScheduler() override;
+            
+            WorkStealingWorker* getCurrentWorker() const;
+            
+            // pop a task from the queue of the worker or steal one from another worker
+            bool getTask(WorkStealingWorker* worker, Task** task);
+            
+            bool stealTask(WorkStealingWorker* thief, Task** task);
+            
+            void runTask(Task* task);
+            
+            // worker threads main loop
+            void run(WorkStealingWorker* worker);
+            
+            // spin, then sleep until some task is queued or the scheduler is stopped
+            void idle();
+            
+            
+        private:
+            
+            // m_workers[0] is the thread which created the scheduler
+            std::vector<WorkStealingWorker*> m_workers;
+            
+            unsigned m_threadCount;
+            
+            bool m_isInitialized;
+            
+            std::atomic<bool> m_isClosing;
+            
+            // number of tasks waiting in the queues
+            std::atomic<int> m_queuedTaskCount;
+            
+            std::atomic<int> m_sleepingWorkerCount;
+            
+            std::mutex m_wakeUpMutex;
+            
+            std::condition_variable m_wakeUpEvent;
+        };
+
+	} // namespace simulation
+
+} // namespace sofa
+
+
+#endif // WorkStealingTaskScheduler_h__
@@ -28,6 +28,8 @@
 #include <queue>
 #include <stack>
 #include <sofa/helper/AdvancedTimer.h>
+#include <sofa/simulation/TaskScheduler.h>
+#include <set>
 
 namespace sofa
 {
@@ -50,6 +52,7 @@ using namespace core::objectmodel;
 
 BruteForceDetection::BruteForceDetection()
     : box(initData(&box, "box", "if not empty, objects that do not intersect this bounding-box will be ignored"))
+    , d_parallel(initData(&d_parallel, false, "parallel", "if true, the narrow phase of the pairs of collision models is computed in parallel using the task scheduler"))
 {
 }
 
@@ -81,6 +84,17 @@ void BruteForceDetection::addCollisionModel(core::CollisionModel *cm)
     if (cm->empty())
         return;
 
+    if (!intersectsBox(cm))
+        return;
+
+    addSelfCollisionPair(cm);
+    for (sofa::helper::vector<core::CollisionModel*>::iterator it = collisionModels.begin(); it != collisionModels.end(); ++it)
+        addModelPair(cm, *it);
+    collisionModels.push_back(cm);
+}
+
+bool BruteForceDetection::intersectsBox(core::CollisionModel *cm)
+{
     if (boxModel)
     {
         bool swapModels = false;
@@ -92,10 +106,14 @@ void BruteForceDetection::addCollisionModel(core::CollisionModel *cm)
 
             // Here we assume a single root element is present in both models
             if (!intersector->canIntersect(cm1->begin(), cm2->begin()))
-                return;
+                return false;
         }
     }
+    return true;
+}
 
+void BruteForceDetection::addSelfCollisionPair(core::CollisionModel *cm)
+{
     if (cm->isSimulated() && cm->getLast()->canCollideWith(cm->getLast()))
     {
         // self collision
@@ -108,54 +126,52 @@ void BruteForceDetection::addCollisionModel(core::CollisionModel *cm)
             }
 
     }
-    for (sofa::helper::vector<core::CollisionModel*>::iterator it = collisionModels.begin(); it != collisionModels.end(); ++it)
-    {
-        core::CollisionModel* cm2 = *it;
+}
 
-        if (!cm->isSimulated() && !cm2->isSimulated())
-        {
-            continue;
-        }
+void BruteForceDetection::addModelPair(core::CollisionModel *cm, core::CollisionModel *cm2)
+{
+    if (!cm->isSimulated() && !cm2->isSimulated())
+    {
+        return;
+    }
 
-        if (!keepCollisionBetween(cm->getLast(), cm2->getLast()))
-            continue;
+    if (!keepCollisionBetween(cm->getLast(), cm2->getLast()))
+        return;
 
-        bool swapModels = false;
-        core::collision::ElementIntersector* intersector = intersectionMethod->findIntersector(cm, cm2, swapModels);
-        if (intersector == NULL)
-            continue;
+    bool swapModels = false;
+    core::collision::ElementIntersector* intersector = intersectionMethod->findIntersector(cm, cm2, swapModels);
+    if (intersector == NULL)
+        return;
 
-        core::CollisionModel* cm1 = (swapModels?cm2:cm);
-        cm2 = (swapModels?cm:cm2);
-
-        // // Here we assume multiple root elements are present in both models
-        // bool collisionDetected = false;
-        // core::CollisionElementIterator begin1 = cm->begin();
-        // core::CollisionElementIterator end1 = cm->end();
-        // core::CollisionElementIterator begin2 = cm2->begin();
-        // core::CollisionElementIterator end2 = cm2->end();
-        // for (core::CollisionElementIterator it1 = begin1; it1 != end1; ++it1)
-        // {
-        //     for (core::CollisionElementIterator it2 = begin2; it2 != end2; ++it2)
-        //     {
-        //         //if (!it1->canCollideWith(it2)) continue;
-        //         if (intersector->canIntersect(it1, it2))
-        //         {
-        //             collisionDetected = true;
-        //             break;
-        //         }
-        //     }
-        //     if (collisionDetected) break;
-        // }
-        // if (collisionDetected)
-
-        // Here we assume a single root element is present in both models
-        if (intersector->canIntersect(cm1->begin(), cm2->begin()))
-        {
-            cmPairs.push_back(std::make_pair(cm1, cm2));
-        }
+    core::CollisionModel* cm1 = (swapModels?cm2:cm);
+    cm2 = (swapModels?cm:cm2);
+
+    // // Here we assume multiple root elements are present in both models
+    // bool collisionDetected = false;
+    // core::CollisionElementIterator begin1 = cm->begin();
+    // core::CollisionElementIterator end1 = cm->end();
+    // core::CollisionElementIterator begin2 = cm2->begin();
+    // core::CollisionElementIterator end2 = cm2->end();
+    // for (core::CollisionElementIterator it1 = begin1; it1 != end1; ++it1)
+    // {
+    //     for (core::CollisionElementIterator it2 = begin2; it2 != end2; ++it2)
+    //     {
+    //         //if (!it1->canCollideWith(it2)) continue;
+    //         if (intersector->canIntersect(it1, it2))
+    //         {
+    //             collisionDetected = true;
+    //             break;
+    //         }
+    //     }
+    //     if (collisionDetected) break;
+    // }
+    // if (collisionDetected)
+
+    // Here we assume a single root element is present in both models
+    if (intersector->canIntersect(cm1->begin(), cm2->begin()))
+    {
+        cmPairs.push_back(std::make_pair(cm1, cm2));
     }
-    collisionModels.push_back(cm);
 }
 
 
@@ -172,28 +188,83 @@ bool BruteForceDetection::keepCollisionBetween(core::CollisionModel *cm1, core::
 
 
 void BruteForceDetection::addCollisionPair(const std::pair<core::CollisionModel*, core::CollisionModel*>& cmPair)
-{    
-    typedef std::pair< std::pair<core::CollisionElementIterator,core::CollisionElementIterator>, std::pair<core::CollisionElementIterator,core::CollisionElementIterator> > TestPair;
+{
+    NarrowPhasePair pair;
+    if (!initCollisionPair(cmPair, pair))
+        return;
+
+    std::string msg = "BruteForceDetection addCollisionPair: " + pair.finalcm1->getName() + " - " + pair.finalcm2->getName();
+    sofa::helper::ScopedAdvancedTimer bfTimer(msg);
+
+    beginCollisionPair(pair);
+    intersectCollisionPair(pair, false);
+}
+
+void BruteForceDetection::addCollisionPairs(const sofa::helper::vector< std::pair<core::CollisionModel*, core::CollisionModel*> >& v)
+{
+    if (!d_parallel.getValue())
+    {
+        core::collision::NarrowPhaseDetection::addCollisionPairs(v);
+        return;
+    }
+
+    sofa::helper::ScopedAdvancedTimer bfTimer("BruteForceDetection parallel addCollisionPairs");
+
+    // the outputs are created sequentially, then each pair writing in its own outputs is processed by a task.
+    // Pairs sharing the outputs of an already dispatched pair are processed sequentially afterwards.
+    std::vector<NarrowPhasePair> pairs;
+    sofa::helper::vector< std::pair<core::CollisionModel*, core::CollisionModel*> > sequentialPairs;
+    std::set< std::pair<core::CollisionModel*, core::CollisionModel*> > dispatchedOutputs;
+    pairs.reserve(v.size());
+    for (const auto& cmPair : v)
+    {
+        NarrowPhasePair pair;
+        if (!initCollisionPair(cmPair, pair))
+            continue;
+        if (!dispatchedOutputs.insert(std::make_pair(pair.finalcm1, pair.finalcm2)).second)
+        {
+            sequentialPairs.push_back(cmPair);
+            continue;
+        }
+        beginCollisionPair(pair);
+        pairs.push_back(pair);
+    }
+
+    simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+    simulation::CpuTask::Status status;
 
+    std::vector<NarrowPhaseTask> tasks;
+    tasks.reserve(pairs.size());
+    for (const NarrowPhasePair& pair : pairs)
+        tasks.emplace_back(&status, this, pair);
+    for (NarrowPhaseTask& task : tasks)
+        scheduler->addTask(&task);
+    scheduler->workUntilDone(&status);
+
+    for (const auto& cmPair : sequentialPairs)
+        addCollisionPair(cmPair);
+
+    m_primitiveTestCount = m_outputsMap.size();
+}
+
+bool BruteForceDetection::initCollisionPair(const std::pair<core::CollisionModel*, core::CollisionModel*>& cmPair, NarrowPhasePair& pair)
+{
     core::CollisionModel *cm1 = cmPair.first; //->getNext();
     core::CollisionModel *cm2 = cmPair.second; //->getNext();
 
     if (!cm1->isSimulated() && !cm2->isSimulated())
-        return;
+        return false;
 
     if (cm1->empty() || cm2->empty())
-        return;
+        return false;
 
     core::CollisionModel *finalcm1 = cm1->getLast();//get the finnest CollisionModel which is not a CubeModel
     core::CollisionModel *finalcm2 = cm2->getLast();
 
-    std::string msg = "BruteForceDetection addCollisionPair: " + finalcm1->getName() + " - " + finalcm2->getName();
-    sofa::helper::ScopedAdvancedTimer bfTimer(msg);
-    
     bool swapModels = false;
     core::collision::ElementIntersector* finalintersector = intersectionMethod->findIntersector(finalcm1, finalcm2, swapModels);//find the method for the finnest CollisionModels
     if (finalintersector == NULL)
-        return;
+        return false;
     if (swapModels)
     {
         core::CollisionModel* tmp;
@@ -201,13 +272,36 @@ void BruteForceDetection::addCollisionPair(const std::pair<core::CollisionModel*
         tmp = finalcm1; finalcm1 = finalcm2; finalcm2 = tmp;
     }
 
-    const bool self = (finalcm1->getContext() == finalcm2->getContext());
-    //if (self)
-    //    sout << "SELF: Final intersector " << finalintersector->name() << " for "<<finalcm1->getName()<<" - "<<finalcm2->getName()<<sendl;
+    pair.cm1 = cm1;
+    pair.cm2 = cm2;
+    pair.finalcm1 = finalcm1;
+    pair.finalcm2 = finalcm2;
+    pair.finalintersector = finalintersector;
+    pair.self = (finalcm1->getContext() == finalcm2->getContext());
+    pair.outputs = NULL;
+    return true;
+}
+
+void BruteForceDetection::beginCollisionPair(NarrowPhasePair& pair)
+{
+    sofa::core::collision::DetectionOutputVector*& outputs = this->getDetectionOutputs(pair.finalcm1, pair.finalcm2);
+
+    pair.finalintersector->beginIntersect(pair.finalcm1, pair.finalcm2, outputs);//creates outputs if null
+    pair.outputs = outputs;
+}
 
-    sofa::core::collision::DetectionOutputVector*& outputs = this->getDetectionOutputs(finalcm1, finalcm2);
+void BruteForceDetection::intersectCollisionPair(NarrowPhasePair pair, bool lockIntersectors)
+{
+    typedef std::pair< std::pair<core::CollisionElementIterator,core::CollisionElementIterator>, std::pair<core::CollisionElementIterator,core::CollisionElementIterator> > TestPair;
 
-    finalintersector->beginIntersect(finalcm1, finalcm2, outputs);//creates outputs if null
+    core::CollisionModel *cm1 = pair.cm1;
+    core::CollisionModel *cm2 = pair.cm2;
+    core::CollisionModel *finalcm1 = pair.finalcm1;
+    core::CollisionModel *finalcm2 = pair.finalcm2;
+    core::collision::ElementIntersector* finalintersector = pair.finalintersector;
+    const bool self = pair.self;
+    sofa::core::collision::DetectionOutputVector* outputs = pair.outputs;
+    bool swapModels = false;
 
     if (finalcm1 == cm1 || finalcm2 == cm2)
     {
@@ -255,7 +349,13 @@ void BruteForceDetection::addCollisionPair(const std::pair<core::CollisionModel*
             cm1 = root.first.first.getCollisionModel();
             cm2 = root.second.first.getCollisionModel();
             if (!cm1 || !cm2) continue;
-            intersector = intersectionMethod->findIntersector(cm1, cm2, swapModels);
+            if (lockIntersectors)
+            {
+                std::lock_guard<std::mutex> lock(m_intersectorMutex);
+                intersector = intersectionMethod->findIntersector(cm1, cm2, swapModels);
+            }
+            else
+                intersector = intersectionMethod->findIntersector(cm1, cm2, swapModels);
 
             if (intersector == NULL)
             {
@@ -397,6 +497,19 @@ void BruteForceDetection::addCollisionPair(const std::pair<core::CollisionModel*
     }
 }
 
+BruteForceDetection::NarrowPhaseTask::NarrowPhaseTask(simulation::CpuTask::Status* status, BruteForceDetection* detection, const NarrowPhasePair& pair)
+    : CpuTask(status)
+    , m_detection(detection)
+    , m_pair(pair)
+{
+}
+
+simulation::Task::MemoryAlloc BruteForceDetection::NarrowPhaseTask::run()
+{
+    m_detection->intersectCollisionPair(m_pair, true);
+    return MemoryAlloc::Stack;
+}
+
 } // namespace collision
 
 } // namespace component
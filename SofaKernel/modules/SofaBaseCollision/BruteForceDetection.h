@@ -28,6 +28,8 @@
 #include <sofa/core/CollisionElement.h>
 #include <SofaBaseCollision/CubeModel.h>
 #include <sofa/defaulttype/Vec.h>
+#include <sofa/simulation/Task.h>
+#include <mutex>
 
 
 namespace sofa
@@ -87,12 +89,56 @@ public:
 
 private:
     bool _is_initialized;
+
+protected:
     sofa::helper::vector<core::CollisionModel*> collisionModels;
 
     Data< helper::fixed_array<sofa::defaulttype::Vector3,2> > box; ///< if not empty, objects that do not intersect this bounding-box will be ignored
 
     CubeModel::SPtr boxModel;
 
+public:
+    Data< bool > d_parallel; ///< if true, the pairs of collision models are processed in parallel using the task scheduler
+
+protected:
+    /// Models and intersector used to compute the narrow phase of a pair of collision models
+    struct NarrowPhasePair
+    {
+        core::CollisionModel* cm1;
+        core::CollisionModel* cm2;
+        core::CollisionModel* finalcm1; ///< finest collision model of the first hierarchy
+        core::CollisionModel* finalcm2; ///< finest collision model of the second hierarchy
+        core::collision::ElementIntersector* finalintersector;
+        bool self;
+        core::collision::DetectionOutputVector* outputs;
+    };
+
+    /// Task computing the narrow phase of one pair of collision models
+    class NarrowPhaseTask : public simulation::CpuTask
+    {
+    public:
+        NarrowPhaseTask(simulation::CpuTask::Status* status, BruteForceDetection* detection, const NarrowPhasePair& pair);
+        ~NarrowPhaseTask() override {}
+        MemoryAlloc run() override;
+
+    private:
+        BruteForceDetection* m_detection;
+        NarrowPhasePair m_pair;
+    };
+
+    /// Find the final models and intersector of a pair. Return false if the pair does not need to be tested.
+    bool initCollisionPair(const std::pair<core::CollisionModel*, core::CollisionModel*>& cmPair, NarrowPhasePair& pair);
+
+    /// Create the outputs of a pair. Not thread-safe as it modifies the outputs map.
+    void beginCollisionPair(NarrowPhasePair& pair);
+
+    /// Traverse the bounding trees of a pair and write the contacts in its outputs.
+    /// If lockIntersectors is true, the intersector lookups are protected so that several pairs can be processed concurrently.
+    void intersectCollisionPair(NarrowPhasePair pair, bool lockIntersectors);
+
+    /// Protects the intersector lookups, which may modify the intersector map, in parallel mode
+    std::mutex m_intersectorMutex;
+
 
 protected:
     BruteForceDetection();
@@ -101,6 +147,13 @@ protected:
 
     virtual bool keepCollisionBetween(core::CollisionModel *cm1, core::CollisionModel *cm2);
 
+    /// Return false if the root of the model does not intersect the bounding-box given in the box Data
+    bool intersectsBox(core::CollisionModel *cm);
+    /// Add the self-collision pair of a model if its root can intersect itself
+    void addSelfCollisionPair(core::CollisionModel *cm);
+    /// Add the pair formed by a new model and a previously added one if their roots can intersect
+    void addModelPair(core::CollisionModel *cm, core::CollisionModel *cm2);
+
 public:
 
     void init() override;
@@ -108,6 +161,7 @@ public:
 
     void addCollisionModel (core::CollisionModel *cm) override;
     void addCollisionPair (const std::pair<core::CollisionModel*, core::CollisionModel*>& cmPair) override;
+    void addCollisionPairs (const sofa::helper::vector< std::pair<core::CollisionModel*, core::CollisionModel*> >& v) override;
 
     void beginBroadPhase() override
     {
@@ -0,0 +1,508 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaBaseCollision/DynamicAABBTreeDetection.h>
+#include <sofa/core/ObjectFactory.h>
+#include <sofa/helper/AdvancedTimer.h>
+#include <algorithm>
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace collision
+{
+
+using namespace sofa::defaulttype;
+
+int DynamicAABBTreeDetectionClass = core::RegisterObject("Collision detection using a persistent dynamic AABB tree of the collision models bounding boxes")
+        .add< DynamicAABBTreeDetection >()
+        ;
+
+namespace
+{
+
+void unionBox(const Vector3& min1, const Vector3& max1, const Vector3& min2, const Vector3& max2, Vector3& minBBox, Vector3& maxBBox)
+{
+    for (int c=0; c<3; ++c)
+    {
+        minBBox[c] = std::min(min1[c], min2[c]);
+        maxBBox[c] = std::max(max1[c], max2[c]);
+    }
+}
+
+/// Half of the area of the surface of a box, used as the cost of a node
+SReal boxCost(const Vector3& minBBox, const Vector3& maxBBox)
+{
+    const Vector3 l = maxBBox - minBBox;
+    return l[0]*l[1] + l[1]*l[2] + l[2]*l[0];
+}
+
+SReal unionCost(const Vector3& min1, const Vector3& max1, const Vector3& min2, const Vector3& max2)
+{
+    Vector3 minBBox, maxBBox;
+    unionBox(min1, max1, min2, max2, minBBox, maxBBox);
+    return boxCost(minBBox, maxBBox);
+}
+
+bool containsBox(const Vector3& min1, const Vector3& max1, const Vector3& min2, const Vector3& max2)
+{
+    for (int c=0; c<3; ++c)
+        if (min2[c] < min1[c] || max2[c] > max1[c])
+            return false;
+    return true;
+}
+
+bool overlapBox(const Vector3& min1, const Vector3& max1, const Vector3& min2, const Vector3& max2)
+{
+    for (int c=0; c<3; ++c)
+        if (min1[c] > max2[c] || min2[c] > max1[c])
+            return false;
+    return true;
+}
+
+} // namespace
+
+DynamicAABBTreeDetection::DynamicAABBTreeDetection()
+    : d_marginRatio(initData(&d_marginRatio, (SReal)0.1, "marginRatio", "margin added around the box of each model in the tree, relative to the diagonal of the box. A model is only re-inserted in the tree when it moves out of its margin"))
+    , m_root(-1)
+    , m_nbReinsertedLeaves(0)
+    , m_nbQueries(0)
+    , m_overlapsAlarmDistance(-1)
+{
+}
+
+DynamicAABBTreeDetection::~DynamicAABBTreeDetection()
+{
+}
+
+bool DynamicAABBTreeDetection::getRootBox(core::CollisionModel* cm, Vector3& minBBox, Vector3& maxBBox)
+{
+    CubeModel* cubeModel = dynamic_cast<CubeModel*>(cm);
+    if (cubeModel == NULL || cubeModel->empty())
+        return false;
+
+    Cube cube(cubeModel, 0);
+    minBBox = cube.minVect();
+    maxBBox = cube.maxVect();
+    for (++cube; cube != Cube(cubeModel->end()); ++cube)
+        unionBox(minBBox, maxBBox, cube.minVect(), cube.maxVect(), minBBox, maxBBox);
+    return true;
+}
+
+int DynamicAABBTreeDetection::allocateNode()
+{
+    int index;
+    if (m_freeNodes.empty())
+    {
+        index = (int)m_nodes.size();
+        m_nodes.resize(m_nodes.size()+1);
+        m_overlaps.resize(m_nodes.size());
+    }
+    else
+    {
+        index = m_freeNodes.back();
+        m_freeNodes.pop_back();
+    }
+    TreeNode& node = m_nodes[index];
+    node.parent = -1;
+    node.child1 = -1;
+    node.child2 = -1;
+    node.height = 0;
+    node.model = NULL;
+    node.order = -1;
+    m_overlaps[index].clear();
+    return index;
+}
+
+void DynamicAABBTreeDetection::freeNode(int index)
+{
+    m_nodes[index].model = NULL;
+    m_nodes[index].height = -1;
+    m_freeNodes.push_back(index);
+}
+
+void DynamicAABBTreeDetection::insertLeaf(int leaf)
+{
+    if (m_root < 0)
+    {
+        m_root = leaf;
+        m_nodes[leaf].parent = -1;
+        return;
+    }
+
+    // Find the best sibling, minimizing the total area of the boxes created or enlarged by the insertion
+    const Vector3 leafMin = m_nodes[leaf].minBBox;
+    const Vector3 leafMax = m_nodes[leaf].maxBBox;
+    int index = m_root;
+    while (m_nodes[index].child1 >= 0)
+    {
+        const TreeNode& node = m_nodes[index];
+        const SReal area = boxCost(node.minBBox, node.maxBBox);
+        const SReal combinedArea = unionCost(node.minBBox, node.maxBBox, leafMin, leafMax);
+
+        // Cost of creating a new parent for this node and the leaf
+        const SReal cost = 2*combinedArea;
+        // Minimum cost of pushing the leaf further down the tree
+        const SReal inheritanceCost = 2*(combinedArea - area);
+
+        SReal childCosts[2];
+        const int children[2] = { node.child1, node.child2 };
+        for (int c=0; c<2; ++c)
+        {
+            const TreeNode& child = m_nodes[children[c]];
+            childCosts[c] = unionCost(child.minBBox, child.maxBBox, leafMin, leafMax) + inheritanceCost;
+            if (child.child1 >= 0)
+                childCosts[c] -= boxCost(child.minBBox, child.maxBBox);
+        }
+
+        if (cost < childCosts[0] && cost < childCosts[1])
+            break;
+        index = (childCosts[0] < childCosts[1]) ? children[0] : children[1];
+    }
+
+    // Create a new parent for the sibling and the leaf
+    const int sibling = index;
+    const int oldParent = m_nodes[sibling].parent;
+    const int newParent = allocateNode();
+    TreeNode& parent = m_nodes[newParent];
+    parent.parent = oldParent;
+    parent.child1 = sibling;
+    parent.child2 = leaf;
+    parent.height = m_nodes[sibling].height + 1;
+    unionBox(leafMin, leafMax, m_nodes[sibling].minBBox, m_nodes[sibling].maxBBox, parent.minBBox, parent.maxBBox);
+
+    if (oldParent >= 0)
+    {
+        if (m_nodes[oldParent].child1 == sibling)
+            m_nodes[oldParent].child1 = newParent;
+        else
+            m_nodes[oldParent].child2 = newParent;
+    }
+    else
+    {
+        m_root = newParent;
+    }
+    m_nodes[sibling].parent = newParent;
+    m_nodes[leaf].parent = newParent;
+
+    refitAncestors(m_nodes[leaf].parent);
+}
+
+void DynamicAABBTreeDetection::removeLeaf(int leaf)
+{
+    if (leaf == m_root)
+    {
+        m_root = -1;
+        return;
+    }
+
+    const int parent = m_nodes[leaf].parent;
+    const int grandParent = m_nodes[parent].parent;
+    const int sibling = (m_nodes[parent].child1 == leaf) ? m_nodes[parent].child2 : m_nodes[parent].child1;
+
+    freeNode(parent);
+    m_nodes[leaf].parent = -1;
+    m_nodes[sibling].parent = grandParent;
+    if (grandParent >= 0)
+    {
+        // Replace the parent by the sibling and update the ancestors
+        if (m_nodes[grandParent].child1 == parent)
+            m_nodes[grandParent].child1 = sibling;
+        else
+            m_nodes[grandParent].child2 = sibling;
+        refitAncestors(grandParent);
+    }
+    else
+    {
+        m_root = sibling;
+    }
+}
+
+void DynamicAABBTreeDetection::refitAncestors(int index)
+{
+    while (index >= 0)
+    {
+        index = balance(index);
+
+        TreeNode& node = m_nodes[index];
+        const TreeNode& child1 = m_nodes[node.child1];
+        const TreeNode& child2 = m_nodes[node.child2];
+        node.height = 1 + std::max(child1.height, child2.height);
+        unionBox(child1.minBBox, child1.maxBBox, child2.minBBox, child2.maxBBox, node.minBBox, node.maxBBox);
+
+        index = node.parent;
+    }
+}
+
+int DynamicAABBTreeDetection::balance(int iA)
+{
+    TreeNode& A = m_nodes[iA];
+    if (A.child1 < 0 || A.height < 2)
+        return iA;
+
+    const int iB = A.child1;
+    const int iC = A.child2;
+    TreeNode& B = m_nodes[iB];
+    TreeNode& C = m_nodes[iC];
+    const int balanceFactor = C.height - B.height;
+
+    // Rotate the highest child up, the lowest of its own children taking its place under A
+    if (balanceFactor > 1 || balanceFactor < -1)
+    {
+        const bool rotateC = (balanceFactor > 1);
+        const int iUp = rotateC ? iC : iB;
+        const int iKept = rotateC ? iB : iC;
+        TreeNode& up = m_nodes[iUp];
+        const int iF = up.child1;
+        const int iG = up.child2;
+        TreeNode& F = m_nodes[iF];
+        TreeNode& G = m_nodes[iG];
+
+        // Swap A and its child
+        up.child1 = iA;
+        up.parent = A.parent;
+        A.parent = iUp;
+        if (up.parent >= 0)
+        {
+            if (m_nodes[up.parent].child1 == iA)
+                m_nodes[up.parent].child1 = iUp;
+            else
+                m_nodes[up.parent].child2 = iUp;
+        }
+        else
+        {
+            m_root = iUp;
+        }
+
+        // The highest grandchild stays under the rotated node, the other one is given to A
+        const int iHigh = (F.height > G.height) ? iF : iG;
+        const int iLow = (F.height > G.height) ? iG : iF;
+        up.child2 = iHigh;
+        if (rotateC)
+            A.child2 = iLow;
+        else
+            A.child1 = iLow;
+        m_nodes[iLow].parent = iA;
+
+        const TreeNode& kept = m_nodes[iKept];
+        const TreeNode& low = m_nodes[iLow];
+        const TreeNode& high = m_nodes[iHigh];
+        unionBox(kept.minBBox, kept.maxBBox, low.minBBox, low.maxBBox, A.minBBox, A.maxBBox);
+        unionBox(A.minBBox, A.maxBBox, high.minBBox, high.maxBBox, up.minBBox, up.maxBBox);
+        A.height = 1 + std::max(kept.height, low.height);
+        up.height = 1 + std::max(A.height, high.height);
+        return iUp;
+    }
+
+    return iA;
+}
+
+void DynamicAABBTreeDetection::queryTree(const Vector3& minBBox, const Vector3& maxBBox)
+{
+    if (m_root < 0)
+        return;
+
+    m_queryStack.clear();
+    m_queryStack.push_back(m_root);
+    while (!m_queryStack.empty())
+    {
+        const int index = m_queryStack.back();
+        const TreeNode& node = m_nodes[index];
+        m_queryStack.pop_back();
+
+        if (!overlapBox(node.minBBox, node.maxBBox, minBBox, maxBBox))
+            continue;
+
+        if (node.child1 < 0)
+        {
+            m_candidates.push_back(index);
+        }
+        else
+        {
+            m_queryStack.push_back(node.child1);
+            m_queryStack.push_back(node.child2);
+        }
+    }
+}
+
+void DynamicAABBTreeDetection::clearOverlaps(int leaf)
+{
+    for (std::set<int>::const_iterator it = m_overlaps[leaf].begin(); it != m_overlaps[leaf].end(); ++it)
+        m_overlaps[*it].erase(leaf);
+    m_overlaps[leaf].clear();
+}
+
+void DynamicAABBTreeDetection::updateTree()
+{
+    m_nbReinsertedLeaves = 0;
+    m_nbQueries = 0;
+    m_unboundedModels.clear();
+    m_updatedLeaves.clear();
+    m_orderLeaves.assign(collisionModels.size(), -1);
+
+    for (std::map<core::CollisionModel*, int>::iterator it = m_leaves.begin(); it != m_leaves.end(); ++it)
+        m_nodes[it->second].order = -1;
+
+    const SReal marginRatio = d_marginRatio.getValue();
+    for (int i=0; i<(int)collisionModels.size(); ++i)
+    {
+        core::CollisionModel* cm = collisionModels[i];
+        Vector3 minBBox, maxBBox;
+        if (!getRootBox(cm, minBBox, maxBBox))
+        {
+            m_unboundedModels.push_back(i);
+            continue;
+        }
+
+        std::map<core::CollisionModel*, int>::iterator it = m_leaves.find(cm);
+        int leaf;
+        if (it == m_leaves.end())
+        {
+            leaf = allocateNode();
+            m_nodes[leaf].model = cm;
+            m_leaves[cm] = leaf;
+        }
+        else
+        {
+            leaf = it->second;
+            if (containsBox(m_nodes[leaf].minBBox, m_nodes[leaf].maxBBox, minBBox, maxBBox))
+            {
+                m_nodes[leaf].order = i;
+                m_orderLeaves[i] = leaf;
+                continue;
+            }
+            // The model moved out of its margin
+            removeLeaf(leaf);
+            ++m_nbReinsertedLeaves;
+        }
+
+        const SReal margin = marginRatio * (maxBBox - minBBox).norm();
+        m_nodes[leaf].minBBox = minBBox - Vector3(margin, margin, margin);
+        m_nodes[leaf].maxBBox = maxBBox + Vector3(margin, margin, margin);
+        m_nodes[leaf].order = i;
+        m_orderLeaves[i] = leaf;
+        insertLeaf(leaf);
+        m_updatedLeaves.push_back(leaf);
+    }
+
+    // Remove the models which were not added in this step
+    for (std::map<core::CollisionModel*, int>::iterator it = m_leaves.begin(); it != m_leaves.end(); )
+    {
+        if (m_nodes[it->second].order < 0)
+        {
+            clearOverlaps(it->second);
+            removeLeaf(it->second);
+            freeNode(it->second);
+            m_leaves.erase(it++);
+        }
+        else
+            ++it;
+    }
+
+    // The overlaps of the leaves which did not move are still valid, unless the alarm distance changed
+    const SReal alarmDist = intersectionMethod->getAlarmDistance();
+    if (alarmDist != m_overlapsAlarmDistance)
+    {
+        m_overlapsAlarmDistance = alarmDist;
+        m_updatedLeaves.clear();
+        for (std::map<core::CollisionModel*, int>::iterator it = m_leaves.begin(); it != m_leaves.end(); ++it)
+            m_updatedLeaves.push_back(it->second);
+    }
+
+    for (std::size_t l=0; l<m_updatedLeaves.size(); ++l)
+        clearOverlaps(m_updatedLeaves[l]);
+
+    const Vector3 alarm(alarmDist, alarmDist, alarmDist);
+    for (std::size_t l=0; l<m_updatedLeaves.size(); ++l)
+    {
+        const int leaf = m_updatedLeaves[l];
+        m_candidates.clear();
+        queryTree(m_nodes[leaf].minBBox - alarm, m_nodes[leaf].maxBBox + alarm);
+        ++m_nbQueries;
+        for (std::size_t c=0; c<m_candidates.size(); ++c)
+        {
+            if (m_candidates[c] == leaf)
+                continue;
+            m_overlaps[leaf].insert(m_candidates[c]);
+            m_overlaps[m_candidates[c]].insert(leaf);
+        }
+    }
+}
+
+void DynamicAABBTreeDetection::addCollisionModel(core::CollisionModel *cm)
+{
+    if (cm->empty())
+        return;
+
+    if (!intersectsBox(cm))
+        return;
+
+    collisionModels.push_back(cm);
+}
+
+void DynamicAABBTreeDetection::endBroadPhase()
+{
+    sofa::helper::ScopedAdvancedTimer treeTimer("DynamicAABBTreeDetection");
+
+    updateTree();
+
+    // The pairs are added in the same order as in BruteForceDetection: for each model, its self-collision
+    // pair, then the pairs with the models added before it
+    for (int i=0; i<(int)collisionModels.size(); ++i)
+    {
+        core::CollisionModel* cm = collisionModels[i];
+        addSelfCollisionPair(cm);
+
+        m_candidates.clear();
+        const int leaf = m_orderLeaves[i];
+        if (leaf >= 0)
+        {
+            for (std::set<int>::const_iterator it = m_overlaps[leaf].begin(); it != m_overlaps[leaf].end(); ++it)
+            {
+                const int order = m_nodes[*it].order;
+                if (order >= 0 && order < i)
+                    m_candidates.push_back(order);
+            }
+            for (std::size_t u=0; u<m_unboundedModels.size() && m_unboundedModels[u] < i; ++u)
+                m_candidates.push_back(m_unboundedModels[u]);
+            std::sort(m_candidates.begin(), m_candidates.end());
+        }
+        else
+        {
+            for (int j=0; j<i; ++j)
+                m_candidates.push_back(j);
+        }
+
+        for (std::size_t c=0; c<m_candidates.size(); ++c)
+            addModelPair(cm, collisionModels[m_candidates[c]]);
+    }
+
+    BruteForceDetection::endBroadPhase();
+}
+
+} // namespace collision
+
+} // namespace component
+
+} // namespace sofa
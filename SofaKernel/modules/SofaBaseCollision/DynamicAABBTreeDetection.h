@@ -0,0 +1,129 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_COMPONENT_COLLISION_DYNAMICAABBTREEDETECTION_H
+#define SOFA_COMPONENT_COLLISION_DYNAMICAABBTREEDETECTION_H
+#include "config.h"
+
+#include <SofaBaseCollision/BruteForceDetection.h>
+#include <map>
+#include <set>
+#include <vector>
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace collision
+{
+
+/**
+ * @brief Broad phase keeping the root bounding boxes of the collision models in a persistent dynamic AABB tree.
+ *
+ * Each model is stored in a leaf whose box is the root box of the model enlarged by a margin. The tree is kept
+ * from one step to the next: a leaf is only removed and re-inserted when the model moves out of its enlarged box,
+ * and the internal nodes are balanced with rotations while updating their boxes. The pairs of leaves whose boxes,
+ * grown by the alarm distance, overlap are kept as well: only the leaves inserted or re-inserted in the step query
+ * the tree again. The cost of a step is thus linear in the number of models (to compare their box with their leaf)
+ * and in the number of kept pairs, plus a tree query per moved model. The potentially colliding pairs are then
+ * filtered as in BruteForceDetection, which also computes the narrow phase. The resulting pairs are the same, in
+ * the same order, as with BruteForceDetection.
+ */
+class SOFA_BASE_COLLISION_API DynamicAABBTreeDetection : public BruteForceDetection
+{
+public:
+    SOFA_CLASS(DynamicAABBTreeDetection, BruteForceDetection);
+
+    Data< SReal > d_marginRatio; ///< margin added around the box of each model in the tree, relative to the diagonal of the box
+
+protected:
+    struct TreeNode
+    {
+        sofa::defaulttype::Vector3 minBBox, maxBBox;
+        int parent;
+        int child1, child2; ///< -1 for the leaves
+        int height; ///< 0 for the leaves
+        core::CollisionModel* model; ///< model stored in a leaf
+        int order; ///< index of the model in collisionModels for the current step, -1 if it was not added
+    };
+
+    std::vector<TreeNode> m_nodes;
+    std::vector<int> m_freeNodes;
+    int m_root;
+    std::map<core::CollisionModel*, int> m_leaves;
+    unsigned int m_nbReinsertedLeaves;
+    unsigned int m_nbQueries;
+
+    /// Leaves overlapping each leaf of the tree, with the alarm distance used to find them
+    std::vector< std::set<int> > m_overlaps;
+    SReal m_overlapsAlarmDistance;
+    /// Leaves inserted or re-inserted in the current step, whose overlaps are searched again
+    std::vector<int> m_updatedLeaves;
+    /// Leaf of each model of the current step, -1 for the models without a root CubeModel
+    std::vector<int> m_orderLeaves;
+
+    /// Models without a root CubeModel, tested against all the other models
+    std::vector<int> m_unboundedModels;
+    std::vector<int> m_queryStack;
+    std::vector<int> m_candidates;
+
+    DynamicAABBTreeDetection();
+    ~DynamicAABBTreeDetection() override;
+
+    /// Compute the box of the root elements of a model. Return false if the model has no root CubeModel.
+    static bool getRootBox(core::CollisionModel* cm, sofa::defaulttype::Vector3& minBBox, sofa::defaulttype::Vector3& maxBBox);
+
+    int allocateNode();
+    void freeNode(int index);
+    void insertLeaf(int leaf);
+    void removeLeaf(int leaf);
+    /// Update the boxes and heights of the ancestors of a node, balancing them on the way up
+    void refitAncestors(int index);
+    /// Perform a left or right rotation if the subtree rooted at the given node is unbalanced. Return the new subtree root.
+    int balance(int index);
+    /// Add to m_candidates the leaves whose box intersects the given box
+    void queryTree(const sofa::defaulttype::Vector3& minBBox, const sofa::defaulttype::Vector3& maxBBox);
+    /// Remove a leaf from the overlaps of the other leaves
+    void clearOverlaps(int leaf);
+    /// Insert, move or remove the leaves to match the models added in the current step, and update the overlaps of the moved leaves
+    void updateTree();
+
+public:
+    void addCollisionModel (core::CollisionModel *cm) override;
+    void endBroadPhase() override;
+
+    /// Number of leaves re-inserted in the tree during the last broad phase, because their model moved out of their margin
+    unsigned int getNbReinsertedLeaves() const { return m_nbReinsertedLeaves; }
+    /// Number of tree queries during the last broad phase, one per inserted or re-inserted leaf
+    unsigned int getNbQueries() const { return m_nbQueries; }
+    /// Height of the tree, 0 if it contains a single leaf and -1 if it is empty
+    int getTreeHeight() const { return m_root < 0 ? -1 : m_nodes[m_root].height; }
+};
+
+} // namespace collision
+
+} // namespace component
+
+} // namespace sofa
+
+#endif
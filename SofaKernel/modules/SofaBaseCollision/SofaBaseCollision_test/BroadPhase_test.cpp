@@ -33,3 +33,16 @@ TEST_F(IncrSAPTest, rand_dense_test ) { ASSERT_TRUE( randDense()); }
 typedef BroadPhaseTest<sofa::component::collision::DirectSAP> DirectSAPTest;
 TEST_F(DirectSAPTest, rand_sparse_test ) { ASSERT_TRUE( randSparse()); }
 TEST_F(DirectSAPTest, rand_dense_test ) { ASSERT_TRUE( randDense()); }
+
+/// DirectSAP sorting its end points with the chunked radix sort run through the task scheduler
+class ParallelSortDirectSAP : public sofa::component::collision::DirectSAP
+{
+public:
+    SOFA_CLASS(ParallelSortDirectSAP, sofa::component::collision::DirectSAP);
+protected:
+    ParallelSortDirectSAP() { d_parallelSort.setValue(true); }
+};
+
+typedef BroadPhaseTest<ParallelSortDirectSAP> ParallelSortDirectSAPTest;
+TEST_F(ParallelSortDirectSAPTest, rand_dense_test ) { ASSERT_TRUE( randDense()); }
+TEST_F(ParallelSortDirectSAPTest, rand_large_test ) { ASSERT_TRUE( randTest(0,3000,1500,Vector3(-40,-40,-40),Vector3(40,40,40))); }
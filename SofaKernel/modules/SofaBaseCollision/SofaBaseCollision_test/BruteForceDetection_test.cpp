@@ -0,0 +1,120 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaTest/Sofa_test.h>
+using sofa::Sofa_test;
+
+#include <SofaBaseCollision/BruteForceDetection.h>
+using sofa::component::collision::BruteForceDetection ;
+
+#include <sofa/core/collision/Pipeline.h>
+using sofa::core::collision::Pipeline ;
+using sofa::core::collision::DetectionOutputVector ;
+
+#include <sofa/simulation/TaskScheduler.h>
+using sofa::simulation::TaskScheduler ;
+
+#include <SofaSimulationGraph/DAGSimulation.h>
+using sofa::simulation::Node ;
+
+#include <SofaSimulationCommon/SceneLoaderXML.h>
+using sofa::simulation::SceneLoaderXML ;
+using sofa::core::ExecParams ;
+
+#include <map>
+#include <string>
+
+namespace bruteforcedetection_test
+{
+
+class TestBruteForceDetection : public Sofa_test<> {
+public:
+    typedef std::map< std::pair<std::string, std::string>, std::size_t > ContactCounts;
+
+    ContactCounts detectCollisions(bool parallel);
+    void checkParallelNarrowPhaseMatchesSequential();
+};
+
+/// Run the collision detection on a set of intersecting grids of spheres and
+/// return the number of contacts found for each pair of models.
+TestBruteForceDetection::ContactCounts TestBruteForceDetection::detectCollisions(bool parallel)
+{
+    std::stringstream scene ;
+    scene << "<?xml version='1.0'?>                                                          \n"
+             "<Node name='Root' gravity='0 -9.81 0' dt='0.01'>                                \n"
+             "  <DefaultPipeline name='pipeline'/>                                           \n"
+             "  <BruteForceDetection name='detection' parallel='" << parallel << "'/>         \n"
+             "  <NewProximityIntersection name='intersection' alarmDistance='0.3' contactDistance='0.1'/> \n" ;
+    for (int i = 0; i < 6; ++i)
+    {
+        scene << "  <Node name='object" << i << "'>                                             \n"
+                 "    <RegularGridTopology n='4 4 4' min='" << 0.7*i << " 0 0' max='" << 0.7*i + 1.5 << " 1.5 1.5'/> \n"
+                 "    <MechanicalObject/>                                                    \n"
+                 "    <SphereCollisionModel name='spheres" << i << "' radius='0.2'/>          \n"
+                 "  </Node>                                                                  \n" ;
+    }
+    scene << "</Node>                                                                        \n" ;
+
+    Node::SPtr root = SceneLoaderXML::loadFromMemory ("testscene",
+                                                      scene.str().c_str(),
+                                                      scene.str().size()) ;
+    EXPECT_NE(root.get(), nullptr) ;
+    root->init(ExecParams::defaultInstance()) ;
+
+    Pipeline* pipeline = dynamic_cast<Pipeline*>(root->getObject("pipeline")) ;
+    BruteForceDetection* detection = dynamic_cast<BruteForceDetection*>(root->getObject("detection")) ;
+    EXPECT_NE(pipeline, nullptr) ;
+    EXPECT_NE(detection, nullptr) ;
+
+    ContactCounts counts ;
+    if (pipeline && detection)
+    {
+        pipeline->computeCollisionReset() ;
+        pipeline->computeCollisionDetection() ;
+
+        for (const auto& output : detection->getDetectionOutputs())
+            counts[std::make_pair(output.first.first->getName(), output.first.second->getName())] = output.second->size() ;
+    }
+
+    clearSceneGraph() ;
+    return counts ;
+}
+
+void TestBruteForceDetection::checkParallelNarrowPhaseMatchesSequential()
+{
+    TaskScheduler* scheduler = TaskScheduler::getInstance() ;
+    scheduler->init(4) ;
+
+    const ContactCounts sequential = detectCollisions(false) ;
+    const ContactCounts parallel = detectCollisions(true) ;
+
+    scheduler->stop() ;
+
+    EXPECT_FALSE(sequential.empty()) ;
+    EXPECT_EQ(sequential, parallel) ;
+}
+
+TEST_F(TestBruteForceDetection, checkParallelNarrowPhaseMatchesSequential)
+{
+    this->checkParallelNarrowPhaseMatchesSequential();
+}
+
+} // bruteforcedetection_test
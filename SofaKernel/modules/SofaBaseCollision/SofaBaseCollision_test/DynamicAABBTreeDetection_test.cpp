@@ -0,0 +1,175 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaTest/Sofa_test.h>
+using sofa::Sofa_test;
+
+#include <SofaBaseCollision/DynamicAABBTreeDetection.h>
+using sofa::component::collision::BruteForceDetection ;
+using sofa::component::collision::DynamicAABBTreeDetection ;
+
+#include <SofaBaseMechanics/MechanicalObject.h>
+using sofa::component::container::MechanicalObject ;
+using sofa::defaulttype::Vec3Types ;
+using sofa::defaulttype::Vector3 ;
+
+#include <sofa/core/collision/Pipeline.h>
+using sofa::core::collision::Pipeline ;
+
+#include <SofaSimulationGraph/DAGSimulation.h>
+using sofa::simulation::Node ;
+
+#include <SofaSimulationCommon/SceneLoaderXML.h>
+using sofa::simulation::SceneLoaderXML ;
+using sofa::core::ExecParams ;
+
+#include <sofa/helper/RandomGenerator.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace dynamicaabbtreedetection_test
+{
+
+class TestDynamicAABBTreeDetection : public Sofa_test<> {
+public:
+    /// Pairs of collision models found by the broad phase and number of contacts per pair of models, for one step
+    struct StepResult
+    {
+        std::vector< std::pair<std::string, std::string> > pairs;
+        std::map< std::pair<std::string, std::string>, std::size_t > contacts;
+        unsigned int nbReinsertedLeaves;
+        unsigned int nbQueries;
+
+        bool operator==(const StepResult& r) const { return pairs == r.pairs && contacts == r.contacts; }
+    };
+
+    std::vector<StepResult> detectCollisions(const std::string& detectionType);
+    void checkSameResultsAsBruteForce();
+};
+
+/// Run the collision detection on spheres grids moving randomly between steps, and return the results of each step.
+std::vector<TestDynamicAABBTreeDetection::StepResult> TestDynamicAABBTreeDetection::detectCollisions(const std::string& detectionType)
+{
+    const int nbObjects = 24;
+    const int nbSteps = 12;
+
+    std::stringstream scene ;
+    scene << "<?xml version='1.0'?>                                                          \n"
+             "<Node name='Root' gravity='0 -9.81 0' dt='0.01'>                                \n"
+             "  <DefaultPipeline name='pipeline'/>                                           \n"
+             "  <" << detectionType << " name='detection'/>                                  \n"
+             "  <NewProximityIntersection name='intersection' alarmDistance='0.3' contactDistance='0.1'/> \n" ;
+    for (int i = 0; i < nbObjects; ++i)
+    {
+        const double x = 1.1*(i%6), y = 1.1*(i/6);
+        scene << "  <Node name='object" << i << "'>                                             \n"
+                 "    <RegularGridTopology n='3 3 3' min='" << x << " " << y << " 0' max='" << x + 0.8 << " " << y + 0.8 << " 0.8'/> \n"
+                 "    <MechanicalObject name='dofs'/>                                        \n"
+                 "    <SphereCollisionModel name='spheres" << i << "' radius='0.1'/>          \n"
+                 "  </Node>                                                                  \n" ;
+    }
+    scene << "</Node>                                                                        \n" ;
+
+    Node::SPtr root = SceneLoaderXML::loadFromMemory ("testscene",
+                                                      scene.str().c_str(),
+                                                      scene.str().size()) ;
+    EXPECT_NE(root.get(), nullptr) ;
+    root->init(ExecParams::defaultInstance()) ;
+
+    Pipeline* pipeline = dynamic_cast<Pipeline*>(root->getObject("pipeline")) ;
+    BruteForceDetection* detection = dynamic_cast<BruteForceDetection*>(root->getObject("detection")) ;
+    EXPECT_NE(pipeline, nullptr) ;
+    EXPECT_NE(detection, nullptr) ;
+
+    std::vector<StepResult> results ;
+    if (!pipeline || !detection)
+        return results ;
+
+    sofa::helper::RandomGenerator random(42) ;
+    for (int step = 0; step < nbSteps; ++step)
+    {
+        if (step > 1)
+        {
+            // move some of the objects, by small steps or jumps
+            for (int i = 0; i < nbObjects; ++i)
+            {
+                if (random.random<int>(0, 3) != 0)
+                    continue;
+                const double amplitude = (random.random<int>(0, 4) == 0) ? 3.0 : 0.05 ;
+                const Vector3 offset(random.random<double>(-amplitude, amplitude),
+                                     random.random<double>(-amplitude, amplitude),
+                                     random.random<double>(-amplitude, amplitude)) ;
+                Node* child = root->getChild("object" + std::to_string(i)) ;
+                MechanicalObject<Vec3Types>* dofs = child->get< MechanicalObject<Vec3Types> >() ;
+                sofa::helper::WriteAccessor< sofa::Data<Vec3Types::VecCoord> > x = *dofs->write(sofa::core::VecCoordId::position()) ;
+                for (std::size_t p = 0; p < x.size(); ++p)
+                    x[p] += offset ;
+            }
+        }
+
+        pipeline->computeCollisionReset() ;
+        pipeline->computeCollisionDetection() ;
+
+        StepResult result ;
+        for (const auto& pair : detection->getCollisionModelPairs())
+            result.pairs.push_back(std::make_pair(pair.first->getLast()->getName(), pair.second->getLast()->getName())) ;
+        for (const auto& output : detection->getDetectionOutputs())
+            result.contacts[std::make_pair(output.first.first->getName(), output.first.second->getName())] = output.second->size() ;
+        DynamicAABBTreeDetection* tree = dynamic_cast<DynamicAABBTreeDetection*>(detection) ;
+        result.nbReinsertedLeaves = tree ? tree->getNbReinsertedLeaves() : 0 ;
+        result.nbQueries = tree ? tree->getNbQueries() : 0 ;
+        results.push_back(result) ;
+    }
+
+    clearSceneGraph() ;
+    return results ;
+}
+
+void TestDynamicAABBTreeDetection::checkSameResultsAsBruteForce()
+{
+    const std::vector<StepResult> bruteForce = detectCollisions("BruteForceDetection") ;
+    const std::vector<StepResult> tree = detectCollisions("DynamicAABBTreeDetection") ;
+
+    ASSERT_EQ(bruteForce.size(), tree.size()) ;
+    for (std::size_t step = 0; step < bruteForce.size(); ++step)
+    {
+        EXPECT_FALSE(bruteForce[step].pairs.empty()) ;
+        EXPECT_TRUE(bruteForce[step] == tree[step]) << "different results at step " << step ;
+    }
+
+    // every model is queried when it is inserted, then only the models which moved out of their margin
+    EXPECT_EQ(tree[0].nbQueries, 24u) ;
+    for (std::size_t step = 1; step < tree.size(); ++step)
+        EXPECT_EQ(tree[step].nbQueries, tree[step].nbReinsertedLeaves) << "step " << step ;
+
+    // nothing moved between the first two steps
+    EXPECT_EQ(tree[1].nbReinsertedLeaves, 0u) ;
+    EXPECT_EQ(tree[1].nbQueries, 0u) ;
+}
+
+TEST_F(TestDynamicAABBTreeDetection, checkSameResultsAsBruteForce)
+{
+    this->checkSameResultsAsBruteForce();
+}
+
+} // dynamicaabbtreedetection_test
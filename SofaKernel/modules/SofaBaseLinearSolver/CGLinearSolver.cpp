@@ -45,12 +45,13 @@ inline void CGLinearSolver<component::linearsolver::GraphScatteredMatrix,compone
 }
 
 template<> SOFA_BASE_LINEAR_SOLVER_API
-inline void CGLinearSolver<component::linearsolver::GraphScatteredMatrix,component::linearsolver::GraphScatteredVector>::cgstep_alpha(const core::ExecParams* params, Vector& x, Vector& r, Vector& p, Vector& q, SReal alpha)
+inline SReal CGLinearSolver<component::linearsolver::GraphScatteredMatrix,component::linearsolver::GraphScatteredVector>::cgstep_alpha(const core::ExecParams* params, Vector& x, Vector& r, Vector& p, Vector& q, SReal alpha)
 {
 #ifdef SOFA_NO_VMULTIOP // unoptimized version
     x.peq(p,alpha);                 // x = x + alpha p
     r.peq(q,-alpha);                // r = r - alpha q
-#else // single-operation optimization
+    return r.dot(r);
+#else // single-operation optimization, fused with the computation of r.r
     typedef sofa::core::behavior::BaseMechanicalState::VMultiOp VMultiOp;
     VMultiOp ops;
     ops.resize(2);
@@ -60,7 +61,9 @@ inline void CGLinearSolver<component::linearsolver::GraphScatteredMatrix,compone
     ops[1].first = (MultiVecDerivId)r;
     ops[1].second.push_back(std::make_pair((MultiVecDerivId)r,1.0));
     ops[1].second.push_back(std::make_pair((MultiVecDerivId)q,-alpha));
-    this->executeVisitor(simulation::MechanicalVMultiOpVisitor(params, ops));
+    SReal rNorm2 = 0;
+    this->executeVisitor(simulation::MechanicalVMultiOpDotVisitor(params, ops, (MultiVecDerivId)r, (MultiVecDerivId)r, &rNorm2));
+    return rNorm2;
 #endif
 }
 
@@ -43,6 +43,18 @@ namespace component
 namespace linearsolver
 {
 
+/// Enable the parallel products of the matrix with vectors, for the matrix types supporting them
+template<class TMatrix>
+inline void setParallelProducts(TMatrix& /*M*/, bool /*parallel*/)
+{
+}
+
+template<class TBloc, class TVecBloc, class TVecIndex>
+inline void setParallelProducts(CompressedRowSparseMatrix<TBloc,TVecBloc,TVecIndex>& M, bool parallel)
+{
+    M.setParallelProducts(parallel);
+}
+
 /// Linear system solver using the conjugate gradient iterative algorithm
 template<class TMatrix, class TVector>
 CGLinearSolver<TMatrix,TVector>::CGLinearSolver()
@@ -52,6 +64,7 @@ CGLinearSolver<TMatrix,TVector>::CGLinearSolver()
     , f_warmStart( initData(&f_warmStart,false,"warmStart","Use previous solution as initial solution") )
     , f_verbose( initData(&f_verbose,false,"verbose","Dump system state at each iteration") )
     , f_graph( initData(&f_graph,"graph","Graph of residuals at each iteration") )
+    , d_parallelProducts( initData(&d_parallelProducts,false,"parallelProducts","Compute the products of the assembled matrix with vectors in parallel with the task scheduler (CompressedRowSparseMatrix only)") )
 {
     f_graph.setWidget("graph");
 #ifdef DISPLAY_TIME
@@ -140,6 +153,7 @@ void CGLinearSolver<TMatrix,TVector>::solve(Matrix& M, Vector& x, Vector& b)
 #endif
 
     const core::ExecParams* params = core::ExecParams::defaultInstance();
+    setParallelProducts(M, d_parallelProducts.getValue());
     typename Inherit::TempVectorContainer vtmp(this, params, M, x, b);
     Vector& p = *vtmp.createTempVector();
     Vector& q = *vtmp.createTempVector();
@@ -189,6 +203,9 @@ void CGLinearSolver<TMatrix,TVector>::solve(Matrix& M, Vector& x, Vector& b)
 
     if(normb != 0.0)
     {
+        /// Squared norm of the residual, updated at the end of each CG step
+        double rNorm2 = r.dot(r);
+
         for( nb_iter=1; nb_iter<=f_maxIter.getValue(); nb_iter++ )
         {
 #ifdef SOFA_DUMP_VISITOR_INFO
@@ -201,7 +218,7 @@ void CGLinearSolver<TMatrix,TVector>::solve(Matrix& M, Vector& x, Vector& b)
 #endif
 
             /// Compute p = r^2
-            rho = r.dot(r);
+            rho = rNorm2;
 
             /// Compute the error from the norm of ρ and b
             double normr = sqrt(rho);
@@ -316,8 +333,8 @@ void CGLinearSolver<TMatrix,TVector>::solve(Matrix& M, Vector& x, Vector& b)
                 /// Compute the coefficient α for the conjugate direction
                 alpha = rho/den;
 
-                /// End of the CG step : update x and r
-                cgstep_alpha(params, x,r,p,q,alpha);
+                /// End of the CG step : update x and r, and compute the new r^2
+                rNorm2 = cgstep_alpha(params, x,r,p,q,alpha);
 
                 if( verbose )
                 {
@@ -396,13 +413,15 @@ inline void CGLinearSolver<TMatrix,TVector>::cgstep_beta(const core::ExecParams*
 }
 
 template<class TMatrix, class TVector>
-inline void CGLinearSolver<TMatrix,TVector>::cgstep_alpha(const core::ExecParams* /*params*/, Vector& x, Vector& r, Vector& p, Vector& q, SReal alpha)
+inline SReal CGLinearSolver<TMatrix,TVector>::cgstep_alpha(const core::ExecParams* /*params*/, Vector& x, Vector& r, Vector& p, Vector& q, SReal alpha)
 {
     // x = x + alpha p
     x.peq(p,alpha);
 
     // r = r - alpha q
     r.peq(q,-alpha);
+
+    return r.dot(r);
 }
 
 } // namespace linearsolver
@@ -27,6 +27,7 @@
 #include <SofaBaseLinearSolver/MatrixExpr.h>
 #include <SofaBaseLinearSolver/matrix_bloc_traits.h>
 #include "FullVector.h"
+#include <sofa/simulation/ParallelFor.h>
 #include <algorithm>
 
 namespace sofa
@@ -101,6 +102,16 @@ public:
     };
     typedef helper::vector<IndexedBloc> VecIndexedBloc;
 
+    /// Scalar indices of an add() call of the recorded assembly sequence, and position of their bloc in colsValue
+    struct PatternSlot
+    {
+        Index i,j;
+        Index bloc; ///< -1 if the bloc was not in the compressed data structure when the sequence was resolved
+        PatternSlot() {}
+        PatternSlot(Index i, Index j) : i(i), j(j), bloc(-1) {}
+    };
+    typedef helper::vector<PatternSlot> VecPatternSlot;
+
     static void split_row_index(Index& index, Index& modulo) { bloc_index_func<NL>::split(index, modulo); }
     static void split_col_index(Index& index, Index& modulo) { bloc_index_func<NC>::split(index, modulo); }
 
@@ -164,6 +175,16 @@ public :
     VecIndexedBloc btemp; ///< unsorted blocks and their indices
     bool compressed;      ///< true if the additional storage is empty or has been transfered to the compressed data structure
 
+    // products with vectors using the task scheduler
+    bool parallelProducts;   ///< true if the products with vectors are split among the threads of the task scheduler
+    Index parallelGrainSize; ///< number of non-empty block rows processed by each task in the parallel products
+
+    // cached assembly pattern
+    bool patternCache;           ///< true if the sequence of add() calls is recorded, to write directly in colsValue in the next assemblies
+    bool patternResolved;        ///< true if the blocs of patternSlots match the current layout of colsValue
+    Index patternPosition;       ///< number of add() calls since the last clear()
+    VecPatternSlot patternSlots; ///< recorded sequence of add() calls
+
     // Temporary vectors used during compression
     VecIndex oldRowIndex;
     VecIndex oldRowBegin;
@@ -171,14 +192,16 @@ public :
     VecBloc  oldColsValue;
 public:
     CompressedRowSparseMatrix()
-        : nRow(0), nCol(0), nBlocRow(0), nBlocCol(0), compressed(true)
+        : nRow(0), nCol(0), nBlocRow(0), nBlocCol(0), compressed(true), parallelProducts(false), parallelGrainSize(256)
+        , patternCache(false), patternResolved(false), patternPosition(0)
     {
     }
 
     CompressedRowSparseMatrix(Index nbRow, Index nbCol)
         : nRow(nbRow), nCol(nbCol),
           nBlocRow((nbRow + NL-1) / NL), nBlocCol((nbCol + NC-1) / NC),
-          compressed(true)
+          compressed(true), parallelProducts(false), parallelGrainSize(256),
+          patternCache(false), patternResolved(false), patternPosition(0)
     {
     }
 
@@ -199,6 +222,30 @@ public:
         return nBlocCol;
     }
 
+    /// Split the products with vectors (mul, addMul, addMultTranspose) among the threads of the task scheduler,
+    /// by chunks of grainSize non-empty block rows.
+    void setParallelProducts(bool parallel, Index grainSize = 256)
+    {
+        parallelProducts = parallel;
+        parallelGrainSize = std::max<Index>(grainSize, 1);
+    }
+    bool getParallelProducts() const { return parallelProducts; }
+
+    /// Record the sequence of add() calls between two clear(), and resolve the position in colsValue of each one
+    /// when the matrix is compressed. While the next assemblies repeat the same sequence, the values are added
+    /// directly in colsValue, without searching the blocs nor sorting new ones. Empty blocs are kept in this mode,
+    /// so that the pattern does not change when some values are zero.
+    void setPatternCache(bool enabled)
+    {
+        if (enabled == patternCache) return;
+        patternCache = enabled;
+        patternResolved = false;
+        patternPosition = 0;
+        patternSlots.clear();
+    }
+    bool getPatternCache() const { return patternCache; }
+    const VecPatternSlot& getPatternSlots() const { return patternSlots; }
+
     const VecIndex& getRowIndex() const { return rowIndex; }
     const VecIndex& getRowBegin() const { return rowBegin; }
     Range getRowRange(Index id) const { return Range(rowBegin[id], rowBegin[id+1]); }
@@ -207,13 +254,14 @@ public:
 
     void resizeBloc(Index nbBRow, Index nbBCol)
     {
-        if (nBlocRow == nbBRow && nBlocRow == nbBCol)
+        if (nBlocRow == nbBRow && nBlocCol == nbBCol)
         {
             // just clear the matrix
             for (Index i=0; i < (Index)colsValue.size(); ++i)
                 traits::clear(colsValue[i]);
             compressed = colsValue.empty();
             btemp.clear();
+            patternPosition = 0;
         }
         else
         {
@@ -230,12 +278,21 @@ public:
             colsValue.clear();
             compressed = true;
             btemp.clear();
+            patternResolved = false;
+            patternPosition = 0;
+            patternSlots.clear();
         }
     }
 
     void compress() override
     {
-        if (compressed && btemp.empty()) return;
+        // empty blocs are only removed when the pattern is not cached, otherwise there is nothing to merge
+        if (btemp.empty() && (compressed || patternCache))
+        {
+            compressed = true;
+            if (patternCache && !patternResolved) resolvePattern();
+            return;
+        }
         if (!btemp.empty())
         {
             dmsg_info_when(EMIT_EXTRA_MESSAGE)
@@ -277,7 +334,7 @@ public:
                 Range inRow( oldRowBegin[inRowId], oldRowBegin[inRowId+1] );
                 while (!inRow.empty())
                 {
-                    if (!traits::empty(oldColsValue[inRow.begin()]))
+                    if (patternCache || !traits::empty(oldColsValue[inRow.begin()]))
                     {
                         colsIndex.push_back(oldColsIndex[inRow.begin()]);
                         colsValue.push_back(oldColsValue[inRow.begin()]);
@@ -321,7 +378,7 @@ public:
                 {
                     if (inColIndex < bColIndex)
                     {
-                        if (!traits::empty(oldColsValue[inRow.begin()]))
+                        if (patternCache || !traits::empty(oldColsValue[inRow.begin()]))
                         {
                             colsIndex.push_back(inColIndex);
                             colsValue.push_back(oldColsValue[inRow.begin()]);
@@ -368,6 +425,38 @@ public:
         rowBegin.push_back(outValId);
         btemp.clear();
         compressed = true;
+        if (patternCache) resolvePattern();
+    }
+
+    /// Find the bloc of each add() call of the recorded sequence in the compressed data structure
+    void resolvePattern()
+    {
+        for (Index s = 0; s < (Index)patternSlots.size(); ++s)
+        {
+            PatternSlot& slot = patternSlots[s];
+            Index i = slot.i, j = slot.j, bi = 0, bj = 0;
+            split_row_index(i, bi); split_col_index(j, bj);
+            const Bloc* b = wbloc(i, j, false);
+            slot.bloc = b ? (Index)(b - &colsValue[0]) : -1;
+        }
+        patternResolved = true;
+    }
+
+    /// Return the bloc where the value of the next add() call is accumulated, if it is the same
+    /// as in the recorded sequence. Otherwise the sequence is recorded again from this call.
+    Bloc* nextPatternBloc(Index i, Index j)
+    {
+        const Index position = patternPosition++;
+        if (position < (Index)patternSlots.size())
+        {
+            const PatternSlot& slot = patternSlots[position];
+            if (slot.i == i && slot.j == j)
+                return (patternResolved && slot.bloc >= 0) ? &colsValue[slot.bloc] : NULL;
+            patternSlots.resize(position);
+        }
+        patternSlots.push_back(PatternSlot(i, j));
+        patternResolved = false;
+        return NULL;
     }
 
     void swap(Matrix& m)
@@ -386,6 +475,8 @@ public:
         colsIndex.swap(m.colsIndex);
         colsValue.swap(m.colsValue);
         btemp.swap(m.btemp);
+        patternResolved = false;
+        m.patternResolved = false;
     }
 
     /// Make sure all rows have an entry even if they are empty
@@ -434,6 +525,7 @@ public:
         }
         if (ndiag == nRow) return;
 
+        patternResolved = false;
         oldRowIndex.swap(rowIndex);
         oldRowBegin.swap(rowBegin);
         oldColsIndex.swap(colsIndex);
@@ -551,6 +643,7 @@ public:
         colsValue.clear();
         compressed = true;
         btemp.clear();
+        patternResolved = false;
         rowIndex.reserve(M.rowIndex.size());
         rowBegin.reserve(M.rowBegin.size());
         colsIndex.reserve(M.colsIndex.size());
@@ -745,7 +838,13 @@ public:
             return;
         }
 #endif
+        Bloc* patternBloc = patternCache ? nextPatternBloc(i, j) : NULL;
         Index bi=0, bj=0; split_row_index(i, bi); split_col_index(j, bj);
+        if (patternBloc)
+        {
+            traits::v(*patternBloc, bi, bj) += (Real)v;
+            return;
+        }
 
         dmsg_info_when(EMIT_EXTRA_MESSAGE)
                 << "("<<rowBSize()<<"*"<<NL<<","<<colBSize()<<"*"<<NC<<"): bloc("<<i<<","<<j<<")["<<bi<<","<<bj<<"] += "<<v ;
@@ -877,6 +976,7 @@ public:
             traits::clear(colsValue[i]);
         compressed = colsValue.empty();
         btemp.clear();
+        patternPosition = 0;
     }
 
     /// @name Get information about the content and structure of this matrix (diagonal, band, sparse, full, block size, ...)
@@ -1258,15 +1358,25 @@ protected:
 
 
 
-      /** Product of the matrix with a templated vector res = this * vec*/
-      template<class Real2, class V1, class V2>
-      void tmul(V1& res, const V2& vec) const
-      {
-          assert( vec.size()%bColSize() == 0 ); // vec.size() must be a multiple of block size.
+    /// Whether the entries of a vector of this type can be written concurrently by different threads, as long as they are different
+    template<class Vec> static bool vconcurrent(const Vec& /*vec*/) { return false; }
+    template<class Vec> static bool vconcurrent(const helper::vector<Vec>& /*vec*/) { return true; }
+    template<class Real2> static bool vconcurrent(const FullVector<Real2>& /*vec*/) { return true; }
 
-          ((Matrix*)this)->compress();
-          vresize( res, rowBSize(), rowSize() );
-          for (Index xi = 0; xi < (Index)rowIndex.size(); ++xi)  // for each non-empty block row
+    /// Whether the products with res can be split among the threads of the task scheduler
+    template<class Vec>
+    bool useParallelProducts(const Vec& res) const
+    {
+        return parallelProducts && vconcurrent(res) && (Index)rowIndex.size() > parallelGrainSize;
+    }
+
+
+      /** Product of the non-empty block rows [xiBegin,xiEnd) of the matrix with a templated vector.
+          The result is written to (or added to, if add is true) the corresponding entries of res. */
+      template<bool add, class Real2, class V1, class V2>
+      void tmulRows(V1& res, const V2& vec, Index xiBegin, Index xiEnd) const
+      {
+          for (Index xi = xiBegin; xi < xiEnd; ++xi)  // for each non-empty block row
           {
               defaulttype::Vec<NL,Real2> r;  // local block-sized vector to accumulate the product of the block row  with the large vector
 
@@ -1290,45 +1400,90 @@ protected:
               // transfer the local result  to the large result vector
               //Index iN = rowIndex[xi] * NL;                      // scalar row index
               for (Index bi = 0; bi < NL; ++bi)
-                  vset(res, rowIndex[xi], NL, bi, r[bi]);
+              {
+                  if (add)
+                      vadd(res, rowIndex[xi], NL, bi, r[bi]);
+                  else
+                      vset(res, rowIndex[xi], NL, bi, r[bi]);
+              }
           }
       }
 
-
-      /** Product of the matrix with a templated vector res += this * vec*/
-      template<class Real2, class V1, class V2>
-      void taddMul(V1& res, const V2& vec) const
+      /** Same as above for full vectors, whose entries are read and written directly in their contiguous storage.
+          The block sizes are known at compile time, so the compiler can unroll and vectorize the block-vector products (e.g. for 3x3 and 6x6 blocks). */
+      template<bool add, class Real2, class R1, class R2>
+      void tmulRows(FullVector<R1>& res, const FullVector<R2>& vec, Index xiBegin, Index xiEnd) const
       {
-          assert( vec.size()%bColSize() == 0 ); // vec.size() must be a multiple of block size.
-
-          ((Matrix*)this)->compress();
-          vresize( res, rowBSize(), rowSize() );
-          for (Index xi = 0; xi < (Index)rowIndex.size(); ++xi)  // for each non-empty block row
+          const R2* x = vec.ptr();
+          R1* y = res.ptr();
+          for (Index xi = xiBegin; xi < xiEnd; ++xi)  // for each non-empty block row
           {
-              defaulttype::Vec<NL,Real2> r;  // local block-sized vector to accumulate the product of the block row  with the large vector
+              Real2 r[NL];
+              for (Index bi = 0; bi < NL; ++bi)
+                  r[bi] = 0;
 
-              // multiply the non-null blocks with the corresponding chunks of the large vector
-              Range rowRange(rowBegin[xi], rowBegin[xi+1]);
-              for (Index xj = rowRange.begin(); xj < rowRange.end(); ++xj)
+              const Index rowEnd = rowBegin[xi+1];
+              for (Index xj = rowBegin[xi]; xj < rowEnd; ++xj)
               {
-                  // transfer a chunk of large vector to a local block-sized vector
-                  defaulttype::Vec<NC,Real2> v;
-                  //Index jN = colsIndex[xj] * NC;    // scalar column index
-                  for (Index bj = 0; bj < NC; ++bj)
-                      v[bj] = vget(vec,colsIndex[xj],NC,bj);
-
-                  // multiply the block with the local vector
-                  const Bloc& b = colsValue[xj];    // non-null block has block-indices (rowIndex[xi],colsIndex[xj]) and value colsValue[xj]
+                  const R2* xb = x + colsIndex[xj] * NC;
+                  const Bloc& b = colsValue[xj];
                   for (Index bi = 0; bi < NL; ++bi)
                       for (Index bj = 0; bj < NC; ++bj)
-                          r[bi] += traits::v(b, bi, bj) * v[bj];
+                          r[bi] += traits::v(b, bi, bj) * xb[bj];
               }
 
-              // transfer the local result  to the large result vector
-              //Index iN = rowIndex[xi] * NL;                      // scalar row index
+              R1* yb = y + rowIndex[xi] * NL;
               for (Index bi = 0; bi < NL; ++bi)
-                  vadd(res, rowIndex[xi], NL, bi, r[bi]);
+              {
+                  if (add)
+                      yb[bi] += (R1)r[bi];
+                  else
+                      yb[bi] = (R1)r[bi];
+              }
+          }
+      }
+
+      /** Product of all the non-empty block rows of the matrix with a templated vector, split in chunks of parallelGrainSize
+          rows among the threads of the task scheduler if parallelProducts is true. Each row is computed by a single thread, so
+          the result is the same as the sequential product. */
+      template<bool add, class Real2, class V1, class V2>
+      void tmulAllRows(V1& res, const V2& vec) const
+      {
+          if (useParallelProducts(res))
+          {
+              simulation::parallelFor(simulation::TaskScheduler::getInstance(), 0, rowIndex.size(), parallelGrainSize,
+                  [&](std::size_t xiBegin, std::size_t xiEnd)
+                  {
+                      tmulRows<add, Real2>(res, vec, (Index)xiBegin, (Index)xiEnd);
+                  });
           }
+          else
+          {
+              tmulRows<add, Real2>(res, vec, 0, (Index)rowIndex.size());
+          }
+      }
+
+      /** Product of the matrix with a templated vector res = this * vec*/
+      template<class Real2, class V1, class V2>
+      void tmul(V1& res, const V2& vec) const
+      {
+          assert( vec.size()%bColSize() == 0 ); // vec.size() must be a multiple of block size.
+
+          ((Matrix*)this)->compress();
+          vresize( res, rowBSize(), rowSize() );
+          tmulAllRows<false, Real2>(res, vec);
+      }
+
+
+      /** Product of the matrix with a templated vector res += this * vec*/
+      template<class Real2, class V1, class V2>
+      void taddMul(V1& res, const V2& vec) const
+      {
+          assert( vec.size()%bColSize() == 0 ); // vec.size() must be a multiple of block size.
+
+          ((Matrix*)this)->compress();
+          vresize( res, rowBSize(), rowSize() );
+          tmulAllRows<true, Real2>(res, vec);
       }
 
 
@@ -1362,15 +1517,11 @@ protected:
           }
       }
 
-      /** Product of the transpose with a templated vector and add it to res   res += this^T * vec */
+      /** Product of the transpose of the non-empty block rows [xiBegin,xiEnd) with a templated vector, added to res */
       template<class Real2, class V1, class V2>
-      void taddMulTranspose(V1& res, const V2& vec) const
+      void taddMulTransposeRows(V1& res, const V2& vec, Index xiBegin, Index xiEnd) const
       {
-          assert( vec.size()%bRowSize() == 0 ); // vec.size() must be a multiple of block size.
-
-          ((Matrix*)this)->compress();
-          vresize( res, colBSize(), colSize() );
-          for (Index xi = 0; xi < rowIndex.size(); ++xi) // for each non-empty block row (i.e. column of the transpose)
+          for (Index xi = xiBegin; xi < xiEnd; ++xi) // for each non-empty block row (i.e. column of the transpose)
           {
               // copy the corresponding chunk of the input to a local vector
               defaulttype::Vec<NL,Real2> v;
@@ -1401,6 +1552,50 @@ protected:
           }
       }
 
+      /** Product of the transpose with a templated vector and add it to res   res += this^T * vec
+          If parallelProducts is true, the block rows are split among the threads of the task scheduler, each thread
+          accumulating its products in its own full vector. These vectors are then added to res in a fixed order. */
+      template<class Real2, class V1, class V2>
+      void taddMulTranspose(V1& res, const V2& vec) const
+      {
+          assert( vec.size()%bRowSize() == 0 ); // vec.size() must be a multiple of block size.
+
+          ((Matrix*)this)->compress();
+          vresize( res, colBSize(), colSize() );
+
+          simulation::TaskScheduler* scheduler = useParallelProducts(res) ? simulation::TaskScheduler::getInstance() : nullptr;
+          const Index nbRows = (Index)rowIndex.size();
+          const Index nbAccumulators = scheduler ? std::min<Index>((Index)scheduler->getThreadCount(), (nbRows + parallelGrainSize - 1) / parallelGrainSize) : 1;
+          if (nbAccumulators < 2)
+          {
+              taddMulTransposeRows<Real2>(res, vec, 0, nbRows);
+              return;
+          }
+
+          std::vector< FullVector<Real2> > accumulators(nbAccumulators);
+          simulation::parallelFor(scheduler, 0, nbAccumulators, 1, [&](std::size_t first, std::size_t last)
+          {
+              for (std::size_t k = first; k < last; ++k)
+              {
+                  accumulators[k].resize(colSize());
+                  taddMulTransposeRows<Real2>(accumulators[k], vec, (Index)(k * nbRows / nbAccumulators), (Index)((k+1) * nbRows / nbAccumulators));
+              }
+          });
+
+          // sum the accumulators, split by block columns
+          simulation::parallelFor(scheduler, 0, colBSize(), parallelGrainSize, [&](std::size_t first, std::size_t last)
+          {
+              for (Index j = (Index)first; j < (Index)last; ++j)
+                  for (Index bj = 0; bj < NC; ++bj)
+                  {
+                      Real2 r = 0;
+                      for (Index k = 0; k < nbAccumulators; ++k)
+                          r += accumulators[k][j * NC + bj];
+                      vadd(res, j, NC, bj, r);
+                  }
+          });
+      }
+
 
 /// @}
 
@@ -34,6 +34,7 @@
 #include <SofaBaseLinearSolver/SparseMatrix.h>
 #include <SofaBaseLinearSolver/CompressedRowSparseMatrix.h>
 #include <SofaBaseLinearSolver/DiagonalMatrix.h>
+#include <SofaBaseLinearSolver/ParallelMatrixAssembly.h>
 #include <sofa/core/behavior/RotationMatrix.h>
 
 namespace sofa
@@ -178,6 +179,9 @@ public:
     typedef typename MatrixLinearSolverInternalData<Vector>::JMatrixType JMatrixType;
     typedef typename MatrixLinearSolverInternalData<Vector>::ResMatrixType ResMatrixType;
 
+    Data<bool> d_cacheAssemblyPattern; ///< Record the entries added to the system matrix in the first assembly, to add the values in place in the next ones
+    Data<bool> d_parallelAssembly; ///< Compute the matrices of the force fields and masses in parallel using the task scheduler
+
     MatrixLinearSolver();
     ~MatrixLinearSolver() override ;
 
@@ -331,6 +335,11 @@ protected:
 
     virtual MatrixInvertData * createInvertData();
 
+    /// Add the M,B,K matrices of the scene to the system matrix of the current group, in parallel if d_parallelAssembly is true
+    void addMBK_ToSystemMatrix(const core::MechanicalParams* mparams);
+
+    ParallelMatrixAssembly parallelAssembly;
+
     class GroupData
     {
     public:
@@ -403,6 +412,9 @@ void MatrixLinearSolver<GraphScatteredMatrix,GraphScatteredVector,NoThreadManage
 template<> SOFA_BASE_LINEAR_SOLVER_API
 void MatrixLinearSolver<GraphScatteredMatrix,GraphScatteredVector,NoThreadManager>::rebuildSystem(double massFactor, double forceFactor);
 
+template<> SOFA_BASE_LINEAR_SOLVER_API
+void MatrixLinearSolver<GraphScatteredMatrix,GraphScatteredVector,NoThreadManager>::addMBK_ToSystemMatrix(const core::MechanicalParams* mparams);
+
 template<> SOFA_BASE_LINEAR_SOLVER_API
 void MatrixLinearSolver<GraphScatteredMatrix,GraphScatteredVector,NoThreadManager>::setSystemRHVector(core::MultiVecDerivId v);
 
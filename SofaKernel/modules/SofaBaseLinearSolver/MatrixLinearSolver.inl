@@ -33,9 +33,23 @@ namespace component {
 namespace linearsolver {
 
 
+/// Enable the cached assembly pattern, for the matrix types supporting it
+template<class TMatrix>
+inline void setPatternCache(TMatrix& /*M*/, bool /*enabled*/)
+{
+}
+
+template<class TBloc, class TVecBloc, class TVecIndex>
+inline void setPatternCache(CompressedRowSparseMatrix<TBloc,TVecBloc,TVecIndex>& M, bool enabled)
+{
+    M.setPatternCache(enabled);
+}
+
 template<class Matrix, class Vector>
 MatrixLinearSolver<Matrix,Vector>::MatrixLinearSolver()
     : Inherit()
+    , d_cacheAssemblyPattern( initData(&d_cacheAssemblyPattern, false, "cacheAssemblyPattern", "Record the entries added to the system matrix in the first assembly, to add the values in place in the next ones as long as the same entries are added in the same order (CompressedRowSparseMatrix only)") )
+    , d_parallelAssembly( initData(&d_parallelAssembly, false, "parallelAssembly", "Compute the matrices of the force fields and masses in parallel using the task scheduler, then add them to the system matrix in the same order as the sequential assembly (in parallel by chunks of rows for CompressedRowSparseMatrix). The force fields must support being assembled concurrently") )
     , currentGroup(&defaultGroup)
 {
     invertData = nullptr;
@@ -81,6 +95,7 @@ void MatrixLinearSolver<Matrix,Vector>::resizeSystem(int n)
     if (!this->frozen)
     {
         if (!currentGroup->systemMatrix) currentGroup->systemMatrix = createMatrix();
+        setPatternCache(*currentGroup->systemMatrix, d_cacheAssemblyPattern.getValue());
         currentGroup->systemMatrix->resize(n,n);
     }
     if (!currentGroup->systemRHVector) currentGroup->systemRHVector = createPersistentVector();
@@ -129,7 +144,7 @@ void MatrixLinearSolver<Matrix,Vector>::setSystemMBKMatrix(const core::Mechanica
         currentGroup->matrixAccessor.setupMatrices();
         resizeSystem(currentGroup->matrixAccessor.getGlobalDimension());
         currentGroup->systemMatrix->clear();
-        mops.addMBK_ToMatrix(&(currentGroup->matrixAccessor), mparams->mFactor(), mparams->bFactor(), mparams->kFactor());
+        addMBK_ToSystemMatrix(mparams);
         currentGroup->matrixAccessor.computeGlobalMatrix();
     }
 
@@ -152,13 +167,32 @@ void MatrixLinearSolver<Matrix,Vector>::rebuildSystem(double massFactor, double
         currentGroup->matrixAccessor.setupMatrices();
         resizeSystem(currentGroup->matrixAccessor.getGlobalDimension());
         currentGroup->systemMatrix->clear();
-        mops.addMBK_ToMatrix(&(currentGroup->matrixAccessor), mparams.mFactor(), mparams.bFactor(), mparams.kFactor());
+        addMBK_ToSystemMatrix(&mparams);
         currentGroup->matrixAccessor.computeGlobalMatrix();
     }
 
     this->invertSystem();
 }
 
+template<class Matrix, class Vector>
+void MatrixLinearSolver<Matrix,Vector>::addMBK_ToSystemMatrix(const core::MechanicalParams* mparams)
+{
+    if (d_parallelAssembly.getValue())
+    {
+        Matrix* systemMatrix = currentGroup->systemMatrix;
+        parallelAssembly.addMBK_ToMatrix(mparams, this->getContext(), &(currentGroup->matrixAccessor), systemMatrix,
+                                         [systemMatrix](const ParallelMatrixAssembly::VecEntryList& lists)
+                                         {
+                                             addEntryLists(*systemMatrix, lists);
+                                         });
+    }
+    else
+    {
+        simulation::common::MechanicalOperations mops(mparams, this->getContext());
+        mops.addMBK_ToMatrix(&(currentGroup->matrixAccessor), mparams->mFactor(), mparams->bFactor(), mparams->kFactor());
+    }
+}
+
 template<class Matrix, class Vector>
 void MatrixLinearSolver<Matrix,Vector>::setSystemRHVector(core::MultiVecDerivId v)
 {
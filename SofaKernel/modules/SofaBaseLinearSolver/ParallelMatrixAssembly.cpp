@@ -0,0 +1,282 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaBaseLinearSolver/ParallelMatrixAssembly.h>
+#include <sofa/simulation/MechanicalVisitor.h>
+#include <sofa/simulation/VisitorExecuteFunc.h>
+#include <sofa/core/BaseMapping.h>
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace linearsolver
+{
+
+MatrixEntryList::MatrixEntryList(defaulttype::BaseMatrix* target)
+    : target(target)
+    , valid(true)
+{
+}
+
+void MatrixEntryList::reset(defaulttype::BaseMatrix* target)
+{
+    this->target = target;
+    entries.clear();
+    valid = true;
+}
+
+void MatrixEntryList::addToTarget() const
+{
+    for (const Entry& e : entries)
+        target->add(e.i, e.j, e.value);
+}
+
+SReal MatrixEntryList::element(Index /*i*/, Index /*j*/) const
+{
+    valid = false;
+    return 0;
+}
+
+void MatrixEntryList::resize(Index /*nbRow*/, Index /*nbCol*/)
+{
+    valid = false;
+}
+
+void MatrixEntryList::clear()
+{
+    valid = false;
+}
+
+void MatrixEntryList::set(Index /*i*/, Index /*j*/, double /*v*/)
+{
+    valid = false;
+}
+
+
+/// Accessor given to a force field assembled in parallel: the matrices of the scene accessor are replaced by
+/// MatrixEntryLists. The scene accessor is only used under the mutex shared by all force fields.
+class ParallelMatrixAssembly::ComponentAccessor : public core::behavior::MultiMatrixAccessor
+{
+public:
+    ComponentAccessor() : accessor(nullptr), mutex(nullptr), nbLists(0) {}
+
+    void reset(const core::behavior::MultiMatrixAccessor* accessor, std::mutex* mutex)
+    {
+        this->accessor = accessor;
+        this->mutex = mutex;
+        nbLists = 0;
+    }
+
+    bool isValid() const
+    {
+        for (std::size_t l = 0; l < nbLists; ++l)
+            if (!lists[l]->isValid())
+                return false;
+        return true;
+    }
+
+    void getEntryLists(VecEntryList& result) const
+    {
+        for (std::size_t l = 0; l < nbLists; ++l)
+            result.push_back(lists[l].get());
+    }
+
+    int getGlobalDimension() const override
+    {
+        std::lock_guard<std::mutex> lock(*mutex);
+        return accessor->getGlobalDimension();
+    }
+
+    int getGlobalOffset(const core::behavior::BaseMechanicalState* mstate) const override
+    {
+        std::lock_guard<std::mutex> lock(*mutex);
+        return accessor->getGlobalOffset(mstate);
+    }
+
+    MatrixRef getMatrix(const core::behavior::BaseMechanicalState* mstate) const override
+    {
+        MatrixRef r;
+        {
+            std::lock_guard<std::mutex> lock(*mutex);
+            r = accessor->getMatrix(mstate);
+        }
+        r.matrix = getEntryList(r.matrix);
+        return r;
+    }
+
+    InteractionMatrixRef getMatrix(const core::behavior::BaseMechanicalState* mstate1, const core::behavior::BaseMechanicalState* mstate2) const override
+    {
+        InteractionMatrixRef r;
+        {
+            std::lock_guard<std::mutex> lock(*mutex);
+            // the diagonal block of a state is only known after the state matrix is requested, which the
+            // sequential assembly does in a previous component
+            if (mstate1 == mstate2)
+                accessor->getMatrix(mstate1);
+            r = accessor->getMatrix(mstate1, mstate2);
+        }
+        r.matrix = getEntryList(r.matrix);
+        return r;
+    }
+
+protected:
+    const core::behavior::MultiMatrixAccessor* accessor;
+    std::mutex* mutex;
+    mutable std::vector< std::unique_ptr<MatrixEntryList> > lists;
+    mutable std::size_t nbLists; ///< number of lists used since the last reset
+
+    MatrixEntryList* getEntryList(defaulttype::BaseMatrix* target) const
+    {
+        if (target == nullptr)
+            return nullptr;
+        for (std::size_t l = 0; l < nbLists; ++l)
+            if (lists[l]->getTarget() == target)
+                return lists[l].get();
+        if (nbLists == lists.size())
+            lists.emplace_back(new MatrixEntryList);
+        lists[nbLists]->reset(target);
+        return lists[nbLists++].get();
+    }
+};
+
+
+/// Collect the force fields and projective constraints in the order of MechanicalAddMBK_ToMatrixVisitor
+class ParallelMatrixAssembly::CollectVisitor : public simulation::MechanicalVisitor
+{
+public:
+    std::vector<Step>& steps;
+
+    CollectVisitor(const core::MechanicalParams* mparams, std::vector<Step>& steps)
+        : simulation::MechanicalVisitor(mparams), steps(steps)
+    {
+    }
+
+    const char* getClassName() const override { return "ParallelMatrixAssembly::CollectVisitor"; }
+
+    Result fwdForceField(simulation::Node* /*node*/, core::behavior::BaseForceField* ff) override
+    {
+        assert( !ff->isCompliance.getValue() );
+        Step step = { ff, nullptr };
+        steps.push_back(step);
+        return RESULT_CONTINUE;
+    }
+
+    Result fwdProjectiveConstraintSet(simulation::Node* /*node*/, core::behavior::BaseProjectiveConstraintSet* c) override
+    {
+        Step step = { nullptr, c };
+        steps.push_back(step);
+        return RESULT_CONTINUE;
+    }
+
+    bool stopAtMechanicalMapping(simulation::Node* /*node*/, core::BaseMapping* map) override
+    {
+        return !map->areMatricesMapped();
+    }
+};
+
+
+ParallelMatrixAssembly::ParallelMatrixAssembly()
+{
+}
+
+ParallelMatrixAssembly::~ParallelMatrixAssembly()
+{
+}
+
+void ParallelMatrixAssembly::addMBK_ToMatrix(const core::MechanicalParams* mparams, core::objectmodel::BaseContext* context,
+                                             const core::behavior::MultiMatrixAccessor* accessor,
+                                             defaulttype::BaseMatrix* globalMatrix, const AddEntryListsFunction& addToGlobalMatrix)
+{
+    steps.clear();
+    CollectVisitor collect(mparams, steps);
+    simulation::common::VisitorExecuteFunc executeVisitor(*context);
+    executeVisitor(&collect);
+
+    std::vector<core::behavior::BaseForceField*> forceFields;
+    for (const Step& step : steps)
+        if (step.forceField)
+            forceFields.push_back(step.forceField);
+
+    std::mutex mutex;
+    while (accessors.size() < forceFields.size())
+        accessors.emplace_back(new ComponentAccessor);
+    for (std::size_t f = 0; f < forceFields.size(); ++f)
+        accessors[f]->reset(accessor, &mutex);
+
+    simulation::parallelFor(simulation::TaskScheduler::getInstance(), 0, forceFields.size(), 1, [&](std::size_t first, std::size_t last)
+    {
+        for (std::size_t f = first; f < last; ++f)
+            forceFields[f]->addMBKToMatrix(mparams, accessors[f].get());
+    });
+
+    // the lists are added just before the next step writing directly in the matrices
+    VecEntryList pending;
+    std::size_t f = 0;
+    for (const Step& step : steps)
+    {
+        if (step.forceField)
+        {
+            const ComponentAccessor* componentAccessor = accessors[f++].get();
+            if (componentAccessor->isValid())
+            {
+                componentAccessor->getEntryLists(pending);
+            }
+            else
+            {
+                flushEntryLists(pending, globalMatrix, addToGlobalMatrix);
+                step.forceField->addMBKToMatrix(mparams, accessor);
+            }
+        }
+        else
+        {
+            flushEntryLists(pending, globalMatrix, addToGlobalMatrix);
+            step.constraint->applyConstraint(mparams, accessor);
+        }
+    }
+    flushEntryLists(pending, globalMatrix, addToGlobalMatrix);
+}
+
+void ParallelMatrixAssembly::flushEntryLists(VecEntryList& lists, defaulttype::BaseMatrix* globalMatrix, const AddEntryListsFunction& addToGlobalMatrix)
+{
+    if (lists.empty())
+        return;
+
+    VecEntryList globalLists;
+    for (const MatrixEntryList* list : lists)
+    {
+        if (list->getTarget() == globalMatrix)
+            globalLists.push_back(list);
+        else
+            list->addToTarget();
+    }
+    if (!globalLists.empty())
+        addToGlobalMatrix(globalLists);
+    lists.clear();
+}
+
+} // namespace linearsolver
+
+} // namespace component
+
+} // namespace sofa
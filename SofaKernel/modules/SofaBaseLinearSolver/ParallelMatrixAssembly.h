@@ -0,0 +1,224 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_COMPONENT_LINEARSOLVER_PARALLELMATRIXASSEMBLY_H
+#define SOFA_COMPONENT_LINEARSOLVER_PARALLELMATRIXASSEMBLY_H
+#include "config.h"
+
+#include <sofa/core/behavior/MultiMatrixAccessor.h>
+#include <sofa/core/behavior/BaseForceField.h>
+#include <sofa/core/behavior/BaseProjectiveConstraintSet.h>
+#include <sofa/core/MechanicalParams.h>
+#include <sofa/defaulttype/BaseMatrix.h>
+#include <SofaBaseLinearSolver/CompressedRowSparseMatrix.h>
+#include <sofa/simulation/ParallelFor.h>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace linearsolver
+{
+
+/// Matrix recording the entries added to another matrix (the target), to add them to it later in the same order.
+///
+/// Only add() is recorded. The other accesses are not supported: they mark the list as invalid.
+class SOFA_BASE_LINEAR_SOLVER_API MatrixEntryList : public defaulttype::BaseMatrix
+{
+public:
+    struct Entry
+    {
+        Index i, j;
+        SReal value;
+    };
+    typedef std::vector<Entry> VecEntry;
+
+    MatrixEntryList(defaulttype::BaseMatrix* target = nullptr);
+
+    /// Remove the entries, keeping the allocated memory, and set the matrix the next entries will be added to
+    void reset(defaulttype::BaseMatrix* target);
+
+    defaulttype::BaseMatrix* getTarget() const { return target; }
+    const VecEntry& getEntries() const { return entries; }
+
+    /// False if another method than add() was called since the last reset()
+    bool isValid() const { return valid; }
+
+    /// Add the entries to the target matrix
+    void addToTarget() const;
+
+    Index rowSize() const override { return target->rowSize(); }
+    Index colSize() const override { return target->colSize(); }
+    SReal element(Index i, Index j) const override;
+    void resize(Index nbRow, Index nbCol) override;
+    void clear() override;
+    void set(Index i, Index j, double v) override;
+    void add(Index i, Index j, double v) override
+    {
+        Entry e;
+        e.i = i;
+        e.j = j;
+        e.value = (SReal)v;
+        entries.push_back(e);
+    }
+
+protected:
+    defaulttype::BaseMatrix* target;
+    VecEntry entries;
+    mutable bool valid;
+};
+
+/// Assembly of the mechanical matrices of a scene, computing the entries of the force fields and masses in parallel.
+///
+/// The force fields and projective constraints are visited in the same order as MechanicalAddMBK_ToMatrixVisitor.
+/// Each force field then adds its entries into its own MatrixEntryList, in the tasks of the task scheduler. Finally
+/// the lists are added to the matrices in the visiting order, interleaved with the projective constraints, so that
+/// each entry receives the same additions, in the same order, as in the sequential assembly.
+/// A force field using another method than add() on its matrices is assembled again sequentially, at its place.
+/// The force fields must support being assembled at the same time as the other ones.
+class SOFA_BASE_LINEAR_SOLVER_API ParallelMatrixAssembly
+{
+public:
+    typedef std::vector<const MatrixEntryList*> VecEntryList;
+    typedef std::function<void(const VecEntryList&)> AddEntryListsFunction;
+
+    ParallelMatrixAssembly();
+    ~ParallelMatrixAssembly();
+
+    /// Add the mechanical matrices of the components below the given context, using the factors of mparams.
+    /// The entries of globalMatrix, which accessor gives for the non-mapped states, are added by addToGlobalMatrix.
+    /// The entries of the other matrices are added sequentially.
+    void addMBK_ToMatrix(const core::MechanicalParams* mparams, core::objectmodel::BaseContext* context,
+                         const core::behavior::MultiMatrixAccessor* accessor,
+                         defaulttype::BaseMatrix* globalMatrix, const AddEntryListsFunction& addToGlobalMatrix);
+
+protected:
+    class ComponentAccessor;
+    class CollectVisitor;
+
+    /// Force field or projective constraint, in the visiting order
+    struct Step
+    {
+        core::behavior::BaseForceField* forceField;
+        core::behavior::BaseProjectiveConstraintSet* constraint;
+    };
+
+    std::vector<Step> steps;
+    std::vector< std::unique_ptr<ComponentAccessor> > accessors; ///< one per force field, reused in the next assemblies
+
+    void flushEntryLists(VecEntryList& lists, defaulttype::BaseMatrix* globalMatrix, const AddEntryListsFunction& addToGlobalMatrix);
+};
+
+/// Add the entries of the lists to M, in order
+template<class TMatrix>
+void addEntryLists(TMatrix& M, const ParallelMatrixAssembly::VecEntryList& lists)
+{
+    for (const MatrixEntryList* list : lists)
+        for (const MatrixEntryList::Entry& e : list->getEntries())
+            M.add(e.i, e.j, e.value);
+}
+
+/// Add the entries of the lists to a CompressedRowSparseMatrix, in parallel.
+/// The rows are split in chunks of parallelGrainSize block rows, and each chunk adds its entries in the order of the
+/// lists to the existing blocks. The entries of new blocks are then added sequentially, in the same order.
+template<class TBloc, class TVecBloc, class TVecIndex>
+void addEntryLists(CompressedRowSparseMatrix<TBloc,TVecBloc,TVecIndex>& M, const ParallelMatrixAssembly::VecEntryList& lists)
+{
+    typedef CompressedRowSparseMatrix<TBloc,TVecBloc,TVecIndex> Matrix;
+    typedef typename Matrix::Index Index;
+    typedef typename Matrix::Bloc Bloc;
+    typedef typename Matrix::traits traits;
+    typedef typename Matrix::Real Real;
+    typedef MatrixEntryList::Entry Entry;
+
+    if (lists.empty() || M.nBlocRow == 0)
+        return;
+
+    M.compress();
+
+    simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+    const std::size_t rowsPerChunk = std::max<Index>(M.parallelGrainSize, 1);
+    const std::size_t nbChunks = (M.nBlocRow + rowsPerChunk - 1) / rowsPerChunk;
+    const std::size_t nbLists = lists.size();
+
+    // sort the entries of each list by chunk, keeping their order in each chunk
+    std::vector< std::vector<std::size_t> > chunkBegin(nbLists);
+    std::vector< std::vector<std::size_t> > order(nbLists);
+    simulation::parallelFor(scheduler, 0, nbLists, 1, [&](std::size_t firstList, std::size_t lastList)
+    {
+        for (std::size_t l = firstList; l < lastList; ++l)
+        {
+            const MatrixEntryList::VecEntry& entries = lists[l]->getEntries();
+            std::vector<std::size_t>& begin = chunkBegin[l];
+            begin.assign(nbChunks + 1, 0);
+            for (const Entry& e : entries)
+                ++begin[std::min<std::size_t>(e.i / Matrix::NL / rowsPerChunk, nbChunks - 1) + 1];
+            for (std::size_t c = 0; c < nbChunks; ++c)
+                begin[c + 1] += begin[c];
+            std::vector<std::size_t> position(begin.begin(), begin.end() - 1);
+            order[l].resize(entries.size());
+            for (std::size_t k = 0; k < entries.size(); ++k)
+                order[l][position[std::min<std::size_t>(entries[k].i / Matrix::NL / rowsPerChunk, nbChunks - 1)]++] = k;
+        }
+    });
+
+    // the compressed structure is only read here, the entries of missing blocks are kept for later
+    std::vector< std::vector<Entry> > missing(nbChunks);
+    simulation::parallelFor(scheduler, 0, nbChunks, 1, [&](std::size_t firstChunk, std::size_t lastChunk)
+    {
+        for (std::size_t c = firstChunk; c < lastChunk; ++c)
+        {
+            for (std::size_t l = 0; l < nbLists; ++l)
+            {
+                const MatrixEntryList::VecEntry& entries = lists[l]->getEntries();
+                for (std::size_t k = chunkBegin[l][c]; k < chunkBegin[l][c + 1]; ++k)
+                {
+                    const Entry& e = entries[order[l][k]];
+                    Index i = e.i, j = e.j, bi = 0, bj = 0;
+                    Matrix::split_row_index(i, bi);
+                    Matrix::split_col_index(j, bj);
+                    if (Bloc* b = M.wbloc(i, j, false))
+                        traits::v(*b, bi, bj) += (Real)e.value;
+                    else
+                        missing[c].push_back(e);
+                }
+            }
+        }
+    });
+
+    for (const std::vector<Entry>& entries : missing)
+        for (const Entry& e : entries)
+            M.add(e.i, e.j, e.value);
+}
+
+} // namespace linearsolver
+
+} // namespace component
+
+} // namespace sofa
+
+#endif
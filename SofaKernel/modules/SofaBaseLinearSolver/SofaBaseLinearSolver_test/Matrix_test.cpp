@@ -33,6 +33,8 @@
 #include <SofaBaseLinearSolver/CompressedRowSparseMatrix.h>
 #include <SofaBaseLinearSolver/FullMatrix.h>
 #include <SofaBaseLinearSolver/FullVector.h>
+#include <SofaBaseLinearSolver/ParallelMatrixAssembly.h>
+#include <sofa/simulation/TaskScheduler.h>
 
 #include <sofa/defaulttype/Mat.h>
 #include <sofa/defaulttype/Vec.h>
@@ -71,7 +71,79 @@ TEST_F(TestMatrix, crs1_vector_product )
     fullVec_nrows_result = crs1 * fullVec_ncols;
     ASSERT_TRUE(vectorMaxDiff(fullVec_nrows_reference,fullVec_nrows_result) < epsilon() );
 }
+TEST_F(TestMatrix, crs1_parallel_vector_product )
+{
+    simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+    scheduler->init(4);
+    crs1.setParallelProducts(true, 1);
+    fullVec_nrows_result = crs1 * fullVec_ncols;
+    scheduler->stop();
+    ASSERT_TRUE(vectorMaxDiff(fullVec_nrows_reference,fullVec_nrows_result) < epsilon() );
+}
+TEST_F(TestMatrix, crs1_parallel_transpose_vector_product )
+{
+    FullVector sequentialResult, parallelResult;
+    crs1.addMultTranspose(sequentialResult, fullVec_nrows_reference);
+    simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+    scheduler->init(4);
+    crs1.setParallelProducts(true, 1);
+    crs1.addMultTranspose(parallelResult, fullVec_nrows_reference);
+    scheduler->stop();
+    ASSERT_TRUE(vectorMaxDiff(sequentialResult,parallelResult) < 100*epsilon() );
+}
 
+TEST_F(TestMatrix, crs1_pattern_cache_assembly )
+{
+    CRSMatrixMN cached;
+    cached.setPatternCache(true);
+    MatMN values;
+    for (unsigned step = 0; step < 6; ++step)
+    {
+        // the sparsity changes at the first and fourth steps only
+        if (step == 0 || step == 3)
+            generateRandomMat( mat, true );
+        values = mat * Real(step+1);
+
+        cached.resize(NROWS, NCOLS);
+        for (unsigned j=0; j<NCOLS; j++)
+            for (unsigned i=0; i<NROWS; i++)
+                if (values(i,j) != 0) cached.add(i, j, values(i,j));
+        if (step != 0 && step != 3)
+        {
+            EXPECT_TRUE( cached.btemp.empty() ) << "step " << step;
+        }
+        cached.compress();
+        ASSERT_TRUE( matrixMaxDiff(values, cached) < 100*epsilon() ) << "step " << step;
+    }
+}
+
+TEST_F(TestMatrix, crs1_parallel_add_entry_lists )
+{
+    // the entries of mat are in the pattern kept by clear(), some of the other ones are new blocks
+    CRSMatrixMN parallel;
+    copyFromMat( parallel, mat );
+    parallel.clear();
+    parallel.parallelGrainSize = 1;
+    MatMN other;
+    generateRandomMat( other, true );
+
+    component::linearsolver::MatrixEntryList list1(&parallel), list2(&parallel);
+    for (unsigned j=0; j<NCOLS; j++)
+        for (unsigned i=0; i<NROWS; i++)
+        {
+            if (mat(i,j) != 0) list1.add(i, j, mat(i,j));
+            if (other(i,j) != 0) list2.add(i, j, other(i,j));
+        }
+    component::linearsolver::ParallelMatrixAssembly::VecEntryList lists;
+    lists.push_back(&list1);
+    lists.push_back(&list2);
+    simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+    scheduler->init(4);
+    component::linearsolver::addEntryLists(parallel, lists);
+    scheduler->stop();
+    parallel.compress();
+    ASSERT_TRUE( matrixMaxDiff(mat + other, parallel) < 100*epsilon() );
+}
 
 // ==============================
 // Matrix product tests
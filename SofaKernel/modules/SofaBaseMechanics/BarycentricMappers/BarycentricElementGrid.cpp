@@ -0,0 +1,214 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include "BarycentricElementGrid.h"
+
+#include <cmath>
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace mapping
+{
+
+BarycentricElementGrid::BarycentricElementGrid()
+    : m_nbElements(0)
+    , m_cellSize(1.0)
+    , m_size(0,0,0)
+{
+}
+
+void BarycentricElementGrid::clear()
+{
+    m_nbElements = 0;
+    m_size = Vec3i(0,0,0);
+    m_regionBegin.clear();
+    m_regionElements.clear();
+    m_centerBegin.clear();
+    m_centerElements.clear();
+}
+
+void BarycentricElementGrid::build(const helper::vector<Vector3>& regionMin,
+                                   const helper::vector<Vector3>& regionMax,
+                                   const helper::vector<Vector3>& centers)
+{
+    clear();
+    const unsigned int nbElements = (unsigned int)centers.size();
+    if (nbElements == 0 || regionMin.size() != nbElements || regionMax.size() != nbElements)
+        return;
+
+    Vector3 bbmin = centers[0], bbmax = centers[0];
+    double meanSize = 0;
+    for (unsigned int e = 0; e < nbElements; ++e)
+    {
+        double size = 0;
+        for (int c = 0; c < 3; ++c)
+        {
+            bbmin[c] = std::min(bbmin[c], std::min(regionMin[e][c], centers[e][c]));
+            bbmax[c] = std::max(bbmax[c], std::max(regionMax[e][c], centers[e][c]));
+            size = std::max(size, regionMax[e][c] - regionMin[e][c]);
+        }
+        meanSize += size;
+    }
+    meanSize /= nbElements;
+
+    const Vector3 extent = bbmax - bbmin;
+    const double maxExtent = std::max(extent[0], std::max(extent[1], extent[2]));
+    if (!std::isfinite(maxExtent))
+        return;
+
+    double cellSize = meanSize;
+    if (!(cellSize > 0))
+        cellSize = maxExtent > 0 ? maxExtent / std::cbrt((double)nbElements) : 1.0;
+
+    // keep the number of cells proportional to the number of elements
+    const long long maxCells = 8*(long long)nbElements + 64;
+    for (;;)
+    {
+        long long nbCells = 1;
+        for (int c = 0; c < 3; ++c)
+        {
+            m_size[c] = (int)std::floor(extent[c] / cellSize) + 1;
+            nbCells *= m_size[c];
+        }
+        if (nbCells <= maxCells)
+            break;
+        cellSize *= 2;
+    }
+
+    m_nbElements = nbElements;
+    m_origin = bbmin;
+    m_cellSize = cellSize;
+
+    const int nbCells = m_size[0]*m_size[1]*m_size[2];
+    m_regionBegin.assign(nbCells+1, 0);
+    m_centerBegin.assign(nbCells+1, 0);
+
+    // count, then fill the cell lists in increasing element order
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        for (unsigned int e = 0; e < nbElements; ++e)
+        {
+            const Vec3i cmin = getClampedCell(regionMin[e]);
+            const Vec3i cmax = getClampedCell(regionMax[e]);
+            for (int k = cmin[2]; k <= cmax[2]; ++k)
+                for (int j = cmin[1]; j <= cmax[1]; ++j)
+                    for (int i = cmin[0]; i <= cmax[0]; ++i)
+                    {
+                        const int cell = cellIndex(i,j,k);
+                        if (pass == 0) ++m_regionBegin[cell+1];
+                        else m_regionElements[m_regionBegin[cell]++] = e;
+                    }
+
+            const Vec3i c = getClampedCell(centers[e]);
+            const int cell = cellIndex(c[0],c[1],c[2]);
+            if (pass == 0) ++m_centerBegin[cell+1];
+            else m_centerElements[m_centerBegin[cell]++] = e;
+        }
+
+        if (pass == 0)
+        {
+            for (int cell = 0; cell < nbCells; ++cell)
+            {
+                m_regionBegin[cell+1] += m_regionBegin[cell];
+                m_centerBegin[cell+1] += m_centerBegin[cell];
+            }
+            m_regionElements.resize(m_regionBegin[nbCells]);
+            m_centerElements.resize(m_centerBegin[nbCells]);
+        }
+        else
+        {
+            // the fill pass shifted each begin to the begin of the next cell
+            for (int cell = nbCells; cell > 0; --cell)
+            {
+                m_regionBegin[cell] = m_regionBegin[cell-1];
+                m_centerBegin[cell] = m_centerBegin[cell-1];
+            }
+            m_regionBegin[0] = 0;
+            m_centerBegin[0] = 0;
+        }
+    }
+}
+
+BarycentricElementGrid::Vec3i BarycentricElementGrid::getCell(const Vector3& p) const
+{
+    Vec3i cell;
+    for (int c = 0; c < 3; ++c)
+    {
+        const double x = std::floor((p[c] - m_origin[c]) / m_cellSize);
+        if (!(x >= 0 && x < m_size[c]))
+            return Vec3i(-1,-1,-1);
+        cell[c] = (int)x;
+    }
+    return cell;
+}
+
+BarycentricElementGrid::Vec3i BarycentricElementGrid::getClampedCell(const Vector3& p) const
+{
+    Vec3i cell;
+    for (int c = 0; c < 3; ++c)
+    {
+        const double x = std::floor((p[c] - m_origin[c]) / m_cellSize);
+        if (x >= m_size[c]) cell[c] = m_size[c]-1;
+        else if (x >= 0) cell[c] = (int)x;
+        else cell[c] = 0; // also catches NaN
+    }
+    return cell;
+}
+
+void BarycentricElementGrid::computeBounds(const Vector3* points, int nbPoints, Vector3& bbmin, Vector3& bbmax)
+{
+    bbmin = bbmax = points[0];
+    for (int i = 1; i < nbPoints; ++i)
+        for (int c = 0; c < 3; ++c)
+        {
+            bbmin[c] = std::min(bbmin[c], points[i][c]);
+            bbmax[c] = std::max(bbmax[c], points[i][c]);
+        }
+    const Vector3 extent = bbmax - bbmin;
+    const double margin = 1e-6 * std::max(extent[0], std::max(extent[1], extent[2]));
+    bbmin -= Vector3(margin, margin, margin);
+    bbmax += Vector3(margin, margin, margin);
+}
+
+void BarycentricElementGrid::getInsideCandidates(const Vector3& p, const unsigned int*& begin, const unsigned int*& end) const
+{
+    begin = end = nullptr;
+    if (m_nbElements == 0)
+        return;
+    const Vec3i c = getCell(p);
+    if (c[0] < 0)
+        return;
+    const int cell = cellIndex(c[0],c[1],c[2]);
+    if (m_regionBegin[cell] == m_regionBegin[cell+1])
+        return;
+    begin = m_regionElements.data() + m_regionBegin[cell];
+    end = m_regionElements.data() + m_regionBegin[cell+1];
+}
+
+} // namespace mapping
+
+} // namespace component
+
+} // namespace sofa
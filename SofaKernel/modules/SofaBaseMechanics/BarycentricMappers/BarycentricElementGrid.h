@@ -0,0 +1,138 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_COMPONENT_MAPPING_BARYCENTRICELEMENTGRID_H
+#define SOFA_COMPONENT_MAPPING_BARYCENTRICELEMENTGRID_H
+#include <SofaBaseMechanics/config.h>
+
+#include <sofa/defaulttype/Vec.h>
+#include <sofa/helper/vector.h>
+
+#include <algorithm>
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace mapping
+{
+
+/// Uniform grid over the elements of a mesh, used by the barycentric mappers to
+/// locate the mapped points without testing every element.
+///
+/// Each element is registered in the cells overlapped by the bounding box of the
+/// region where a point is considered inside it, and in the cell of its center.
+/// Cell lists are sorted by element index, so that a search over the grid can
+/// reproduce the result of a linear search over all the elements.
+class SOFA_BASE_MECHANICS_API BarycentricElementGrid
+{
+public:
+    typedef defaulttype::Vector3 Vector3;
+    typedef defaulttype::Vec<3,int> Vec3i;
+
+    BarycentricElementGrid();
+
+    /// Build the grid from the bounding boxes of the element regions and their centers
+    void build(const helper::vector<Vector3>& regionMin,
+               const helper::vector<Vector3>& regionMax,
+               const helper::vector<Vector3>& centers);
+
+    void clear();
+
+    bool empty() const { return m_nbElements == 0; }
+
+    /// Elements whose region bounding box may contain p, in increasing index order
+    void getInsideCandidates(const Vector3& p, const unsigned int*& begin, const unsigned int*& end) const;
+
+    /// Visit the elements by rings of cells around p, in increasing distance to p,
+    /// until the squared distance of the nearest center found so far is below the
+    /// distance of the next ring. The visitor is called with an element index and is
+    /// expected to update bestDistance2.
+    template<class Visitor>
+    void visitCentersByDistance(const Vector3& p, const double& bestDistance2, Visitor visit) const
+    {
+        if (m_nbElements == 0)
+            return;
+
+        const Vec3i c = getClampedCell(p);
+        const int maxRing = std::max(m_size[0], std::max(m_size[1], m_size[2]));
+        for (int r = 0; r <= maxRing; ++r)
+        {
+            for (int i = c[0]-r; i <= c[0]+r; ++i)
+            {
+                if (i < 0 || i >= m_size[0]) continue;
+                const bool borderI = (i == c[0]-r || i == c[0]+r);
+                for (int j = c[1]-r; j <= c[1]+r; ++j)
+                {
+                    if (j < 0 || j >= m_size[1]) continue;
+                    const bool borderJ = borderI || (j == c[1]-r || j == c[1]+r);
+                    for (int k = c[2]-r; k <= c[2]+r; ++k)
+                    {
+                        if (k < 0 || k >= m_size[2]) continue;
+                        // only the shell of the cube of half-width r is visited
+                        if (!borderJ && k != c[2]-r && k != c[2]+r) continue;
+                        const int cell = cellIndex(i,j,k);
+                        for (unsigned int n = m_centerBegin[cell]; n < m_centerBegin[cell+1]; ++n)
+                            visit(m_centerElements[n]);
+                    }
+                }
+            }
+
+            // the cells of the following rings are at least r cells away from the cell of the
+            // projection of p on the grid, and the projection on a box does not increase distances
+            const double ringDistance = r * m_cellSize;
+            if (bestDistance2 <= ringDistance*ringDistance)
+                break;
+        }
+    }
+
+    /// Bounding box of the given points, slightly enlarged to be robust to rounding errors
+    static void computeBounds(const Vector3* points, int nbPoints, Vector3& bbmin, Vector3& bbmax);
+
+    double getCellSize() const { return m_cellSize; }
+    const Vec3i& getSize() const { return m_size; }
+
+protected:
+    int cellIndex(int i, int j, int k) const { return (k*m_size[1] + j)*m_size[0] + i; }
+    Vec3i getCell(const Vector3& p) const;
+    Vec3i getClampedCell(const Vector3& p) const;
+
+    unsigned int m_nbElements;
+    Vector3 m_origin;
+    double m_cellSize;
+    Vec3i m_size;
+
+    /// Compressed cell lists: elements of cell c are in [begin[c], begin[c+1])
+    helper::vector<unsigned int> m_regionBegin;
+    helper::vector<unsigned int> m_regionElements;
+    helper::vector<unsigned int> m_centerBegin;
+    helper::vector<unsigned int> m_centerElements;
+};
+
+} // namespace mapping
+
+} // namespace component
+
+} // namespace sofa
+
+#endif
@@ -84,6 +84,10 @@ public:
     virtual void applyOnePoint( const unsigned int& hexaId, typename Out::VecCoord& out, const typename In::VecCoord& in);
     virtual void clear( int reserve=0 ) =0;
 
+    /// Locate the mapped points concurrently during init, using the global task scheduler
+    void setParallelInit(bool parallelInit) { m_parallelInit = parallelInit; }
+    bool getParallelInit() const { return m_parallelInit; }
+
     inline friend std::istream& operator >> ( std::istream& in, BarycentricMapper< In, Out > & ) {return in;}
     inline friend std::ostream& operator << ( std::ostream& out, const BarycentricMapper< In, Out > &  ) { return out; }
 
@@ -91,6 +95,12 @@ public:
 protected:
     void addMatrixContrib(MatrixType* m, int row, int col, Real value);
 
+    /// Call f(i) for each i in [0,size), concurrently if parallel init is enabled
+    template<class F>
+    void forEachPointToLocate(std::size_t size, F f) const;
+
+    bool m_parallelInit {false};
+
     template< int NC,  int NP>
     class MappingData
     {
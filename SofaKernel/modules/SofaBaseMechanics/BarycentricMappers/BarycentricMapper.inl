@@ -23,6 +23,7 @@
 #define SOFA_COMPONENT_MAPPING_BARYCENTRICMAPPER_INL
 
 #include "BarycentricMapper.h"
+#include <sofa/simulation/ParallelFor.h>
 
 namespace sofa
 {
@@ -64,6 +65,26 @@ void BarycentricMapper<In,Out>::applyOnePoint( const unsigned int& hexaId, typen
     SOFA_UNUSED(in);
 }
 
+template<class In, class Out>
+template<class F>
+void BarycentricMapper<In,Out>::forEachPointToLocate(std::size_t size, F f) const
+{
+    if (m_parallelInit)
+    {
+        simulation::parallelFor(simulation::TaskScheduler::getInstance(), 0, size, 64,
+                                [&f](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; ++i)
+                f(i);
+        });
+    }
+    else
+    {
+        for (std::size_t i = 0; i < size; ++i)
+            f(i);
+    }
+}
+
 }}}}
 
 #endif
@@ -23,6 +23,7 @@
 #define SOFA_COMPONENT_MAPPING_BARYCENTRICMAPPERMESHTOPOLOGY_H
 
 #include <SofaBaseMechanics/BarycentricMappers/TopologyBarycentricMapper.h>
+#include <SofaBaseMechanics/BarycentricMappers/BarycentricElementGrid.h>
 
 namespace sofa
 {
@@ -106,6 +107,14 @@ protected:
     MatrixType* m_matrixJ {nullptr};
     bool        m_updateJ {false};
 private:
+    /// Find the element containing pos, or else the one with the nearest center, with the
+    /// same result as a linear search over all the elements. distance(e,pos,coefs) computes
+    /// the barycentric coordinates of pos in e and returns a negative value if pos is inside.
+    template<class Distance>
+    void locateInElements(const BarycentricElementGrid& grid, const helper::vector<defaulttype::Vector3>& centers,
+                          const defaulttype::Vector3& pos, const Distance& distance,
+                          int& index, defaulttype::Vector3& coefs) const;
+
     void clearMap1dAndReserve(int size=0);
     void clearMap2dAndReserve(int size=0);
     void clearMap3dAndReserve(int size=0);
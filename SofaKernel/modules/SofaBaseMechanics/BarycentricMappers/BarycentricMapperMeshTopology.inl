@@ -23,6 +23,7 @@
 #define SOFA_COMPONENT_MAPPING_BARYCENTRICMAPPERMESHTOPOLOGY_INL
 
 #include "BarycentricMapperMeshTopology.h"
+#include "BarycentricMapper.inl"
 #include <sofa/core/visual/VisualParams.h>
 
 namespace sofa
@@ -151,30 +152,51 @@ void BarycentricMapperMeshTopology<In,Out>::init ( const typename Out::VecCoord&
                 bases[nbTriangles+q].invert ( mt );
                 centers[nbTriangles+q] = ( in[quads[q][0]]+in[quads[q][1]]+in[quads[q][2]]+in[quads[q][3]] ) *0.25;
             }
-            for ( unsigned int i=0; i<out.size(); i++ )
+
+            // Bounds of the regions where a point is considered inside each element
+            helper::vector<Vector3> regionMin ( bases.size() ), regionMax ( bases.size() );
+            for ( unsigned int t = 0; t < triangles.size(); t++ )
             {
-                Vector3 outPos = Out::getCPos(out[i]);
-                Vector3 coefs;
-                int index = -1;
-                double distance = 1e10;
-                for ( unsigned int t = 0; t < triangles.size(); t++ )
-                {
-                    Vec3d v = bases[t] * ( outPos - in[triangles[t][0]] );
-                    double d = std::max ( std::max ( -v[0],-v[1] ),std::max ( ( v[2]<0?-v[2]:v[2] )-0.01,v[0]+v[1]-1 ) );
-                    if ( d>0 ) d = ( outPos-centers[t] ).norm2();
-                    if ( d<distance ) { coefs = v; distance = d; index = int(t); }
-                }
-                for ( unsigned int q = 0; q < quads.size(); q++ )
+                const Vector3 p0 = in[triangles[t][0]];
+                const Vector3 m0 = in[triangles[t][1]]-p0, m1 = in[triangles[t][2]]-p0, n = cross ( m0,m1 )*0.01;
+                const Vector3 corners[6] = { p0+n, p0+m0+n, p0+m1+n, p0-n, p0+m0-n, p0+m1-n };
+                BarycentricElementGrid::computeBounds ( corners, 6, regionMin[t], regionMax[t] );
+            }
+            for ( unsigned int q = 0; q < quads.size(); q++ )
+            {
+                const Vector3 p0 = in[quads[q][0]];
+                const Vector3 m0 = in[quads[q][1]]-p0, m1 = in[quads[q][3]]-p0, n = cross ( m0,m1 )*0.01;
+                const Vector3 corners[8] = { p0+n, p0+m0+n, p0+m1+n, p0+m0+m1+n, p0-n, p0+m0-n, p0+m1-n, p0+m0+m1-n };
+                BarycentricElementGrid::computeBounds ( corners, 8, regionMin[nbTriangles+q], regionMax[nbTriangles+q] );
+            }
+            BarycentricElementGrid grid;
+            grid.build ( regionMin, regionMax, centers );
+
+            auto distance = [&] ( unsigned int e, const Vector3& outPos, Vector3& v ) -> double
+            {
+                if ( e < nbTriangles )
                 {
-                    Vec3d v = bases[nbTriangles+q] * ( outPos - in[quads[q][0]] );
-                    double d = std::max ( std::max ( -v[0],-v[1] ),std::max ( std::max ( v[1]-1,v[0]-1 ),std::max ( v[2]-0.01,-v[2]-0.01 ) ) );
-                    if ( d>0 ) d = ( outPos-centers[nbTriangles+q] ).norm2();
-                    if ( d<distance ) { coefs = v; distance = d; index = nbTriangles+q; }
+                    v = bases[e] * ( outPos - in[triangles[e][0]] );
+                    return std::max ( std::max ( -v[0],-v[1] ),std::max ( ( v[2]<0?-v[2]:v[2] )-0.01,v[0]+v[1]-1 ) );
                 }
+                v = bases[e] * ( outPos - in[quads[e-nbTriangles][0]] );
+                return std::max ( std::max ( -v[0],-v[1] ),std::max ( std::max ( v[1]-1,v[0]-1 ),std::max ( v[2]-0.01,-v[2]-0.01 ) ) );
+            };
+
+            helper::vector<int> indices ( out.size() );
+            helper::vector<Vector3> coefs ( out.size() );
+            this->forEachPointToLocate ( out.size(), [&] ( std::size_t i )
+            {
+                locateInElements ( grid, centers, Out::getCPos(out[i]), distance, indices[i], coefs[i] );
+            } );
+
+            for ( unsigned int i=0; i<out.size(); i++ )
+            {
+                const int index = indices[i];
                 if ( index < int(nbTriangles) )
-                    addPointInTriangle ( index, coefs.ptr() );
+                    addPointInTriangle ( index, coefs[i].ptr() );
                 else
-                    addPointInQuad ( index-nbTriangles, coefs.ptr() );
+                    addPointInQuad ( index-nbTriangles, coefs[i].ptr() );
             }
         }
     }
@@ -204,35 +226,88 @@ void BarycentricMapperMeshTopology<In,Out>::init ( const typename Out::VecCoord&
             bases[nbTetras+h].invert ( mt );
             centers[nbTetras+h] = ( in[hexas[h][0]]+in[hexas[h][1]]+in[hexas[h][2]]+in[hexas[h][3]]+in[hexas[h][4]]+in[hexas[h][5]]+in[hexas[h][6]]+in[hexas[h][7]] ) *0.125;
         }
-        for ( unsigned int i=0; i<out.size(); i++ )
+
+        // Bounds of the regions where a point is considered inside each element
+        helper::vector<Vector3> regionMin ( bases.size() ), regionMax ( bases.size() );
+        for ( unsigned int t = 0; t < tetras.size(); t++ )
         {
-            Vector3 pos = Out::getCPos(out[i]);
-            Vector3 coefs;
-            int index = -1;
-            double distance = 1e10;
-            for ( unsigned int t = 0; t < tetras.size(); t++ )
-            {
-                Vector3 v = bases[t] * ( pos - in[tetras[t][0]] );
-                double d = std::max ( std::max ( -v[0],-v[1] ),std::max ( -v[2],v[0]+v[1]+v[2]-1 ) );
-                if ( d>0 ) d = ( pos-centers[t] ).norm2();
-                if ( d<distance ) { coefs = v; distance = d; index = int(t); }
-            }
-            for ( unsigned int h = 0; h < hexas.size(); h++ )
+            const Vector3 corners[4] = { in[tetras[t][0]], in[tetras[t][1]], in[tetras[t][2]], in[tetras[t][3]] };
+            BarycentricElementGrid::computeBounds ( corners, 4, regionMin[t], regionMax[t] );
+        }
+        for ( unsigned int h = 0; h < hexas.size(); h++ )
+        {
+            // the mapping uses the parallelepiped spanned by the edges 0-1, 0-3 and 0-4
+            const Vector3 p0 = in[hexas[h][0]];
+            const Vector3 m0 = in[hexas[h][1]]-p0, m1 = in[hexas[h][3]]-p0, m2 = in[hexas[h][4]]-p0;
+            const Vector3 corners[8] = { p0, p0+m0, p0+m1, p0+m0+m1, p0+m2, p0+m0+m2, p0+m1+m2, p0+m0+m1+m2 };
+            BarycentricElementGrid::computeBounds ( corners, 8, regionMin[nbTetras+h], regionMax[nbTetras+h] );
+        }
+        BarycentricElementGrid grid;
+        grid.build ( regionMin, regionMax, centers );
+
+        auto distance = [&] ( unsigned int e, const Vector3& pos, Vector3& v ) -> double
+        {
+            if ( e < nbTetras )
             {
-                Vector3 v = bases[nbTetras+h] * ( pos - in[hexas[h][0]] );
-                double d = std::max ( std::max ( -v[0],-v[1] ),std::max ( std::max ( -v[2],v[0]-1 ),std::max ( v[1]-1,v[2]-1 ) ) );
-                if ( d>0 ) d = ( pos-centers[nbTetras+h] ).norm2();
-                if ( d<distance ) { coefs = v; distance = d; index = int(nbTetras+h); }
+                v = bases[e] * ( pos - in[tetras[e][0]] );
+                return std::max ( std::max ( -v[0],-v[1] ),std::max ( -v[2],v[0]+v[1]+v[2]-1 ) );
             }
+            v = bases[e] * ( pos - in[hexas[e-nbTetras][0]] );
+            return std::max ( std::max ( -v[0],-v[1] ),std::max ( std::max ( -v[2],v[0]-1 ),std::max ( v[1]-1,v[2]-1 ) ) );
+        };
+
+        helper::vector<int> indices ( out.size() );
+        helper::vector<Vector3> coefs ( out.size() );
+        this->forEachPointToLocate ( out.size(), [&] ( std::size_t i )
+        {
+            locateInElements ( grid, centers, Out::getCPos(out[i]), distance, indices[i], coefs[i] );
+        } );
+
+        for ( unsigned int i=0; i<out.size(); i++ )
+        {
+            const int index = indices[i];
             if ( index < int(nbTetras) )
-                addPointInTetra ( index, coefs.ptr() );
+                addPointInTetra ( index, coefs[i].ptr() );
             else
-                addPointInCube ( index-nbTetras, coefs.ptr() );
+                addPointInCube ( index-nbTetras, coefs[i].ptr() );
         }
     }
 }
 
 
+template <class In, class Out>
+template <class Distance>
+void BarycentricMapperMeshTopology<In,Out>::locateInElements ( const BarycentricElementGrid& grid, const helper::vector<Vector3>& centers,
+                                                              const Vector3& pos, const Distance& distance,
+                                                              int& index, Vector3& coefs ) const
+{
+    index = -1;
+    double best = 1e10;
+
+    // An element containing the point (lowest distance, then lowest index)
+    const unsigned int* begin;
+    const unsigned int* end;
+    grid.getInsideCandidates ( pos, begin, end );
+    for ( const unsigned int* it = begin; it != end; ++it )
+    {
+        Vector3 v;
+        const double d = distance ( *it, pos, v );
+        if ( d<=0 && d<best ) { coefs = v; best = d; index = int(*it); }
+    }
+    if ( index >= 0 ) return;
+
+    // Otherwise the element with the nearest center
+    grid.visitCentersByDistance ( pos, best, [&] ( unsigned int e )
+    {
+        Vector3 v;
+        double d = distance ( e, pos, v );
+        if ( !( d>0 ) ) return; // degenerate element
+        d = ( pos-centers[e] ).norm2();
+        if ( d<best || ( d==best && int(e)<index ) ) { coefs = v; best = d; index = int(e); }
+    } );
+}
+
+
 template <class In, class Out>
 void BarycentricMapperMeshTopology<In,Out>::clearMap1dAndReserve ( int size )
 {
@@ -24,6 +24,7 @@
 #include <sofa/core/visual/VisualParams.h>
 
 #include "BarycentricMapperTopologyContainer.h"
+#include "BarycentricMapper.inl"
 
 namespace sofa
 {
@@ -147,10 +148,11 @@ void BarycentricMapperTopologyContainer<In,Out,MappingDataType,Element>::init (
 
     // Compute distances to get nearest element and corresponding bary coef
     const helper::vector<Element>& elements = getElements();
-    for ( unsigned int i=0; i<out.size(); i++ )
+    helper::vector<NearestParams> nearest(out.size());
+    this->forEachPointToLocate(out.size(), [&](std::size_t i)
     {
         Vector3 outPos = Out::getCPos(out[i]);
-        NearestParams nearestParams;
+        NearestParams& nearestParams = nearest[i];
 
         // Search nearest element in grid cell
         Vec3i gridIds = getGridIndices(outPos);
@@ -173,7 +175,6 @@ void BarycentricMapperTopologyContainer<In,Out,MappingDataType,Element>::init (
                 Vector3 inPos = in[elements[e][0]];
                 checkDistanceFromElement(e, outPos, inPos, nearestParams);
             }
-            addPointInElement(nearestParams.elementId, nearestParams.baryCoords.ptr());
         }
         else if(abs(nearestParams.distance)>m_gridCellSize/2.) // Nearest element in grid cell may not be optimal, check neighbors
         {
@@ -195,11 +196,12 @@ void BarycentricMapperTopologyContainer<In,Out,MappingDataType,Element>::init (
                             }
                         }
                     }
-            addPointInElement(nearestParams.elementId, nearestParams.baryCoords.ptr());
         }
-        else
-            addPointInElement(nearestParams.elementId, nearestParams.baryCoords.ptr());
-    }
+    });
+
+    // The map is filled sequentially, in the order of the mapped points
+    for ( unsigned int i=0; i<out.size(); i++ )
+        addPointInElement(nearest[i].elementId, nearest[i].baryCoords.ptr());
 }
 
 
@@ -78,6 +78,7 @@ public:
 
 public:
     Data< bool > useRestPosition; ///< Use the rest position of the input and output models to initialize the mapping    
+    Data< bool > d_parallelInit; ///< Locate the mapped points concurrently when initializing the mapping, using the global task scheduler
 
     SingleLink<BarycentricMapping<In,Out>,Mapper,BaseLink::FLAG_STRONGLINK> d_mapper;
     SingleLink<BarycentricMapping<In,Out>,BaseMeshTopology,BaseLink::FLAG_STRONGLINK> d_input_topology;
@@ -98,6 +98,7 @@ static bool is_a(const V * topology) {
 template <class TIn, class TOut>
 BarycentricMapping<TIn, TOut>::BarycentricMapping(core::State<In>* from, core::State<Out>* to, typename Mapper::SPtr mapper)
     : Inherit1 ( from, to )
+    , d_parallelInit(initData(&d_parallelInit, false, "parallelInit", "Locate the mapped points concurrently when initializing the mapping, using the global task scheduler"))
     , d_mapper(initLink("mapper","Internal mapper created depending on the type of topology"), mapper)
     , d_input_topology(initLink("input_topology", "Input topology container (usually the surrounding domain)."))
     , d_output_topology(initLink("output_topology", "Output topology container (usually the immersed domain)."))
@@ -111,6 +112,7 @@ BarycentricMapping<TIn, TOut>::BarycentricMapping(core::State<In>* from, core::S
 template <class TIn, class TOut>
 BarycentricMapping<TIn, TOut>::BarycentricMapping (core::State<In>* from, core::State<Out>* to, BaseMeshTopology * input_topology )
     : Inherit1 ( from, to )
+    , d_parallelInit(initData(&d_parallelInit, false, "parallelInit", "Locate the mapped points concurrently when initializing the mapping, using the global task scheduler"))
     , d_mapper (initLink("mapper","Internal mapper created depending on the type of topology"))
     , d_input_topology(initLink("input_topology", "Input topology container (usually the surrounding domain)."))
     , d_output_topology(initLink("output_topology", "Output topology container (usually the immersed domain)."))
@@ -269,6 +271,7 @@ void BarycentricMapping<TIn, TOut>::init()
     if (!this->toModel)
         return;
 
+    d_mapper->setParallelInit(d_parallelInit.getValue());
     if (useRestPosition.getValue())
         d_mapper->init ( ((const core::State<Out> *)this->toModel)->read(core::ConstVecCoordId::restPosition())->getValue(), ((const core::State<In> *)this->fromModel)->read(core::ConstVecCoordId::restPosition())->getValue() );
     else
@@ -283,6 +286,7 @@ void BarycentricMapping<TIn, TOut>::reinit()
     if ( d_mapper != NULL )
     {
         d_mapper->clear();
+        d_mapper->setParallelInit(d_parallelInit.getValue());
         d_mapper->init (((const core::State<Out> *)this->toModel)->read(core::ConstVecCoordId::position())->getValue(), ((const core::State<In> *)this->fromModel)->read(core::ConstVecCoordId::position())->getValue() );
     }
 }
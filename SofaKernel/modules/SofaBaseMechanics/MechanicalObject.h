@@ -155,6 +155,8 @@ public:
     Data< int > drawMode; ///< The way vectors will be drawn: - 0: Line - 1:Cylinder - 2: Arrow.  The DOFS will be drawn: - 0: point - >1: sphere. (default=0)
     Data< defaulttype::Vec4f > d_color;  ///< drawing color
     Data < bool > isToPrint; ///< ignore some Data for file export
+    Data< bool > d_parallelVectorOperations; ///< Process the entries of the vectors in chunks with the task scheduler in the vector operations (vOp, vMultiOp, vDot). (default=false)
+    Data< unsigned int > d_vectorOperationsGrainSize; ///< Number of entries processed by each task when parallelVectorOperations is true. (default=4096)
 
     void init() override;
     void reinit() override;
@@ -341,6 +343,9 @@ public:
 
     void vMultiOp(const core::ExecParams* params, const VMultiOp& ops) override;
 
+    /// Apply the operations and compute the dot product in a single pass over the entries when all the vectors are derivatives of the same size
+    SReal vMultiOpDot(const core::ExecParams* params, const VMultiOp& ops, core::ConstVecId a, core::ConstVecId b) override;
+
     void vThreshold(core::VecId a, SReal threshold ) override;
 
     SReal vDot(const core::ExecParams* params, core::ConstVecId a, core::ConstVecId b) override;
@@ -434,6 +439,15 @@ protected :
 
     /// @}
 
+    /// Call function(begin, end) on the chunks of [0, size), in parallel if parallelVectorOperations is true
+    template<class Function>
+    void forEachVectorChunk(std::size_t size, const Function& function);
+
+    /// Sum the results of function(begin, end) on the chunks of [0, size), computed in parallel if parallelVectorOperations is true.
+    /// The chunk results are added in order, so that the result only depends on the grain size, not on the number of threads.
+    template<class Function>
+    Real reduceVectorChunks(std::size_t size, const Function& function);
+
     /**
     * @brief Internal function : Draw indices in 3d coordinates.
     */
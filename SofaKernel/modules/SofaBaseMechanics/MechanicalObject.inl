@@ -37,6 +37,7 @@
 #ifdef SOFA_DUMP_VISITOR_INFO
 #include <sofa/simulation/Visitor.h>
 #endif
+#include <sofa/simulation/ParallelFor.h>
 
 #include <cassert>
 #include <iostream>
@@ -99,6 +100,8 @@ MechanicalObject<DataTypes>::MechanicalObject()
     , drawMode(initData(&drawMode,0,"drawMode","The way vectors will be drawn:\n- 0: Line\n- 1:Cylinder\n- 2: Arrow.\n\nThe DOFS will be drawn:\n- 0: point\n- >1: sphere. (default=0)"))
     , d_color(initData(&d_color, defaulttype::Vec4f(1,1,1,1), "showColor", "Color for object display. (default=[1 1 1 1])"))
     , isToPrint( initData(&isToPrint, false, "isToPrint", "suppress somes data before using save as function. (default=false)"))
+    , d_parallelVectorOperations(initData(&d_parallelVectorOperations, false, "parallelVectorOperations", "Process the entries of the vectors in chunks with the task scheduler in the vector operations (vOp, vMultiOp, vDot). Dot products are then summed chunk by chunk. (default=false)"))
+    , d_vectorOperationsGrainSize(initData(&d_vectorOperationsGrainSize, (unsigned int)4096, "vectorOperationsGrainSize", "Number of entries processed by each task when parallelVectorOperations is true. (default=4096)"))
     , translation(initData(&translation, Vector3(), "translation", "Translation of the DOFs"))
     , rotation(initData(&rotation, Vector3(), "rotation", "Rotation of the DOFs"))
     , scale(initData(&scale, Vector3(1.0,1.0,1.0), "scale3d", "Scale of the DOFs in 3 dimensions"))
@@ -1827,15 +1830,21 @@ void MechanicalObject<DataTypes>::vOp(const core::ExecParams* params, core::VecI
             {
                 helper::WriteOnlyAccessor< Data<VecCoord> > vv( params, *this->write(core::VecCoordId(v)) );
                 vv.resize(d_size.getValue());
-                for (unsigned int i=0; i<vv.size(); i++)
-                    vv[i] = Coord();
+                forEachVectorChunk(vv.size(), [&](std::size_t begin, std::size_t end)
+                {
+                    for (std::size_t i=begin; i<end; ++i)
+                        vv[i] = Coord();
+                });
             }
             else
             {
                 helper::WriteOnlyAccessor< Data<VecDeriv> > vv( params, *this->write(core::VecDerivId(v)) );
                 vv.resize(d_size.getValue());
-                for (unsigned int i=0; i<vv.size(); i++)
-                    vv[i] = Deriv();
+                forEachVectorChunk(vv.size(), [&](std::size_t begin, std::size_t end)
+                {
+                    for (std::size_t i=begin; i<end; ++i)
+                        vv[i] = Deriv();
+                });
             }
         }
         else
@@ -1852,14 +1861,20 @@ void MechanicalObject<DataTypes>::vOp(const core::ExecParams* params, core::VecI
                 if (v.type == sofa::core::V_COORD)
                 {
                     helper::WriteAccessor< Data<VecCoord> > vv( params, *this->write(core::VecCoordId(v)) );
-                    for (unsigned int i=0; i<vv.size(); i++)
-                        vv[i] *= (Real)f;
+                    forEachVectorChunk(vv.size(), [&](std::size_t begin, std::size_t end)
+                    {
+                        for (std::size_t i=begin; i<end; ++i)
+                            vv[i] *= (Real)f;
+                    });
                 }
                 else
                 {
                     helper::WriteAccessor< Data<VecDeriv> > vv( params, *this->write(core::VecDerivId(v)) );
-                    for (unsigned int i=0; i<vv.size(); i++)
-                        vv[i] *= (Real)f;
+                    forEachVectorChunk(vv.size(), [&](std::size_t begin, std::size_t end)
+                    {
+                        for (std::size_t i=begin; i<end; ++i)
+                            vv[i] *= (Real)f;
+                    });
                 }
             }
             else
@@ -1870,16 +1885,22 @@ void MechanicalObject<DataTypes>::vOp(const core::ExecParams* params, core::VecI
                     helper::WriteAccessor< Data<VecCoord> > vv( params, *this->write(core::VecCoordId(v)) );
                     helper::ReadAccessor< Data<VecCoord> > vb( params, *this->read(core::ConstVecCoordId(b)) );
                     vv.resize(vb.size());
-                    for (unsigned int i=0; i<vv.size(); i++)
-                        vv[i] = vb[i] * (Real)f;
+                    forEachVectorChunk(vv.size(), [&](std::size_t begin, std::size_t end)
+                    {
+                        for (std::size_t i=begin; i<end; ++i)
+                            vv[i] = vb[i] * (Real)f;
+                    });
                 }
                 else
                 {
                     helper::WriteAccessor< Data<VecDeriv> > vv( params, *this->write(core::VecDerivId(v)) );
                     helper::ReadAccessor< Data<VecDeriv> > vb( params, *this->read(core::ConstVecDerivId(b)) );
                     vv.resize(vb.size());
-                    for (unsigned int i=0; i<vv.size(); i++)
-                        vv[i] = vb[i] * (Real)f;
+                    forEachVectorChunk(vv.size(), [&](std::size_t begin, std::size_t end)
+                    {
+                        for (std::size_t i=begin; i<end; ++i)
+                            vv[i] = vb[i] * (Real)f;
+                    });
                 }
             }
         }
@@ -1900,16 +1921,22 @@ void MechanicalObject<DataTypes>::vOp(const core::ExecParams* params, core::VecI
                 helper::WriteOnlyAccessor< Data<VecCoord> > vv( params, *this->write(core::VecCoordId(v)) );
                 helper::ReadAccessor< Data<VecCoord> > va( params, *this->read(core::ConstVecCoordId(a)) );
                 vv.resize(va.size());
-                for (unsigned int i=0; i<vv.size(); i++)
-                    vv[i] = va[i];
+                forEachVectorChunk(vv.size(), [&](std::size_t begin, std::size_t end)
+                {
+                    for (std::size_t i=begin; i<end; ++i)
+                        vv[i] = va[i];
+                });
             }
             else
             {
                 helper::WriteOnlyAccessor< Data<VecDeriv> > vv( params, *this->write(core::VecDerivId(v)) );
                 helper::ReadAccessor< Data<VecDeriv> > va( params, *this->read(core::ConstVecDerivId(a)) );
                 vv.resize(va.size());
-                for (unsigned int i=0; i<vv.size(); i++)
-                    vv[i] = va[i];
+                forEachVectorChunk(vv.size(), [&](std::size_t begin, std::size_t end)
+                {
+                    for (std::size_t i=begin; i<end; ++i)
+                        vv[i] = va[i];
+                });
             }
         }
         else
@@ -1929,8 +1956,11 @@ void MechanicalObject<DataTypes>::vOp(const core::ExecParams* params, core::VecI
                             if (vb.size() > vv.size())
                                 vv.resize(vb.size());
 
-                            for (unsigned int i=0; i<vb.size(); i++)
-                                vv[i] += vb[i];
+                            forEachVectorChunk(vb.size(), [&](std::size_t begin, std::size_t end)
+                            {
+                                for (std::size_t i=begin; i<end; ++i)
+                                    vv[i] += vb[i];
+                            });
                         }
                         else
                         {
@@ -1939,8 +1969,11 @@ void MechanicalObject<DataTypes>::vOp(const core::ExecParams* params, core::VecI
                             if (vb.size() > vv.size())
                                 vv.resize(vb.size());
 
-                            for (unsigned int i=0; i<vb.size(); i++)
-                                vv[i] += vb[i];
+                            forEachVectorChunk(vb.size(), [&](std::size_t begin, std::size_t end)
+                            {
+                                for (std::size_t i=begin; i<end; ++i)
+                                    vv[i] += vb[i];
+                            });
                         }
                     }
                     else if (b.type == sofa::core::V_DERIV)
@@ -1951,8 +1984,11 @@ void MechanicalObject<DataTypes>::vOp(const core::ExecParams* params, core::VecI
                         if (vb.size() > vv.size())
                             vv.resize(vb.size());
 
-                        for (unsigned int i=0; i<vb.size(); i++)
-                            vv[i] += vb[i];
+                        forEachVectorChunk(vb.size(), [&](std::size_t begin, std::size_t end)
+                        {
+                            for (std::size_t i=begin; i<end; ++i)
+                                vv[i] += vb[i];
+                        });
                     }
                     else
                     {
@@ -1974,8 +2010,11 @@ void MechanicalObject<DataTypes>::vOp(const core::ExecParams* params, core::VecI
                             if (vb.size() > vv.size())
                                 vv.resize(vb.size());
 
-                            for (unsigned int i=0; i<vb.size(); i++)
-                                vv[i] += vb[i]*(Real)f;
+                            forEachVectorChunk(vb.size(), [&](std::size_t begin, std::size_t end)
+                            {
+                                for (std::size_t i=begin; i<end; ++i)
+                                    vv[i] += vb[i]*(Real)f;
+                            });
                         }
                         else
                         {
@@ -1984,8 +2023,11 @@ void MechanicalObject<DataTypes>::vOp(const core::ExecParams* params, core::VecI
                             if (vb.size() > vv.size())
                                 vv.resize(vb.size());
 
-                            for (unsigned int i=0; i<vb.size(); i++)
-                                vv[i] += vb[i]*(Real)f;
+                            forEachVectorChunk(vb.size(), [&](std::size_t begin, std::size_t end)
+                            {
+                                for (std::size_t i=begin; i<end; ++i)
+                                    vv[i] += vb[i]*(Real)f;
+                            });
                         }
                     }
                     else if (b.type == sofa::core::V_DERIV)
@@ -1996,8 +2038,11 @@ void MechanicalObject<DataTypes>::vOp(const core::ExecParams* params, core::VecI
                         if (vb.size() > vv.size())
                             vv.resize(vb.size());
 
-                        for (unsigned int i=0; i<vb.size(); i++)
-                            vv[i] += vb[i]*(Real)f;
+                        forEachVectorChunk(vb.size(), [&](std::size_t begin, std::size_t end)
+                        {
+                            for (std::size_t i=begin; i<end; ++i)
+                                vv[i] += vb[i]*(Real)f;
+                        });
                     }
                     else
                     {
@@ -2022,8 +2067,11 @@ void MechanicalObject<DataTypes>::vOp(const core::ExecParams* params, core::VecI
                             if (va.size() > vv.size())
                                 vv.resize(va.size());
 
-                            for (unsigned int i=0; i<va.size(); i++)
-                                vv[i] += va[i];
+                            forEachVectorChunk(va.size(), [&](std::size_t begin, std::size_t end)
+                            {
+                                for (std::size_t i=begin; i<end; ++i)
+                                    vv[i] += va[i];
+                            });
                         }
                         else
                         {
@@ -2032,8 +2080,11 @@ void MechanicalObject<DataTypes>::vOp(const core::ExecParams* params, core::VecI
                             if (va.size() > vv.size())
                                 vv.resize(va.size());
 
-                            for (unsigned int i=0; i<va.size(); i++)
-                                vv[i] += va[i];
+                            forEachVectorChunk(va.size(), [&](std::size_t begin, std::size_t end)
+                            {
+                                for (std::size_t i=begin; i<end; ++i)
+                                    vv[i] += va[i];
+                            });
                         }
                     }
                     else if (a.type == sofa::core::V_DERIV)
@@ -2044,8 +2095,11 @@ void MechanicalObject<DataTypes>::vOp(const core::ExecParams* params, core::VecI
                         if (va.size() > vv.size())
                             vv.resize(va.size());
 
-                        for (unsigned int i=0; i<va.size(); i++)
-                            vv[i] += va[i];
+                        forEachVectorChunk(va.size(), [&](std::size_t begin, std::size_t end)
+                        {
+                            for (std::size_t i=begin; i<end; ++i)
+                                vv[i] += va[i];
+                        });
                     }
                     else
                     {
@@ -2062,22 +2116,28 @@ void MechanicalObject<DataTypes>::vOp(const core::ExecParams* params, core::VecI
                         helper::WriteOnlyAccessor< Data<VecCoord> > vv( params, *this->write(core::VecCoordId(v)) );
                         helper::ReadAccessor< Data<VecCoord> > va( params, *this->read(core::ConstVecCoordId(a)) );
                         vv.resize(va.size());
-                        for (unsigned int i=0; i<vv.size(); i++)
+                        forEachVectorChunk(vv.size(), [&](std::size_t begin, std::size_t end)
                         {
-                            vv[i] *= (Real)f;
-                            vv[i] += va[i];
-                        }
+                            for (std::size_t i=begin; i<end; ++i)
+                            {
+                                vv[i] *= (Real)f;
+                                vv[i] += va[i];
+                            }
+                        });
                     }
                     else
                     {
                         helper::WriteOnlyAccessor< Data<VecDeriv> > vv( params, *this->write(core::VecDerivId(v)) );
                         helper::ReadAccessor< Data<VecDeriv> > va( params, *this->read(core::ConstVecDerivId(a)) );
                         vv.resize(va.size());
-                        for (unsigned int i=0; i<vv.size(); i++)
+                        forEachVectorChunk(vv.size(), [&](std::size_t begin, std::size_t end)
                         {
-                            vv[i] *= (Real)f;
-                            vv[i] += va[i];
-                        }
+                            for (std::size_t i=begin; i<end; ++i)
+                            {
+                                vv[i] *= (Real)f;
+                                vv[i] += va[i];
+                            }
+                        });
                     }
                 }
             }
@@ -2094,20 +2154,26 @@ void MechanicalObject<DataTypes>::vOp(const core::ExecParams* params, core::VecI
                         if (b.type == sofa::core::V_COORD)
                         {
                             helper::ReadAccessor< Data<VecCoord> > vb( params, *this->read(core::ConstVecCoordId(b)) );
-                            for (unsigned int i=0; i<vv.size(); i++)
+                            forEachVectorChunk(vv.size(), [&](std::size_t begin, std::size_t end)
                             {
-                                vv[i] = va[i];
-                                vv[i] += vb[i];
-                            }
+                                for (std::size_t i=begin; i<end; ++i)
+                                {
+                                    vv[i] = va[i];
+                                    vv[i] += vb[i];
+                                }
+                            });
                         }
                         else
                         {
                             helper::ReadAccessor< Data<VecDeriv> > vb( params, *this->read(core::ConstVecDerivId(b)) );
-                            for (unsigned int i=0; i<vv.size(); i++)
+                            forEachVectorChunk(vv.size(), [&](std::size_t begin, std::size_t end)
                             {
-                                vv[i] = va[i];
-                                vv[i] += vb[i];
-                            }
+                                for (std::size_t i=begin; i<end; ++i)
+                                {
+                                    vv[i] = va[i];
+                                    vv[i] += vb[i];
+                                }
+                            });
                         }
                     }
                     else if (b.type == sofa::core::V_DERIV)
@@ -2116,11 +2182,14 @@ void MechanicalObject<DataTypes>::vOp(const core::ExecParams* params, core::VecI
                         helper::ReadAccessor< Data<VecDeriv> > va( params, *this->read(core::ConstVecDerivId(a)) );
                         helper::ReadAccessor< Data<VecDeriv> > vb( params, *this->read(core::ConstVecDerivId(b)) );
                         vv.resize(va.size());
-                        for (unsigned int i=0; i<vv.size(); i++)
+                        forEachVectorChunk(vv.size(), [&](std::size_t begin, std::size_t end)
                         {
-                            vv[i] = va[i];
-                            vv[i] += vb[i];
-                        }
+                            for (std::size_t i=begin; i<end; ++i)
+                            {
+                                vv[i] = va[i];
+                                vv[i] += vb[i];
+                            }
+                        });
                     }
                     else
                     {
@@ -2140,20 +2209,26 @@ void MechanicalObject<DataTypes>::vOp(const core::ExecParams* params, core::VecI
                         if (b.type == sofa::core::V_COORD)
                         {
                             helper::ReadAccessor< Data<VecCoord> > vb( params, *this->read(core::ConstVecCoordId(b)) );
-                            for (unsigned int i=0; i<vv.size(); i++)
+                            forEachVectorChunk(vv.size(), [&](std::size_t begin, std::size_t end)
                             {
-                                vv[i] = va[i];
-                                vv[i] += vb[i]*(Real)f;
-                            }
+                                for (std::size_t i=begin; i<end; ++i)
+                                {
+                                    vv[i] = va[i];
+                                    vv[i] += vb[i]*(Real)f;
+                                }
+                            });
                         }
                         else
                         {
                             helper::ReadAccessor< Data<VecDeriv> > vb( params, *this->read(core::ConstVecDerivId(b)) );
-                            for (unsigned int i=0; i<vv.size(); i++)
+                            forEachVectorChunk(vv.size(), [&](std::size_t begin, std::size_t end)
                             {
-                                vv[i] = va[i];
-                                vv[i] += vb[i]*(Real)f;
-                            }
+                                for (std::size_t i=begin; i<end; ++i)
+                                {
+                                    vv[i] = va[i];
+                                    vv[i] += vb[i]*(Real)f;
+                                }
+                            });
                         }
                     }
                     else if (b.type == sofa::core::V_DERIV)
@@ -2162,11 +2237,14 @@ void MechanicalObject<DataTypes>::vOp(const core::ExecParams* params, core::VecI
                         helper::ReadAccessor< Data<VecDeriv> > va( params, *this->read(core::ConstVecDerivId(a)) );
                         helper::ReadAccessor< Data<VecDeriv> > vb( params, *this->read(core::ConstVecDerivId(b)) );
                         vv.resize(va.size());
-                        for (unsigned int i=0; i<vv.size(); i++)
+                        forEachVectorChunk(vv.size(), [&](std::size_t begin, std::size_t end)
                         {
-                            vv[i] = va[i];
-                            vv[i] += vb[i]*(Real)f;
-                        }
+                            for (std::size_t i=begin; i<end; ++i)
+                            {
+                                vv[i] = va[i];
+                                vv[i] += vb[i]*(Real)f;
+                            }
+                        });
                     }
                     else
                     {
@@ -2209,39 +2287,51 @@ void MechanicalObject<DataTypes>::vMultiOp(const core::ExecParams* params, const
         {
             if (f_v_a == 1.0) // used by euler implicit and other integrators that directly computes a*dt
             {
-                for (unsigned int i=0; i<n; ++i)
+                forEachVectorChunk(n, [&](std::size_t begin, std::size_t end)
                 {
-                    vv[i] += va[i];
-                    vx[i] += vv[i]*f_x_v;
-                }
+                    for (std::size_t i=begin; i<end; ++i)
+                    {
+                        vv[i] += va[i];
+                        vx[i] += vv[i]*f_x_v;
+                    }
+                });
             }
             else
             {
-                for (unsigned int i=0; i<n; ++i)
+                forEachVectorChunk(n, [&](std::size_t begin, std::size_t end)
                 {
-                    vv[i] += va[i]*f_v_a;
-                    vx[i] += vv[i]*f_x_v;
-                }
+                    for (std::size_t i=begin; i<end; ++i)
+                    {
+                        vv[i] += va[i]*f_v_a;
+                        vx[i] += vv[i]*f_x_v;
+                    }
+                });
             }
         }
         else if (f_x_x == 1.0) // some damping is applied to v
         {
-            for (unsigned int i=0; i<n; ++i)
+            forEachVectorChunk(n, [&](std::size_t begin, std::size_t end)
             {
-                vv[i] *= f_v_v;
-                vv[i] += va[i];
-                vx[i] += vv[i]*f_x_v;
-            }
+                for (std::size_t i=begin; i<end; ++i)
+                {
+                    vv[i] *= f_v_v;
+                    vv[i] += va[i];
+                    vx[i] += vv[i]*f_x_v;
+                }
+            });
         }
         else // general case
         {
-            for (unsigned int i=0; i<n; ++i)
+            forEachVectorChunk(n, [&](std::size_t begin, std::size_t end)
             {
-                vv[i] *= f_v_v;
-                vv[i] += va[i]*f_v_a;
-                vx[i] *= f_x_x;
-                vx[i] += vv[i]*f_x_v;
-            }
+                for (std::size_t i=begin; i<end; ++i)
+                {
+                    vv[i] *= f_v_v;
+                    vv[i] += va[i]*f_v_a;
+                    vx[i] *= f_x_x;
+                    vx[i] += vv[i]*f_x_v;
+                }
+            });
         }
     }
     else if(ops.size()==2 //used in the ExplicitBDF solver only (Electrophysiology)
@@ -2263,18 +2353,117 @@ void MechanicalObject<DataTypes>::vMultiOp(const core::ExecParams* params, const
         const Real f_2 = (Real)(ops[1].second[1].second);
         const Real f_3 = (Real)(ops[1].second[2].second);
 
-        for (unsigned int i=0; i<n; ++i)
+        forEachVectorChunk(n, [&](std::size_t begin, std::size_t end)
         {
-            previousPos[i] = v11[i];
-            newPos[i]  = v21[i]*f_1;
-            newPos[i] += v22[i]*f_2;
-            newPos[i] += v23[i]*f_3;
-        }
+            for (std::size_t i=begin; i<end; ++i)
+            {
+                previousPos[i] = v11[i];
+                newPos[i]  = v21[i]*f_1;
+                newPos[i] += v22[i]*f_2;
+                newPos[i] += v23[i]*f_3;
+            }
+        });
     }
     else // no optimization for now for other cases
         Inherited::vMultiOp(params, ops);
 }
 
+template <class DataTypes>
+SReal MechanicalObject<DataTypes>::vMultiOpDot(const core::ExecParams* params, const VMultiOp& ops, core::ConstVecId a, core::ConstVecId b)
+{
+    // the entries of each vector only depend on the same entries of the other vectors, so all the
+    // operations can be applied entry by entry in a single pass, as long as no vector is resized
+    const std::size_t n = d_size.getValue();
+    bool fusable = !ops.empty() && a.type == sofa::core::V_DERIV && b.type == sofa::core::V_DERIV;
+    for (std::size_t k = 0; k < ops.size() && fusable; ++k)
+    {
+        fusable = !ops[k].second.empty()
+                && ops[k].first.getId(this).type == sofa::core::V_DERIV
+                && this->read(core::ConstVecDerivId(ops[k].first.getId(this)))->getValue(params).size() == n;
+        for (std::size_t j = 0; j < ops[k].second.size() && fusable; ++j)
+        {
+            const core::ConstVecId operand = ops[k].second[j].first.getId(this);
+            fusable = operand.type == sofa::core::V_DERIV
+                    && this->read(core::ConstVecDerivId(operand))->getValue(params).size() == n;
+        }
+    }
+    if (!fusable
+            || this->read(core::ConstVecDerivId(a))->getValue(params).size() != n
+            || this->read(core::ConstVecDerivId(b))->getValue(params).size() != n)
+    {
+        return Inherited::vMultiOpDot(params, ops, a, b);
+    }
+
+    // the vectors written by the operations are accessed through their edited values, also when they are read
+    helper::vector< core::VecDerivId > resultIds(ops.size());
+    helper::vector< VecDeriv* > results(ops.size());
+    for (std::size_t k = 0; k < ops.size(); ++k)
+    {
+        resultIds[k] = core::VecDerivId(ops[k].first.getId(this));
+        results[k] = this->write(resultIds[k])->beginEdit(params);
+    }
+    auto getVector = [&](core::ConstVecId id) -> const VecDeriv*
+    {
+        for (std::size_t k = 0; k < resultIds.size(); ++k)
+            if (resultIds[k] == id)
+                return results[k];
+        return &this->read(core::ConstVecDerivId(id))->getValue(params);
+    };
+
+    helper::vector< helper::vector< std::pair< const VecDeriv*, SReal > > > operands(ops.size());
+    for (std::size_t k = 0; k < ops.size(); ++k)
+        for (std::size_t j = 0; j < ops[k].second.size(); ++j)
+            operands[k].push_back(std::make_pair(getVector(ops[k].second[j].first.getId(this)), ops[k].second[j].second));
+    const VecDeriv& va = *getVector(a);
+    const VecDeriv& vb = *getVector(b);
+
+    // same sequence of operations on each entry as vMultiOp followed by vDot
+    const Real r = reduceVectorChunks(n, [&](std::size_t begin, std::size_t end)
+    {
+        Real chunk = 0.0;
+        for (std::size_t i=begin; i<end; ++i)
+        {
+            for (std::size_t k = 0; k < ops.size(); ++k)
+            {
+                Deriv& vv = (*results[k])[i];
+                const helper::vector< std::pair< const VecDeriv*, SReal > >& op = operands[k];
+                std::size_t j = 1;
+                if (op[0].first == results[k])
+                {
+                    if (op[0].second != 1.0)
+                        vv *= (Real)op[0].second;
+                }
+                else if (op[0].second == 1.0 && op.size() > 1 && op[1].first == results[k])
+                {
+                    // v = a + v*f, computed as in vOp from the previous value of v
+                    if (op[1].second != 1.0)
+                        vv *= (Real)op[1].second;
+                    vv += (*op[0].first)[i];
+                    j = 2;
+                }
+                else if (op[0].second == 1.0)
+                    vv = (*op[0].first)[i];
+                else
+                    vv = (*op[0].first)[i] * (Real)op[0].second;
+                for (; j < op.size(); ++j)
+                {
+                    if (op[j].second == 1.0)
+                        vv += (*op[j].first)[i];
+                    else
+                        vv += (*op[j].first)[i] * (Real)op[j].second;
+                }
+            }
+            chunk += va[i] * vb[i];
+        }
+        return chunk;
+    });
+
+    for (std::size_t k = 0; k < ops.size(); ++k)
+        this->write(resultIds[k])->endEdit(params);
+
+    return r;
+}
+
 template <class T> inline void clear( T& t )
 {
     t.clear();
@@ -2297,11 +2486,14 @@ void MechanicalObject<DataTypes>::vThreshold(core::VecId v, SReal t)
     {
         helper::WriteAccessor< Data<VecDeriv> > vv = *this->write(core::VecDerivId(v));
         Real t2 = (Real)(t*t);
-        for (unsigned int i=0; i<vv.size(); i++)
+        forEachVectorChunk(vv.size(), [&](std::size_t begin, std::size_t end)
         {
-            if( vv[i]*vv[i] < t2 )
-                clear(vv[i]);
-        }
+            for (std::size_t i=begin; i<end; ++i)
+            {
+                if( vv[i]*vv[i] < t2 )
+                    clear(vv[i]);
+            }
+        });
     }
     else
     {
@@ -2319,20 +2511,30 @@ SReal MechanicalObject<DataTypes>::vDot(const core::ExecParams* params, core::Co
         const VecCoord &va = this->read(core::ConstVecCoordId(a))->getValue(params);
         const VecCoord &vb = this->read(core::ConstVecCoordId(b))->getValue(params);
 
-        for (unsigned int i=0; i<va.size(); i++)
+        r = reduceVectorChunks(va.size(), [&](std::size_t begin, std::size_t end)
         {
-            r += va[i] * vb[i];
-        }
+            Real chunk = 0.0;
+            for (std::size_t i=begin; i<end; ++i)
+            {
+                chunk += va[i] * vb[i];
+            }
+            return chunk;
+        });
     }
     else if (a.type == sofa::core::V_DERIV && b.type == sofa::core::V_DERIV)
     {
         const VecDeriv &va = this->read(core::ConstVecDerivId(a))->getValue(params);
         const VecDeriv &vb = this->read(core::ConstVecDerivId(b))->getValue(params);
 
-        for (unsigned int i=0; i<va.size(); i++)
+        r = reduceVectorChunks(va.size(), [&](std::size_t begin, std::size_t end)
         {
-            r += va[i] * vb[i];
-        }
+            Real chunk = 0.0;
+            for (std::size_t i=begin; i<end; ++i)
+            {
+                chunk += va[i] * vb[i];
+            }
+            return chunk;
+        });
     }
     else
     {
@@ -2342,6 +2544,28 @@ SReal MechanicalObject<DataTypes>::vDot(const core::ExecParams* params, core::Co
     return r;
 }
 
+template <class DataTypes>
+template <class Function>
+void MechanicalObject<DataTypes>::forEachVectorChunk(std::size_t size, const Function& function)
+{
+    if (d_parallelVectorOperations.getValue())
+        simulation::parallelFor(simulation::TaskScheduler::getInstance(), 0, size, d_vectorOperationsGrainSize.getValue(), function);
+    else
+        function(0, size);
+}
+
+template <class DataTypes>
+template <class Function>
+typename MechanicalObject<DataTypes>::Real MechanicalObject<DataTypes>::reduceVectorChunks(std::size_t size, const Function& function)
+{
+    if (!d_parallelVectorOperations.getValue())
+        return function(0, size);
+
+    return simulation::parallelReduce(simulation::TaskScheduler::getInstance(), 0, size, d_vectorOperationsGrainSize.getValue(), Real(0.0),
+        [&](std::size_t begin, std::size_t end, Real /*identity*/) { return function(begin, end); },
+        [](Real r1, Real r2) { return r1 + r2; });
+}
+
 typedef std::size_t nat;
 
 template <class DataTypes>
@@ -21,14 +21,18 @@
 ******************************************************************************/
 #include <SofaBaseMechanics/BarycentricMapping.h>
 #include <SofaBaseMechanics/BarycentricMappers/BarycentricMapperTriangleSetTopology.h>
+#include <SofaBaseMechanics/BarycentricMappers/BarycentricMapperMeshTopology.h>
 using sofa::component::mapping::BarycentricMapperTriangleSetTopology;
+using sofa::component::mapping::BarycentricMapperMeshTopology;
 using sofa::component::mapping::BarycentricMapping;
 
 #include <SofaBaseTopology/TriangleSetTopologyContainer.h>
 #include <SofaBaseTopology/TetrahedronSetTopologyContainer.h>
+#include <SofaBaseTopology/MeshTopology.h>
 #include <sofa/core/topology/BaseMeshTopology.h>
 using sofa::component::topology::TriangleSetTopologyContainer;
 using sofa::component::topology::TetrahedronSetTopologyContainer;
+using sofa::component::topology::MeshTopology;
 using sofa::core::topology::BaseMeshTopology;
 
 #include <gtest/gtest.h>
@@ -144,3 +148,128 @@ TEST_F(BarycentricMapperTriangleSetTopologyTest_d, initHashing)
 }
 
 
+
+
+template <class In, class Out>
+struct BarycentricMapperMeshTopologyTest :  public Test, public BarycentricMapperMeshTopology<In,Out>
+{
+    typedef BarycentricMapperMeshTopology<In,Out> Inherit;
+
+    using Inherit::m_fromTopology;
+    using Inherit::m_map3d;
+    using Inherit::init;
+
+    typename In::VecCoord m_in;
+    typename Out::VecCoord m_out;
+    MeshTopology::SPtr m_topology;
+
+    BarycentricMapperMeshTopologyTest() : Inherit(nullptr, nullptr) {}
+
+    void SetUp() override
+    {
+        // A distorted 4x3x3 grid, split in tetrahedra on one half and kept as hexahedra on the other
+        const int n[3] = {5, 4, 4};
+        for (int k=0; k<n[2]; k++)
+            for (int j=0; j<n[1]; j++)
+                for (int i=0; i<n[0]; i++)
+                    m_in.push_back(Vector3(i + 0.2*std::sin(3.0*j+k), j + 0.15*std::cos(2.0*i), k + 0.1*std::sin(i+2.0*j)));
+
+        m_topology = New<MeshTopology>();
+        auto id = [&](int i, int j, int k) { return (k*n[1]+j)*n[0]+i; };
+        for (int k=0; k<n[2]-1; k++)
+            for (int j=0; j<n[1]-1; j++)
+                for (int i=0; i<n[0]-1; i++)
+                {
+                    const int c[8] = { id(i,j,k), id(i+1,j,k), id(i+1,j+1,k), id(i,j+1,k),
+                                       id(i,j,k+1), id(i+1,j,k+1), id(i+1,j+1,k+1), id(i,j+1,k+1) };
+                    if (i < 2)
+                    {
+                        m_topology->addTetra(c[0],c[5],c[1],c[6]);
+                        m_topology->addTetra(c[0],c[1],c[3],c[6]);
+                        m_topology->addTetra(c[1],c[3],c[6],c[2]);
+                        m_topology->addTetra(c[6],c[3],c[0],c[7]);
+                        m_topology->addTetra(c[6],c[7],c[0],c[5]);
+                        m_topology->addTetra(c[7],c[5],c[4],c[0]);
+                    }
+                    else
+                        m_topology->addHexa(c[0],c[1],c[2],c[3],c[4],c[5],c[6],c[7]);
+                }
+        m_fromTopology = m_topology.get();
+
+        // points inside, on the vertices, and outside of the mesh
+        for (int p=0; p<500; p++)
+            m_out.push_back(Vector3(-1.0 + 6.0*std::fmod(0.618034*p, 1.0), -1.0 + 5.0*std::fmod(0.414214*p, 1.0), -1.0 + 5.0*std::fmod(0.732051*p, 1.0)));
+        for (unsigned int p=0; p<m_in.size(); p+=7)
+            m_out.push_back(m_in[p]);
+    }
+
+    /// Reference result: linear search over all the elements
+    void bruteForce(const Vector3& pos, int& index, Vector3& coefs)
+    {
+        const auto& tetras = m_fromTopology->getTetrahedra();
+        const auto& hexas = m_fromTopology->getHexahedra();
+        index = -1;
+        double distance = 1e10;
+        for (unsigned int e=0; e<tetras.size()+hexas.size(); e++)
+        {
+            const bool isTetra = e < tetras.size();
+            const int i0 = isTetra ? tetras[e][0] : hexas[e-tetras.size()][0];
+            const int i1 = isTetra ? tetras[e][1] : hexas[e-tetras.size()][1];
+            const int i2 = isTetra ? tetras[e][2] : hexas[e-tetras.size()][3];
+            const int i3 = isTetra ? tetras[e][3] : hexas[e-tetras.size()][4];
+            sofa::defaulttype::Mat3x3d m, mt, base;
+            m[0] = m_in[i1]-m_in[i0];
+            m[1] = m_in[i2]-m_in[i0];
+            m[2] = m_in[i3]-m_in[i0];
+            mt.transpose(m);
+            base.invert(mt);
+            Vector3 center;
+            if (isTetra)
+                center = (m_in[i0]+m_in[i1]+m_in[i2]+m_in[i3])*0.25;
+            else
+            {
+                for (int c=0; c<8; c++) center += m_in[hexas[e-tetras.size()][c]];
+                center *= 0.125;
+            }
+            Vector3 v = base * (pos - m_in[i0]);
+            double d = isTetra ? std::max(std::max(-v[0],-v[1]), std::max(-v[2],v[0]+v[1]+v[2]-1))
+                               : std::max(std::max(-v[0],-v[1]), std::max(std::max(-v[2],v[0]-1), std::max(v[1]-1,v[2]-1)));
+            if (d>0) d = (pos-center).norm2();
+            if (d<distance) { coefs = v; distance = d; index = int(e); }
+        }
+    }
+
+    void init_test(bool parallel)
+    {
+        this->setParallelInit(parallel);
+        init(m_out, m_in);
+
+        const unsigned int nbTetras = m_fromTopology->getNbTetrahedra();
+        const unsigned int nbCubes = m_fromTopology->getNbHexahedra();
+        ASSERT_EQ(m_map3d.size(), m_out.size());
+        for (unsigned int i=0; i<m_out.size(); i++)
+        {
+            int index;
+            Vector3 coefs;
+            bruteForce(m_out[i], index, coefs);
+
+            // cubes are indexed after the tetrahedra, as in the linear search
+            EXPECT_EQ(m_map3d[i].in_index, index) << "point " << i;
+            EXPECT_LT(index, int(nbTetras+nbCubes));
+            for (int c=0; c<3; c++)
+                EXPECT_NEAR(m_map3d[i].baryCoords[c], coefs[c], 1e-10) << "point " << i;
+        }
+    }
+};
+
+typedef BarycentricMapperMeshTopologyTest< Vec3dTypes, Vec3dTypes> BarycentricMapperMeshTopologyTest_d;
+
+TEST_F(BarycentricMapperMeshTopologyTest_d, initMatchesLinearSearch)
+{
+    init_test(false);
+}
+
+TEST_F(BarycentricMapperMeshTopologyTest_d, parallelInitMatchesLinearSearch)
+{
+    init_test(true);
+}
@@ -20,6 +20,7 @@
 * Contact information: contact@sofa-framework.org                             *
 ******************************************************************************/
 #include <SofaBaseMechanics/MechanicalObject.inl>
+#include <sofa/simulation/TaskScheduler.h>
 
 #include <SofaTest/Sofa_test.h>
 using BaseTest = sofa::Sofa_test<SReal>;
@@ -43,6 +44,87 @@ struct MechanicalObject_test :  public BaseTest
     typedef typename StubMechanicalObject<T>::DataTypes::Real   Real;
 
     StubMechanicalObject<T> mechanicalObject;
+
+    typedef typename StubMechanicalObject<T>::DataTypes::Deriv  Deriv;
+    typedef typename StubMechanicalObject<T>::DataTypes::VecDeriv  VecDeriv;
+
+    /// Resize the object and fill its velocity, force, dx and external force vectors with arbitrary values
+    static void fillVectors(StubMechanicalObject<T>& mo, std::size_t size)
+    {
+        mo.resize(size);
+        const core::VecDerivId ids[4] = { core::VecDerivId::velocity(), core::VecDerivId::force(), core::VecDerivId::dx(), core::VecDerivId::externalForce() };
+        for (unsigned int k = 0; k < 4; ++k)
+        {
+            helper::WriteAccessor< Data<VecDeriv> > vec = *mo.write(ids[k]);
+            vec.resize(size);
+            for (std::size_t i = 0; i < size; ++i)
+                for (std::size_t c = 0; c < Deriv::total_size; ++c)
+                    vec[i][c] = (Real)std::sin(0.1 * (k + 1) * (i * Deriv::total_size + c));
+        }
+    }
+
+    /// x = x + p*alpha, r = r - q*alpha, then r.r, as in a conjugate gradient step
+    static core::behavior::BaseMechanicalState::VMultiOp cgStep(SReal alpha)
+    {
+        core::behavior::BaseMechanicalState::VMultiOp ops(2);
+        ops[0] = core::behavior::BaseMechanicalState::VMultiOpEntry(core::VecDerivId::velocity(), core::VecDerivId::velocity(), core::VecDerivId::force(), alpha);
+        ops[1] = core::behavior::BaseMechanicalState::VMultiOpEntry(core::VecDerivId::dx(), core::VecDerivId::dx(), core::VecDerivId::externalForce(), -alpha);
+        return ops;
+    }
+
+    /// dx = f + dx*0.5, with the result vector as last operand
+    static core::behavior::BaseMechanicalState::VMultiOp selfScaledStep()
+    {
+        core::behavior::BaseMechanicalState::VMultiOp ops(1);
+        ops[0] = core::behavior::BaseMechanicalState::VMultiOpEntry(core::VecDerivId::dx(), core::VecDerivId::force(), core::VecDerivId::dx(), 0.5);
+        return ops;
+    }
+
+    /// dx = f + fext + dx*0.5, where vMultiOp applies the last term to the updated dx
+    static core::behavior::BaseMechanicalState::VMultiOp selfScaledSumStep()
+    {
+        core::behavior::BaseMechanicalState::VMultiOp ops(1);
+        ops[0].first = core::VecDerivId::dx();
+        ops[0].second.push_back(std::make_pair(core::ConstMultiVecId(core::VecDerivId::force()), 1.0));
+        ops[0].second.push_back(std::make_pair(core::ConstMultiVecId(core::VecDerivId::externalForce()), 1.0));
+        ops[0].second.push_back(std::make_pair(core::ConstMultiVecId(core::VecDerivId::dx()), 0.5));
+        return ops;
+    }
+
+    void checkVMultiOpDot(bool parallel, const core::behavior::BaseMechanicalState::VMultiOp& ops = cgStep(0.25))
+    {
+        const std::size_t size = 1000;
+        StubMechanicalObject<T> reference;
+        fillVectors(reference, size);
+        fillVectors(mechanicalObject, size);
+        mechanicalObject.d_parallelVectorOperations.setValue(parallel);
+        mechanicalObject.d_vectorOperationsGrainSize.setValue(64);
+
+        reference.core::behavior::BaseMechanicalState::vMultiOp(core::ExecParams::defaultInstance(), ops);
+        const SReal expected = reference.vDot(core::ExecParams::defaultInstance(), core::VecDerivId::dx(), core::VecDerivId::dx());
+        simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+        if (parallel)
+            scheduler->init(4);
+        const SReal result = mechanicalObject.vMultiOpDot(core::ExecParams::defaultInstance(), ops, core::VecDerivId::dx(), core::VecDerivId::dx());
+        if (parallel)
+            scheduler->stop();
+
+        // without chunks, the entries are accumulated in the same order
+        if (parallel)
+            EXPECT_NEAR(expected, result, 1e-4 * expected);
+        else
+            EXPECT_EQ(expected, result);
+
+        const VecDeriv& v = mechanicalObject.read(core::ConstVecDerivId::velocity())->getValue();
+        const VecDeriv& vRef = reference.read(core::ConstVecDerivId::velocity())->getValue();
+        const VecDeriv& dx = mechanicalObject.read(core::ConstVecDerivId::dx())->getValue();
+        const VecDeriv& dxRef = reference.read(core::ConstVecDerivId::dx())->getValue();
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            EXPECT_EQ(vRef[i], v[i]);
+            EXPECT_EQ(dxRef[i], dx[i]);
+        }
+    }
 };
 
 
@@ -110,6 +192,28 @@ TYPED_TEST(MechanicalObject_test, checkThatPositionDefaultValueIsAVectorOfValueI
     TestHelpers::CheckPosition(this->mechanicalObject);
 }
 
+TYPED_TEST(MechanicalObject_test, checkThatVMultiOpDotMatchesVMultiOpThenVDot)
+{
+    this->checkVMultiOpDot(false);
+}
+
+TYPED_TEST(MechanicalObject_test, checkThatParallelVMultiOpDotMatchesVMultiOpThenVDot)
+{
+    this->checkVMultiOpDot(true);
+}
+
+TYPED_TEST(MechanicalObject_test, checkThatVMultiOpDotWithTheResultAsOperandMatchesVMultiOpThenVDot)
+{
+    this->checkVMultiOpDot(false, this->selfScaledStep());
+    this->checkVMultiOpDot(false, this->selfScaledSumStep());
+}
+
+TYPED_TEST(MechanicalObject_test, checkThatParallelVMultiOpDotWithTheResultAsOperandMatchesVMultiOpThenVDot)
+{
+    this->checkVMultiOpDot(true, this->selfScaledStep());
+    this->checkVMultiOpDot(true, this->selfScaledSumStep());
+}
+
 } // namespace
 
 } // namespace sofa
@@ -23,6 +23,7 @@
 #include <gtest/gtest.h>
 #include <SofaBaseVisual/VisualModelImpl.h>
 #include <sofa/defaulttype/VecTypes.h>
+#include <cmath>
 
 namespace sofa {
 
@@ -120,4 +121,101 @@ TEST( VisualModelImpl_test , checkThatMembersAreCorrectlyConstructed )
     ASSERT_EQ(1u, visualModel.xforms.size());
 }
 
+/// Build a bumpy grid made of quads on one half and triangles on the other half
+void createBumpyGrid(StubVisualModelImpl& visualModel, unsigned int n)
+{
+    typedef component::visualmodel::VisualModelImpl VisualModelImpl;
+    VisualModelImpl::VecCoord positions;
+    VisualModelImpl::VecTexCoord texcoords;
+    VisualModelImpl::VecTriangle triangles;
+    VisualModelImpl::VecQuad quads;
+    for (unsigned int j = 0; j <= n; ++j)
+        for (unsigned int i = 0; i <= n; ++i)
+        {
+            positions.push_back(VisualModelImpl::Coord(double(i), double(j), 0.3*std::sin(0.7*i)*std::cos(1.3*j)));
+            texcoords.push_back(VisualModelImpl::TexCoord(float(i)/n, float(j)/n));
+        }
+    for (unsigned int j = 0; j < n; ++j)
+        for (unsigned int i = 0; i < n; ++i)
+        {
+            const unsigned int p0 = j*(n+1)+i, p1 = p0+1, p2 = p0+n+2, p3 = p0+n+1;
+            if (i < n/2)
+                quads.push_back(VisualModelImpl::Quad(p0, p1, p2, p3));
+            else
+            {
+                triangles.push_back(VisualModelImpl::Triangle(p0, p1, p2));
+                triangles.push_back(VisualModelImpl::Triangle(p0, p2, p3));
+            }
+        }
+    visualModel.setVertices(&positions);
+    visualModel.setVtexcoords(&texcoords);
+    visualModel.setTriangles(&triangles);
+    visualModel.setQuads(&quads);
+    visualModel.m_computeTangents.setValue(true);
+}
+
+void updateNormalsAndTangents(StubVisualModelImpl& visualModel)
+{
+    visualModel.computeNormals();
+    visualModel.computeTangents();
+}
+
+template <class VecT>
+void expectSameVectors(const VecT& expected, const VecT& actual)
+{
+    ASSERT_EQ(expected.size(), actual.size());
+    for (std::size_t i = 0; i < expected.size(); ++i)
+        for (std::size_t c = 0; c < 3; ++c)
+            EXPECT_EQ(expected[i][c], actual[i][c]) << "vertex " << i;
+}
+
+void movePosition(StubVisualModelImpl& visualModel, unsigned int index, const component::visualmodel::VisualModelImpl::Coord& delta)
+{
+    component::visualmodel::VisualModelImpl::VecCoord positions = visualModel.getVertices();
+    positions[index] += delta;
+    visualModel.setVertices(&positions);
+}
+
+TEST( VisualModelImpl_test , adjacencyNormalsMatchSequentialNormals )
+{
+    StubVisualModelImpl reference, gathered;
+    createBumpyGrid(reference, 8);
+    createBumpyGrid(gathered, 8);
+    gathered.d_parallelNormals.setValue(true);
+
+    updateNormalsAndTangents(reference);
+    updateNormalsAndTangents(gathered);
+    expectSameVectors(reference.getVnormals(), gathered.getVnormals());
+    expectSameVectors(reference.getVtangents(), gathered.getVtangents());
+    expectSameVectors(reference.getVbitangents(), gathered.getVbitangents());
+}
+
+TEST( VisualModelImpl_test , incrementalNormalsOnlyFollowLargeDisplacements )
+{
+    typedef component::visualmodel::VisualModelImpl::Coord Coord;
+    StubVisualModelImpl reference, incremental;
+    createBumpyGrid(reference, 8);
+    createBumpyGrid(incremental, 8);
+    incremental.d_normalsUpdateThreshold.setValue(0.01);
+    updateNormalsAndTangents(incremental);
+
+    // below the threshold: nothing is refreshed
+    const component::visualmodel::VisualModelImpl::VecDeriv initialNormals = incremental.getVnormals();
+    movePosition(incremental, 20, Coord(0, 0, 0.005));
+    updateNormalsAndTangents(incremental);
+    expectSameVectors(initialNormals, incremental.getVnormals());
+
+    // above the threshold: the faces around both moved vertices are refreshed
+    movePosition(incremental, 20, Coord(0, 0, 0.1));
+    movePosition(incremental, 60, Coord(0.2, 0, 0));
+    updateNormalsAndTangents(incremental);
+
+    movePosition(reference, 20, Coord(0, 0, 0.005));
+    movePosition(reference, 20, Coord(0, 0, 0.1));
+    movePosition(reference, 60, Coord(0.2, 0, 0));
+    updateNormalsAndTangents(reference);
+    expectSameVectors(reference.getVnormals(), incremental.getVnormals());
+    expectSameVectors(reference.getVtangents(), incremental.getVtangents());
+}
+
 } //sofa
@@ -42,6 +42,7 @@
 #include <sofa/helper/io/MeshOBJ.h>
 #include <sofa/helper/rmath.h>
 #include <sofa/helper/accessor.h>
+#include <sofa/simulation/ParallelFor.h>
 #include <sstream>
 #include <map>
 #include <memory>
@@ -193,6 +194,8 @@ VisualModelImpl::VisualModelImpl() //const std::string &name, std::string filena
     , m_handleDynamicTopology (initData   (&m_handleDynamicTopology, true, "handleDynamicTopology", "True if topological changes should be handled"))
     , m_fixMergedUVSeams (initData   (&m_fixMergedUVSeams, true, "fixMergedUVSeams", "True if UV seams should be handled even when duplicate UVs are merged"))
     , m_keepLines (initData   (&m_keepLines, false, "keepLines", "keep and draw lines (false by default)"))
+    , d_parallelNormals (initData   (&d_parallelNormals, false, "parallelNormals", "True if normals and tangents should be computed in parallel using the task scheduler"))
+    , d_normalsUpdateThreshold (initData   (&d_normalsUpdateThreshold, (SReal)0, "normalsUpdateThreshold", "If positive, only faces with a vertex moved further than this distance since their last update get new normals and tangents"))
     , m_vertices2       (initData   (&m_vertices2, "vertices", "vertices of the model (only if vertices have multiple normals/texcoords, otherwise positions are used)"))
     , m_vtexcoords      (initData   (&m_vtexcoords, "texcoords", "coordinates of the texture"))
     , m_vtangents       (initData   (&m_vtangents, "tangents", "tangents for normal mapping"))
@@ -904,8 +907,15 @@ void VisualModelImpl::computeNormals()
 {
     const VecCoord& vertices = getVertices();
     //const VecCoord& vertices = m_vertices2.getValue();
+    m_incrementalFaces = false;
     if (vertices.empty() || (!m_updateNormals.getValue() && (m_vnormals.getValue()).size() == (vertices).size())) return;
 
+    if (d_parallelNormals.getValue() || d_normalsUpdateThreshold.getValue() > 0)
+    {
+        computeNormalsFromAdjacency();
+        return;
+    }
+
     const VecTriangle& triangles = m_triangles.getValue();
     const VecQuad& quads = m_quads.getValue();
     const helper::vector<int> &vertNormIdx = m_vertNormIdx.getValue();
@@ -1032,6 +1042,12 @@ void VisualModelImpl::computeTangents()
 {
     if (!m_computeTangents.getValue() || !m_vtexcoords.getValue().size()) return;
 
+    if (d_parallelNormals.getValue() || d_normalsUpdateThreshold.getValue() > 0)
+    {
+        computeTangentsFromAdjacency();
+        return;
+    }
+
     const VecTriangle& triangles = m_triangles.getValue();
     const VecQuad& quads = m_quads.getValue();
     const VecCoord& vertices = getVertices();
@@ -1122,6 +1138,333 @@ void VisualModelImpl::computeTangents()
     m_vbitangents.endEdit();
 }
 
+template<class Function>
+void VisualModelImpl::forEachNormalChunk(std::size_t size, const Function& function)
+{
+    if (d_parallelNormals.getValue())
+        simulation::parallelFor(simulation::TaskScheduler::getInstance(), 0, size, 256, function);
+    else
+        function(0, size);
+}
+
+namespace
+{
+
+/// Fill a CSR table giving, for each key, the face corner entries it is part of.
+/// Triangle i is entry i and corner k of quad q is entry nbTriangles+4*q+k. Entries are
+/// listed triangles first, then quads, which is the order computeNormals() accumulates them.
+template<class KeyOf>
+void buildFaceCornerTable(std::size_t nbKeys, const VisualModelImpl::VecTriangle& triangles, const VisualModelImpl::VecQuad& quads,
+                          const KeyOf& keyOf, vector<unsigned int>& begin, vector<unsigned int>& entries)
+{
+    const std::size_t nbT = triangles.size();
+    begin.assign(nbKeys+1, 0);
+    for (std::size_t i = 0; i < nbT; ++i)
+        for (unsigned int k = 0; k < 3; ++k)
+            ++begin[keyOf(triangles[i][k])+1];
+    for (std::size_t i = 0; i < quads.size(); ++i)
+        for (unsigned int k = 0; k < 4; ++k)
+            ++begin[keyOf(quads[i][k])+1];
+    for (std::size_t i = 0; i < nbKeys; ++i)
+        begin[i+1] += begin[i];
+
+    entries.resize(begin[nbKeys]);
+    vector<unsigned int> cursor(begin.begin(), begin.end()-1);
+    for (std::size_t i = 0; i < nbT; ++i)
+        for (unsigned int k = 0; k < 3; ++k)
+            entries[cursor[keyOf(triangles[i][k])]++] = (unsigned int)i;
+    for (std::size_t i = 0; i < quads.size(); ++i)
+        for (unsigned int k = 0; k < 4; ++k)
+            entries[cursor[keyOf(quads[i][k])]++] = (unsigned int)(nbT + 4*i + k);
+}
+
+} // anonymous namespace
+
+bool VisualModelImpl::updateFaceCornerAdjacency(std::size_t nbVertices)
+{
+    const int counters[3] = { m_triangles.getCounter(), m_quads.getCounter(), m_vertNormIdx.getCounter() };
+    if (std::equal(counters, counters+3, m_adjacencyCounters) && m_adjacencyNbVertices == nbVertices
+            && m_vertexCornerBegin.size() == nbVertices+1)
+        return false;
+
+    const VecTriangle& triangles = m_triangles.getValue();
+    const VecQuad& quads = m_quads.getValue();
+    const helper::vector<int>& vertNormIdx = m_vertNormIdx.getValue();
+
+    buildFaceCornerTable(nbVertices, triangles, quads, [](unsigned int v) { return v; },
+                         m_vertexCornerBegin, m_vertexCorners);
+
+    if (vertNormIdx.empty())
+    {
+        m_normalSlotCornerBegin.clear();
+        m_normalSlotCorners.clear();
+    }
+    else
+    {
+        int nbn = 0;
+        for (unsigned int i = 0; i < vertNormIdx.size(); i++)
+        {
+            if (vertNormIdx[i] >= nbn)
+                nbn = vertNormIdx[i]+1;
+        }
+        buildFaceCornerTable(nbn, triangles, quads, [&vertNormIdx](unsigned int v) { return (unsigned int)vertNormIdx[v]; },
+                             m_normalSlotCornerBegin, m_normalSlotCorners);
+    }
+
+    std::copy(counters, counters+3, m_adjacencyCounters);
+    m_adjacencyNbVertices = nbVertices;
+    return true;
+}
+
+void VisualModelImpl::computeNormalsFromAdjacency()
+{
+    const VecCoord& vertices = getVertices();
+    const VecTriangle& triangles = m_triangles.getValue();
+    const VecQuad& quads = m_quads.getValue();
+    const helper::vector<int> &vertNormIdx = m_vertNormIdx.getValue();
+    const std::size_t nbv = vertices.size();
+    const std::size_t nbT = triangles.size();
+    const std::size_t nbFaces = nbT + quads.size();
+
+    const bool rebuilt = updateFaceCornerAdjacency(nbv);
+    const SReal threshold = d_normalsUpdateThreshold.getValue();
+
+    VecDeriv& normals = *(m_vnormals.beginEdit());
+    const bool incremental = threshold > 0 && !rebuilt && normals.size() == nbv
+            && m_normalsRefPositions.size() == nbv && m_dirtyFaces.size() == nbFaces
+            && m_cornerNormals.size() == nbT + 4*quads.size();
+
+    if (incremental)
+    {
+        // flag the vertices which moved beyond the threshold, and the faces using them
+        const Real threshold2 = (Real)(threshold*threshold);
+        vector<char> moved(nbv);
+        forEachNormalChunk(nbv, [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                moved[i] = (vertices[i] - m_normalsRefPositions[i]).norm2() > threshold2;
+                if (moved[i])
+                    m_normalsRefPositions[i] = vertices[i];
+            }
+        });
+        forEachNormalChunk(nbFaces, [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t f = begin; f < end; ++f)
+            {
+                if (f < nbT)
+                {
+                    const Triangle& t = triangles[f];
+                    m_dirtyFaces[f] = moved[t[0]] || moved[t[1]] || moved[t[2]];
+                }
+                else
+                {
+                    const Quad& q = quads[f-nbT];
+                    m_dirtyFaces[f] = moved[q[0]] || moved[q[1]] || moved[q[2]] || moved[q[3]];
+                }
+            }
+        });
+    }
+    else
+    {
+        normals.resize(nbv);
+        m_cornerNormals.resize(nbT + 4*quads.size());
+        m_dirtyFaces.assign(nbFaces, 1);
+        if (threshold > 0)
+            m_normalsRefPositions = vertices;
+        else
+            m_normalsRefPositions.clear();
+    }
+    m_incrementalFaces = incremental;
+
+    forEachNormalChunk(nbFaces, [&](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t f = begin; f < end; ++f)
+        {
+            if (!m_dirtyFaces[f]) continue;
+            if (f < nbT)
+            {
+                const Coord& v1 = vertices[triangles[f][0]];
+                const Coord& v2 = vertices[triangles[f][1]];
+                const Coord& v3 = vertices[triangles[f][2]];
+                m_cornerNormals[f] = cross(v2-v1, v3-v1);
+            }
+            else
+            {
+                const std::size_t i = f - nbT;
+                const Coord & v1 = vertices[quads[i][0]];
+                const Coord & v2 = vertices[quads[i][1]];
+                const Coord & v3 = vertices[quads[i][2]];
+                const Coord & v4 = vertices[quads[i][3]];
+                Deriv* n = &m_cornerNormals[nbT + 4*i];
+                n[0] = cross(v2-v1, v4-v1);
+                n[1] = cross(v3-v2, v1-v2);
+                n[2] = cross(v4-v3, v2-v3);
+                n[3] = cross(v1-v4, v3-v4);
+            }
+        }
+    });
+
+    // sum the normals of the face corners around each vertex (or normal slot)
+    auto gatherNormals = [&](const vector<unsigned int>& cornerBegin, const vector<unsigned int>& corners,
+                             VecDeriv& out, std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            if (incremental)
+            {
+                bool dirty = false;
+                for (unsigned int c = cornerBegin[i]; c < cornerBegin[i+1] && !dirty; ++c)
+                {
+                    const unsigned int e = corners[c];
+                    dirty = m_dirtyFaces[e < nbT ? e : nbT + (e-nbT)/4] != 0;
+                }
+                if (!dirty) continue;
+            }
+            Deriv n;
+            n.clear();
+            for (unsigned int c = cornerBegin[i]; c < cornerBegin[i+1]; ++c)
+                n += m_cornerNormals[corners[c]];
+            n.normalize();
+            out[i] = n;
+        }
+    };
+
+    if (vertNormIdx.empty())
+    {
+        forEachNormalChunk(nbv, [&](std::size_t begin, std::size_t end)
+        {
+            gatherNormals(m_vertexCornerBegin, m_vertexCorners, normals, begin, end);
+        });
+    }
+    else
+    {
+        const std::size_t nbn = m_normalSlotCornerBegin.size()-1;
+        m_slotNormals.resize(nbn);
+        forEachNormalChunk(nbn, [&](std::size_t begin, std::size_t end)
+        {
+            gatherNormals(m_normalSlotCornerBegin, m_normalSlotCorners, m_slotNormals, begin, end);
+        });
+        forEachNormalChunk(nbv, [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; ++i)
+                normals[i] = m_slotNormals[vertNormIdx[i]];
+        });
+    }
+    m_vnormals.endEdit();
+}
+
+void VisualModelImpl::computeTangentsFromAdjacency()
+{
+    const VecTriangle& triangles = m_triangles.getValue();
+    const VecQuad& quads = m_quads.getValue();
+    const VecCoord& vertices = getVertices();
+    const VecTexCoord& texcoords = m_vtexcoords.getValue();
+    const VecDeriv& normals = m_vnormals.getValue();
+    const std::size_t nbv = vertices.size();
+    const std::size_t nbT = triangles.size();
+    const std::size_t nbFaces = nbT + quads.size();
+    const std::size_t nbEntries = nbT + 4*quads.size();
+
+    const bool rebuilt = updateFaceCornerAdjacency(nbv);
+    // only reuse the face tangents if the normals were just updated incrementally on the same mesh
+    const bool incremental = m_incrementalFaces && !rebuilt && m_dirtyFaces.size() == nbFaces
+            && m_cornerTangents.size() == nbEntries && m_tangentsTexCoordsCounter == m_vtexcoords.getCounter();
+    m_incrementalFaces = false;
+    m_tangentsTexCoordsCounter = m_vtexcoords.getCounter();
+    m_cornerTangents.resize(nbEntries);
+    m_cornerBitangents.resize(nbEntries);
+
+    const bool fixMergedUVSeams = m_fixMergedUVSeams.getValue();
+    forEachNormalChunk(nbFaces, [&](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t f = begin; f < end; ++f)
+        {
+            if (incremental && !m_dirtyFaces[f]) continue;
+            if (f < nbT)
+            {
+                const Coord v1 = vertices[triangles[f][0]];
+                const Coord v2 = vertices[triangles[f][1]];
+                const Coord v3 = vertices[triangles[f][2]];
+                TexCoord t1 = texcoords[triangles[f][0]];
+                TexCoord t2 = texcoords[triangles[f][1]];
+                TexCoord t3 = texcoords[triangles[f][2]];
+                if (fixMergedUVSeams)
+                {
+                    for (unsigned int j=0; j<t1.size(); ++j)
+                    {
+                        t2[j] += helper::rnear(t1[j]-t2[j]);
+                        t3[j] += helper::rnear(t1[j]-t3[j]);
+                    }
+                }
+                m_cornerTangents[f] = computeTangent(v1, v2, v3, t1, t2, t3);
+                m_cornerBitangents[f] = computeBitangent(v1, v2, v3, t1, t2, t3);
+            }
+            else
+            {
+                const std::size_t i = f - nbT;
+                const Coord & v1 = vertices[quads[i][0]];
+                const Coord & v2 = vertices[quads[i][1]];
+                const Coord & v3 = vertices[quads[i][2]];
+                const Coord & v4 = vertices[quads[i][3]];
+                const TexCoord t1 = texcoords[quads[i][0]];
+                const TexCoord t2 = texcoords[quads[i][1]];
+                const TexCoord t3 = texcoords[quads[i][2]];
+                const TexCoord t4 = texcoords[quads[i][3]];
+
+                // same splitting as computeTangents()
+                Coord t123 = computeTangent  (v1, v2, v3, t1, t2, t3);
+                Coord b123 = computeBitangent(v1, v2, v2, t1, t2, t3);
+
+                Coord t234 = computeTangent  (v2, v3, v4, t2, t3, t4);
+                Coord b234 = computeBitangent(v2, v3, v4, t2, t3, t4);
+
+                Coord t341 = computeTangent  (v3, v4, v1, t3, t4, t1);
+                Coord b341 = computeBitangent(v3, v4, v1, t3, t4, t1);
+
+                Coord t412 = computeTangent  (v4, v1, v2, t4, t1, t2);
+                Coord b412 = computeBitangent(v4, v1, v2, t4, t1, t2);
+
+                Coord* t = &m_cornerTangents[nbT + 4*i];
+                Coord* b = &m_cornerBitangents[nbT + 4*i];
+                t[0] = t123        + t341 + t412;
+                b[0] = b123        + b341 + b412;
+                t[1] = t123 + t234        + t412;
+                b[1] = b123 + b234        + b412;
+                t[2] = t123 + t234 + t341;
+                b[2] = b123 + b234 + b341;
+                t[3] =        t234 + t341 + t412;
+                b[3] =        b234 + b341 + b412;
+            }
+        }
+    });
+
+    VecCoord& tangents = *(m_vtangents.beginEdit());
+    VecCoord& bitangents = *(m_vbitangents.beginEdit());
+    tangents.resize(nbv);
+    bitangents.resize(nbv);
+    forEachNormalChunk(nbv, [&](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            Coord& t = tangents[i];
+            Coord& b = bitangents[i];
+            t.clear();
+            b.clear();
+            for (unsigned int c = m_vertexCornerBegin[i]; c < m_vertexCornerBegin[i+1]; ++c)
+            {
+                t += m_cornerTangents[m_vertexCorners[c]];
+                b += m_cornerBitangents[m_vertexCorners[c]];
+            }
+            const Coord n = normals[i];
+            b = sofa::defaulttype::cross(n, t.normalized());
+            t = sofa::defaulttype::cross(b, n);
+        }
+    });
+    m_vtangents.endEdit();
+    m_vbitangents.endEdit();
+}
+
 void VisualModelImpl::computeBBox(const core::ExecParams* params, bool)
 {
     const VecCoord& x = getVertices(); //m_vertices.getValue(params);
@@ -117,6 +117,8 @@ public:
     Data<bool> m_handleDynamicTopology; ///< True if topological changes should be handled
     Data<bool> m_fixMergedUVSeams; ///< True if UV seams should be handled even when duplicate UVs are merged
     Data<bool> m_keepLines; ///< keep and draw lines (false by default)
+    Data<bool> d_parallelNormals; ///< True if normals and tangents should be computed in parallel using the task scheduler
+    Data<SReal> d_normalsUpdateThreshold; ///< If positive, only faces with a vertex moved further than this distance since their last update get new normals and tangents
 
     Data< VecCoord > m_vertices2; ///< vertices of the model (only if vertices have multiple normals/texcoords, otherwise positions are used)
     topology::PointData< VecTexCoord > m_vtexcoords; ///< coordinates of the texture
@@ -422,6 +424,44 @@ public:
 
     bool insertInNode( core::objectmodel::BaseNode* node ) override { Inherit1::insertInNode(node); Inherit2::insertInNode(node); return true; }
     bool removeInNode( core::objectmodel::BaseNode* node ) override { Inherit1::removeInNode(node); Inherit2::removeInNode(node); return true; }
+
+protected:
+    /// Gather-based normal computation, used when parallelNormals or normalsUpdateThreshold is set.
+    /// Face normals are stored per face corner (one entry per triangle, one per quad corner) and
+    /// summed per vertex in the same order as computeNormals(), so results do not depend on the thread count.
+    void computeNormalsFromAdjacency();
+
+    /// Gather-based counterpart of computeTangents(), reusing the face corner adjacency.
+    void computeTangentsFromAdjacency();
+
+    /// Rebuild the vertex (and normal slot) to face corner adjacency if the mesh changed.
+    /// Returns true if the adjacency was rebuilt.
+    bool updateFaceCornerAdjacency(std::size_t nbVertices);
+
+    /// Run function(begin, end) over [0,size), in parallel if parallelNormals is set.
+    template<class Function>
+    void forEachNormalChunk(std::size_t size, const Function& function);
+
+    /// Vertex to face corner entries, in CSR form
+    helper::vector<unsigned int> m_vertexCornerBegin;
+    helper::vector<unsigned int> m_vertexCorners;
+    /// Normal slot to face corner entries, in CSR form (only used if m_vertNormIdx is not empty)
+    helper::vector<unsigned int> m_normalSlotCornerBegin;
+    helper::vector<unsigned int> m_normalSlotCorners;
+    /// Counters of the topology Data the adjacency was built from
+    int m_adjacencyCounters[3] {-1, -1, -1};
+    std::size_t m_adjacencyNbVertices {0};
+
+    VecDeriv m_cornerNormals;
+    VecDeriv m_slotNormals;
+    VecCoord m_cornerTangents;
+    VecCoord m_cornerBitangents;
+    /// Positions used for the last normal update of each vertex (incremental mode)
+    VecCoord m_normalsRefPositions;
+    /// Faces refreshed by the last computeNormalsFromAdjacency() call
+    helper::vector<char> m_dirtyFaces;
+    bool m_incrementalFaces {false};
+    int m_tangentsTexCoordsCounter {-1};
 };
 
 
@@ -29,6 +29,7 @@
 
 #include <sofa/core/objectmodel/BaseData.h>
 #include <sofa/core/objectmodel/BaseObject.h>
+#include <sofa/helper/io/TextTokenizer.h>
 
 namespace sofa
 {
@@ -72,6 +73,8 @@ public:
         ~BaseVTKDataIO() override {}
         virtual void resize(int n) = 0;
         virtual bool read(istream& f, int n, int binary) = 0;
+        /// Read n values at the position of the tokenizer, and move it after them
+        virtual bool read(helper::io::TextTokenizer& in, int n, int binary) = 0;
         virtual bool read(const string& s, int n, int binary) = 0;
         virtual bool read(const string& s, int binary) = 0;
         virtual bool write(ofstream& f, int n, int groups, int binary) = 0;
@@ -101,6 +104,7 @@ public:
         virtual bool read(const string& s, int n, int binary) override;
         virtual bool read(const string& s, int binary) override;
         virtual bool read(istream& in, int n, int binary) override;
+        virtual bool read(helper::io::TextTokenizer& in, int n, int binary) override;
         virtual bool write(ofstream& out, int n, int groups, int binary) override;
         BaseData* createSofaData() override ;
     };
@@ -22,10 +22,16 @@
 #ifndef SOFA_COMPONENT_LOADER_BASEVTKREADER_INL
 #define SOFA_COMPONENT_LOADER_BASEVTKREADER_INL
 #include <SofaLoader/BaseVTKReader.h>
+#include <sofa/helper/io/TextTokenizer.h>
+#include <sofa/simulation/ParallelFor.h>
 
 #include <string>
 #include <istream>
 #include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+#include <vector>
 
 
 namespace sofa
@@ -94,11 +100,64 @@ void BaseVTKReader::VTKDataIO<T>::swap()
         data[i] = swapT(data[i], nestedDataSize);
 }
 
+/// Parse n whitespace separated values. Large blocks of numbers (e.g. the vertices of a mesh)
+/// are split in chunks of values parsed concurrently on the task scheduler: finding the
+/// beginning of each chunk only scans the separators, which is much cheaper than parsing.
+template<class T>
+bool readTextValues(helper::io::TextTokenizer& in, T* values, int n)
+{
+    const int chunkSize = 16384;
+    if (!std::is_arithmetic<T>::value || n <= chunkSize)
+    {
+        int i = 0;
+        while (i < n && in.read(values[i]))
+            ++i;
+        return i == n;
+    }
+
+    auto isSeparator = [](char c) { return helper::io::TextTokenizer::isSpace(c) || c == '\n'; };
+    std::vector<const char*> chunks;
+    chunks.reserve(std::size_t(n / chunkSize + 1));
+    const char* p = in.position();
+    const char* end = in.end();
+    for (int i = 0; i < n; ++i)
+    {
+        while (p < end && isSeparator(*p))
+            ++p;
+        if (p == end)
+            return false;
+        if (i % chunkSize == 0)
+            chunks.push_back(p);
+        while (p < end && !isSeparator(*p))
+            ++p;
+    }
+
+    std::vector<char> chunkRead(chunks.size(), 1);
+    simulation::parallelFor(0, chunks.size(), 1, [&](std::size_t firstChunk, std::size_t lastChunk)
+    {
+        for (std::size_t c = firstChunk; c < lastChunk; ++c)
+        {
+            helper::io::TextTokenizer chunk(chunks[c], p);
+            const int last = std::min(n, int(c + 1) * chunkSize);
+            for (int i = int(c) * chunkSize; i < last; ++i)
+            {
+                if (!chunk.read(values[i]))
+                {
+                    chunkRead[c] = 0;
+                    break;
+                }
+            }
+        }
+    });
+    in.setPosition(p);
+    return std::find(chunkRead.begin(), chunkRead.end(), 0) == chunkRead.end();
+}
+
 template<class T>
 bool BaseVTKReader::VTKDataIO<T>::read(const string& s, int n, int binary)
 {
-    istringstream iss(s);
-    return read(iss, n, binary);
+    helper::io::TextTokenizer in(s.data(), s.data() + s.size());
+    return read(in, n, binary);
 }
 
 template<class T>
@@ -122,11 +181,10 @@ bool BaseVTKReader::VTKDataIO<T>::read(const string& s, int binary)
     }
     else
     {
-        n = sizeof(s.c_str())/sizeof(T);
+        n = int(s.size()/sizeof(T));
     }
-    istringstream iss(s);
-
-    return read(iss, n, binary);
+    helper::io::TextTokenizer in(s.data(), s.data() + s.size());
+    return read(in, n, binary);
 }
 
 template<class T>
@@ -156,7 +214,7 @@ bool BaseVTKReader::VTKDataIO<T>::read(istream& in, int n, int binary)
         while(i < dataSize && !in.eof() && !in.bad())
         {
             std::getline(in, line);
-            istringstream ln(line);
+            helper::io::TextTokenizer ln(line.data(), line.data() + line.size());
             while (i < n && ln >> data[i])
                 ++i;
         }
@@ -169,6 +227,41 @@ bool BaseVTKReader::VTKDataIO<T>::read(istream& in, int n, int binary)
     return true;
 }
 
+template<class T>
+bool BaseVTKReader::VTKDataIO<T>::read(helper::io::TextTokenizer& in, int n, int binary)
+{
+    resize(n);
+    if (binary)
+    {
+        const std::size_t size = std::size_t(n) * sizeof(T);
+        if (std::size_t(in.end() - in.position()) < size)
+        {
+            resize(0);
+            return false;
+        }
+        std::memcpy((char*)data, in.position(), size);
+        in.setPosition(in.position() + size);
+        if (binary == 2) // swap bytes
+        {
+            for (int i=0; i<n; ++i)
+            {
+                data[i] = swapT(data[i], nestedDataSize);
+            }
+        }
+    }
+    else
+    {
+        if (!readTextValues(in, data, n))
+        {
+            resize(0);
+            return false;
+        }
+        // as with the stream version, the rest of the last line is ignored
+        in.skipLine();
+    }
+    return true;
+}
+
 template<class T>
 bool BaseVTKReader::VTKDataIO<T>::write(ofstream& out, int n, int groups, int binary)
 {
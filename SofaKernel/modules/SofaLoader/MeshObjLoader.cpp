@@ -23,6 +23,8 @@
 #include <SofaLoader/MeshObjLoader.h>
 #include <sofa/core/visual/VisualParams.h>
 #include <sofa/helper/system/SetDirectory.h>
+#include <sofa/helper/io/MappedFile.h>
+#include <algorithm>
 #include <fstream>
 
 namespace sofa
@@ -114,16 +116,17 @@ bool MeshObjLoader::load()
 
     // -- Loading file
     const char* filename = m_filename.getFullPath().c_str();
-    std::ifstream file(filename);
+    helper::io::MappedFile file(filename);
 
-    if (!file.good())
+    if (!file.isOpen())
     {
         msg_error() << "Error: MeshObjLoader: Cannot read file '" << m_filename << "'.";
         return false;
     }
 
     // -- Reading file
-    fileRead = this->readOBJ (file,filename);
+    helper::io::TextTokenizer tokenizer(file.begin(), file.end());
+    fileRead = this->readOBJ (tokenizer,filename);
     file.close();
 
     return fileRead;
@@ -155,7 +158,7 @@ void MeshObjLoader::addGroup (const PrimitiveGroup& g)
     d_quadsGroups.endEdit();
 }
 
-bool MeshObjLoader::readOBJ (std::ifstream &file, const char* filename)
+bool MeshObjLoader::readOBJ (helper::io::TextTokenizer &file, const char* filename)
 {
  
     const bool handleSeams = d_handleSeams.getValue();
@@ -203,11 +206,13 @@ bool MeshObjLoader::readOBJ (std::ifstream &file, const char* filename)
     int curMaterialId = -1;
     int nbFaces[NBFACETYPE] = {0}; // number of edges, triangles, quads
     int groupF0[NBFACETYPE] = {0}; // first primitives indices in current group for edges, triangles, quads
-    std::string line;
-    while( std::getline(file,line) )
+    while( !file.eof() )
     {
-        if (line.empty()) continue;
-        std::istringstream values(line);
+        const char* lineBegin = file.position();
+        const char* lineEnd = file.lineEnd();
+        file.skipLine();
+        if (lineBegin == lineEnd) continue;
+        helper::io::TextTokenizer values(lineBegin, lineEnd);
         std::string token;
         values >> token;
 
@@ -291,33 +296,29 @@ bool MeshObjLoader::readOBJ (std::ifstream &file, const char* filename)
             nIndices.clear();
             tIndices.clear();
 
-            while (!values.eof())
+            const char* faceBegin;
+            const char* faceEnd;
+            while (values.nextWordInLine(faceBegin, faceEnd))
             {
-                std::string face;
-                values >> face;
-                if (face.empty()) continue;
                 for (int j = 0; j < 3; j++)
                 {
                     vtn[j] = -1;
-                    std::string::size_type pos = face.find('/');
-                    std::string tmp = face.substr(0, pos);
-                    if (pos == std::string::npos)
-                        face = "";
-                    else
-                    {
-                        face = face.substr(pos + 1);
-                    }
+                    const char* pos = std::find(faceBegin, faceEnd, '/');
+                    const char* tmp = faceBegin;
+                    faceBegin = (pos == faceEnd) ? faceEnd : pos + 1;
 
-                    if (!tmp.empty())
+                    if (tmp != pos)
                     {
-                        vtn[j] = atoi(tmp.c_str());
+                        const char* p = tmp;
+                        if (!helper::io::parseValue(p, pos, vtn[j]))
+                            vtn[j] = 0;
                         if (vtn[j] >= 1)
                             vtn[j] -=1; // -1 because the numerotation begins at 1 and a vector begins at 0
                         else if (vtn[j] < 0)
                             vtn[j] += (j==0) ? my_positions.size() : (j==1) ? my_texCoords.size() : my_normals.size();
                         else
                         {
-                            msg_error() << "Invalid index " << tmp;
+                            msg_error() << "Invalid index " << std::string(tmp, pos);
                             vtn[j] = -1;
                         }
                     }
@@ -25,6 +25,7 @@
 
 #include <sofa/core/loader/MeshLoader.h>
 #include <sofa/helper/SVector.h>
+#include <sofa/helper/io/TextTokenizer.h>
 #include <sofa/helper/types/Material.h>
 
 namespace sofa
@@ -56,7 +57,7 @@ public:
     }
 
 protected:
-    bool readOBJ (std::ifstream &file, const char* filename);
+    bool readOBJ (helper::io::TextTokenizer &file, const char* filename);
     bool readMTL (const char* filename, helper::vector <sofa::helper::types::Material>& d_materials);
     void addGroup (const sofa::core::loader::PrimitiveGroup& g);
 
@@ -33,8 +33,23 @@ using sofa::component::loader::BaseVTKReader ;
 /// This is needed for template specialization.
 #include <SofaLoader/BaseVTKReader.inl>
 
+#include <sofa/helper/io/MappedFile.h>
+#include <sofa/helper/io/TextTokenizer.h>
+
 #include <tinyxml.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#ifdef SOFA_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#if defined(WIN32)
+#define strcasecmp stricmp
+#endif
+
 //XML VTK Loader
 #define checkError(A) if (!A) { return false; }
 #define checkErrorPtr(A) if (!A) { return NULL; }
@@ -54,7 +69,6 @@ using sofa::core::objectmodel::BaseData ;
 using sofa::core::objectmodel::BaseObject ;
 using sofa::defaulttype::Vector3 ;
 using sofa::defaulttype::Vec ;
-using std::istringstream;
 using std::istream;
 using std::ofstream;
 using std::string;
@@ -69,6 +83,7 @@ public:
 class XMLVTKReader : public BaseVTKReader
 {
 public:
+    XMLVTKReader() : headerSize(4), appendedData(nullptr), appendedDataEnd(nullptr), appendedDataIsBase64(false) {}
     bool readFile(const char* filename) override;
 protected:
     bool loadUnstructuredGrid(TiXmlHandle datasetFormatHandle);
@@ -80,8 +95,31 @@ protected:
     BaseVTKDataIO* loadDataArray(TiXmlElement* dataArrayElement, int size, string type);
     BaseVTKDataIO* loadDataArray(TiXmlElement* dataArrayElement, int size);
     BaseVTKDataIO* loadDataArray(TiXmlElement* dataArrayElement);
+
+    /// Decode the header and (possibly compressed) data of a "binary" or "appended" DataArray
+    bool readBinaryData(const char* begin, const char* end, bool base64, string& bytes);
+
+    /// Size in bytes of the integers in the headers of binary data (header_type attribute)
+    std::size_t headerSize;
+    string compressor;
+    /// Content of the AppendedData section, after the '_' marker
+    const char* appendedData;
+    const char* appendedDataEnd;
+    bool appendedDataIsBase64;
 };
 
+namespace
+{
+
+/// Copy the current line of the file without its line break, and move to the next one
+void getLine(helper::io::TextTokenizer& file, string& line)
+{
+    line.assign(file.position(), file.lineEnd());
+    file.skipLine();
+}
+
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////////////// MeshVTKLoader IMPLEMENTATION //////////////////////////////////
 MeshVTKLoader::MeshVTKLoader() : MeshLoader()
@@ -91,19 +129,20 @@ MeshVTKLoader::MeshVTKLoader() : MeshLoader()
 
 MeshVTKLoader::VTKFileType MeshVTKLoader::detectFileType(const char* filename)
 {
-    std::ifstream inVTKFile(filename, std::ifstream::in | std::ifstream::binary);
+    helper::io::MappedFile file(filename);
 
-    if( !inVTKFile.is_open() )
+    if( !file.isOpen() )
     {
         return MeshVTKLoader::NONE;
     }
+    helper::io::TextTokenizer inVTKFile(file.begin(), file.end());
 
     string line;
-    std::getline(inVTKFile, line);
+    getLine(inVTKFile, line);
 
     if (line.find("<?xml") != string::npos)
     {
-        std::getline(inVTKFile, line);
+        getLine(inVTKFile, line);
 
         if (line.find("<VTKFile") != string::npos)
         {
@@ -569,16 +608,17 @@ bool MeshVTKLoader::setInputsData()
 //Legacy VTK Loader
 bool LegacyVTKReader::readFile(const char* filename)
 {
-    std::ifstream inVTKFile(filename, std::ifstream::in | std::ifstream::binary);
-    if( !inVTKFile.is_open() )
+    helper::io::MappedFile file(filename);
+    if( !file.isOpen() )
     {
         return false;
     }
+    helper::io::TextTokenizer inVTKFile(file.begin(), file.end());
 
     string line;
 
     // Part 1
-    std::getline(inVTKFile, line);
+    getLine(inVTKFile, line);
     if (string(line, 0, 23) != "# vtk DataFile Version ")
     {
         msg_error() << "Error: Unrecognized header in file '" << filename << "'." ;
@@ -588,10 +628,10 @@ bool LegacyVTKReader::readFile(const char* filename)
 
     // Part 2
     string header;
-    std::getline(inVTKFile, header);
+    getLine(inVTKFile, header);
 
     // Part 3
-    std::getline(inVTKFile, line);
+    getLine(inVTKFile, line);
 
     int binary;
     if (line == "BINARY" || line == "BINARY\r" )
@@ -617,9 +657,9 @@ bool LegacyVTKReader::readFile(const char* filename)
     // Part 4
     do
     {
-        std::getline(inVTKFile, line);
+        getLine(inVTKFile, line);
     }
-    while (line.empty());
+    while (!inVTKFile.eof() && line.empty());
     if (line != "DATASET POLYDATA" && line != "DATASET UNSTRUCTURED_GRID"
             && line != "DATASET POLYDATA\r" && line != "DATASET UNSTRUCTURED_GRID\r" )
     {
@@ -637,11 +677,11 @@ bool LegacyVTKReader::readFile(const char* filename)
     {
         do
         {
-            std::getline(inVTKFile, line);
+            getLine(inVTKFile, line);
         }
         while (!inVTKFile.eof() && line.empty());
 
-        istringstream ln(line);
+        helper::io::TextTokenizer ln(line.data(), line.data() + line.size());
         string kw;
         ln >> kw;
         if (kw == "POINTS")
@@ -726,11 +766,11 @@ bool LegacyVTKReader::readFile(const char* filename)
             ln >> nb_ele;
             while (!inVTKFile.eof())
             {
-                std::ifstream::pos_type previousPos = inVTKFile.tellg();
+                const char* previousPos = inVTKFile.position();
                 /// line defines the type and name such as SCALAR dataset
                 do
                 {
-                    std::getline(inVTKFile, line);
+                    getLine(inVTKFile, line);
                 }
                 while (!inVTKFile.eof() && line.empty());
 
@@ -738,7 +778,7 @@ bool LegacyVTKReader::readFile(const char* filename)
                 {
                     break;
                 }
-                istringstream lnData(line);
+                helper::io::TextTokenizer lnData(line.data(), line.data() + line.size());
                 string dataStructure;
                 lnData >> dataStructure;
 
@@ -753,11 +793,11 @@ bool LegacyVTKReader::readFile(const char* filename)
                     {
                         {
                             // skip lookup_table if present
-                            const std::ifstream::pos_type positionBeforeLookupTable = inVTKFile.tellg();
+                            const char* positionBeforeLookupTable = inVTKFile.position();
                             std::string lookupTable;
                             std::string lookupTableName;
-                            std::getline(inVTKFile, line);
-                            istringstream lnDataLookup(line);
+                            getLine(inVTKFile, line);
+                            helper::io::TextTokenizer lnDataLookup(line.data(), line.data() + line.size());
                             lnDataLookup >> lookupTable >> lookupTableName;
                             if (lookupTable == "LOOKUP_TABLE")
                             {
@@ -765,7 +805,7 @@ bool LegacyVTKReader::readFile(const char* filename)
                             }
                             else
                             {
-                                inVTKFile.seekg(positionBeforeLookupTable);
+                                inVTKFile.setPosition(positionBeforeLookupTable);
                             }
                         }
                         if (data->read(inVTKFile, nb_ele, binary))
@@ -839,10 +879,10 @@ bool LegacyVTKReader::readFile(const char* filename)
                     {
                         do
                         {
-                            std::getline(inVTKFile, line);
+                            getLine(inVTKFile, line);
                         }
-                        while (line.empty());
-                        istringstream lnData(line);
+                        while (!inVTKFile.eof() && line.empty());
+                        helper::io::TextTokenizer lnData(line.data(), line.data() + line.size());
                         std::string dataName;
                         int nbData;
                         int nbComponents;
@@ -890,7 +930,7 @@ bool LegacyVTKReader::readFile(const char* filename)
                 }
                 else     /// TODO
                 {
-                    inVTKFile.seekg(previousPos);
+                    inVTKFile.setPosition(previousPos);
                     break;
                 }
             }
@@ -956,11 +996,192 @@ bool LegacyVTKReader::readFile(const char* filename)
     return true;
 }
 
+namespace
+{
+
+/// Reverse the bytes of a value, to read files written with the other endianness
+template<class T>
+T swapBytes(T t)
+{
+    char* b = (char*) &t;
+    std::reverse(b, b + sizeof(T));
+    return t;
+}
+
+/// Sequential reader over the binary content of a DataArray, either raw or base64 encoded.
+/// Several base64 segments may follow each other (VTK encodes the header of compressed
+/// data separately), each one being padded independently.
+class BinaryDataSource
+{
+public:
+    BinaryDataSource(const char* begin, const char* end, bool base64)
+        : m_pos(begin), m_end(end), m_base64(base64), m_pendingPos(0) {}
+
+    bool read(std::size_t n, string& out)
+    {
+        out.clear();
+        if (!m_base64)
+        {
+            if ((std::size_t)(m_end - m_pos) < n)
+                return false;
+            out.assign(m_pos, n);
+            m_pos += n;
+            return true;
+        }
+
+        while (m_pending.size() - m_pendingPos < n)
+        {
+            if (m_pendingPos > 0)
+            {
+                m_pending.erase(0, m_pendingPos);
+                m_pendingPos = 0;
+            }
+            if (!decodeQuantum())
+                return false;
+        }
+        out.assign(m_pending, m_pendingPos, n);
+        m_pendingPos += n;
+        return true;
+    }
+
+    std::uint64_t readInteger(std::size_t size, bool swap, bool& ok)
+    {
+        string bytes;
+        ok = read(size, bytes);
+        if (!ok)
+            return 0;
+        if (size == 8)
+        {
+            std::uint64_t v;
+            std::memcpy(&v, bytes.data(), 8);
+            return swap ? swapBytes(v) : v;
+        }
+        std::uint32_t v;
+        std::memcpy(&v, bytes.data(), 4);
+        return swap ? swapBytes(v) : v;
+    }
+
+protected:
+    static int decodeChar(char c)
+    {
+        if (c >= 'A' && c <= 'Z') return c - 'A';
+        if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+        if (c >= '0' && c <= '9') return c - '0' + 52;
+        if (c == '+') return 62;
+        if (c == '/') return 63;
+        return -1;
+    }
+
+    /// Decode the next group of 4 characters into up to 3 bytes
+    bool decodeQuantum()
+    {
+        unsigned int bits = 0;
+        int nbChars = 0;
+        int nbPadding = 0;
+        while (nbChars < 4)
+        {
+            if (m_pos == m_end || *m_pos == '<')
+                return false;
+            const char c = *m_pos++;
+            if (c == '=')
+            {
+                ++nbPadding;
+            }
+            else
+            {
+                const int v = decodeChar(c);
+                if (v < 0)
+                    continue; // whitespace
+                if (nbPadding > 0)
+                    return false;
+                bits |= (unsigned int)v << (6 * (3 - nbChars));
+            }
+            ++nbChars;
+        }
+        if (nbPadding > 2)
+            return false;
+        for (int i = 0; i < 3 - nbPadding; ++i)
+            m_pending.push_back((char)((bits >> (8 * (2 - i))) & 0xFF));
+        return true;
+    }
+
+    const char* m_pos;
+    const char* m_end;
+    bool m_base64;
+    string m_pending;
+    std::size_t m_pendingPos;
+};
+
+template<class From, class To>
+void convertValues(const string& bytes, bool swap, string& converted)
+{
+    const std::size_t n = bytes.size() / sizeof(From);
+    converted.resize(n * sizeof(To));
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        From v;
+        std::memcpy(&v, bytes.data() + i * sizeof(From), sizeof(From));
+        if (swap)
+            v = swapBytes(v);
+        const To t = (To) v;
+        std::memcpy(&converted[i * sizeof(To)], &t, sizeof(To));
+    }
+}
+
+/// Convert binary values stored as the VTK scalar type fromType into native values of type To
+template<class To>
+bool convertBinaryValues(const string& fromType, const string& bytes, bool swap, string& converted)
+{
+    const char* t = fromType.c_str();
+    if (!strcasecmp(t, "Int8") || !strcasecmp(t, "char")) convertValues<std::int8_t, To>(bytes, swap, converted);
+    else if (!strcasecmp(t, "UInt8") || !strcasecmp(t, "unsigned_char")) convertValues<std::uint8_t, To>(bytes, swap, converted);
+    else if (!strcasecmp(t, "Int16") || !strcasecmp(t, "short")) convertValues<std::int16_t, To>(bytes, swap, converted);
+    else if (!strcasecmp(t, "UInt16") || !strcasecmp(t, "unsigned_short")) convertValues<std::uint16_t, To>(bytes, swap, converted);
+    else if (!strcasecmp(t, "Int32") || !strcasecmp(t, "int")) convertValues<std::int32_t, To>(bytes, swap, converted);
+    else if (!strcasecmp(t, "UInt32") || !strcasecmp(t, "unsigned_int")) convertValues<std::uint32_t, To>(bytes, swap, converted);
+    else if (!strcasecmp(t, "Int64") || !strcasecmp(t, "long")) convertValues<std::int64_t, To>(bytes, swap, converted);
+    else if (!strcasecmp(t, "UInt64") || !strcasecmp(t, "unsigned_long")) convertValues<std::uint64_t, To>(bytes, swap, converted);
+    else if (!strcasecmp(t, "Float32") || !strcasecmp(t, "float")) convertValues<float, To>(bytes, swap, converted);
+    else if (!strcasecmp(t, "Float64") || !strcasecmp(t, "double")) convertValues<double, To>(bytes, swap, converted);
+    else return false;
+    return true;
+}
+
+} // anonymous namespace
+
 bool XMLVTKReader::readFile(const char* filename)
 {
+    helper::io::MappedFile vtkFile;
+    checkErrorMsg(vtkFile.open(filename), "Unable to open file " << filename);
+
+    // Raw appended data is not valid XML: only the text before it is given to the parser,
+    // and the DataArrays read their content directly from the file.
+    static const char appendedDataTag[] = "<AppendedData";
+    const char* appendedDataBegin = std::search(vtkFile.begin(), vtkFile.end(),
+                                                appendedDataTag, appendedDataTag + sizeof(appendedDataTag) - 1);
+    string xmlText;
+    appendedData = appendedDataEnd = nullptr;
+    if (appendedDataBegin != vtkFile.end())
+    {
+        const char* tagEnd = std::find(appendedDataBegin, vtkFile.end(), '>');
+        appendedDataIsBase64 = (string(appendedDataBegin, tagEnd).find("base64") != string::npos);
+        appendedData = std::find(tagEnd, vtkFile.end(), '_');
+        checkErrorMsg((appendedData != vtkFile.end()), "AppendedData marker '_' not found");
+        ++appendedData;
+        appendedDataEnd = vtkFile.end();
+        xmlText.assign(vtkFile.begin(), appendedDataBegin);
+        xmlText += "</VTKFile>";
+    }
+    else
+    {
+        xmlText.assign(vtkFile.begin(), vtkFile.end());
+    }
+    xmlText.erase(std::remove(xmlText.begin(), xmlText.end(), '\r'), xmlText.end());
+
     TiXmlDocument vtkDoc(filename);
+    vtkDoc.Parse(xmlText.c_str());
     //quick check
-    checkErrorMsg(vtkDoc.LoadFile(), "Unknown error while loading VTK Xml doc");
+    checkErrorMsg(!vtkDoc.Error(), "Unknown error while loading VTK Xml doc");
 
     TiXmlHandle hVTKDoc(&vtkDoc);
     TiXmlElement* pElem;
@@ -976,6 +1197,12 @@ bool XMLVTKReader::readFile(const char* filename)
     const char* endiannessStrTemp = pElem->Attribute("byte_order");
     isLittleEndian = (string(endiannessStrTemp).compare("LittleEndian") == 0) ;
 
+    //Binary data layout
+    const char* headerTypeStrTemp = pElem->Attribute("header_type");
+    headerSize = (headerTypeStrTemp && string(headerTypeStrTemp).compare("UInt64") == 0) ? 8 : 4;
+    const char* compressorStrTemp = pElem->Attribute("compressor");
+    compressor = compressorStrTemp ? string(compressorStrTemp) : string();
+
     //read VTK data format type
     const char* datasetFormatStrTemp = pElem->Attribute("type");
     checkErrorMsg(datasetFormatStrTemp, "Dataset format not defined")
@@ -1038,6 +1265,7 @@ bool XMLVTKReader::readFile(const char* filename)
             checkErrorMsg(false, "Dataset format not implemented");
             break;
     }
+    appendedData = appendedDataEnd = nullptr;
     checkErrorMsg(stateLoading, "Error while parsing XML");
 
     return true;
@@ -1099,17 +1327,51 @@ BaseVTKReader::BaseVTKDataIO* XMLVTKReader::loadDataArray(TiXmlElement* dataArra
     }
 
     //Values
-    const char* listValuesStrTemp = dataArrayElement->GetText();
-
-    bool state = false;
+    string values;
+    if (binary == 0)
+    {
+        const char* listValuesStrTemp = dataArrayElement->GetText();
 
-    if (!listValuesStrTemp)
+        if (!listValuesStrTemp)
+        {
+            return NULL;
+        }
+        values = string(listValuesStrTemp);
+        if (values.size() < 1)
+        {
+            return NULL;
+        }
+    }
+    else if (string(formatStrTemp).compare("appended") == 0)
     {
-        return NULL;
+        int offset = 0;
+        checkErrorPtr(appendedData);
+        checkErrorPtr((dataArrayElement->QueryIntAttribute("offset", &offset) == TIXML_SUCCESS));
+        checkErrorPtr((offset >= 0 && offset < appendedDataEnd - appendedData));
+        checkErrorPtr(readBinaryData(appendedData + offset, appendedDataEnd, appendedDataIsBase64, values));
     }
-    if (string(listValuesStrTemp).size() < 1)
+    else
     {
-        return NULL;
+        const char* listValuesStrTemp = dataArrayElement->GetText();
+        checkErrorPtr(listValuesStrTemp);
+        checkErrorPtr(readBinaryData(listValuesStrTemp, listValuesStrTemp + strlen(listValuesStrTemp), true, values));
+    }
+
+    //Binary values stored with another type than the requested one are converted
+    const char* storedTypeStrTemp = dataArrayElement->Attribute("type");
+    if (binary != 0 && storedTypeStrTemp && strcasecmp(storedTypeStrTemp, typeStrTemp) != 0)
+    {
+        string converted;
+        bool state = false;
+        if (!strcasecmp(typeStrTemp, "Float64"))
+            state = convertBinaryValues<double>(storedTypeStrTemp, values, binary == 2, converted);
+        else if (!strcasecmp(typeStrTemp, "Float32"))
+            state = convertBinaryValues<float>(storedTypeStrTemp, values, binary == 2, converted);
+        else if (!strcasecmp(typeStrTemp, "Int32"))
+            state = convertBinaryValues<std::int32_t>(storedTypeStrTemp, values, binary == 2, converted);
+        checkErrorPtr(state);
+        values.swap(converted);
+        binary = 1;
     }
 
     BaseVTKDataIO* d = BaseVTKReader::newVTKDataIO(string(typeStrTemp));
@@ -1119,19 +1381,69 @@ BaseVTKReader::BaseVTKDataIO* XMLVTKReader::loadDataArray(TiXmlElement* dataArra
         return NULL;
     }
 
+    bool state = false;
     if (size > 0)
     {
-        state = (d->read(string(listValuesStrTemp), numberOfComponents * size, binary));
+        state = (d->read(values, numberOfComponents * size, binary));
     }
     else
     {
-        state = (d->read(string(listValuesStrTemp), binary));
+        state = (d->read(values, binary));
     }
     checkErrorPtr(state);
 
     return d;
 }
 
+bool XMLVTKReader::readBinaryData(const char* begin, const char* end, bool base64, string& bytes)
+{
+    const bool swap = !isLittleEndian;
+    BinaryDataSource source(begin, end, base64);
+    bool ok = true;
+
+    if (compressor.empty())
+    {
+        const std::uint64_t nbBytes = source.readInteger(headerSize, swap, ok);
+        return ok && source.read((std::size_t)nbBytes, bytes);
+    }
+
+#ifdef SOFA_HAVE_ZLIB
+    if (compressor.compare("vtkZLibDataCompressor") != 0)
+    {
+        msg_error("MeshVTKLoader") << "Unsupported compressor " << compressor;
+        return false;
+    }
+
+    // header: number of blocks, block size, size of the last block, compressed size of each block
+    const std::uint64_t nbBlocks = source.readInteger(headerSize, swap, ok);
+    const std::uint64_t blockSize = ok ? source.readInteger(headerSize, swap, ok) : 0;
+    const std::uint64_t lastBlockSize = ok ? source.readInteger(headerSize, swap, ok) : 0;
+    std::vector<std::uint64_t> compressedSizes;
+    for (std::uint64_t b = 0; ok && b < nbBlocks; ++b)
+        compressedSizes.push_back(source.readInteger(headerSize, swap, ok));
+    if (!ok)
+        return false;
+
+    bytes.clear();
+    string compressed;
+    for (std::uint64_t b = 0; b < nbBlocks; ++b)
+    {
+        if (!source.read((std::size_t)compressedSizes[b], compressed))
+            return false;
+        uLongf uncompressedSize = (uLongf)((b + 1 == nbBlocks && lastBlockSize != 0) ? lastBlockSize : blockSize);
+        const std::size_t blockBegin = bytes.size();
+        bytes.resize(blockBegin + uncompressedSize);
+        if (uncompress((Bytef*)&bytes[blockBegin], &uncompressedSize, (const Bytef*)compressed.data(), (uLong)compressed.size()) != Z_OK)
+            return false;
+        bytes.resize(blockBegin + uncompressedSize);
+    }
+    return true;
+#else
+    msg_error("MeshVTKLoader") << "Compressed data can not be read without zlib";
+    return false;
+#endif
+}
+
 bool XMLVTKReader::loadUnstructuredGrid(TiXmlHandle datasetFormatHandle)
 {
     TiXmlElement* pieceElem = datasetFormatHandle.FirstChild( "Piece" ).ToElement();
@@ -1175,13 +1487,13 @@ bool XMLVTKReader::loadUnstructuredGrid(TiXmlHandle datasetFormatHandle)
                     if (currentDataArrayName.compare("connectivity") == 0)
                     {
                         //number of elements in values is not known ; have to guess it
-                        inputCells = loadDataArray(dataArrayElement);
+                        inputCells = loadDataArray(dataArrayElement, 0, "Int32");
                         checkError(inputCells);
                     }
                     ///DA - offsets
                     if (currentDataArrayName.compare("offsets") == 0)
                     {
-                        inputCellOffsets = loadDataArray(dataArrayElement, numberOfCells - 1);
+                        inputCellOffsets = loadDataArray(dataArrayElement, numberOfCells - 1, "Int32");
                         checkError(inputCellOffsets);
                     }
                     ///DA - types
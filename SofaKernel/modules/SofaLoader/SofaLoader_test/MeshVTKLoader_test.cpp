@@ -32,6 +32,16 @@ using sofa::helper::BackTrace ;
 #include <sofa/helper/testing/BaseTest.h>
 using sofa::helper::testing::BaseTest ;
 
+#include <sofa/simulation/TaskScheduler.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+
+#ifdef SOFA_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
 namespace sofa
 {
 namespace meshvtkloader_test
@@ -60,6 +70,52 @@ struct MeshVTKLoaderTest : public BaseTest,
         EXPECT_EQ(nbHexahedra, d_hexahedra.getValue().size());
     }
 
+    /// Content of a binary DataArray: a header with the number of bytes, then the values
+    template<class Header, class T>
+    static std::string binaryBlock(const std::vector<T>& values)
+    {
+        const Header nbBytes = Header(values.size() * sizeof(T));
+        std::string block((const char*)&nbBytes, sizeof(Header));
+        block.append((const char*)values.data(), nbBytes);
+        return block;
+    }
+
+    static std::string base64(const std::string& bytes)
+    {
+        static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        std::string text;
+        for (std::size_t i = 0; i < bytes.size(); i += 3)
+        {
+            unsigned int bits = (unsigned char)bytes[i] << 16;
+            if (i + 1 < bytes.size()) bits |= (unsigned char)bytes[i + 1] << 8;
+            if (i + 2 < bytes.size()) bits |= (unsigned char)bytes[i + 2];
+            text += table[(bits >> 18) & 63];
+            text += table[(bits >> 12) & 63];
+            text += (i + 1 < bytes.size()) ? table[(bits >> 6) & 63] : '=';
+            text += (i + 2 < bytes.size()) ? table[bits & 63] : '=';
+        }
+        return text;
+    }
+
+    /// One tetrahedron, stored with the types written by VTK (Float32 points, Int64 connectivity, UInt8 types)
+    const std::vector<float> tetraPoints {0,0,0, 1,0,0, 0,1,0, 0,0,1.5f};
+    const std::vector<std::int64_t> tetraConnectivity {0, 1, 2, 3};
+    const std::vector<std::int64_t> tetraOffsets {4};
+    const std::vector<std::uint8_t> tetraTypes {10};
+
+    void writeFile(const std::string& filename, const std::string& content)
+    {
+        std::ofstream file(filename.c_str(), std::ios::binary);
+        file << content;
+    }
+
+    void checkTetra()
+    {
+        ASSERT_EQ(4u, d_positions.getValue().size());
+        EXPECT_EQ(defaulttype::Vector3(0, 0, 1.5), d_positions.getValue()[3]);
+        ASSERT_EQ(1u, d_tetrahedra.getValue().size());
+        EXPECT_EQ(3u, d_tetrahedra.getValue()[0][3]);
+    }
 };
 
 TEST_F(MeshVTKLoaderTest, detectFileType)
@@ -125,6 +181,100 @@ TEST_F(MeshVTKLoaderTest, loadLegacy_binary)
     EXPECT_TRUE(dynamic_cast<Data<helper::vector<defaulttype::Vec3f>>*>(vect2) != nullptr);
 }
 
+TEST_F(MeshVTKLoaderTest, loadXML_appendedRaw)
+{
+    std::string appended;
+    std::vector<std::size_t> offsets;
+    offsets.push_back(appended.size()); appended += binaryBlock<std::uint64_t>(tetraPoints);
+    offsets.push_back(appended.size()); appended += binaryBlock<std::uint64_t>(tetraConnectivity);
+    offsets.push_back(appended.size()); appended += binaryBlock<std::uint64_t>(tetraOffsets);
+    offsets.push_back(appended.size()); appended += binaryBlock<std::uint64_t>(tetraTypes);
+
+    std::ostringstream xml;
+    xml << "<?xml version=\"1.0\"?>\n"
+        << "<VTKFile type=\"UnstructuredGrid\" version=\"1.0\" byte_order=\"LittleEndian\" header_type=\"UInt64\">\n"
+        << "<UnstructuredGrid><Piece NumberOfPoints=\"4\" NumberOfCells=\"1\">\n"
+        << "<Points><DataArray type=\"Float32\" NumberOfComponents=\"3\" format=\"appended\" offset=\"" << offsets[0] << "\"/></Points>\n"
+        << "<Cells>\n"
+        << "<DataArray type=\"Int64\" Name=\"connectivity\" format=\"appended\" offset=\"" << offsets[1] << "\"/>\n"
+        << "<DataArray type=\"Int64\" Name=\"offsets\" format=\"appended\" offset=\"" << offsets[2] << "\"/>\n"
+        << "<DataArray type=\"UInt8\" Name=\"types\" format=\"appended\" offset=\"" << offsets[3] << "\"/>\n"
+        << "</Cells></Piece></UnstructuredGrid>\n"
+        << "<AppendedData encoding=\"raw\">\n_" << appended << "\n</AppendedData>\n</VTKFile>\n";
+
+    const std::string filename = "MeshVTKLoader_test_appended.vtu";
+    writeFile(filename, xml.str());
+    setFilename(filename);
+    EXPECT_TRUE(load());
+    checkTetra();
+    std::remove(filename.c_str());
+}
+
+#ifdef SOFA_HAVE_ZLIB
+TEST_F(MeshVTKLoaderTest, loadXML_compressedBase64)
+{
+    // one zlib block per array; the header and the data are encoded separately, as VTK does
+    auto compressedArray = [](const std::string& raw)
+    {
+        uLongf size = compressBound((uLong)raw.size());
+        std::string compressed(size, '\0');
+        compress((Bytef*)&compressed[0], &size, (const Bytef*)raw.data(), (uLong)raw.size());
+        compressed.resize(size);
+        const std::uint32_t header[4] = {1, (std::uint32_t)raw.size(), (std::uint32_t)raw.size(), (std::uint32_t)size};
+        return base64(std::string((const char*)header, sizeof(header))) + base64(compressed);
+    };
+    auto bytes = [](const void* data, std::size_t size) { return std::string((const char*)data, size); };
+
+    std::ostringstream xml;
+    xml << "<?xml version=\"1.0\"?>\n"
+        << "<VTKFile type=\"UnstructuredGrid\" version=\"0.1\" byte_order=\"LittleEndian\" compressor=\"vtkZLibDataCompressor\">\n"
+        << "<UnstructuredGrid><Piece NumberOfPoints=\"4\" NumberOfCells=\"1\">\n"
+        << "<Points><DataArray type=\"Float32\" NumberOfComponents=\"3\" format=\"binary\">\n"
+        << compressedArray(bytes(tetraPoints.data(), tetraPoints.size() * sizeof(float))) << "\n</DataArray></Points>\n"
+        << "<Cells>\n"
+        << "<DataArray type=\"Int64\" Name=\"connectivity\" format=\"binary\">"
+        << compressedArray(bytes(tetraConnectivity.data(), tetraConnectivity.size() * sizeof(std::int64_t))) << "</DataArray>\n"
+        << "<DataArray type=\"Int64\" Name=\"offsets\" format=\"binary\">"
+        << compressedArray(bytes(tetraOffsets.data(), tetraOffsets.size() * sizeof(std::int64_t))) << "</DataArray>\n"
+        << "<DataArray type=\"UInt8\" Name=\"types\" format=\"binary\">"
+        << compressedArray(bytes(tetraTypes.data(), tetraTypes.size())) << "</DataArray>\n"
+        << "</Cells></Piece></UnstructuredGrid>\n</VTKFile>\n";
+
+    const std::string filename = "MeshVTKLoader_test_compressed.vtu";
+    writeFile(filename, xml.str());
+    setFilename(filename);
+    EXPECT_TRUE(load());
+    checkTetra();
+    std::remove(filename.c_str());
+}
+#endif
+
+TEST_F(MeshVTKLoaderTest, loadLegacy_largeAscii)
+{
+    // enough points for the coordinates to be parsed in several chunks, on several threads
+    simulation::TaskScheduler::getInstance()->init(4);
+
+    const unsigned nbPoints = 20000;
+    std::ostringstream vtk;
+    vtk << "# vtk DataFile Version 3.0\nlarge\nASCII\nDATASET POLYDATA\n"
+        << "POINTS " << nbPoints << " float\n";
+    for (unsigned i = 0; i < nbPoints; ++i)
+        vtk << i << " " << 0.5 * i << ((i % 3 == 2) ? "\n" : " ") << -0.25 * i << ((i % 2) ? "\n" : "\t");
+    vtk << "\nPOLYGONS 2 8\n3 0 1 2\n3 " << nbPoints - 3 << " " << nbPoints - 2 << " " << nbPoints - 1 << "\n";
+
+    const std::string filename = "MeshVTKLoader_test_large.vtk";
+    writeFile(filename, vtk.str());
+    setFilename(filename);
+    EXPECT_TRUE(load());
+    std::remove(filename.c_str());
+
+    ASSERT_EQ(nbPoints, d_positions.getValue().size());
+    for (unsigned i = 0; i < nbPoints; ++i)
+        ASSERT_EQ(defaulttype::Vector3(i, 0.5 * i, -0.25 * i), d_positions.getValue()[i]) << "point " << i;
+    ASSERT_EQ(2u, d_triangles.getValue().size());
+    EXPECT_EQ(nbPoints - 1, d_triangles.getValue()[1][2]);
+}
+
 TEST_F(MeshVTKLoaderTest, loadInvalidFilenames)
 {
     EXPECT_MSG_EMIT(Error) ;
@@ -34,6 +34,11 @@ using sofa::simulation::Node ;
 using sofa::simulation::SceneLoaderXML ;
 using sofa::core::ExecParams ;
 
+#include <sofa/simulation/TaskScheduler.h>
+using sofa::simulation::TaskScheduler ;
+
+#include <sofa/core/behavior/LinearSolver.h>
+
 namespace sofa {
 
 using namespace modeling;
@@ -134,6 +139,203 @@ struct TetrahedronFEMForceField_test : public ForceField_test<_TetrahedronFEMFor
 
         EXPECT_EQ(fem->getComponentState(), ComponentState::Invalid) ;
     }
+
+    /// The parallel addForce/addDForce must give exactly the same results as the sequential ones
+    void checkParallelForcesMatchSequential(const std::string& method)
+    {
+        this->clearSceneGraph();
+
+        std::stringstream scene ;
+        scene << "<?xml version='1.0'?>"
+                 "<Node 	name='Root'>                                \n"
+                 "  <Node name='FEMnode'>                               \n"
+                 "    <RegularGridTopology n='6 5 4' min='0 0 0' max='5 4 3'/>  \n"
+                 "    <MechanicalObject/>                               \n"
+                 "    <TetrahedronFEMForceField name='fem' youngModulus='5000' poissonRatio='0.3' "
+                 "                              method='" << method << "' parallelGrainSize='7'/>\n"
+                 "  </Node>                                             \n"
+                 "</Node>                                               \n" ;
+
+        Node::SPtr root = SceneLoaderXML::loadFromMemory ("testscene",
+                                                          scene.str().c_str(),
+                                                          scene.str().size()) ;
+        root->init(ExecParams::defaultInstance()) ;
+
+        ForceType* fem = dynamic_cast<ForceType*>(root->getTreeNode("FEMnode")->getObject("fem")) ;
+        ASSERT_NE(fem, nullptr) ;
+
+        // deformed positions and some displacement
+        VecCoord x = fem->_initialPoints.getValue() ;
+        VecDeriv dx(x.size()) ;
+        for (std::size_t i=0; i<x.size(); ++i)
+        {
+            DataTypes::set( dx[i], (Real)std::sin(1.3*i), (Real)std::cos(0.7*i), (Real)std::sin(0.1*i*i) ) ;
+            x[i] += dx[i] * (Real)0.2 ;
+        }
+
+        core::objectmodel::Data<VecCoord> dataX ; dataX.setValue(x) ;
+        core::objectmodel::Data<VecDeriv> dataV ; dataV.setValue(VecDeriv(x.size())) ;
+        core::objectmodel::Data<VecDeriv> dataDx ; dataDx.setValue(dx) ;
+        core::MechanicalParams mparams ;
+        mparams.setKFactor(1.7) ;
+
+        TaskScheduler* scheduler = TaskScheduler::getInstance() ;
+        scheduler->init(4) ;
+
+        core::objectmodel::Data<VecDeriv> sequentialF, sequentialDf, parallelF, parallelDf ;
+        fem->d_parallel.setValue(false) ;
+        fem->addForce(&mparams, sequentialF, dataX, dataV) ;
+        fem->addDForce(&mparams, sequentialDf, dataDx) ;
+
+        fem->d_parallel.setValue(true) ;
+        fem->addForce(&mparams, parallelF, dataX, dataV) ;
+        fem->addDForce(&mparams, parallelDf, dataDx) ;
+
+        scheduler->stop() ;
+
+        ASSERT_EQ(sequentialF.getValue().size(), parallelF.getValue().size()) ;
+        ASSERT_EQ(sequentialDf.getValue().size(), parallelDf.getValue().size()) ;
+        for (std::size_t i=0; i<x.size(); ++i)
+        {
+            for (std::size_t j=0; j<3; ++j)
+            {
+                EXPECT_EQ(sequentialF.getValue()[i][j], parallelF.getValue()[i][j]) ;
+                EXPECT_EQ(sequentialDf.getValue()[i][j], parallelDf.getValue()[i][j]) ;
+            }
+        }
+    }
+
+    void checkVectorizedForcesMatchScalar(bool parallel)
+    {
+        this->clearSceneGraph();
+
+        // 6*5*4 grid: the number of tetrahedra is not a multiple of the packing size
+        std::stringstream scene ;
+        scene << "<?xml version='1.0'?>"
+                 "<Node 	name='Root'>                                \n"
+                 "  <Node name='FEMnode'>                               \n"
+                 "    <RegularGridTopology n='6 5 4' min='0 0 0' max='5 4 3'/>  \n"
+                 "    <MechanicalObject/>                               \n"
+                 "    <TetrahedronFEMForceField name='fem' youngModulus='5000' poissonRatio='0.3' "
+                 "                              method='large' parallelGrainSize='7'/>\n"
+                 "  </Node>                                             \n"
+                 "</Node>                                               \n" ;
+
+        Node::SPtr root = SceneLoaderXML::loadFromMemory ("testscene",
+                                                          scene.str().c_str(),
+                                                          scene.str().size()) ;
+        root->init(ExecParams::defaultInstance()) ;
+
+        ForceType* fem = dynamic_cast<ForceType*>(root->getTreeNode("FEMnode")->getObject("fem")) ;
+        ASSERT_NE(fem, nullptr) ;
+
+        VecCoord x = fem->_initialPoints.getValue() ;
+        VecDeriv dx(x.size()) ;
+        for (std::size_t i=0; i<x.size(); ++i)
+        {
+            DataTypes::set( dx[i], (Real)std::sin(1.3*i), (Real)std::cos(0.7*i), (Real)std::sin(0.1*i*i) ) ;
+            x[i] += dx[i] * (Real)0.2 ;
+        }
+
+        core::objectmodel::Data<VecCoord> dataX ; dataX.setValue(x) ;
+        core::objectmodel::Data<VecDeriv> dataV ; dataV.setValue(VecDeriv(x.size())) ;
+        core::objectmodel::Data<VecDeriv> dataDx ; dataDx.setValue(dx) ;
+        core::MechanicalParams mparams ;
+        mparams.setKFactor(1.7) ;
+
+        TaskScheduler* scheduler = TaskScheduler::getInstance() ;
+        scheduler->init(4) ;
+
+        core::objectmodel::Data<VecDeriv> scalarF, scalarDf, vectorizedF, vectorizedDf ;
+        fem->addForce(&mparams, scalarF, dataX, dataV) ;
+        fem->addDForce(&mparams, scalarDf, dataDx) ;
+
+        fem->d_vectorized.setValue(true) ;
+        fem->d_parallel.setValue(parallel) ;
+        fem->addForce(&mparams, vectorizedF, dataX, dataV) ;
+        fem->addDForce(&mparams, vectorizedDf, dataDx) ;
+
+        scheduler->stop() ;
+
+        // the compiler may contract the vectorized operations differently, hence the tolerance
+        ASSERT_EQ(scalarF.getValue().size(), vectorizedF.getValue().size()) ;
+        ASSERT_EQ(scalarDf.getValue().size(), vectorizedDf.getValue().size()) ;
+        for (std::size_t i=0; i<x.size(); ++i)
+        {
+            for (std::size_t j=0; j<3; ++j)
+            {
+                EXPECT_NEAR(scalarF.getValue()[i][j], vectorizedF.getValue()[i][j], 1e-8) ;
+                EXPECT_NEAR(scalarDf.getValue()[i][j], vectorizedDf.getValue()[i][j], 1e-8) ;
+            }
+        }
+    }
+
+    /// The system matrix assembled in parallel (parallel element stiffnesses, force fields assembled concurrently,
+    /// then merged in the visiting order with the projective constraints) must match the sequential one
+    void checkParallelAssemblyMatchSequential(const std::string& matrixType)
+    {
+        this->clearSceneGraph();
+
+        std::stringstream scene ;
+        scene << "<?xml version='1.0'?>"
+                 "<Node 	name='Root'>                                \n"
+                 "  <CGLinearSolver name='solver' template='" << matrixType << "' iterations='25' tolerance='1e-9' threshold='1e-9'/>\n" ;
+        for (int n=0; n<2; ++n)
+        {
+            scene << "  <Node name='FEMnode" << n << "'>                  \n"
+                     "    <RegularGridTopology n='5 4 3' min='" << 5*n << " 0 0' max='" << 5*n+4 << " 3 2'/>  \n"
+                     "    <MechanicalObject/>                               \n"
+                     "    <UniformMass totalMass='1'/>                      \n"
+                     "    <TetrahedronFEMForceField name='fem' youngModulus='5000' poissonRatio='0.3' "
+                     "                              method='large' parallelGrainSize='7'/>\n"
+                     "    <FixedConstraint indices='" << n << " 7'/>        \n"
+                     "  </Node>                                             \n" ;
+        }
+        scene << "</Node>                                               \n" ;
+
+        Node::SPtr root = SceneLoaderXML::loadFromMemory ("testscene",
+                                                          scene.str().c_str(),
+                                                          scene.str().size()) ;
+        root->init(ExecParams::defaultInstance()) ;
+
+        core::behavior::LinearSolver* solver = dynamic_cast<core::behavior::LinearSolver*>(root->getObject("solver")) ;
+        ASSERT_NE(solver, nullptr) ;
+
+        core::MechanicalParams mparams ;
+        mparams.setMFactor(1.0) ;
+        mparams.setKFactor(0.3) ;
+
+        TaskScheduler* scheduler = TaskScheduler::getInstance() ;
+        scheduler->init(4) ;
+
+        solver->setSystemMBKMatrix(&mparams) ;
+        const defaulttype::BaseMatrix* matrix = solver->getSystemBaseMatrix() ;
+        ASSERT_NE(matrix, nullptr) ;
+        ASSERT_EQ(matrix->rowSize(), 2*60*3) ;
+        std::vector<SReal> sequential ;
+        for (int i=0; i<matrix->rowSize(); ++i)
+            for (int j=0; j<matrix->colSize(); ++j)
+                sequential.push_back(matrix->element(i,j)) ;
+
+        solver->findData("parallelAssembly")->read("true") ;
+        for (int n=0; n<2; ++n)
+        {
+            std::stringstream node ; node << "FEMnode" << n ;
+            ForceType* fem = dynamic_cast<ForceType*>(root->getTreeNode(node.str())->getObject("fem")) ;
+            ASSERT_NE(fem, nullptr) ;
+            fem->d_parallel.setValue(true) ;
+        }
+        solver->setSystemMBKMatrix(&mparams) ;
+        matrix = solver->getSystemBaseMatrix() ;
+
+        scheduler->stop() ;
+
+        ASSERT_EQ((std::size_t)(matrix->rowSize()*matrix->colSize()), sequential.size()) ;
+        std::size_t k = 0 ;
+        for (int i=0; i<matrix->rowSize(); ++i)
+            for (int j=0; j<matrix->colSize(); ++j)
+                EXPECT_NEAR(sequential[k++], matrix->element(i,j), 1e-10) << "entry " << i << "," << j ;
+    }
 };
 
 // ========= Define the list of types to instanciate.
@@ -170,4 +372,25 @@ TYPED_TEST(TetrahedronFEMForceField_test, checkGracefullHandlingWhenTopologyIsMi
     this->checkGracefullHandlingWhenTopologyIsMissing();
 }
 
+TYPED_TEST(TetrahedronFEMForceField_test, checkParallelForcesMatchSequential)
+{
+    this->checkParallelForcesMatchSequential("small");
+    this->checkParallelForcesMatchSequential("large");
+    this->checkParallelForcesMatchSequential("polar");
+    this->checkParallelForcesMatchSequential("svd");
+}
+
+TYPED_TEST(TetrahedronFEMForceField_test, checkVectorizedForcesMatchScalar)
+{
+    this->checkVectorizedForcesMatchScalar(false);
+    this->checkVectorizedForcesMatchScalar(true);
+}
+
+TYPED_TEST(TetrahedronFEMForceField_test, checkParallelAssemblyMatchSequential)
+{
+    this->checkParallelAssemblyMatchSequential("CompressedRowSparseMatrix3d");
+    this->checkParallelAssemblyMatchSequential("CompressedRowSparseMatrixd");
+    this->checkParallelAssemblyMatchSequential("FullMatrix");
+}
+
 } // namespace sofa
@@ -31,6 +31,8 @@
 #include <sofa/core/behavior/BaseRotationFinder.h>
 #include <sofa/core/behavior/RotationMatrix.h>
 #include <sofa/helper/OptionsGroup.h>
+#include <sofa/helper/fixed_array.h>
+#include <sofa/simulation/Task.h>
 
 #include <sofa/helper/ColorMap.h>
 
@@ -134,6 +136,9 @@ protected:
     /// Symmetrical tensor written as a vector following the Voigt notation
     typedef defaulttype::VecNoInit<6,Real> VoigtTensor;
 
+    /// Forces applied by a tetrahedron on its 4 vertices
+    typedef helper::fixed_array<Deriv,4> ElementForce;
+
     /// @}
 
     /// Vector of material stiffness of each tetrahedron
@@ -230,6 +235,10 @@ public:
     Data<bool>  isToPrint;
     Data<bool>  _updateStiffness; ///< udpate structures (precomputed in init) using stiffness parameters in each iteration (set listening=1)
 
+    Data<bool> d_parallel; ///< compute addForce, addDForce and the element stiffnesses of addKToMatrix on the task scheduler (results are identical to the sequential computation)
+    Data<unsigned int> d_parallelGrainSize; ///< number of elements (or vertices) processed by each task in parallel mode
+    Data<bool> d_vectorized; ///< use a structure of arrays storage of the elements processed by blocks (large method only)
+
     SingleLink<TetrahedronFEMForceField<DataTypes>, sofa::core::topology::BaseMeshTopology, BaseLink::FLAG_STOREPATH|BaseLink::FLAG_STRONGLINK> l_topology;
 
     helper::vector<defaulttype::Vec<6,Real> > elemDisplacements;
@@ -294,11 +303,16 @@ protected:
     void computeForce( Displacement &F, const Displacement &Depl, VoigtTensor &plasticStrain, const MaterialStiffness &K, const StrainDisplacement &J );
     void computeForce( Displacement &F, const Displacement &Depl, const MaterialStiffness &K, const StrainDisplacement &J, SReal fact );
 
+    /// Add the per element forces to the vertices: f[a] += F[0], f[b] += F[1], ...
+    void addElementForce( Vector& f, const Element& index, const ElementForce& F );
+
 
     ////////////// small displacements method
     void initSmall(int i, Index&a, Index&b, Index&c, Index&d);
     void accumulateForceSmall( Vector& f, const Vector & p, typename VecElement::const_iterator elementIt, Index elementIndex );
+    void computeElementForceSmall( ElementForce& F, const Vector & p, typename VecElement::const_iterator elementIt, Index elementIndex );
     void applyStiffnessSmall( Vector& f, const Vector& x, int i=0, Index a=0,Index b=1,Index c=2,Index d=3, SReal fact=1.0  );
+    void computeElementDForceSmall( ElementForce& dF, const Vector& x, int i, Index a, Index b, Index c, Index d, SReal fact );
 
     ////////////// large displacements method
     helper::vector<helper::fixed_array<Coord,4> > _rotatedInitialElements;   ///< The initials positions in its frame
@@ -306,18 +320,91 @@ protected:
     void initLarge(int i, Index&a, Index&b, Index&c, Index&d);
     void computeRotationLarge( Transformation &r, const Vector &p, const Index &a, const Index &b, const Index &c);
     void accumulateForceLarge( Vector& f, const Vector & p, typename VecElement::const_iterator elementIt, Index elementIndex );
+    void computeElementForceLarge( ElementForce& F, const Vector & p, typename VecElement::const_iterator elementIt, Index elementIndex );
 
     ////////////// polar decomposition method
     helper::vector<unsigned int> _rotationIdx;
     void initPolar(int i, Index&a, Index&b, Index&c, Index&d);
     void accumulateForcePolar( Vector& f, const Vector & p, typename VecElement::const_iterator elementIt, Index elementIndex );
+    void computeElementForcePolar( ElementForce& F, const Vector & p, typename VecElement::const_iterator elementIt, Index elementIndex );
 
     ////////////// svd decomposition method
     helper::vector<Transformation>  _initialTransformation;
     void initSVD(int i, Index&a, Index&b, Index&c, Index&d);
     void accumulateForceSVD( Vector& f, const Vector & p, typename VecElement::const_iterator elementIt, Index elementIndex );
+    void computeElementForceSVD( ElementForce& F, const Vector & p, typename VecElement::const_iterator elementIt, Index elementIndex );
 
     void applyStiffnessCorotational( Vector& f, const Vector& x, int i=0, Index a=0,Index b=1,Index c=2,Index d=3, SReal fact=1.0  );
+    void computeElementDForceCorotational( ElementForce& dF, const Vector& x, int i, Index a, Index b, Index c, Index d, SReal fact );
+
+    ////////////// packed (structure of arrays) large displacements method
+    /// PackSize consecutive elements are stored as arrays of their coefficients, so that the
+    /// element computations are loops over the elements of a block that the compiler turns into
+    /// SIMD instructions (SSE, AVX, ... depending on the target architecture).
+    enum { PackSize = 8 };
+    struct PackedElementBlock
+    {
+        Index index[4][PackSize];      ///< vertices of the elements
+        Real J[12][3][PackSize];       ///< non-zero entries of each row of the strain-displacement matrix: columns (0,3,5), (1,3,4) or (2,4,5) depending on the row
+        Real K[12][PackSize];          ///< non-zero entries of the material stiffness: upper 3x3 block (row major) then diagonal of the lower block
+        Real R[9][PackSize];           ///< rotations, row major (same as the rotations vector)
+        Real initial[6][PackSize];     ///< non-zero coordinates of _rotatedInitialElements: [1][0], [2][0], [2][1], [3][0], [3][1], [3][2]
+    };
+    helper::vector<PackedElementBlock> m_packedElements;
+    bool m_packedRotationsUpToDate; ///< the rotations of m_packedElements have been computed by the last addForce
+    bool usePackedElements() const;
+    void packElements();
+    void computeElementForcesPacked( ElementForce* elementForces, const Vector& p, std::size_t blockIndex );
+    void computeElementDForcesPacked( ElementForce* elementDForces, const Vector& dx, std::size_t blockIndex, SReal fact );
+    void packedAddForce( Vector& f, const Vector& p );
+    void packedAddDForce( Vector& df, const Vector& dx, SReal kFactor );
+
+    ////////////// multithreaded addForce / addDForce
+    /// The element forces are computed in parallel into m_elementForces, then each vertex gathers
+    /// the contributions of its elements in increasing element order. The floating point operations
+    /// are thus performed in the same order as in the sequential loops, whatever the number of threads.
+    helper::vector<ElementForce> m_elementForces;
+    helper::vector<unsigned int> m_vertexCornersBegin; ///< for each vertex, first entry in m_vertexCorners (CSR storage)
+    helper::vector<unsigned int> m_vertexCorners;      ///< 4*elementIndex+corner of the elements around each vertex, sorted by element index
+    bool useParallelForces() const;
+    void computeVertexCorners(std::size_t nbVertices);
+    void parallelAddForce( Vector& f, const Vector& p );
+    void parallelAddDForce( Vector& df, const Vector& dx, SReal kFactor );
+    void gatherElementForces( Vector& f );
+
+    /// In parallel mode, addKToMatrix computes the element stiffness matrices in parallel by batches of elements,
+    /// and adds them to the matrix in the element order
+    helper::vector<StiffnessMatrix> m_elementStiffnesses;
+    std::size_t m_elementStiffnessesBegin; ///< index of the element of m_elementStiffnesses[0]
+    void computeElementStiffness( StiffnessMatrix& JKJt, StiffnessMatrix& tmp, std::size_t elementIndex, const Transformation& Rot );
+
+    class ElementForceTask : public simulation::CpuTask
+    {
+    public:
+        ElementForceTask( simulation::CpuTask::Status* status, TetrahedronFEMForceField<DataTypes>* ff, const Vector* x, SReal kFactor, bool dforce, bool packed, std::size_t first, std::size_t last );
+        MemoryAlloc run() final;
+    private:
+        void runPacked();
+        TetrahedronFEMForceField<DataTypes>* m_ff;
+        const Vector* m_x;
+        SReal m_kFactor;
+        bool m_dforce; ///< compute the force differential (addDForce) instead of the force (addForce)
+        bool m_packed; ///< use m_packedElements, first and last are then multiples of PackSize (or the number of elements)
+        std::size_t m_first;
+        std::size_t m_last;
+    };
+
+    class GatherForceTask : public simulation::CpuTask
+    {
+    public:
+        GatherForceTask( simulation::CpuTask::Status* status, TetrahedronFEMForceField<DataTypes>* ff, Vector* f, std::size_t first, std::size_t last );
+        MemoryAlloc run() final;
+    private:
+        TetrahedronFEMForceField<DataTypes>* m_ff;
+        Vector* m_f;
+        std::size_t m_first;
+        std::size_t m_last;
+    };
 
     void handleTopologyChange() override { needUpdateTopology = true; }
 
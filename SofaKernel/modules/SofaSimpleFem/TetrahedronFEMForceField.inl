@@ -33,6 +33,9 @@
 #include <SofaBaseLinearSolver/CompressedRowSparseMatrix.h>
 #include <sofa/simulation/AnimateBeginEvent.h>
 #include <sofa/simulation/AnimateEndEvent.h>
+#include <sofa/simulation/TaskScheduler.h>
+#include <sofa/simulation/ParallelFor.h>
+#include <algorithm>
 
 
 namespace sofa
@@ -74,6 +77,9 @@ TetrahedronFEMForceField<DataTypes>::TetrahedronFEMForceField()
     , _showVonMisesStressPerNode(initData(&_showVonMisesStressPerNode,false,"showVonMisesStressPerNode","draw points  showing vonMises stress interpolated in nodes"))
     , isToPrint( initData(&isToPrint, false, "isToPrint", "suppress somes data before using save as function"))
     , _updateStiffness(initData(&_updateStiffness,false,"updateStiffness","udpate structures (precomputed in init) using stiffness parameters in each iteration (set listening=1)"))
+    , d_parallel(initData(&d_parallel,false,"parallel","compute addForce and addDForce, and the element stiffness matrices of addKToMatrix, in parallel using the task scheduler. Results are identical to the sequential computation. Not used for addForce and addDForce when computeGlobalMatrix is true"))
+    , d_parallelGrainSize(initData(&d_parallelGrainSize,(unsigned int)256,"parallelGrainSize","number of elements (or vertices) processed by each task when parallel is true"))
+    , d_vectorized(initData(&d_vectorized,false,"vectorized","large method only: store the elements as packed arrays processed by blocks, allowing SIMD vectorization of the element computations. Not used with plasticity, updateStiffnessMatrix or computeGlobalMatrix"))
     , l_topology(initLink("topology", "link to the tetrahedron topology container"))
 {
     _poissonRatio.setRequired(true);
@@ -86,6 +92,8 @@ TetrahedronFEMForceField<DataTypes>::TetrahedronFEMForceField()
     this->addAlias(&_assembling, "assembling");
     minYoung = 0.0;
     maxYoung = 0.0;
+    m_packedRotationsUpToDate = false;
+    m_elementStiffnessesBegin = 0;
 }
 
 
@@ -593,8 +601,25 @@ void TetrahedronFEMForceField<DataTypes>::initSmall(int i, Index&a, Index&b, Ind
     computeStrainDisplacement( strainDisplacements[i], initialPoints[a], initialPoints[b], initialPoints[c], initialPoints[d] );
 }
 
+template<class DataTypes>
+inline void TetrahedronFEMForceField<DataTypes>::addElementForce( Vector& f, const Element& index, const ElementForce& F )
+{
+    f[index[0]] += F[0];
+    f[index[1]] += F[1];
+    f[index[2]] += F[2];
+    f[index[3]] += F[3];
+}
+
 template<class DataTypes>
 inline void TetrahedronFEMForceField<DataTypes>::accumulateForceSmall( Vector& f, const Vector & p, typename VecElement::const_iterator elementIt, Index elementIndex )
+{
+    ElementForce F;
+    computeElementForceSmall( F, p, elementIt, elementIndex );
+    addElementForce( f, *elementIt, F );
+}
+
+template<class DataTypes>
+inline void TetrahedronFEMForceField<DataTypes>::computeElementForceSmall( ElementForce& elementForce, const Vector & p, typename VecElement::const_iterator elementIt, Index elementIndex )
 {
     const VecCoord &initialPoints=_initialPoints.getValue();
     Element index = *elementIt;
@@ -677,14 +702,14 @@ inline void TetrahedronFEMForceField<DataTypes>::accumulateForceSmall( Vector& f
     else
     {
         msg_error() << "Support for assembling system matrix when using plasticity.";
+        elementForce.assign( Deriv() );
         return;
     }
 
-    f[a] += Deriv( F[0], F[1], F[2] );
-    f[b] += Deriv( F[3], F[4], F[5] );
-    f[c] += Deriv( F[6], F[7], F[8] );
-    f[d] += Deriv( F[9], F[10], F[11] );
-
+    elementForce[0] = Deriv( F[0], F[1], F[2] );
+    elementForce[1] = Deriv( F[3], F[4], F[5] );
+    elementForce[2] = Deriv( F[6], F[7], F[8] );
+    elementForce[3] = Deriv( F[9], F[10], F[11] );
 }
 
 // getPotentialEnergy only for small method and if assembling is false
@@ -788,6 +813,17 @@ inline SReal TetrahedronFEMForceField<DataTypes>::getPotentialEnergy(const core:
 
 template<class DataTypes>
 inline void TetrahedronFEMForceField<DataTypes>::applyStiffnessSmall( Vector& f, const Vector& x, int i, Index a, Index b, Index c, Index d, SReal fact )
+{
+    ElementForce dF;
+    computeElementDForceSmall( dF, x, i, a, b, c, d, fact );
+    f[a] += dF[0];
+    f[b] += dF[1];
+    f[c] += dF[2];
+    f[d] += dF[3];
+}
+
+template<class DataTypes>
+inline void TetrahedronFEMForceField<DataTypes>::computeElementDForceSmall( ElementForce& dF, const Vector& x, int i, Index a, Index b, Index c, Index d, SReal fact )
 {
     Displacement X;
 
@@ -810,10 +846,10 @@ inline void TetrahedronFEMForceField<DataTypes>::applyStiffnessSmall( Vector& f,
     Displacement F;
     computeForce( F, X, materialsStiffnesses[i], strainDisplacements[i], fact );
 
-    f[a] += Deriv( -F[0], -F[1],  -F[2] );
-    f[b] += Deriv( -F[3], -F[4],  -F[5] );
-    f[c] += Deriv( -F[6], -F[7],  -F[8] );
-    f[d] += Deriv( -F[9], -F[10], -F[11] );
+    dF[0] = Deriv( -F[0], -F[1],  -F[2] );
+    dF[1] = Deriv( -F[3], -F[4],  -F[5] );
+    dF[2] = Deriv( -F[6], -F[7],  -F[8] );
+    dF[3] = Deriv( -F[9], -F[10], -F[11] );
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -945,6 +981,15 @@ void TetrahedronFEMForceField<DataTypes>::initLarge(int i, Index&a, Index&b, Ind
 template<class DataTypes>
 inline void TetrahedronFEMForceField<DataTypes>::accumulateForceLarge( Vector& f, const Vector & p,
                                                                        typename VecElement::const_iterator elementIt, Index elementIndex )
+{
+    ElementForce F;
+    computeElementForceLarge( F, p, elementIt, elementIndex );
+    addElementForce( f, *elementIt, F );
+}
+
+template<class DataTypes>
+inline void TetrahedronFEMForceField<DataTypes>::computeElementForceLarge( ElementForce& elementForce, const Vector & p,
+                                                                           typename VecElement::const_iterator elementIt, Index elementIndex )
 {
     Element index = *elementIt;
 
@@ -1001,7 +1046,7 @@ inline void TetrahedronFEMForceField<DataTypes>::accumulateForceLarge( Vector& f
         // compute force on element
         computeForce( F, D, _plasticStrains[elementIndex], materialsStiffnesses[elementIndex], strainDisplacements[elementIndex] );
         for(int i=0; i<12; i+=3)
-            f[index[i/3]] += rotations[elementIndex] * Deriv( F[i], F[i+1],  F[i+2] );
+            elementForce[i/3] = rotations[elementIndex] * Deriv( F[i], F[i+1],  F[i+2] );
     }
     else if( _plasticMaxThreshold.getValue() <= 0 )
     {
@@ -1052,11 +1097,12 @@ inline void TetrahedronFEMForceField<DataTypes>::accumulateForceLarge( Vector& f
         F = RJKJt*D;
 
         for(int i=0; i<12; i+=3)
-            f[index[i/3]] += Deriv( F[i], F[i+1],  F[i+2] );
+            elementForce[i/3] = Deriv( F[i], F[i+1],  F[i+2] );
     }
     else
     {
         dmsg_error() << "Support for assembling system matrix when using plasticity." ;
+        elementForce.assign( Deriv() );
     }
 }
 
@@ -1099,6 +1145,14 @@ void TetrahedronFEMForceField<DataTypes>::initPolar(int i, Index& a, Index&b, In
 
 template<class DataTypes>
 inline void TetrahedronFEMForceField<DataTypes>::accumulateForcePolar( Vector& f, const Vector & p, typename VecElement::const_iterator elementIt, Index elementIndex )
+{
+    ElementForce F;
+    computeElementForcePolar( F, p, elementIt, elementIndex );
+    addElementForce( f, *elementIt, F );
+}
+
+template<class DataTypes>
+inline void TetrahedronFEMForceField<DataTypes>::computeElementForcePolar( ElementForce& elementForce, const Vector & p, typename VecElement::const_iterator elementIt, Index elementIndex )
 {
     Element index = *elementIt;
 
@@ -1145,11 +1199,12 @@ inline void TetrahedronFEMForceField<DataTypes>::accumulateForcePolar( Vector& f
     {
         computeForce( F, D, _plasticStrains[elementIndex], materialsStiffnesses[elementIndex], strainDisplacements[elementIndex] );
         for(int i=0; i<12; i+=3)
-            f[index[i/3]] += rotations[elementIndex] * Deriv( F[i], F[i+1],  F[i+2] );
+            elementForce[i/3] = rotations[elementIndex] * Deriv( F[i], F[i+1],  F[i+2] );
     }
     else
     {
         dmsg_error() << "Support for assembling system matrix when using polar method.";
+        elementForce.assign( Deriv() );
     }
 }
 
@@ -1194,10 +1249,19 @@ void TetrahedronFEMForceField<DataTypes>::initSVD( int i, Index& a, Index&b, Ind
 
 template<class DataTypes>
 inline void TetrahedronFEMForceField<DataTypes>::accumulateForceSVD( Vector& f, const Vector & p, typename VecElement::const_iterator elementIt, Index elementIndex )
+{
+    ElementForce F;
+    computeElementForceSVD( F, p, elementIt, elementIndex );
+    addElementForce( f, *elementIt, F );
+}
+
+template<class DataTypes>
+inline void TetrahedronFEMForceField<DataTypes>::computeElementForceSVD( ElementForce& elementForce, const Vector & p, typename VecElement::const_iterator elementIt, Index elementIndex )
 {
     if( _assembling.getValue() )
     {
         dmsg_error() << "Support for assembling system matrix when using SVD method.";
+        elementForce.assign( Deriv() );
         return;
     }
 
@@ -1253,7 +1317,7 @@ inline void TetrahedronFEMForceField<DataTypes>::accumulateForceSVD( Vector& f,
     computeForce( Forces, D, _plasticStrains[elementIndex], materialsStiffnesses[elementIndex], strainDisplacements[elementIndex] );
     for( int i=0 ; i<12 ; i+=3 )
     {
-        f[index[i/3]] += rotations[elementIndex] * Deriv( Forces[i], Forces[i+1],  Forces[i+2] );
+        elementForce[i/3] = rotations[elementIndex] * Deriv( Forces[i], Forces[i+1],  Forces[i+2] );
     }
 }
 
@@ -1265,6 +1329,17 @@ inline void TetrahedronFEMForceField<DataTypes>::accumulateForceSVD( Vector& f,
 
 template<class DataTypes>
 inline void TetrahedronFEMForceField<DataTypes>::applyStiffnessCorotational( Vector& f, const Vector& x, int i, Index a, Index b, Index c, Index d, SReal fact )
+{
+    ElementForce dF;
+    computeElementDForceCorotational( dF, x, i, a, b, c, d, fact );
+    f[a] += dF[0];
+    f[b] += dF[1];
+    f[c] += dF[2];
+    f[d] += dF[3];
+}
+
+template<class DataTypes>
+inline void TetrahedronFEMForceField<DataTypes>::computeElementDForceCorotational( ElementForce& dF, const Vector& x, int i, Index a, Index b, Index c, Index d, SReal fact )
 {
     Displacement X;
 
@@ -1295,21 +1370,21 @@ inline void TetrahedronFEMForceField<DataTypes>::applyStiffnessCorotational( Vec
 
 
     // rotate by rotations[i]
-    f[a][0] -= rotations[i][0][0] *  F[0] +  rotations[i][0][1] * F[1]  + rotations[i][0][2] * F[2];
-    f[a][1] -= rotations[i][1][0] *  F[0] +  rotations[i][1][1] * F[1]  + rotations[i][1][2] * F[2];
-    f[a][2] -= rotations[i][2][0] *  F[0] +  rotations[i][2][1] * F[1]  + rotations[i][2][2] * F[2];
+    dF[0][0] = -( rotations[i][0][0] *  F[0] +  rotations[i][0][1] * F[1]  + rotations[i][0][2] * F[2] );
+    dF[0][1] = -( rotations[i][1][0] *  F[0] +  rotations[i][1][1] * F[1]  + rotations[i][1][2] * F[2] );
+    dF[0][2] = -( rotations[i][2][0] *  F[0] +  rotations[i][2][1] * F[1]  + rotations[i][2][2] * F[2] );
 
-    f[b][0] -= rotations[i][0][0] *  F[3] +  rotations[i][0][1] * F[4]  + rotations[i][0][2] * F[5];
-    f[b][1] -= rotations[i][1][0] *  F[3] +  rotations[i][1][1] * F[4]  + rotations[i][1][2] * F[5];
-    f[b][2] -= rotations[i][2][0] *  F[3] +  rotations[i][2][1] * F[4]  + rotations[i][2][2] * F[5];
+    dF[1][0] = -( rotations[i][0][0] *  F[3] +  rotations[i][0][1] * F[4]  + rotations[i][0][2] * F[5] );
+    dF[1][1] = -( rotations[i][1][0] *  F[3] +  rotations[i][1][1] * F[4]  + rotations[i][1][2] * F[5] );
+    dF[1][2] = -( rotations[i][2][0] *  F[3] +  rotations[i][2][1] * F[4]  + rotations[i][2][2] * F[5] );
 
-    f[c][0] -= rotations[i][0][0] *  F[6] +  rotations[i][0][1] * F[7]  + rotations[i][0][2] * F[8];
-    f[c][1] -= rotations[i][1][0] *  F[6] +  rotations[i][1][1] * F[7]  + rotations[i][1][2] * F[8];
-    f[c][2] -= rotations[i][2][0] *  F[6] +  rotations[i][2][1] * F[7]  + rotations[i][2][2] * F[8];
+    dF[2][0] = -( rotations[i][0][0] *  F[6] +  rotations[i][0][1] * F[7]  + rotations[i][0][2] * F[8] );
+    dF[2][1] = -( rotations[i][1][0] *  F[6] +  rotations[i][1][1] * F[7]  + rotations[i][1][2] * F[8] );
+    dF[2][2] = -( rotations[i][2][0] *  F[6] +  rotations[i][2][1] * F[7]  + rotations[i][2][2] * F[8] );
 
-    f[d][0] -= rotations[i][0][0] *  F[9] +  rotations[i][0][1] * F[10] + rotations[i][0][2] * F[11];
-    f[d][1]	-= rotations[i][1][0] *  F[9] +  rotations[i][1][1] * F[10] + rotations[i][1][2] * F[11];
-    f[d][2]	-= rotations[i][2][0] *  F[9] +  rotations[i][2][1] * F[10] + rotations[i][2][2] * F[11];
+    dF[3][0] = -( rotations[i][0][0] *  F[9] +  rotations[i][0][1] * F[10] + rotations[i][0][2] * F[11] );
+    dF[3][1] = -( rotations[i][1][0] *  F[9] +  rotations[i][1][1] * F[10] + rotations[i][1][2] * F[11] );
+    dF[3][2] = -( rotations[i][2][0] *  F[9] +  rotations[i][2][1] * F[10] + rotations[i][2][2] * F[11] );
 
 }
 
@@ -1485,6 +1560,12 @@ inline void TetrahedronFEMForceField<DataTypes>::reinit()
     strainDisplacements.resize( _indexedElements->size() );
     materialsStiffnesses.resize(_indexedElements->size() );
     _plasticStrains.resize(     _indexedElements->size() );
+
+    // the vertex to element adjacency used in parallel mode and the packed elements are rebuilt at the next addForce
+    m_vertexCornersBegin.clear();
+    m_vertexCorners.clear();
+    m_packedElements.clear();
+    m_packedRotationsUpToDate = false;
     if(_assembling.getValue())
     {
         _stiffnesses.resize( _initialPoints.getValue().size()*3 );
@@ -1621,6 +1702,19 @@ inline void TetrahedronFEMForceField<DataTypes>::addForce (const core::Mechanica
         needUpdateTopology = false;
     }
 
+    const bool packed = usePackedElements();
+    if (packed && m_packedElements.size() != (_indexedElements->size() + PackSize - 1) / PackSize)
+        packElements();
+    m_packedRotationsUpToDate = packed;
+
+    if (useParallelForces())
+    {
+        parallelAddForce( f, p );
+        d_f.endEdit();
+        updateVonMisesStress = true;
+        return;
+    }
+
     unsigned int i;
     typename VecElement::const_iterator it;
     switch(method)
@@ -1635,6 +1729,11 @@ inline void TetrahedronFEMForceField<DataTypes>::addForce (const core::Mechanica
     }
     case LARGE :
     {
+        if (packed)
+        {
+            packedAddForce( f, p );
+            break;
+        }
         for(it=_indexedElements->begin(), i = 0 ; it!=_indexedElements->end(); ++it,++i)
         {
 
@@ -1672,6 +1771,14 @@ inline void TetrahedronFEMForceField<DataTypes>::addDForce(const core::Mechanica
     Real kFactor = (Real)mparams->kFactorIncludingRayleighDamping(this->rayleighStiffness.getValue());
 
     df.resize(dx.size());
+
+    if (useParallelForces())
+    {
+        parallelAddDForce( df, dx, kFactor );
+        d_df.endEdit();
+        return;
+    }
+
     unsigned int i;
     typename VecElement::const_iterator it;
 
@@ -1687,6 +1794,10 @@ inline void TetrahedronFEMForceField<DataTypes>::addDForce(const core::Mechanica
             applyStiffnessSmall( df,dx, i, a,b,c,d, kFactor );
         }
     }
+    else if( usePackedElements() && m_packedRotationsUpToDate )
+    {
+        packedAddDForce( df, dx, kFactor );
+    }
     else
     {
         for(it = _indexedElements->begin(), i = 0 ; it != _indexedElements->end() ; ++it, ++i)
@@ -1703,6 +1814,507 @@ inline void TetrahedronFEMForceField<DataTypes>::addDForce(const core::Mechanica
     d_df.endEdit();
 }
 
+//////////////////////////////////////////////////////////////////////
+//////////  packed (structure of arrays) large displacements  ////////
+//////////////////////////////////////////////////////////////////////
+
+template<class DataTypes>
+bool TetrahedronFEMForceField<DataTypes>::usePackedElements() const
+{
+    // the packed kernels assume constant strain-displacement matrices and no plasticity
+    return d_vectorized.getValue() && method == LARGE && !_assembling.getValue()
+            && !_updateStiffnessMatrix.getValue() && _plasticMaxThreshold.getValue() <= 0;
+}
+
+template<class DataTypes>
+void TetrahedronFEMForceField<DataTypes>::packElements()
+{
+    const VecElement& elements = *_indexedElements;
+    const std::size_t nbElements = elements.size();
+    m_packedElements.resize((nbElements + PackSize - 1) / PackSize);
+
+    for (std::size_t b = 0; b < m_packedElements.size(); ++b)
+    {
+        PackedElementBlock& block = m_packedElements[b];
+        for (std::size_t l = 0; l < PackSize; ++l)
+        {
+            // the last block is completed with copies of the last element, whose results are discarded
+            const std::size_t e = std::min(b * PackSize + l, nbElements - 1);
+            const StrainDisplacement& J = strainDisplacements[e];
+            const MaterialStiffness& K = materialsStiffnesses[e];
+
+            for (int k = 0; k < 4; ++k)
+                block.index[k][l] = elements[e][k];
+
+            for (int r = 0; r < 12; r += 3)
+            {
+                block.J[r  ][0][l] = J[r  ][0]; block.J[r  ][1][l] = J[r  ][3]; block.J[r  ][2][l] = J[r  ][5];
+                block.J[r+1][0][l] = J[r+1][1]; block.J[r+1][1][l] = J[r+1][3]; block.J[r+1][2][l] = J[r+1][4];
+                block.J[r+2][0][l] = J[r+2][2]; block.J[r+2][1][l] = J[r+2][4]; block.J[r+2][2][l] = J[r+2][5];
+            }
+
+            for (int r = 0; r < 3; ++r)
+                for (int c = 0; c < 3; ++c)
+                    block.K[r*3+c][l] = K[r][c];
+            block.K[ 9][l] = K[3][3];
+            block.K[10][l] = K[4][4];
+            block.K[11][l] = K[5][5];
+
+            for (int r = 0; r < 3; ++r)
+                for (int c = 0; c < 3; ++c)
+                    block.R[r*3+c][l] = rotations[e][r][c];
+
+            block.initial[0][l] = _rotatedInitialElements[e][1][0];
+            block.initial[1][l] = _rotatedInitialElements[e][2][0];
+            block.initial[2][l] = _rotatedInitialElements[e][2][1];
+            block.initial[3][l] = _rotatedInitialElements[e][3][0];
+            block.initial[4][l] = _rotatedInitialElements[e][3][1];
+            block.initial[5][l] = _rotatedInitialElements[e][3][2];
+        }
+    }
+    m_packedRotationsUpToDate = true;
+}
+
+/// Same computations as accumulateForceLarge and computeForce, for all the elements of a block
+template<class DataTypes>
+void TetrahedronFEMForceField<DataTypes>::computeElementForcesPacked( ElementForce* elementForces, const Vector& p, std::size_t blockIndex )
+{
+    enum { W = PackSize };
+    PackedElementBlock& block = m_packedElements[blockIndex];
+    const Real epsilon = std::numeric_limits<Real>::epsilon();
+
+    Real x[4][3][W];
+    for (int k = 0; k < 4; ++k)
+        for (int l = 0; l < W; ++l)
+        {
+            const Coord& pk = p[block.index[k][l]];
+            x[k][0][l] = pk[0];
+            x[k][1][l] = pk[1];
+            x[k][2][l] = pk[2];
+        }
+
+    // rotation, see computeRotationLarge: the rows of R_0_2 are the normalized edges ex, ey and ez
+    Real ex[3][W], ey[3][W], ez[3][W], norm[W];
+    for (int l = 0; l < W; ++l)
+        for (int i = 0; i < 3; ++i)
+        {
+            ex[i][l] = x[1][i][l] - x[0][i][l];
+            ey[i][l] = x[2][i][l] - x[0][i][l];
+        }
+
+    for (int l = 0; l < W; ++l)
+        norm[l] = helper::rsqrt( ex[0][l]*ex[0][l] + ex[1][l]*ex[1][l] + ex[2][l]*ex[2][l] );
+    for (int l = 0; l < W; ++l)
+        if (norm[l] > epsilon) { ex[0][l] /= norm[l]; ex[1][l] /= norm[l]; ex[2][l] /= norm[l]; }
+
+    for (int l = 0; l < W; ++l)
+        norm[l] = helper::rsqrt( ey[0][l]*ey[0][l] + ey[1][l]*ey[1][l] + ey[2][l]*ey[2][l] );
+    for (int l = 0; l < W; ++l)
+        if (norm[l] > epsilon) { ey[0][l] /= norm[l]; ey[1][l] /= norm[l]; ey[2][l] /= norm[l]; }
+
+    for (int l = 0; l < W; ++l)
+    {
+        ez[0][l] = ex[1][l]*ey[2][l] - ex[2][l]*ey[1][l];
+        ez[1][l] = ex[2][l]*ey[0][l] - ex[0][l]*ey[2][l];
+        ez[2][l] = ex[0][l]*ey[1][l] - ex[1][l]*ey[0][l];
+    }
+    for (int l = 0; l < W; ++l)
+        norm[l] = helper::rsqrt( ez[0][l]*ez[0][l] + ez[1][l]*ez[1][l] + ez[2][l]*ez[2][l] );
+    for (int l = 0; l < W; ++l)
+        if (norm[l] > epsilon) { ez[0][l] /= norm[l]; ez[1][l] /= norm[l]; ez[2][l] /= norm[l]; }
+
+    for (int l = 0; l < W; ++l)
+    {
+        ey[0][l] = ez[1][l]*ex[2][l] - ez[2][l]*ex[1][l];
+        ey[1][l] = ez[2][l]*ex[0][l] - ez[0][l]*ex[2][l];
+        ey[2][l] = ez[0][l]*ex[1][l] - ez[1][l]*ex[0][l];
+    }
+    for (int l = 0; l < W; ++l)
+        norm[l] = helper::rsqrt( ey[0][l]*ey[0][l] + ey[1][l]*ey[1][l] + ey[2][l]*ey[2][l] );
+    for (int l = 0; l < W; ++l)
+        if (norm[l] > epsilon) { ey[0][l] /= norm[l]; ey[1][l] /= norm[l]; ey[2][l] /= norm[l]; }
+
+    // rotations = transposed(R_0_2)
+    for (int i = 0; i < 3; ++i)
+        for (int l = 0; l < W; ++l)
+        {
+            block.R[i*3+0][l] = ex[i][l];
+            block.R[i*3+1][l] = ey[i][l];
+            block.R[i*3+2][l] = ez[i][l];
+        }
+
+    // positions of the deformed and displaced tetrahedron in its frame
+    Real deforme[4][3][W];
+    for (int k = 0; k < 4; ++k)
+        for (int l = 0; l < W; ++l)
+        {
+            deforme[k][0][l] = ex[0][l]*x[k][0][l] + ex[1][l]*x[k][1][l] + ex[2][l]*x[k][2][l];
+            deforme[k][1][l] = ey[0][l]*x[k][0][l] + ey[1][l]*x[k][1][l] + ey[2][l]*x[k][2][l];
+            deforme[k][2][l] = ez[0][l]*x[k][0][l] + ez[1][l]*x[k][1][l] + ez[2][l]*x[k][2][l];
+        }
+
+    // non-zero displacements D[3], D[6], D[7], D[9], D[10], D[11], and forces
+    Real F[12][W];
+    for (int l = 0; l < W; ++l)
+    {
+        const Real D3  = block.initial[0][l] - ( deforme[1][0][l] - deforme[0][0][l] );
+        const Real D6  = block.initial[1][l] - ( deforme[2][0][l] - deforme[0][0][l] );
+        const Real D7  = block.initial[2][l] - ( deforme[2][1][l] - deforme[0][1][l] );
+        const Real D9  = block.initial[3][l] - ( deforme[3][0][l] - deforme[0][0][l] );
+        const Real D10 = block.initial[4][l] - ( deforme[3][1][l] - deforme[0][1][l] );
+        const Real D11 = block.initial[5][l] - ( deforme[3][2][l] - deforme[0][2][l] );
+
+        const Real JtD0 = block.J[3][0][l]*D3 + block.J[6][0][l]*D6 + block.J[9][0][l]*D9;
+        const Real JtD1 = block.J[7][0][l]*D7 + block.J[10][0][l]*D10;
+        const Real JtD2 = block.J[11][0][l]*D11;
+        const Real JtD3 = block.J[3][1][l]*D3 + block.J[6][1][l]*D6 + block.J[7][1][l]*D7 + block.J[9][1][l]*D9 + block.J[10][1][l]*D10;
+        const Real JtD4 = block.J[7][2][l]*D7 + block.J[10][2][l]*D10 + block.J[11][1][l]*D11;
+        const Real JtD5 = block.J[3][2][l]*D3 + block.J[6][2][l]*D6 + block.J[9][2][l]*D9 + block.J[11][2][l]*D11;
+
+        const Real KJtD0 = block.K[0][l]*JtD0 + block.K[1][l]*JtD1 + block.K[2][l]*JtD2;
+        const Real KJtD1 = block.K[3][l]*JtD0 + block.K[4][l]*JtD1 + block.K[5][l]*JtD2;
+        const Real KJtD2 = block.K[6][l]*JtD0 + block.K[7][l]*JtD1 + block.K[8][l]*JtD2;
+        const Real KJtD3 = block.K[ 9][l]*JtD3;
+        const Real KJtD4 = block.K[10][l]*JtD4;
+        const Real KJtD5 = block.K[11][l]*JtD5;
+
+        for (int r = 0; r < 12; r += 3)
+        {
+            F[r  ][l] = block.J[r  ][0][l]*KJtD0 + block.J[r  ][1][l]*KJtD3 + block.J[r  ][2][l]*KJtD5;
+            F[r+1][l] = block.J[r+1][0][l]*KJtD1 + block.J[r+1][1][l]*KJtD3 + block.J[r+1][2][l]*KJtD4;
+            F[r+2][l] = block.J[r+2][0][l]*KJtD2 + block.J[r+2][1][l]*KJtD4 + block.J[r+2][2][l]*KJtD5;
+        }
+    }
+
+    // back to the world frame: rotations * F
+    for (int l = 0; l < W; ++l)
+        for (int k = 0; k < 4; ++k)
+            for (int i = 0; i < 3; ++i)
+                elementForces[l][k][i] = block.R[i*3+0][l]*F[3*k][l] + block.R[i*3+1][l]*F[3*k+1][l] + block.R[i*3+2][l]*F[3*k+2][l];
+
+    // keep the rotations vector up to date for getRotation, von Mises stress and assembly
+    const std::size_t first = blockIndex * PackSize;
+    const std::size_t count = std::min<std::size_t>(PackSize, _indexedElements->size() - first);
+    for (std::size_t l = 0; l < count; ++l)
+        for (int i = 0; i < 3; ++i)
+            for (int j = 0; j < 3; ++j)
+                rotations[first + l][i][j] = block.R[i*3+j][l];
+}
+
+/// Same computations as applyStiffnessCorotational, for all the elements of a block
+template<class DataTypes>
+void TetrahedronFEMForceField<DataTypes>::computeElementDForcesPacked( ElementForce* elementDForces, const Vector& dx, std::size_t blockIndex, SReal fact )
+{
+    enum { W = PackSize };
+    const PackedElementBlock& block = m_packedElements[blockIndex];
+
+    // rotate by rotations transposed
+    Real X[12][W];
+    for (int k = 0; k < 4; ++k)
+        for (int l = 0; l < W; ++l)
+        {
+            const Deriv& dxk = dx[block.index[k][l]];
+            for (int i = 0; i < 3; ++i)
+                X[3*k+i][l] = block.R[0*3+i][l]*dxk[0] + block.R[1*3+i][l]*dxk[1] + block.R[2*3+i][l]*dxk[2];
+        }
+
+    Real F[12][W];
+    for (int l = 0; l < W; ++l)
+    {
+        const Real JtD0 = block.J[0][0][l]*X[0][l] + block.J[3][0][l]*X[3][l] + block.J[6][0][l]*X[6][l] + block.J[9][0][l]*X[9][l];
+        const Real JtD1 = block.J[1][0][l]*X[1][l] + block.J[4][0][l]*X[4][l] + block.J[7][0][l]*X[7][l] + block.J[10][0][l]*X[10][l];
+        const Real JtD2 = block.J[2][0][l]*X[2][l] + block.J[5][0][l]*X[5][l] + block.J[8][0][l]*X[8][l] + block.J[11][0][l]*X[11][l];
+        const Real JtD3 = block.J[0][1][l]*X[0][l] + block.J[1][1][l]*X[1][l] + block.J[3][1][l]*X[3][l] + block.J[4][1][l]*X[4][l]
+                        + block.J[6][1][l]*X[6][l] + block.J[7][1][l]*X[7][l] + block.J[9][1][l]*X[9][l] + block.J[10][1][l]*X[10][l];
+        const Real JtD4 = block.J[1][2][l]*X[1][l] + block.J[2][1][l]*X[2][l] + block.J[4][2][l]*X[4][l] + block.J[5][1][l]*X[5][l]
+                        + block.J[7][2][l]*X[7][l] + block.J[8][1][l]*X[8][l] + block.J[10][2][l]*X[10][l] + block.J[11][1][l]*X[11][l];
+        const Real JtD5 = block.J[0][2][l]*X[0][l] + block.J[2][2][l]*X[2][l] + block.J[3][2][l]*X[3][l] + block.J[5][2][l]*X[5][l]
+                        + block.J[6][2][l]*X[6][l] + block.J[8][2][l]*X[8][l] + block.J[9][2][l]*X[9][l] + block.J[11][2][l]*X[11][l];
+
+        Real KJtD0 = block.K[0][l]*JtD0 + block.K[1][l]*JtD1 + block.K[2][l]*JtD2;
+        Real KJtD1 = block.K[3][l]*JtD0 + block.K[4][l]*JtD1 + block.K[5][l]*JtD2;
+        Real KJtD2 = block.K[6][l]*JtD0 + block.K[7][l]*JtD1 + block.K[8][l]*JtD2;
+        Real KJtD3 = block.K[ 9][l]*JtD3;
+        Real KJtD4 = block.K[10][l]*JtD4;
+        Real KJtD5 = block.K[11][l]*JtD5;
+        KJtD0 *= fact; KJtD1 *= fact; KJtD2 *= fact;
+        KJtD3 *= fact; KJtD4 *= fact; KJtD5 *= fact;
+
+        for (int r = 0; r < 12; r += 3)
+        {
+            F[r  ][l] = block.J[r  ][0][l]*KJtD0 + block.J[r  ][1][l]*KJtD3 + block.J[r  ][2][l]*KJtD5;
+            F[r+1][l] = block.J[r+1][0][l]*KJtD1 + block.J[r+1][1][l]*KJtD3 + block.J[r+1][2][l]*KJtD4;
+            F[r+2][l] = block.J[r+2][0][l]*KJtD2 + block.J[r+2][1][l]*KJtD4 + block.J[r+2][2][l]*KJtD5;
+        }
+    }
+
+    // rotate by rotations
+    for (int l = 0; l < W; ++l)
+        for (int k = 0; k < 4; ++k)
+            for (int i = 0; i < 3; ++i)
+                elementDForces[l][k][i] = -( block.R[i*3+0][l]*F[3*k][l] + block.R[i*3+1][l]*F[3*k+1][l] + block.R[i*3+2][l]*F[3*k+2][l] );
+}
+
+template<class DataTypes>
+void TetrahedronFEMForceField<DataTypes>::packedAddForce( Vector& f, const Vector& p )
+{
+    const VecElement& elements = *_indexedElements;
+    ElementForce blockForces[PackSize];
+    for (std::size_t b = 0; b < m_packedElements.size(); ++b)
+    {
+        computeElementForcesPacked( blockForces, p, b );
+
+        const std::size_t count = std::min<std::size_t>(PackSize, elements.size() - b * PackSize);
+        for (std::size_t l = 0; l < count; ++l)
+            addElementForce( f, elements[b * PackSize + l], blockForces[l] );
+    }
+}
+
+template<class DataTypes>
+void TetrahedronFEMForceField<DataTypes>::packedAddDForce( Vector& df, const Vector& dx, SReal kFactor )
+{
+    const VecElement& elements = *_indexedElements;
+    ElementForce blockDForces[PackSize];
+    for (std::size_t b = 0; b < m_packedElements.size(); ++b)
+    {
+        computeElementDForcesPacked( blockDForces, dx, b, kFactor );
+
+        const std::size_t count = std::min<std::size_t>(PackSize, elements.size() - b * PackSize);
+        for (std::size_t l = 0; l < count; ++l)
+            addElementForce( df, elements[b * PackSize + l], blockDForces[l] );
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+////////////////  multithreaded addForce / addDForce  ////////////////
+//////////////////////////////////////////////////////////////////////
+
+template<class DataTypes>
+bool TetrahedronFEMForceField<DataTypes>::useParallelForces() const
+{
+    // the assembled stiffness (_stiffnesses) is filled sequentially
+    return d_parallel.getValue() && !_assembling.getValue();
+}
+
+template<class DataTypes>
+void TetrahedronFEMForceField<DataTypes>::computeElementStiffness( StiffnessMatrix& JKJt, StiffnessMatrix& tmp, std::size_t elementIndex, const Transformation& Rot )
+{
+    if (!d_parallel.getValue())
+    {
+        if (method == SMALL) computeStiffnessMatrix(JKJt,tmp,materialsStiffnesses[elementIndex], strainDisplacements[elementIndex],Rot);
+        else computeStiffnessMatrix(JKJt,tmp,materialsStiffnesses[elementIndex], strainDisplacements[elementIndex],rotations[elementIndex]);
+        return;
+    }
+
+    // the next batch of elements is computed in parallel when the element is not in the current one
+    if (elementIndex < m_elementStiffnessesBegin || elementIndex >= m_elementStiffnessesBegin + m_elementStiffnesses.size())
+    {
+        simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+        const std::size_t grainSize = std::max(d_parallelGrainSize.getValue(), 1u);
+        const std::size_t batchSize = 4 * grainSize * std::max(scheduler->getThreadCount(), 1u);
+        m_elementStiffnessesBegin = elementIndex;
+        m_elementStiffnesses.resize(std::min(batchSize, _indexedElements->size() - elementIndex));
+        simulation::parallelFor(scheduler, 0, m_elementStiffnesses.size(), grainSize, [&](std::size_t first, std::size_t last)
+        {
+            StiffnessMatrix S;
+            for (std::size_t i = first; i < last; ++i)
+            {
+                const std::size_t e = m_elementStiffnessesBegin + i;
+                if (method == SMALL) computeStiffnessMatrix(S,m_elementStiffnesses[i],materialsStiffnesses[e], strainDisplacements[e],Rot);
+                else computeStiffnessMatrix(S,m_elementStiffnesses[i],materialsStiffnesses[e], strainDisplacements[e],rotations[e]);
+            }
+        });
+    }
+    tmp = m_elementStiffnesses[elementIndex - m_elementStiffnessesBegin];
+}
+
+template<class DataTypes>
+void TetrahedronFEMForceField<DataTypes>::computeVertexCorners(std::size_t nbVertices)
+{
+    const VecElement& elements = *_indexedElements;
+
+    m_vertexCornersBegin.assign(nbVertices+1, 0);
+    for (std::size_t e = 0; e < elements.size(); ++e)
+        for (unsigned int k = 0; k < 4; ++k)
+            ++m_vertexCornersBegin[elements[e][k]+1];
+
+    for (std::size_t v = 0; v < nbVertices; ++v)
+        m_vertexCornersBegin[v+1] += m_vertexCornersBegin[v];
+
+    // elements are visited in increasing order, so the entries of each vertex are sorted
+    m_vertexCorners.resize(4*elements.size());
+    helper::vector<unsigned int> next(m_vertexCornersBegin.begin(), m_vertexCornersBegin.end()-1);
+    for (std::size_t e = 0; e < elements.size(); ++e)
+        for (unsigned int k = 0; k < 4; ++k)
+            m_vertexCorners[next[elements[e][k]]++] = (unsigned int)(4*e+k);
+}
+
+template<class DataTypes>
+void TetrahedronFEMForceField<DataTypes>::parallelAddForce( Vector& f, const Vector& p )
+{
+    const std::size_t nbElements = _indexedElements->size();
+    const bool packed = usePackedElements();
+    std::size_t grainSize = std::max(d_parallelGrainSize.getValue(), 1u);
+    if (packed)
+        grainSize = (grainSize + PackSize - 1) / PackSize * PackSize;
+    m_elementForces.resize(nbElements);
+
+    simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+    simulation::CpuTask::Status status;
+
+    std::vector<ElementForceTask> tasks;
+    tasks.reserve((nbElements + grainSize - 1) / grainSize);
+    for (std::size_t first = 0; first < nbElements; first += grainSize)
+        tasks.emplace_back(&status, this, &p, 0, false, packed, first, std::min(first + grainSize, nbElements));
+
+    for (ElementForceTask& task : tasks)
+        scheduler->addTask(&task);
+    scheduler->workUntilDone(&status);
+
+    gatherElementForces(f);
+}
+
+template<class DataTypes>
+void TetrahedronFEMForceField<DataTypes>::parallelAddDForce( Vector& df, const Vector& dx, SReal kFactor )
+{
+    const std::size_t nbElements = _indexedElements->size();
+    const bool packed = usePackedElements() && m_packedRotationsUpToDate;
+    std::size_t grainSize = std::max(d_parallelGrainSize.getValue(), 1u);
+    if (packed)
+        grainSize = (grainSize + PackSize - 1) / PackSize * PackSize;
+    m_elementForces.resize(nbElements);
+
+    simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+    simulation::CpuTask::Status status;
+
+    std::vector<ElementForceTask> tasks;
+    tasks.reserve((nbElements + grainSize - 1) / grainSize);
+    for (std::size_t first = 0; first < nbElements; first += grainSize)
+        tasks.emplace_back(&status, this, &dx, kFactor, true, packed, first, std::min(first + grainSize, nbElements));
+
+    for (ElementForceTask& task : tasks)
+        scheduler->addTask(&task);
+    scheduler->workUntilDone(&status);
+
+    gatherElementForces(df);
+}
+
+template<class DataTypes>
+void TetrahedronFEMForceField<DataTypes>::gatherElementForces( Vector& f )
+{
+    const std::size_t nbVertices = f.size();
+    const std::size_t grainSize = std::max(d_parallelGrainSize.getValue(), 1u);
+
+    if (m_vertexCornersBegin.size() != nbVertices+1 || m_vertexCorners.size() != 4*_indexedElements->size())
+        computeVertexCorners(nbVertices);
+
+    simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+    simulation::CpuTask::Status status;
+
+    std::vector<GatherForceTask> tasks;
+    tasks.reserve((nbVertices + grainSize - 1) / grainSize);
+    for (std::size_t first = 0; first < nbVertices; first += grainSize)
+        tasks.emplace_back(&status, this, &f, first, std::min(first + grainSize, nbVertices));
+
+    for (GatherForceTask& task : tasks)
+        scheduler->addTask(&task);
+    scheduler->workUntilDone(&status);
+}
+
+template<class DataTypes>
+TetrahedronFEMForceField<DataTypes>::ElementForceTask::ElementForceTask( simulation::CpuTask::Status* status, TetrahedronFEMForceField<DataTypes>* ff, const Vector* x, SReal kFactor, bool dforce, bool packed, std::size_t first, std::size_t last )
+    : CpuTask(status)
+    , m_ff(ff)
+    , m_x(x)
+    , m_kFactor(kFactor)
+    , m_dforce(dforce)
+    , m_packed(packed)
+    , m_first(first)
+    , m_last(last)
+{
+}
+
+template<class DataTypes>
+simulation::Task::MemoryAlloc TetrahedronFEMForceField<DataTypes>::ElementForceTask::run()
+{
+    if (m_packed)
+    {
+        runPacked();
+        return MemoryAlloc::Stack;
+    }
+
+    const VecElement& elements = *m_ff->_indexedElements;
+    const Vector& x = *m_x;
+
+    for (std::size_t i = m_first; i < m_last; ++i)
+    {
+        ElementForce& F = m_ff->m_elementForces[i];
+        const Element& e = elements[i];
+
+        if (m_dforce)
+        {
+            if (m_ff->method == SMALL)
+                m_ff->computeElementDForceSmall( F, x, (int)i, e[0], e[1], e[2], e[3], m_kFactor );
+            else
+                m_ff->computeElementDForceCorotational( F, x, (int)i, e[0], e[1], e[2], e[3], m_kFactor );
+            continue;
+        }
+
+        typename VecElement::const_iterator it = elements.begin() + i;
+        switch (m_ff->method)
+        {
+        case SMALL : m_ff->computeElementForceSmall( F, x, it, (Index)i ); break;
+        case LARGE : m_ff->computeElementForceLarge( F, x, it, (Index)i ); break;
+        case POLAR : m_ff->computeElementForcePolar( F, x, it, (Index)i ); break;
+        case SVD   : m_ff->computeElementForceSVD( F, x, it, (Index)i ); break;
+        }
+    }
+    return MemoryAlloc::Stack;
+}
+
+template<class DataTypes>
+void TetrahedronFEMForceField<DataTypes>::ElementForceTask::runPacked()
+{
+    ElementForce blockForces[PackSize];
+    for (std::size_t first = m_first; first < m_last; first += PackSize)
+    {
+        if (m_dforce)
+            m_ff->computeElementDForcesPacked( blockForces, *m_x, first / PackSize, m_kFactor );
+        else
+            m_ff->computeElementForcesPacked( blockForces, *m_x, first / PackSize );
+
+        const std::size_t count = std::min<std::size_t>(PackSize, m_last - first);
+        for (std::size_t l = 0; l < count; ++l)
+            m_ff->m_elementForces[first + l] = blockForces[l];
+    }
+}
+
+template<class DataTypes>
+TetrahedronFEMForceField<DataTypes>::GatherForceTask::GatherForceTask( simulation::CpuTask::Status* status, TetrahedronFEMForceField<DataTypes>* ff, Vector* f, std::size_t first, std::size_t last )
+    : CpuTask(status)
+    , m_ff(ff)
+    , m_f(f)
+    , m_first(first)
+    , m_last(last)
+{
+}
+
+template<class DataTypes>
+simulation::Task::MemoryAlloc TetrahedronFEMForceField<DataTypes>::GatherForceTask::run()
+{
+    const helper::vector<ElementForce>& elementForces = m_ff->m_elementForces;
+    const helper::vector<unsigned int>& begin = m_ff->m_vertexCornersBegin;
+    const helper::vector<unsigned int>& corners = m_ff->m_vertexCorners;
+    Vector& f = *m_f;
+
+    for (std::size_t v = m_first; v < m_last; ++v)
+    {
+        for (unsigned int c = begin[v]; c < begin[v+1]; ++c)
+            f[v] += elementForces[corners[c]/4][corners[c]%4];
+    }
+    return MemoryAlloc::Stack;
+}
+
 //////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////
@@ -1998,12 +2610,14 @@ void TetrahedronFEMForceField<DataTypes>::addKToMatrix(sofa::defaulttype::BaseMa
     Rot[1][0]=Rot[1][2]=0;
     Rot[2][0]=Rot[2][1]=0;
 
+    m_elementStiffnesses.clear();
+    m_elementStiffnessesBegin = 0;
+
     if (sofa::component::linearsolver::CompressedRowSparseMatrix<defaulttype::Mat<3,3,double> > * crsmat = dynamic_cast<sofa::component::linearsolver::CompressedRowSparseMatrix<defaulttype::Mat<3,3,double> > * >(mat))
     {
         for(it = _indexedElements->begin(), IT=0 ; it != _indexedElements->end() ; ++it,++IT)
         {
-            if (method == SMALL) computeStiffnessMatrix(JKJt,tmp,materialsStiffnesses[IT], strainDisplacements[IT],Rot);
-            else computeStiffnessMatrix(JKJt,tmp,materialsStiffnesses[IT], strainDisplacements[IT],rotations[IT]);
+            computeElementStiffness(JKJt, tmp, IT, Rot);
 
             defaulttype::Mat<3,3,double> tmpBlock[4][4];
             // find index of node 1
@@ -2045,8 +2659,7 @@ void TetrahedronFEMForceField<DataTypes>::addKToMatrix(sofa::defaulttype::BaseMa
     {
         for(it = _indexedElements->begin(), IT=0 ; it != _indexedElements->end() ; ++it,++IT)
         {
-            if (method == SMALL) computeStiffnessMatrix(JKJt,tmp,materialsStiffnesses[IT], strainDisplacements[IT],Rot);
-            else computeStiffnessMatrix(JKJt,tmp,materialsStiffnesses[IT], strainDisplacements[IT],rotations[IT]);
+            computeElementStiffness(JKJt, tmp, IT, Rot);
 
             defaulttype::Mat<3,3,double> tmpBlock[4][4];
             // find index of node 1
@@ -2089,10 +2702,7 @@ void TetrahedronFEMForceField<DataTypes>::addKToMatrix(sofa::defaulttype::BaseMa
     {
         for(it = _indexedElements->begin(), IT=0 ; it != _indexedElements->end() ; ++it,++IT)
         {
-            if (method == SMALL)
-                computeStiffnessMatrix(JKJt,tmp,materialsStiffnesses[IT], strainDisplacements[IT],Rot);
-            else
-                computeStiffnessMatrix(JKJt,tmp,materialsStiffnesses[IT], strainDisplacements[IT],rotations[IT]);
+            computeElementStiffness(JKJt, tmp, IT, Rot);
 
             // find index of node 1
             for (n1=0; n1<4; n1++)
@@ -2287,6 +2897,8 @@ void TetrahedronFEMForceField<DataTypes>::handleEvent(core::objectmodel::Event *
                 Index d = (*it)[3];
                 this->computeMaterialStiffness(i,a,b,c,d);
             }
+            m_packedElements.clear();
+            m_packedRotationsUpToDate = false;
         }
     }
     if (sofa::simulation::AnimateEndEvent::checkEventType(event)) {
@@ -23,6 +23,7 @@
 
 #include <sofa/helper/system/Locale.h>
 #include <sofa/helper/cast.h>
+#include <sofa/core/InitCache.h>
 
 #include <SofaSimulationCommon/xml/XML.h>
 #include <SofaSimulationCommon/xml/NodeElement.h>
@@ -143,6 +144,9 @@ Node::SPtr SceneLoaderXML::loadFromMemory ( const char *filename, const char *da
 {
     notifyLoadingSceneBefore();
 
+    core::InitCache* initCache = core::InitCache::getInstance();
+    initCache->setSceneHash(initCache->isEnabled() ? core::InitCache::hash(data, size) : 0);
+
     xml::BaseElement* xml = xml::loadFromMemory (filename, data, size );
 
     Node::SPtr root = processXML(xml, filename);
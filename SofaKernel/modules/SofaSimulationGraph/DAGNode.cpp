@@ -22,6 +22,12 @@
 #include <SofaSimulationGraph/DAGNode.h>
 #include <SofaSimulationCommon/xml/NodeElement.h>
 #include <sofa/helper/Factory.inl>
+#include <sofa/simulation/ParallelFor.h>
+#include <sofa/core/BaseMapping.h>
+#include <sofa/core/behavior/BaseMechanicalState.h>
+#include <sofa/core/behavior/BaseInteractionForceField.h>
+#include <sofa/core/behavior/BaseInteractionConstraint.h>
+#include <sofa/core/behavior/BaseInteractionProjectiveConstraintSet.h>
 
 namespace sofa
 {
@@ -114,6 +120,7 @@ protected:
 
 DAGNode::DAGNode(const std::string& name, DAGNode* parent)
     : simulation::Node(name)
+    , d_parallelTraversal(initData(&d_parallelTraversal, false, "parallelTraversal", "If true, the child subtrees sharing no node are traversed concurrently by the visitors that support it"))
     , l_parents(initLink("parents", "Parents nodes in the graph"))
 {
     if( parent )
@@ -596,18 +603,23 @@ void DAGNode::doExecuteVisitor(simulation::Visitor* action, bool precomputedOrde
             // that can have ancestors in another branch that is not pruned...
             // An already pruned node is ignored.
 
+            // The independent child subtrees of the nodes with parallelTraversal can be traversed concurrently
+            // if the visitor supports it. Each group of subtrees then has its own list of executed nodes.
+
             NodeList executedNodes;
+            ConcurrentSubtrees concurrentSubtrees;
+            ConcurrentSubtrees* concurrent = action->canTraverseConcurrently() ? &concurrentSubtrees : nullptr;
             {
                 StatusMap statusMap;
-                executeVisitorTopDown( action, executedNodes, statusMap, this );
+                executeVisitorTopDown( action, executedNodes, statusMap, this, concurrent );
             }
-            executeVisitorBottomUp( action, executedNodes );
+            executeVisitorBottomUp( action, executedNodes, concurrent );
         }
     }
 }
 
 
-void DAGNode::executeVisitorTopDown(simulation::Visitor* action, NodeList& executedNodes, StatusMap& statusMap, DAGNode* visitorRoot )
+void DAGNode::executeVisitorTopDown(simulation::Visitor* action, NodeList& executedNodes, StatusMap& statusMap, DAGNode* visitorRoot, ConcurrentSubtrees* concurrentSubtrees )
 {
     if ( statusMap[this] != NOT_VISITED )
     {
@@ -669,10 +681,10 @@ void DAGNode::executeVisitorTopDown(simulation::Visitor* action, NodeList& execu
         // ... but continue the recursion anyway!
         if( action->childOrderReversed(this) )
             for(unsigned int i = unsigned(child.size()); i>0;)
-                static_cast<DAGNode*>(child[--i].get())->executeVisitorTopDown(action,executedNodes,statusMap,visitorRoot);
+                static_cast<DAGNode*>(child[--i].get())->executeVisitorTopDown(action,executedNodes,statusMap,visitorRoot,concurrentSubtrees);
         else
             for(unsigned int i = 0; i<child.size(); ++i)
-                static_cast<DAGNode*>(child[i].get())->executeVisitorTopDown(action,executedNodes,statusMap,visitorRoot);
+                static_cast<DAGNode*>(child[i].get())->executeVisitorTopDown(action,executedNodes,statusMap,visitorRoot,concurrentSubtrees);
     }
     else
     {
@@ -685,12 +697,16 @@ void DAGNode::executeVisitorTopDown(simulation::Visitor* action, NodeList& execu
         executedNodes.push_back(this);
 
         // ... and continue the recursion
+        if( concurrentSubtrees && result != simulation::Visitor::RESULT_PRUNE && d_parallelTraversal.getValue()
+                && executeVisitorTopDownConcurrently( action, statusMap, visitorRoot, *concurrentSubtrees ) )
+            return;
+
         if( action->childOrderReversed(this) )
             for(unsigned int i = unsigned(child.size()); i>0;)
-                static_cast<DAGNode*>(child[--i].get())->executeVisitorTopDown(action,executedNodes,statusMap,visitorRoot);
+                static_cast<DAGNode*>(child[--i].get())->executeVisitorTopDown(action,executedNodes,statusMap,visitorRoot,concurrentSubtrees);
         else
             for(unsigned int i = 0; i<child.size(); ++i)
-                static_cast<DAGNode*>(child[i].get())->executeVisitorTopDown(action,executedNodes,statusMap,visitorRoot);
+                static_cast<DAGNode*>(child[i].get())->executeVisitorTopDown(action,executedNodes,statusMap,visitorRoot,concurrentSubtrees);
 
     }
 }
@@ -699,16 +715,182 @@ void DAGNode::executeVisitorTopDown(simulation::Visitor* action, NodeList& execu
 // warning nodes that are dynamically created during the traversal, but that have not been traversed during the top-down, won't be traversed during the bottom-up
 // TODO is it what we want?
 // otherwise it is possible to restart from top, go to leaves and running bottom-up action while going up
-void DAGNode::executeVisitorBottomUp( simulation::Visitor* action, NodeList& executedNodes )
+void DAGNode::executeVisitorBottomUp( simulation::Visitor* action, const NodeList& executedNodes, const ConcurrentSubtrees* concurrentSubtrees )
 {
-    for( NodeList::reverse_iterator it = executedNodes.rbegin(), itend = executedNodes.rend() ; it != itend ; ++it )
+    for( NodeList::const_reverse_iterator it = executedNodes.rbegin(), itend = executedNodes.rend() ; it != itend ; ++it )
     {
+        if( concurrentSubtrees )
+        {
+            // the child subtrees traversed concurrently are executed right after their parent in the top-down traversal
+            ConcurrentSubtrees::const_iterator subtrees = concurrentSubtrees->find( *it );
+            if( subtrees != concurrentSubtrees->end() )
+            {
+                const std::vector<NodeList>& groups = subtrees->second;
+                parallelFor( TaskScheduler::getInstance(), 0, groups.size(), 1, [&]( std::size_t begin, std::size_t end )
+                {
+                    for( std::size_t g = begin ; g < end ; ++g )
+                        executeVisitorBottomUp( action, groups[g], concurrentSubtrees );
+                });
+            }
+        }
+
         (*it)->updateDescendancy();
         action->processNodeBottomUp( *it );
     }
 }
 
 
+bool DAGNode::executeVisitorTopDownConcurrently(simulation::Visitor* action, StatusMap& statusMap, DAGNode* visitorRoot, ConcurrentSubtrees& concurrentSubtrees )
+{
+    if( child.size() < 2 )
+        return false;
+
+    std::vector< std::vector<DAGNode*> > groups;
+    if( !getIndependentSubtrees( action, groups ) || groups.size() < 2 )
+        return false;
+
+    // the descendancy is only read from now on
+    visitorRoot->updateDescendancy();
+
+    // each group of subtrees is traversed with its own status map, only knowing the status of this node
+    const std::size_t nbGroups = groups.size();
+    std::vector<NodeList> executedNodes( nbGroups );
+    std::vector<StatusMap> statusMaps( nbGroups );
+    std::vector<ConcurrentSubtrees> nestedSubtrees( nbGroups );
+    for( std::size_t g = 0 ; g < nbGroups ; ++g )
+        statusMaps[g][this] = statusMap[this];
+
+    parallelFor( TaskScheduler::getInstance(), 0, nbGroups, 1, [&]( std::size_t begin, std::size_t end )
+    {
+        for( std::size_t g = begin ; g < end ; ++g )
+            for( DAGNode* node : groups[g] )
+                node->executeVisitorTopDown( action, executedNodes[g], statusMaps[g], visitorRoot, &nestedSubtrees[g] );
+    });
+
+    for( std::size_t g = 0 ; g < nbGroups ; ++g )
+    {
+        for( StatusMap::const_iterator it = statusMaps[g].begin() ; it != statusMaps[g].end() ; ++it )
+            statusMap[it->first] = it->second.status;
+        concurrentSubtrees.insert( nestedSubtrees[g].begin(), nestedSubtrees[g].end() );
+    }
+    concurrentSubtrees[this].swap( executedNodes );
+
+    return true;
+}
+
+
+bool DAGNode::getIndependentSubtrees(simulation::Visitor* action, std::vector< std::vector<DAGNode*> >& groups )
+{
+    updateDescendancy();
+
+    std::vector<DAGNode*> children;
+    children.reserve( child.size() );
+    if( action->childOrderReversed(this) )
+        for(unsigned int i = unsigned(child.size()); i>0;)
+            children.push_back( static_cast<DAGNode*>(child[--i].get()) );
+    else
+        for(unsigned int i = 0; i<child.size(); ++i)
+            children.push_back( static_cast<DAGNode*>(child[i].get()) );
+
+    // union-find of the children sharing a descendant
+    std::vector<std::size_t> group( children.size() );
+    for( std::size_t i = 0 ; i < children.size() ; ++i )
+        group[i] = i;
+    auto findGroup = [&group]( std::size_t i )
+    {
+        while( group[i] != i )
+            i = group[i] = group[group[i]];
+        return i;
+    };
+
+    std::map<DAGNode*, std::size_t> owner;
+    for( std::size_t i = 0 ; i < children.size() ; ++i )
+    {
+        DAGNode* c = children[i];
+        std::vector<DAGNode*> subtree( c->_descendancy.begin(), c->_descendancy.end() );
+        subtree.push_back( c );
+        for( DAGNode* node : subtree )
+        {
+            // a node also reached from outside of this subtree must wait for its other parents
+            const LinkParents::Container &parents = node->l_parents.getValue();
+            for( unsigned int p = 0 ; p < parents.size() ; ++p )
+                if( parents[p] != this && _descendancy.find( parents[p] ) == _descendancy.end() )
+                    return false;
+
+            std::map<DAGNode*, std::size_t>::iterator it = owner.find( node );
+            if( it == owner.end() )
+                owner[node] = i;
+            else
+            {
+                const std::size_t a = findGroup( it->second ), b = findGroup( i );
+                group[std::max(a,b)] = std::min(a,b);
+            }
+        }
+    }
+
+    // the components writing into a state of another group merge both groups, and a state out of the subtrees
+    // (e.g. the state of this node written by the mappings of several children) makes the traversal sequential
+    std::size_t current = 0;
+    auto shareState = [&]( core::behavior::BaseMechanicalState* state )
+    {
+        if( !state )
+            return true;
+        std::map<DAGNode*, std::size_t>::const_iterator it = owner.find( dynamic_cast<DAGNode*>( state->getContext() ) );
+        if( it == owner.end() )
+            return false;
+        const std::size_t a = findGroup( it->second ), b = findGroup( current );
+        group[std::max(a,b)] = std::min(a,b);
+        return true;
+    };
+
+    for( std::map<DAGNode*, std::size_t>::const_iterator it = owner.begin() ; it != owner.end() ; ++it )
+    {
+        DAGNode* node = it->first;
+        current = it->second;
+
+        if( core::BaseMapping* mapping = node->mechanicalMapping.get() )
+        {
+            for( core::behavior::BaseMechanicalState* state : mapping->getMechFrom() )
+                if( !shareState( state ) ) return false;
+            for( core::behavior::BaseMechanicalState* state : mapping->getMechTo() )
+                if( !shareState( state ) ) return false;
+        }
+
+        for( unsigned int i = 0 ; i < node->interactionForceField.size() ; ++i )
+        {
+            core::behavior::BaseInteractionForceField* ff = node->interactionForceField[i];
+            if( !shareState( ff->getMechModel1() ) || !shareState( ff->getMechModel2() ) )
+                return false;
+        }
+
+        for( unsigned int i = 0 ; i < node->constraintSet.size() ; ++i )
+            if( core::behavior::BaseInteractionConstraint* c = dynamic_cast<core::behavior::BaseInteractionConstraint*>( node->constraintSet[i] ) )
+                if( !shareState( c->getMechModel1() ) || !shareState( c->getMechModel2() ) )
+                    return false;
+
+        for( unsigned int i = 0 ; i < node->projectiveConstraintSet.size() ; ++i )
+            if( core::behavior::BaseInteractionProjectiveConstraintSet* c = dynamic_cast<core::behavior::BaseInteractionProjectiveConstraintSet*>( node->projectiveConstraintSet[i] ) )
+                if( !shareState( c->getMechModel1() ) || !shareState( c->getMechModel2() ) )
+                    return false;
+    }
+
+    // the groups are ordered by their first child, and keep the traversal order of their children
+    groups.clear();
+    std::vector<int> groupIndex( children.size(), -1 );
+    for( std::size_t i = 0 ; i < children.size() ; ++i )
+    {
+        const std::size_t root = findGroup( i );
+        if( groupIndex[root] < 0 )
+        {
+            groupIndex[root] = int(groups.size());
+            groups.push_back( std::vector<DAGNode*>() );
+        }
+        groups[groupIndex[root]].push_back( children[i] );
+    }
+    return true;
+}
+
+
 void DAGNode::setDirtyDescendancy()
 {
     _descendancy.clear();
@@ -53,6 +53,10 @@ public:
     typedef MultiLink<DAGNode,DAGNode,BaseLink::FLAG_STOREPATH|BaseLink::FLAG_DOUBLELINK> LinkParents;
     typedef LinkParents::const_iterator ParentIterator;
 
+    /// If true, the child subtrees sharing no node nor mechanical state are traversed concurrently by the visitors that support it
+    /// (see Visitor::canTraverseConcurrently). The top-down traversals are joined before the bottom-up one.
+    Data<bool> d_parallelTraversal;
+
 
 protected:
     DAGNode( const std::string& name="", DAGNode* parent=nullptr  );
@@ -200,6 +204,9 @@ protected:
     /// list of DAGNode*
     typedef std::list<DAGNode*> NodeList;
 
+    /// for each node whose child subtrees were traversed concurrently, the nodes executed in each group of subtrees
+    typedef std::map<DAGNode*, std::vector<NodeList> > ConcurrentSubtrees;
+
     /// the ordered list of Node to traverse from this Node
     NodeList _precomputedTraversalOrder;
 
@@ -207,8 +214,18 @@ protected:
     /// @executedNodes will be fill with the DAGNodes where the top-down action is processed
     /// @statusMap the visitor's flag map
     /// @visitorRoot node from where the visitor has been run
-    void executeVisitorTopDown(simulation::Visitor* action, NodeList& executedNodes, StatusMap& statusMap, DAGNode* visitorRoot );
-    void executeVisitorBottomUp(simulation::Visitor* action, NodeList& executedNodes );
+    /// @concurrentSubtrees if not null, the child subtrees of the nodes with parallelTraversal are traversed concurrently and recorded there
+    void executeVisitorTopDown(simulation::Visitor* action, NodeList& executedNodes, StatusMap& statusMap, DAGNode* visitorRoot, ConcurrentSubtrees* concurrentSubtrees=nullptr );
+    void executeVisitorBottomUp(simulation::Visitor* action, const NodeList& executedNodes, const ConcurrentSubtrees* concurrentSubtrees=nullptr );
+
+    /// @internal concurrent top-down traversal of the child subtrees, returns false if they are not independent
+    bool executeVisitorTopDownConcurrently(simulation::Visitor* action, StatusMap& statusMap, DAGNode* visitorRoot, ConcurrentSubtrees& concurrentSubtrees );
+
+    /// @internal group the children whose subtrees share nodes or mechanical states (through mappings,
+    /// interaction force fields or constraints), in traversal order.
+    /// Returns false if a node of the subtrees has a parent outside of this node's descendancy,
+    /// or if a component of the subtrees references a mechanical state outside of them.
+    bool getIndependentSubtrees(simulation::Visitor* action, std::vector< std::vector<DAGNode*> >& groups );
     /// @}
 
     /// @internal tree traversal implementation
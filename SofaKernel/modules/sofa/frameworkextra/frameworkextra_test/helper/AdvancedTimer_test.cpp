@@ -20,6 +20,10 @@
 * Contact information: contact@sofa-framework.org                             *
 ******************************************************************************/
 #include <sofa/helper/AdvancedTimer.h>
+#include <../extlibs/json/json.h>
+
+#include <sstream>
+#include <thread>
 
 #include <SofaSimulationCommon/SceneLoaderXML.h>
 using sofa::simulation::SceneLoaderXML ;
@@ -104,5 +108,66 @@ TEST_F(AdvancedTimerTest, End)
 	EXPECT_NO_FATAL_FAILURE(AdvancedTimer::end("validId", nullptr));
 }
 
+TEST_F(AdvancedTimerTest, ChromeTrace)
+{
+	using namespace sofa::helper;
+
+	AdvancedTimer::clearTrace();
+	AdvancedTimer::setTraceEnabled(true);
+	ASSERT_TRUE(AdvancedTimer::isTraceEnabled());
+
+	AdvancedTimer::stepBegin("traceMain", "object1");
+	std::thread worker([]()
+	{
+		AdvancedTimer::stepBegin("traceWorker");
+		AdvancedTimer::valSet("traceValue", 2.0);
+		AdvancedTimer::valAdd("traceValue", 3.0);
+		AdvancedTimer::stepEnd("traceWorker");
+	});
+	worker.join();
+	AdvancedTimer::stepEnd("traceMain", "object1");
+
+	AdvancedTimer::setTraceEnabled(false);
+	AdvancedTimer::stepBegin("notTraced");
+	AdvancedTimer::stepEnd("notTraced");
+
+	std::ostringstream out;
+	AdvancedTimer::exportChromeTrace(out);
+	const json trace = json::parse(out.str());
+	ASSERT_TRUE(trace["traceEvents"].is_array());
+
+	int mainTid = -1, workerTid = -1, nbBegin = 0, nbEnd = 0;
+	double lastValue = 0;
+	for (const json& event : trace["traceEvents"])
+	{
+		const std::string name = event["name"];
+		const std::string ph = event["ph"];
+		EXPECT_NE(name, "notTraced");
+		if (name == "traceMain")
+		{
+			mainTid = event["tid"];
+			EXPECT_EQ(event["args"]["object"], "object1");
+		}
+		if (name == "traceWorker")
+		{
+			workerTid = event["tid"];
+			nbBegin += (ph == "B");
+			nbEnd += (ph == "E");
+		}
+		if (name == "traceValue")
+		{
+			EXPECT_EQ(ph, "C");
+			lastValue = event["args"]["value"];
+		}
+	}
+	EXPECT_GE(mainTid, 0);
+	EXPECT_GE(workerTid, 0);
+	EXPECT_NE(mainTid, workerTid);
+	EXPECT_EQ(nbBegin, 1);
+	EXPECT_EQ(nbEnd, 1);
+	EXPECT_EQ(lastValue, 5.0);
+
+	AdvancedTimer::clearTrace();
+}
 
 } //namespace sofa
@@ -32,6 +32,15 @@ using sofa::simulation::graph::DAGNode;
 
 #include <SofaSimulationGraph/DAGSimulation.h>
 
+#include <SofaBaseMechanics/MechanicalObject.h>
+#include <SofaBaseMechanics/IdentityMapping.h>
+#include <SofaBaseMechanics/UniformMass.h>
+#include <sofa/simulation/MechanicalVisitor.h>
+#include <sofa/simulation/TaskScheduler.h>
+using sofa::simulation::TaskScheduler;
+
+#include <mutex>
+
 namespace sofa {
 
 using namespace modeling;
@@ -290,6 +299,166 @@ Expected output: RABCDEEDCBAR
 
 
 
+    /// TestVisitor allowing the concurrent traversal of independent subtrees
+    struct ConcurrentTestVisitor: public TestVisitor
+    {
+        std::mutex mutex;
+
+        Result processNodeTopDown(simulation::Node* node) override
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return TestVisitor::processNodeTopDown(node);
+        }
+
+        void processNodeBottomUp(simulation::Node* node) override
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            TestVisitor::processNodeBottomUp(node);
+        }
+
+        bool isThreadSafe() const override { return true; }
+        bool canTraverseConcurrently() const override { return true; }
+    };
+
+    /// check that every node is traversed once, top-down after its parents, and bottom-up after its children
+    static void checkConcurrentTraversal( const std::string& nodes, const std::vector<std::string>& edges, const std::string& topdown, const std::string& bottomup )
+    {
+        std::string sortedNodes(nodes), sortedTopDown(topdown), sortedBottomUp(bottomup);
+        std::sort(sortedNodes.begin(), sortedNodes.end());
+        std::sort(sortedTopDown.begin(), sortedTopDown.end());
+        std::sort(sortedBottomUp.begin(), sortedBottomUp.end());
+        EXPECT_EQ(sortedNodes, sortedTopDown);
+        EXPECT_EQ(sortedNodes, sortedBottomUp);
+
+        for( const std::string& edge : edges )
+        {
+            EXPECT_LT(topdown.find(edge[0]), topdown.find(edge[1])) << edge << " in " << topdown;
+            EXPECT_GT(bottomup.find(edge[0]), bottomup.find(edge[1])) << edge << " in " << bottomup;
+        }
+    }
+
+/**
+  * @brief Independent subtrees traversed concurrently from R, B and C sharing X
+
+    R____
+   / \ \ \
+   A B C G
+   | |\|
+   D E X F
+
+  */
+    void traverse_concurrent()
+    {
+        Node::SPtr root = clearScene();
+        root->setName("R");
+        Node::SPtr A = root->createChild("A");
+        Node::SPtr B = root->createChild("B");
+        Node::SPtr C = root->createChild("C");
+        root->createChild("G");
+        A->createChild("D");
+        B->createChild("E");
+        Node::SPtr X = B->createChild("X");
+        C->createChild("F");
+        C->addChild(X);
+        root->findData("parallelTraversal")->read("true");
+
+        ConcurrentTestVisitor t;
+        t.execute( root.get() );
+        checkConcurrentTraversal( "RABCGDEXF", {"RA","RB","RC","RG","AD","BE","BX","CX","CF"}, t.topdown, t.bottomup );
+
+        // a visitor which is not thread-safe follows the sequential order
+        TestVisitor s;
+        s.execute( root.get() );
+        EXPECT_EQ( "RADBECFXG", s.topdown );
+        EXPECT_EQ( "GXFCEBDAR", s.bottomup );
+
+        // a subtree reached from outside of the node is not traversed concurrently
+        root->findData("parallelTraversal")->read("false");
+        B->findData("parallelTraversal")->read("true");
+        t.clear();
+        t.execute( root.get() );
+        EXPECT_EQ( "RADBECFXG", t.topdown );
+        EXPECT_EQ( "GXFCEBDAR", t.bottomup );
+    }
+
+
+/**
+  * @brief Mapped children writing the state of their parent are not traversed concurrently
+
+    R______
+    |      |
+    B0     B1      (MechanicalObject)
+   /|\    /|\
+   C ...  C ...    (MechanicalObject, IdentityMapping, UniformMass)
+
+  */
+    void traverse_concurrent_mapped()
+    {
+        typedef component::container::MechanicalObject<defaulttype::Vec3Types> MechanicalObject3;
+        typedef component::mapping::IdentityMapping<defaulttype::Vec3Types, defaulttype::Vec3Types> IdentityMapping3;
+        typedef component::mass::UniformMass<defaulttype::Vec3Types, SReal> UniformMass3;
+        const std::size_t nbBodies = 2, nbChildren = 4, nbPoints = 100000;
+
+        Node::SPtr root = clearScene();
+        root->setGravity( defaulttype::Vector3(0,-9.81,0) );
+        std::vector<Node::SPtr> bodies;
+        std::vector<MechanicalObject3::SPtr> bodyStates;
+        for( std::size_t b = 0 ; b < nbBodies ; ++b )
+        {
+            Node::SPtr body = root->createChild( "body" + std::to_string(b) );
+            MechanicalObject3::SPtr bodyState = core::objectmodel::New<MechanicalObject3>();
+            bodyState->resize( nbPoints );
+            body->addObject( bodyState );
+            for( std::size_t c = 0 ; c < nbChildren ; ++c )
+            {
+                Node::SPtr child = body->createChild( "child" + std::to_string(c) );
+                MechanicalObject3::SPtr childState = core::objectmodel::New<MechanicalObject3>();
+                childState->resize( nbPoints );
+                child->addObject( childState );
+                IdentityMapping3::SPtr mapping = core::objectmodel::New<IdentityMapping3>();
+                mapping->setModels( bodyState.get(), childState.get() );
+                child->addObject( mapping );
+                UniformMass3::SPtr mass = core::objectmodel::New<UniformMass3>();
+                mass->setMass( SReal(1 + b + 0.1 * c) );
+                child->addObject( mass );
+            }
+            bodies.push_back( body );
+            bodyStates.push_back( bodyState );
+        }
+        sofa::simulation::getSimulation()->init( root.get() );
+
+        TaskScheduler::getInstance()->init( 4 );
+
+        const core::MechanicalParams* mparams = core::MechanicalParams::defaultInstance();
+        auto computeForces = [&]()
+        {
+            MechanicalResetForceVisitor( mparams, core::VecDerivId::force() ).execute( root.get() );
+            MechanicalComputeForceVisitor( mparams, core::VecDerivId::force() ).execute( root.get() );
+        };
+
+        computeForces();
+        std::vector<MechanicalObject3::VecDeriv> sequentialForces;
+        for( MechanicalObject3::SPtr bodyState : bodyStates )
+            sequentialForces.push_back( bodyState->read( core::ConstVecDerivId::force() )->getValue() );
+
+        root->findData("parallelTraversal")->read("true");
+        for( Node::SPtr body : bodies )
+            body->findData("parallelTraversal")->read("true");
+
+        for( int run = 0 ; run < 20 ; ++run )
+        {
+            computeForces();
+            for( std::size_t b = 0 ; b < nbBodies ; ++b )
+            {
+                const MechanicalObject3::VecDeriv& forces = bodyStates[b]->read( core::ConstVecDerivId::force() )->getValue();
+                ASSERT_EQ( sequentialForces[b].size(), forces.size() );
+                for( std::size_t i = 0 ; i < forces.size() ; ++i )
+                    ASSERT_EQ( sequentialForces[b][i], forces[i] ) << "body " << b << ", point " << i << ", run " << run;
+            }
+        }
+    }
+
+
     static void getObjectByPath( Node::SPtr node, const std::string& searchpath, const std::string& objpath )
     {
         void *foundObj = node->getObject(classid(Dummy), searchpath);
@@ -378,6 +547,18 @@ TEST_F( DAG_test, traverse )
     traverse_morecomplex2();
 }
 
+TEST_F( DAG_test, traverse_concurrent )
+{
+    EXPECT_MSG_NOEMIT(Error) ;
+    traverse_concurrent();
+}
+
+TEST_F( DAG_test, traverse_concurrent_mapped )
+{
+    EXPECT_MSG_NOEMIT(Error) ;
+    traverse_concurrent_mapped();
+}
+
 TEST(DAGNodeTest, objectDestruction_singleObject)
 {
     EXPECT_MSG_NOEMIT(Error) ;
@@ -57,7 +57,10 @@ Fluid3D::Fluid3D():
     f_height ( initData(&f_height, 5.0f, "height", "initial fluid height") ),
     f_dir ( initData(&f_dir, vec3(0,1,0), "dir", "initial fluid surface normal") ),
     f_tstart ( initData(&f_tstart, 0.0f, "tstart", "starting time for fluid source") ),
-    f_tstop ( initData(&f_tstop, 60.0f, "tstop", "stopping time for fluid source") )
+    f_tstop ( initData(&f_tstop, 60.0f, "tstop", "stopping time for fluid source") ),
+    d_parallel ( initData(&d_parallel, false, "parallel", "compute the advection, diffusion and pressure projection sweeps by z slabs in parallel using the task scheduler") ),
+    d_multigrid ( initData(&d_multigrid, false, "multigrid", "precondition the pressure projection with a geometric multigrid V-cycle respecting the fluid, air and wall cells") ),
+    d_projectMaxIter ( initData(&d_projectMaxIter, 100, "projectMaxIter", "maximum number of conjugate gradient iterations of the pressure projection") )
 {
     fluid = new Grid3D;
     fnext = new Grid3D;
@@ -102,6 +105,9 @@ void Fluid3D::reset()
 void Fluid3D::updatePosition(SReal dt)
 {
     fnext->gravity = getContext()->getGravity()/f_cellwidth.getValue();
+    fnext->parallel = d_parallel.getValue();
+    fnext->multigrid = d_multigrid.getValue();
+    fnext->projectMaxIter = d_projectMaxIter.getValue();
     fnext->step(fluid, ftemp, (real)dt);
     Grid3D* p = fluid; fluid=fnext; fnext=p;
 }
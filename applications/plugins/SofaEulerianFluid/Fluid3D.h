@@ -63,6 +63,9 @@ public:
     sofa::core::objectmodel::Data<vec3> f_dir; ///< initial fluid surface normal
     sofa::core::objectmodel::Data<real> f_tstart; ///< starting time for fluid source
     sofa::core::objectmodel::Data<real> f_tstop; ///< stopping time for fluid source
+    sofa::core::objectmodel::Data<bool> d_parallel; ///< compute the grid sweeps by z slabs in parallel using the task scheduler
+    sofa::core::objectmodel::Data<bool> d_multigrid; ///< precondition the pressure projection with a geometric multigrid V-cycle
+    sofa::core::objectmodel::Data<int> d_projectMaxIter; ///< maximum number of conjugate gradient iterations of the pressure projection
 protected:
     Fluid3D();
     ~Fluid3D() override;
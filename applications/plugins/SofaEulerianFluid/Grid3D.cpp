@@ -22,7 +22,9 @@
 #include <iostream>
 #include <SofaEulerianFluid/Grid3D.h>
 #include <sofa/core/visual/VisualParams.h>
+#include <sofa/simulation/ParallelFor.h>
 #include <cstring>
+#include <functional>
 
 // set to true/false to activate extra verbose FMM.
 #define EMIT_EXTRA_FMM_MESSAGE false
@@ -46,6 +48,40 @@ const unsigned long* Grid3D::obstacles = NULL;
 
 #define LEVELSET_MARGIN 0.01f
 
+// Multigrid V-cycle parameters: red-black Gauss-Seidel sweeps on each level and on the coarsest one,
+// and scale of the restricted residual (sum of the 8 children) to match the coarse stencil
+#define MG_SMOOTH_SWEEPS 2
+#define MG_COARSE_SWEEPS 16
+#define MG_RESTRICT_SCALE 0.5f
+
+/// Call f(zbegin, zend) on the slabs [z0,z1), one slab per task if parallel is set
+template<class Function>
+static void forSlabs(bool parallel, int z0, int z1, const Function& f)
+{
+    if (parallel)
+        simulation::parallelFor(simulation::TaskScheduler::getInstance(), z0, z1, 1, [&](std::size_t zbegin, std::size_t zend)
+        {
+            f((int)zbegin, (int)zend);
+        });
+    else
+        f(z0, z1);
+}
+
+/// Sum f(zbegin, zend) over each slab of [z0,z1), in the same order whether parallel is set or not
+template<class Function>
+static double sumSlabs(bool parallel, int z0, int z1, const Function& f)
+{
+    if (parallel)
+        return simulation::parallelReduce(simulation::TaskScheduler::getInstance(), z0, z1, 1, 0.0, [&](std::size_t zbegin, std::size_t zend, double)
+        {
+            return f((int)zbegin, (int)zend);
+        }, std::plus<double>());
+    double sum = 0.0;
+    for (int z=z0; z<z1; z++)
+        sum += f(z, z+1);
+    return sum;
+}
+
 // For loop macros
 
 #define FOR_ALL_CELLS(grid,cmd)                 \
@@ -81,6 +117,50 @@ const unsigned long* Grid3D::obstacles = NULL;
       }                                         \
 }
 
+#define FOR_INNER_CELLS_IN_SLABS(zbegin,zend,cmd) \
+{                                               \
+  for (int z=zbegin;z<zend;z++)                 \
+  {                                             \
+    int ind = index(1,1,z);                     \
+    for (int y=1;y<ny-1;y++,ind+=index(2,0,0))  \
+      for (int x=1;x<nx-1;x++,ind+=index(1,0,0))\
+      {                                         \
+    cmd;                                    \
+      }                                         \
+  }                                             \
+}
+
+// Same loops split in z slabs, processed in parallel if the parallel flag is set.
+// The sum variant accumulates slabSum in each slab and returns the total.
+
+#define FOR_ALL_SLABS(cmd)                      \
+forSlabs(parallel, 0, nz, [&](int zbegin, int zend) \
+{                                               \
+  for (int z=zbegin;z<zend;z++)                 \
+  {                                             \
+    int ind = index(0,0,z);                     \
+    for (int y=0;y<ny;y++)                      \
+      for (int x=0;x<nx;x++,ind+=index(1,0,0))  \
+      {                                         \
+    cmd;                                    \
+      }                                         \
+  }                                             \
+})
+
+#define FOR_INNER_SLABS(cmd)                    \
+forSlabs(parallel, 1, nz-1, [&](int zbegin, int zend) \
+{                                               \
+  FOR_INNER_CELLS_IN_SLABS(zbegin,zend,cmd);    \
+})
+
+#define SUM_INNER_SLABS(cmd)                    \
+sumSlabs(parallel, 1, nz-1, [&](int zbegin, int zend) \
+{                                               \
+  double slabSum = 0.0;                         \
+  FOR_INNER_CELLS_IN_SLABS(zbegin,zend,cmd);    \
+  return slabSum;                               \
+})
+
 // Surface cells  are inner  cells and borders  between a  fluid inner
 // cell and an empty out cell (right or bottom side)
 
@@ -101,6 +181,8 @@ Grid3D::Grid3D()
       t(0), tend(60),
       max_pressure(0.0),
       gravity(0,-5,0),
+      parallel(false), multigrid(false),
+      projectMaxIter(100), projectIterations(0),
       fmm_status(NULL),
       fmm_heap(NULL),
       fmm_heap_size(0)
@@ -274,7 +356,7 @@ void Grid3D::step_levelset(Grid3D* prev, Grid3D* temp, real dt, real /*diff*/)
     // Modified Eulerian / Midpoint method
     // Carlson Thesis page 22
 
-    FOR_INNER_CELLS(levelset,
+    FOR_INNER_SLABS(
     {
         //if (prev->fdata[ind].type != PART_WALL && rabs(prev->levelset[ind]) < 5)
         if (rabs(prev->levelset[ind]) < 5)
@@ -838,7 +920,7 @@ void Grid3D::step_advect(const Grid3D* /*prev*/, Grid3D* temp, real dt, real /*d
 
     memset(temp->fdata,0,temp->ncell*sizeof(Cell));
 
-    FOR_INNER_CELLS(temp->fdata,
+    FOR_INNER_SLABS(
     {
         // X Axis
         vec3 px( x-0.5f - dt*(fdata[ind].u[0]),
@@ -874,7 +956,7 @@ void Grid3D::step_diffuse(const Grid3D* /*prev*/, Grid3D* temp, real /*dt*/, rea
     real a = diff;
     real inv_c = 1.0f / (1.0001f + 6*a);
 
-    FOR_INNER_CELLS(fdata,
+    FOR_INNER_SLABS(
     {
         fdata[ind].u = (temp->fdata[ind].u +
         (temp->fdata[ind+index(-1,0,0)].u+temp->fdata[ind+index(1,0,0)].u+
@@ -905,11 +987,9 @@ void Grid3D::step_project(const Grid3D* prev, Grid3D* temp, real dt, real /*diff
 
     real a = -1.0f/dt;
 
-    double b_norm2 = 0.0;
-
     //  int nbdiag[7]={0,0,0,0,0,0,0};
 
-    FOR_INNER_CELLS(diag,
+    FOR_INNER_SLABS(
     {
         if (fdata[ind].type>0)
         {
@@ -925,17 +1005,17 @@ void Grid3D::step_project(const Grid3D* prev, Grid3D* temp, real dt, real /*diff
         }
     });
 
-    FOR_INNER_CELLS(b,
+    double b_norm2 = SUM_INNER_SLABS(
     {
         if (fdata[ind].type>0)
         {
             real bi = a*(fdata[ind+index(1,0,0)].u[0]-fdata[ind].u[0] + fdata[ind+index(0,1,0)].u[1]-fdata[ind].u[1] + fdata[ind+index(0,0,1)].u[2]-fdata[ind].u[2]);
             b[ind] = bi;
-            b_norm2 += bi*bi;
+            slabSum += bi*bi;
         }
     });
 
-    FOR_ALL_CELLS(pressure,
+    FOR_ALL_SLABS(
     {
         if (fdata[ind].type>0)
             pressure[ind] = prev->pressure[ind]; // use previous pressure as initial estimate
@@ -945,7 +1025,7 @@ void Grid3D::step_project(const Grid3D* prev, Grid3D* temp, real dt, real /*diff
     double err = 0.0;
 
     // r = b - Ax
-    FOR_INNER_CELLS(r,
+    FOR_INNER_SLABS(
     {
         if (diag[ind] != 0)
         {
@@ -955,36 +1035,55 @@ void Grid3D::step_project(const Grid3D* prev, Grid3D* temp, real dt, real /*diff
         }
     });
 
-    FOR_ALL_CELLS(g,
+    // preconditioned residual s = Mr, the residual itself without preconditioner
+    const real* s = r;
+    if (multigrid)
     {
-        g[ind] = r[ind]; // first direction is r
-    });
+        mg_init(diag);
+        s = &mg_levels[0].x[0];
+    }
+    double rs = 0.0;
 
     double min_err = 0.000001f*b_norm2;
 
     int step;
-    for (step=0; step<100; step++)
+    for (step=0; step<projectMaxIter; step++)
     {
-        double err_old = err;
-        err = 0.0;
-        FOR_READ_INNER_CELLS(
+        double rs_old = rs;
+        err = SUM_INNER_SLABS(
         {
-            err += r[ind]*r[ind];
+            slabSum += r[ind]*r[ind];
         });
 
         if (err<=min_err) break;
+        if (multigrid)
+        {
+            mg_vcycle(r);
+            rs = SUM_INNER_SLABS(
+            {
+                slabSum += r[ind]*s[ind];
+            });
+        }
+        else
+            rs = err;
         if (step>0)
         {
-            real beta = (real)(err/err_old);
-            // g = g*beta + r
-            FOR_ALL_CELLS(g,
+            real beta = (real)(rs/rs_old);
+            // g = g*beta + s
+            FOR_ALL_SLABS(
+            {
+                g[ind] = g[ind]*beta + s[ind];
+            });
+        }
+        else
+        {
+            FOR_ALL_SLABS(
             {
-                g[ind] = g[ind]*beta + r[ind];
+                g[ind] = s[ind]; // first direction is s
             });
         }
-        double g_q = 0.0;
         // q = Ag
-        FOR_INNER_CELLS(q,
+        double g_q = SUM_INNER_SLABS(
         {
             if (diag[ind] != 0)
             {
@@ -992,18 +1091,19 @@ void Grid3D::step_project(const Grid3D* prev, Grid3D* temp, real dt, real /*diff
                 -g[ind+index(-1,0,0)]-g[ind+index(0,-1,0)]-g[ind+index(0,0,-1)]
                 -g[ind+index( 1,0,0)]-g[ind+index(0, 1,0)]-g[ind+index(0,0, 1)]);
                 q[ind] = Ag;
-                g_q += g[ind]*Ag;
+                slabSum += g[ind]*Ag;
             }
         });
 
-        real alpha = (real)(err/g_q);
+        real alpha = (real)(rs/g_q);
 
-        FOR_ALL_CELLS(pressure,
+        FOR_ALL_SLABS(
         {
             pressure[ind] += alpha*g[ind];
             r[ind] -= alpha*q[ind];
         });
     }
+    projectIterations = step;
 
     // Now apply pressure back to velocity
     a = dt;
@@ -1013,7 +1113,7 @@ void Grid3D::step_project(const Grid3D* prev, Grid3D* temp, real dt, real /*diff
     //max_pressure = 0.0;
     max_pressure = prev->max_pressure;
 
-    FOR_INNER_CELLS(fdata,
+    FOR_INNER_SLABS(
     {
         if (fdata[ind].type>=PART_EMPTY)
         {
@@ -1040,6 +1140,201 @@ void Grid3D::step_project(const Grid3D* prev, Grid3D* temp, real dt, real /*diff
     });
 }
 
+//////////////////////////////////////////////////////////////////
+//// Multigrid preconditioner of the pressure projection
+
+// Each level rediscretizes the pressure stencil on cells twice as large:
+// walls are Neumann boundaries (not counted in the diagonal) and air cells
+// are Dirichlet boundaries at zero pressure, as on the finest grid.
+
+void Grid3D::mg_init(const real* diag)
+{
+    if (mg_levels.empty() || mg_levels[0].nx != nx || mg_levels[0].ny != ny || mg_levels[0].nz != nz)
+    {
+        mg_levels.clear();
+        int lnx = nx, lny = ny, lnz = nz;
+        for (;;)
+        {
+            mg_levels.resize(mg_levels.size()+1);
+            MultigridLevel& level = mg_levels.back();
+            level.nx = lnx; level.ny = lny; level.nz = lnz;
+            level.nxny = lnx*lny; level.ncell = level.nxny*lnz;
+            level.type.assign(level.ncell, PART_WALL);
+            level.diag.assign(level.ncell, 0);
+            level.x.assign(level.ncell, 0);
+            level.b.assign(level.ncell, 0);
+            level.r.assign(level.ncell, 0);
+            // inner cells i and i+1 of this level are merged in the inner cell (i+1)/2 of the next level
+            if (lnx-2 < 4 || lny-2 < 4 || lnz-2 < 4) break;
+            lnx = (lnx-1)/2+2; lny = (lny-1)/2+2; lnz = (lnz-1)/2+2;
+        }
+    }
+
+    MultigridLevel& fine = mg_levels[0];
+    FOR_ALL_SLABS(
+    {
+        fine.type[ind] = fdata[ind].type;
+        fine.diag[ind] = diag[ind];
+    });
+
+    for (unsigned int l=1; l<mg_levels.size(); l++)
+    {
+        const MultigridLevel& child = mg_levels[l-1];
+        MultigridLevel& level = mg_levels[l];
+        const int lnx = level.nx, lny = level.ny, lnxny = level.nxny;
+        forSlabs(parallel, 1, level.nz-1, [&](int zbegin, int zend)
+        {
+            for (int z=zbegin; z<zend; z++)
+                for (int y=1; y<lny-1; y++)
+                    for (int x=1; x<lnx-1; x++)
+                    {
+                        int ind = x + y*lnx + z*lnxny;
+                        int ind0 = (2*x-1) + (2*y-1)*child.nx + (2*z-1)*child.nxny;
+                        int t = PART_WALL;
+                        for (int dz=0; dz<2; dz++)
+                            for (int dy=0; dy<2; dy++)
+                                for (int dx=0; dx<2; dx++)
+                                {
+                                    int ct = child.type[ind0 + dx + dy*child.nx + dz*child.nxny];
+                                    if (ct == PART_EMPTY) t = PART_EMPTY;
+                                    else if (ct > 0 && t == PART_WALL) t = PART_FULL;
+                                }
+                        level.type[ind] = t;
+                    }
+        });
+        forSlabs(parallel, 1, level.nz-1, [&](int zbegin, int zend)
+        {
+            for (int z=zbegin; z<zend; z++)
+                for (int y=1; y<lny-1; y++)
+                    for (int x=1; x<lnx-1; x++)
+                    {
+                        int ind = x + y*lnx + z*lnxny;
+                        real d = 0;
+                        if (level.type[ind] > 0)
+                        {
+                            d = 6; // count air/fluid neighbours
+                            d -= (level.type[ind-1] < 0);
+                            d -= (level.type[ind+1] < 0);
+                            d -= (level.type[ind-lnx] < 0);
+                            d -= (level.type[ind+lnx] < 0);
+                            d -= (level.type[ind-lnxny] < 0);
+                            d -= (level.type[ind+lnxny] < 0);
+                        }
+                        level.diag[ind] = d;
+                    }
+        });
+    }
+}
+
+void Grid3D::mg_smooth(MultigridLevel& level, int color)
+{
+    // Gauss-Seidel update of the cells (x+y+z)%2 == color, which only depend on the other color
+    const int lnx = level.nx, lny = level.ny, lnxny = level.nxny;
+    const real* diag = &level.diag[0];
+    const real* b = &level.b[0];
+    real* x = &level.x[0];
+    forSlabs(parallel, 1, level.nz-1, [&](int zbegin, int zend)
+    {
+        for (int z=zbegin; z<zend; z++)
+            for (int y=1; y<lny-1; y++)
+            {
+                int x0 = 1 + ((1+y+z+color)&1);
+                for (int ind = x0 + y*lnx + z*lnxny, xi=x0; xi<lnx-1; xi+=2, ind+=2)
+                {
+                    if (diag[ind] != 0)
+                        x[ind] = (b[ind] + x[ind-1] + x[ind+1] + x[ind-lnx] + x[ind+lnx] + x[ind-lnxny] + x[ind+lnxny]) / diag[ind];
+                }
+            }
+    });
+}
+
+void Grid3D::mg_residual(MultigridLevel& level)
+{
+    const int lnx = level.nx, lny = level.ny, lnxny = level.nxny;
+    const real* diag = &level.diag[0];
+    const real* b = &level.b[0];
+    const real* x = &level.x[0];
+    real* r = &level.r[0];
+    forSlabs(parallel, 1, level.nz-1, [&](int zbegin, int zend)
+    {
+        for (int z=zbegin; z<zend; z++)
+            for (int y=1; y<lny-1; y++)
+                for (int ind = 1 + y*lnx + z*lnxny, xi=1; xi<lnx-1; xi++, ind++)
+                {
+                    if (diag[ind] != 0)
+                        r[ind] = b[ind] - (diag[ind]*x[ind] - x[ind-1] - x[ind+1] - x[ind-lnx] - x[ind+lnx] - x[ind-lnxny] - x[ind+lnxny]);
+                    else
+                        r[ind] = 0;
+                }
+    });
+}
+
+void Grid3D::mg_vcycle(const real* r)
+{
+    // One V-cycle from a zero initial guess, with the sweeps of the way up done in reverse
+    // order of the way down so that it stays a symmetric preconditioner for the conjugate gradient
+    const int nlevels = (int)mg_levels.size();
+    memcpy(&mg_levels[0].b[0], r, ncell*sizeof(real));
+
+    for (int l=0; l<nlevels; l++)
+    {
+        MultigridLevel& level = mg_levels[l];
+        std::fill(level.x.begin(), level.x.end(), (real)0);
+        if (l == nlevels-1)
+        {
+            for (int i=0; i<MG_COARSE_SWEEPS; i++) { mg_smooth(level, 0); mg_smooth(level, 1); }
+            for (int i=0; i<MG_COARSE_SWEEPS; i++) { mg_smooth(level, 1); mg_smooth(level, 0); }
+            break;
+        }
+        for (int i=0; i<MG_SMOOTH_SWEEPS; i++) { mg_smooth(level, 0); mg_smooth(level, 1); }
+        mg_residual(level);
+
+        // restriction: sum of the residuals of the children
+        MultigridLevel& coarse = mg_levels[l+1];
+        const int cnx = coarse.nx, cny = coarse.ny, cnxny = coarse.nxny;
+        forSlabs(parallel, 1, coarse.nz-1, [&](int zbegin, int zend)
+        {
+            for (int z=zbegin; z<zend; z++)
+                for (int y=1; y<cny-1; y++)
+                    for (int x=1; x<cnx-1; x++)
+                    {
+                        int ind = x + y*cnx + z*cnxny;
+                        real sum = 0;
+                        if (coarse.diag[ind] != 0)
+                        {
+                            int ind0 = (2*x-1) + (2*y-1)*level.nx + (2*z-1)*level.nxny;
+                            for (int dz=0; dz<2; dz++)
+                                for (int dy=0; dy<2; dy++)
+                                    for (int dx=0; dx<2; dx++)
+                                        sum += level.r[ind0 + dx + dy*level.nx + dz*level.nxny];
+                        }
+                        coarse.b[ind] = sum*MG_RESTRICT_SCALE;
+                    }
+        });
+    }
+
+    for (int l=nlevels-2; l>=0; l--)
+    {
+        MultigridLevel& level = mg_levels[l];
+        const MultigridLevel& coarse = mg_levels[l+1];
+        const int lnx = level.nx, lny = level.ny, lnxny = level.nxny;
+
+        // prolongation: add the correction of the parent cell
+        forSlabs(parallel, 1, level.nz-1, [&](int zbegin, int zend)
+        {
+            for (int z=zbegin; z<zend; z++)
+                for (int y=1; y<lny-1; y++)
+                    for (int x=1; x<lnx-1; x++)
+                    {
+                        int ind = x + y*lnx + z*lnxny;
+                        if (level.diag[ind] != 0)
+                            level.x[ind] += coarse.x[(x+1)/2 + ((y+1)/2)*coarse.nx + ((z+1)/2)*coarse.nxny];
+                    }
+        });
+        for (int i=0; i<MG_SMOOTH_SWEEPS; i++) { mg_smooth(level, 1); mg_smooth(level, 0); }
+    }
+}
+
 } // namespace eulerianfluid
 
 } // namespace behaviormodel
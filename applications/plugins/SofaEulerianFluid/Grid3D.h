@@ -27,6 +27,7 @@
 #include <sofa/defaulttype/Mat.h>
 #include <sofa/helper/rmath.h>
 #include <iostream>
+#include <vector>
 
 
 namespace sofa
@@ -80,6 +81,11 @@ public:
 
     vec3 gravity;
 
+    bool parallel; ///< run the grid sweeps over z slabs in parallel using the task scheduler
+    bool multigrid; ///< precondition the pressure projection with a multigrid V-cycle
+    int projectMaxIter; ///< maximum number of conjugate gradient iterations of the pressure projection
+    int projectIterations; ///< number of iterations used by the last pressure projection
+
     static const unsigned long* obstacles;
 
     Grid3D();
@@ -298,6 +304,25 @@ public:
     int fmm_pop();
     void fmm_push(int index);
     void fmm_swap(int entry1, int entry2);
+
+    // Geometric Multigrid Pressure Preconditioner
+    /// Level of the hierarchy: a coarse cell covers 2x2x2 cells of the finer level,
+    /// it is air if one of its children is air, fluid if one of them is fluid, and wall otherwise.
+    struct MultigridLevel
+    {
+        int nx,ny,nz,nxny,ncell;
+        std::vector<int> type;
+        std::vector<real> diag;
+        std::vector<real> x;
+        std::vector<real> b;
+        std::vector<real> r;
+    };
+    std::vector<MultigridLevel> mg_levels;
+
+    void mg_init(const real* diag);
+    void mg_vcycle(const real* r);
+    void mg_smooth(MultigridLevel& level, int color);
+    void mg_residual(MultigridLevel& level);
 };
 
 } // namespace eulerianfluid
@@ -0,0 +1,156 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/helper/testing/BaseTest.h>
+using sofa::helper::testing::BaseTest ;
+
+#include <SofaEulerianFluid/Grid3D.h>
+using sofa::component::behaviormodel::eulerianfluid::Grid3D ;
+
+#include <sofa/simulation/TaskScheduler.h>
+using sofa::simulation::TaskScheduler ;
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace sofa
+{
+namespace component
+{
+namespace behaviormodel
+{
+namespace eulerianfluid
+{
+namespace _grid3d_
+{
+
+struct Grid3D_test : public BaseTest
+{
+    typedef Grid3D::real real ;
+    typedef Grid3D::vec3 vec3 ;
+
+    static const int NX = 20, NY = 16, NZ = 12 ;
+
+    /// A box with wall borders, a block of fluid with a swirling velocity, and air above it
+    static void seedBox(Grid3D& grid)
+    {
+        grid.clear(NX, NY, NZ) ;
+        grid.seed(vec3(2,1,1), vec3(NX-4, NY*0.6f, NZ-3)) ;
+        for (int z=0; z<NZ; ++z)
+            for (int y=0; y<NY; ++y)
+                for (int x=0; x<NX; ++x)
+                {
+                    Grid3D::Cell* c = grid.get(x,y,z) ;
+                    c->u = vec3(0.3f*std::sin(0.7f*y+0.2f*z), 0.2f*std::cos(0.5f*x), 0.25f*std::sin(0.4f*x+0.9f*y)) ;
+                }
+    }
+
+    /// Run one step from the seeded box, with the given projection options
+    static void stepBox(Grid3D& next, bool multigrid, bool parallel)
+    {
+        Grid3D prev, temp ;
+        seedBox(prev) ;
+        next.clear(NX, NY, NZ) ;
+        temp.clear(NX, NY, NZ) ;
+        for (Grid3D* g : {&prev, &next, &temp})
+        {
+            g->multigrid = multigrid ;
+            g->parallel = parallel ;
+            g->projectMaxIter = 1000 ;
+        }
+        next.step(&prev, &temp, 0.04f) ;
+    }
+
+    static int countCells(const Grid3D& grid, int type)
+    {
+        int n = 0 ;
+        for (int i=0; i<grid.ncell; ++i)
+            n += (type > 0) ? (grid.fdata[i].type > 0) : (grid.fdata[i].type == type) ;
+        return n ;
+    }
+
+    void checkMultigridMatchesConjugateGradient()
+    {
+        Grid3D cg, mg ;
+        stepBox(cg, false, false) ;
+        stepBox(mg, true, false) ;
+
+        // the box has walls, air and fluid cells
+        EXPECT_GT(countCells(cg, Grid3D::PART_WALL), 0) ;
+        EXPECT_GT(countCells(cg, Grid3D::PART_EMPTY), 0) ;
+        EXPECT_GT(countCells(cg, Grid3D::PART_FULL), 0) ;
+
+        EXPECT_GT(cg.projectIterations, 0) ;
+        EXPECT_LT(cg.projectIterations, 1000) ;
+        EXPECT_LT(mg.projectIterations, cg.projectIterations) ;
+
+        real maxPressure = 0 ;
+        for (int i=0; i<cg.ncell; ++i)
+            maxPressure = std::max(maxPressure, std::abs(cg.pressure[i])) ;
+        EXPECT_GT(maxPressure, 0) ;
+        for (int i=0; i<cg.ncell; ++i)
+        {
+            EXPECT_NEAR(cg.pressure[i], mg.pressure[i], 1e-3f*maxPressure) << "cell " << i ;
+        }
+    }
+
+    void checkParallelMatchesSequential(bool multigrid)
+    {
+        Grid3D sequential, parallel ;
+        stepBox(sequential, multigrid, false) ;
+
+        TaskScheduler* scheduler = TaskScheduler::getInstance() ;
+        scheduler->init(4) ;
+        stepBox(parallel, multigrid, true) ;
+        scheduler->stop() ;
+
+        EXPECT_EQ(sequential.projectIterations, parallel.projectIterations) ;
+        EXPECT_EQ(0, std::memcmp(sequential.pressure, parallel.pressure, sequential.ncell*sizeof(real))) ;
+        EXPECT_EQ(0, std::memcmp(sequential.levelset, parallel.levelset, sequential.ncell*sizeof(real))) ;
+        for (int i=0; i<sequential.ncell; ++i)
+        {
+            ASSERT_EQ(sequential.fdata[i].type, parallel.fdata[i].type) << "cell " << i ;
+            ASSERT_EQ(0, std::memcmp(&sequential.fdata[i].u, &parallel.fdata[i].u, sizeof(vec3))) << "cell " << i ;
+        }
+    }
+};
+
+TEST_F(Grid3D_test, checkMultigridMatchesConjugateGradient)
+{
+    this->checkMultigridMatchesConjugateGradient() ;
+}
+
+TEST_F(Grid3D_test, checkParallelMatchesSequential)
+{
+    this->checkParallelMatchesSequential(false) ;
+}
+
+TEST_F(Grid3D_test, checkParallelMultigridMatchesSequential)
+{
+    this->checkParallelMatchesSequential(true) ;
+}
+
+} // namespace _grid3d_
+} // namespace eulerianfluid
+} // namespace behaviormodel
+} // namespace component
+} // namespace sofa
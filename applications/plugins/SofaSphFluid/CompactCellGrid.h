@@ -0,0 +1,119 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_COMPONENT_CONTAINER_COMPACTCELLGRID_H
+#define SOFA_COMPONENT_CONTAINER_COMPACTCELLGRID_H
+#include "config.h"
+
+#include <sofa/defaulttype/VecTypes.h>
+#include <sofa/helper/vector.h>
+#include <cstdint>
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace container
+{
+
+/** Cell-linked-list grid stored in a few flat arrays.
+ *
+ *  The particles are sorted by the Z-order (Morton) key of the cell containing
+ *  them, using a radix sort made of counting sort passes. Only the non-empty
+ *  cells are stored, in increasing key order, as contiguous ranges of the sorted
+ *  particle array. The neighbor cells of a cell are found by binary search on
+ *  the cell keys.
+ *
+ *  Particles of the same cell are sorted by increasing index, so the sorted order
+ *  only depends on the positions. It is also a good particle ordering for memory
+ *  locality, see SpatialGridContainer::sortPoints().
+ */
+template<class DataTypes>
+class CompactCellGrid
+{
+public:
+    typedef typename DataTypes::Real Real;
+    typedef typename DataTypes::Coord Coord;
+    typedef typename DataTypes::VecCoord VecCoord;
+    typedef std::uint64_t Key;
+
+    enum { N = Coord::spatial_dimensions };
+    /// number of bits of the cell coordinates in each direction
+    enum { KEY_BITS = (63 / N < 21) ? 63 / N : 21 };
+    /// maximum number of neighbor cells of a cell (itself included)
+    enum { MAX_NEIGHBOR_CELLS = (N == 3) ? 27 : (N == 2) ? 9 : 3 };
+
+    CompactCellGrid();
+
+    /// Sort the particles in cells of width cellWidth
+    void build(const VecCoord& x, Real cellWidth);
+
+    std::size_t getNbParticles() const { return m_sortedIndices.size(); }
+    std::size_t getNbCells() const { return m_cellKeys.size(); }
+    Real getCellWidth() const { return m_cellWidth; }
+
+    /// Particle indices sorted by cell
+    const helper::vector<unsigned int>& getSortedIndices() const { return m_sortedIndices; }
+
+    /// The particles of a cell are getSortedIndices()[cellBegin(cell)..cellEnd(cell)[
+    std::size_t cellBegin(std::size_t cell) const { return m_cellBegin[cell]; }
+    std::size_t cellEnd(std::size_t cell) const { return m_cellBegin[cell+1]; }
+
+    /// Fill neighborCells with the non-empty cells adjacent to cell, itself included.
+    /// neighborCells must have room for MAX_NEIGHBOR_CELLS entries. Returns the number of cells.
+    unsigned int getNeighborCells(std::size_t cell, std::size_t* neighborCells) const;
+
+    /// Fill the old2new and new2old arrays giving the permutation sorting the particles by cell
+    void reorderIndices(helper::vector<unsigned int>* old2new, helper::vector<unsigned int>* new2old) const;
+
+    static Key encode(const int* cellCoords);
+    static void decode(Key key, int* cellCoords);
+
+protected:
+    Real m_cellWidth;
+    Coord m_origin;
+
+    /// cell keys of the particles, in the order of m_sortedIndices
+    helper::vector<Key> m_sortedKeys;
+    helper::vector<unsigned int> m_sortedIndices;
+    helper::vector<Key> m_keyBuffer;
+    helper::vector<unsigned int> m_indexBuffer;
+
+    helper::vector<Key> m_cellKeys;
+    helper::vector<std::size_t> m_cellBegin;
+
+    std::size_t findCell(Key key) const;
+};
+
+#if  !defined(SOFA_COMPONENT_CONTAINER_COMPACTCELLGRID_CPP)
+extern template class SOFA_SPH_FLUID_API CompactCellGrid< sofa::defaulttype::Vec3Types >;
+extern template class SOFA_SPH_FLUID_API CompactCellGrid< sofa::defaulttype::Vec2Types >;
+#endif
+
+} // namespace container
+
+} // namespace component
+
+} // namespace sofa
+
+#endif
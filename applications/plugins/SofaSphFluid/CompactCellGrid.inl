@@ -0,0 +1,193 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_COMPONENT_CONTAINER_COMPACTCELLGRID_INL
+#define SOFA_COMPONENT_CONTAINER_COMPACTCELLGRID_INL
+
+#include <SofaSphFluid/CompactCellGrid.h>
+#include <algorithm>
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace container
+{
+
+template<class DataTypes>
+CompactCellGrid<DataTypes>::CompactCellGrid()
+    : m_cellWidth(1)
+{
+    m_cellBegin.push_back(0);
+}
+
+template<class DataTypes>
+typename CompactCellGrid<DataTypes>::Key CompactCellGrid<DataTypes>::encode(const int* cellCoords)
+{
+    Key key = 0;
+    for (int b = 0; b < KEY_BITS; ++b)
+        for (int c = 0; c < N; ++c)
+            key |= (Key)((cellCoords[c] >> b) & 1) << (N*b + c);
+    return key;
+}
+
+template<class DataTypes>
+void CompactCellGrid<DataTypes>::decode(Key key, int* cellCoords)
+{
+    for (int c = 0; c < N; ++c)
+        cellCoords[c] = 0;
+    for (int b = 0; b < KEY_BITS; ++b)
+        for (int c = 0; c < N; ++c)
+            cellCoords[c] |= (int)((key >> (N*b + c)) & 1) << b;
+}
+
+template<class DataTypes>
+void CompactCellGrid<DataTypes>::build(const VecCoord& x, Real cellWidth)
+{
+    const std::size_t n = x.size();
+    m_cellWidth = cellWidth;
+    m_sortedKeys.resize(n);
+    m_sortedIndices.resize(n);
+    m_cellKeys.clear();
+    m_cellBegin.clear();
+    if (n == 0)
+    {
+        m_cellBegin.push_back(0);
+        return;
+    }
+
+    // the grid starts at the lower corner of the bounding box, so that the cell coordinates are positive
+    m_origin = x[0];
+    for (std::size_t i = 1; i < n; ++i)
+        for (int c = 0; c < N; ++c)
+            m_origin[c] = std::min(m_origin[c], x[i][c]);
+
+    const Real invCellWidth = 1/cellWidth;
+    const Real maxCoord = (Real)((((Key)1) << KEY_BITS) - 1);
+    Key maxKey = 0;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        int cellCoords[N];
+        for (int c = 0; c < N; ++c)
+        {
+            Real v = (x[i][c] - m_origin[c]) * invCellWidth;
+            if (!(v > 0)) v = 0;
+            else if (v > maxCoord) v = maxCoord;
+            cellCoords[c] = (int)v;
+        }
+        m_sortedKeys[i] = encode(cellCoords);
+        m_sortedIndices[i] = (unsigned int)i;
+        maxKey |= m_sortedKeys[i];
+    }
+
+    // LSD radix sort, one counting sort per byte of the keys. Each pass is stable,
+    // so the particles of a cell keep their increasing indices.
+    m_keyBuffer.resize(n);
+    m_indexBuffer.resize(n);
+    for (unsigned int shift = 0; shift < 64 && (maxKey >> shift) != 0; shift += 8)
+    {
+        std::size_t count[257];
+        std::fill(count, count+257, 0);
+        for (std::size_t i = 0; i < n; ++i)
+            ++count[((m_sortedKeys[i] >> shift) & 255) + 1];
+        for (int b = 0; b < 256; ++b)
+            count[b+1] += count[b];
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            const std::size_t dest = count[(m_sortedKeys[i] >> shift) & 255]++;
+            m_keyBuffer[dest] = m_sortedKeys[i];
+            m_indexBuffer[dest] = m_sortedIndices[i];
+        }
+        m_sortedKeys.swap(m_keyBuffer);
+        m_sortedIndices.swap(m_indexBuffer);
+    }
+
+    for (std::size_t k = 0; k < n; ++k)
+    {
+        if (k == 0 || m_sortedKeys[k] != m_cellKeys.back())
+        {
+            m_cellKeys.push_back(m_sortedKeys[k]);
+            m_cellBegin.push_back(k);
+        }
+    }
+    m_cellBegin.push_back(n);
+}
+
+template<class DataTypes>
+std::size_t CompactCellGrid<DataTypes>::findCell(Key key) const
+{
+    typename helper::vector<Key>::const_iterator it = std::lower_bound(m_cellKeys.begin(), m_cellKeys.end(), key);
+    if (it == m_cellKeys.end() || *it != key)
+        return m_cellKeys.size();
+    return it - m_cellKeys.begin();
+}
+
+template<class DataTypes>
+unsigned int CompactCellGrid<DataTypes>::getNeighborCells(std::size_t cell, std::size_t* neighborCells) const
+{
+    int cellCoords[N];
+    decode(m_cellKeys[cell], cellCoords);
+    const int maxCoord = (int)((((Key)1) << KEY_BITS) - 1);
+
+    unsigned int nbNeighbors = 0;
+    for (int d = 0; d < MAX_NEIGHBOR_CELLS; ++d)
+    {
+        int coords[N];
+        bool inside = true;
+        int offsets = d;
+        for (int c = 0; c < N; ++c)
+        {
+            coords[c] = cellCoords[c] + (offsets % 3) - 1;
+            offsets /= 3;
+            inside &= (coords[c] >= 0 && coords[c] <= maxCoord);
+        }
+        if (!inside)
+            continue;
+        const std::size_t neighbor = findCell(encode(coords));
+        if (neighbor != m_cellKeys.size())
+            neighborCells[nbNeighbors++] = neighbor;
+    }
+    return nbNeighbors;
+}
+
+template<class DataTypes>
+void CompactCellGrid<DataTypes>::reorderIndices(helper::vector<unsigned int>* old2new, helper::vector<unsigned int>* new2old) const
+{
+    const std::size_t n = m_sortedIndices.size();
+    if (new2old != NULL)
+        *new2old = m_sortedIndices;
+    if (old2new != NULL)
+    {
+        old2new->resize(n);
+        for (std::size_t k = 0; k < n; ++k)
+            (*old2new)[m_sortedIndices[k]] = (unsigned int)k;
+    }
+}
+
+} // namespace container
+
+} // namespace component
+
+} // namespace sofa
+
+#endif
@@ -27,6 +27,7 @@
 #include <sofa/core/behavior/ForceField.h>
 #include <sofa/core/behavior/MechanicalState.h>
 #include <SofaSphFluid/SpatialGridContainer.h>
+#include <SofaSphFluid/CompactCellGrid.h>
 #include <sofa/helper/rmath.h>
 #include <vector>
 #include <cmath>
@@ -459,6 +460,8 @@ public:
     Data< int > pressureType; ///< 0 = none, 1 = default pressure
     Data< int > viscosityType; ///< 0 = none, 1 = default viscosity using kernel Laplacian, 2 = artificial viscosity
     Data< int > surfaceTensionType; ///< 0 = none, 1 = default surface tension using kernel Laplacian, 2 = cohesion forces surface tension from Becker et al. 2007
+    Data< bool > d_parallel; ///< find the neighbors with a compact cell grid and compute the density, pressure and viscosity passes in parallel on the task scheduler
+    Data< unsigned int > d_parallelGrainSize; ///< number of cells or particles processed by each task in parallel mode
 
 protected:
     struct Particle
@@ -480,6 +483,9 @@ protected:
 
     Grid* grid;
 
+    /// grid used in parallel mode, where the neighbor lists of the particles are symmetric
+    sofa::component::container::CompactCellGrid<DataTypes> m_cellGrid;
+
     SPHFluidForceFieldInternalData<DataTypes> data;
     friend class SPHFluidForceFieldInternalData<DataTypes>;
 
@@ -574,6 +580,12 @@ protected:
     void computeNeighbors(const core::MechanicalParams* mparams, const DataVecCoord& d_x, const DataVecDeriv& d_v);
     template<class Kd, class Kp, class Kv, class Kc>
     void computeForce(const core::MechanicalParams* mparams, DataVecDeriv& d_f, const DataVecCoord& d_x, const DataVecDeriv& d_v);
+
+    /// Parallel versions of computeNeighbors and computeForce: each particle stores all its neighbors,
+    /// so that every pass only writes the values of its own particles
+    void computeNeighborsParallel(const VecCoord& x);
+    template<class Kd, class Kp, class Kv, class Kc>
+    void computeForceParallel(DataVecDeriv& d_f, const DataVecCoord& d_x, const DataVecDeriv& d_v);
 };
 
 using sofa::defaulttype::Vec3Types;
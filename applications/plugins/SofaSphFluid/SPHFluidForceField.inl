@@ -25,6 +25,7 @@
 #include <SofaSphFluid/SPHFluidForceField.h>
 #include <sofa/core/visual/VisualParams.h>
 #include <SofaSphFluid/SpatialGridContainer.inl>
+#include <sofa/simulation/ParallelFor.h>
 #include <sofa/helper/system/config.h>
 #include <cmath>
 #include <iostream>
@@ -51,6 +52,8 @@ SPHFluidForceField<DataTypes>::SPHFluidForceField()
                     pressureType(initData(&pressureType, 1, "pressureType", "0 = none, 1 = default pressure")),
                     viscosityType(initData(&viscosityType, 1, "viscosityType", "0 = none, 1 = default viscosity using kernel Laplacian, 2 = artificial viscosity")),
                     surfaceTensionType(initData(&surfaceTensionType, 1, "surfaceTensionType", "0 = none, 1 = default surface tension using kernel Laplacian, 2 = cohesion forces surface tension from Becker et al. 2007")),
+                    d_parallel(initData(&d_parallel, false, "parallel", "find the neighbors with a compact cell grid sorted in Z-order instead of the SpatialGridContainer, and compute the density, pressure and viscosity passes in parallel using the task scheduler")),
+                    d_parallelGrainSize(initData(&d_parallelGrainSize, (unsigned int)256, "parallelGrainSize", "number of cells or particles processed by each task when parallel is true")),
                     grid(NULL)
 {
 }
@@ -226,7 +229,11 @@ void SPHFluidForceField<DataTypes>::init()
 template<class DataTypes>
 void SPHFluidForceField<DataTypes>::addForce(const core::MechanicalParams* mparams, DataVecDeriv& d_f, const DataVecCoord& d_x, const DataVecDeriv& d_v)
 {
-    computeNeighbors(mparams, d_x, d_v);
+    const bool parallel = d_parallel.getValue();
+    if (parallel)
+        computeNeighborsParallel(d_x.getValue());
+    else
+        computeNeighbors(mparams, d_x, d_v);
 
     switch(kernelType.getValue())
     {
@@ -235,18 +242,22 @@ void SPHFluidForceField<DataTypes>::addForce(const core::MechanicalParams* mpara
         // fallthrough
     case 0: // default
     {
-        computeForce <SPHKernel<SPH_KERNEL_DEFAULT_DENSITY,Deriv>,
-                     SPHKernel<SPH_KERNEL_DEFAULT_PRESSURE,Deriv>,
-                     SPHKernel<SPH_KERNEL_DEFAULT_VISCOSITY,Deriv>,
-                     SPHKernel<SPH_KERNEL_DEFAULT_DENSITY,Deriv> > (mparams, d_f, d_x, d_v);
+        typedef SPHKernel<SPH_KERNEL_DEFAULT_DENSITY,Deriv> Kd;
+        typedef SPHKernel<SPH_KERNEL_DEFAULT_PRESSURE,Deriv> Kp;
+        typedef SPHKernel<SPH_KERNEL_DEFAULT_VISCOSITY,Deriv> Kv;
+        if (parallel)
+            computeForceParallel <Kd, Kp, Kv, Kd> (d_f, d_x, d_v);
+        else
+            computeForce <Kd, Kp, Kv, Kd> (mparams, d_f, d_x, d_v);
         break;
     }
     case 1: // cubic
     {
-        computeForce <SPHKernel<SPH_KERNEL_CUBIC,Deriv>,
-                     SPHKernel<SPH_KERNEL_CUBIC,Deriv>,
-                     SPHKernel<SPH_KERNEL_CUBIC,Deriv>,
-                     SPHKernel<SPH_KERNEL_CUBIC,Deriv> > (mparams, d_f, d_x, d_v);
+        typedef SPHKernel<SPH_KERNEL_CUBIC,Deriv> Kc;
+        if (parallel)
+            computeForceParallel <Kc, Kc, Kc, Kc> (d_f, d_x, d_v);
+        else
+            computeForce <Kc, Kc, Kc, Kc> (mparams, d_f, d_x, d_v);
         break;
     }
     }
@@ -510,6 +521,187 @@ void SPHFluidForceField<DataTypes>::computeForce(const core::MechanicalParams* /
     }
 }
 
+template<class DataTypes>
+void SPHFluidForceField<DataTypes>::computeNeighborsParallel(const VecCoord& x)
+{
+    const Real h = particleRadius.getValue();
+    const Real h2 = h*h;
+    const std::size_t n = x.size();
+    particles.resize(n);
+    if (h <= 0)
+    {
+        for (std::size_t i=0; i<n; i++)
+            particles[i].neighbors.clear();
+        return;
+    }
+
+    // With cells of width h, the neighbors of a particle are in the adjacent cells
+    m_cellGrid.build(x, h);
+    const helper::vector<unsigned int>& sorted = m_cellGrid.getSortedIndices();
+    const std::size_t grainSize = std::max(d_parallelGrainSize.getValue(), 1u);
+
+    simulation::parallelFor(simulation::TaskScheduler::getInstance(), 0, m_cellGrid.getNbCells(), grainSize, [&](std::size_t firstCell, std::size_t lastCell)
+    {
+        std::size_t neighborCells[container::CompactCellGrid<DataTypes>::MAX_NEIGHBOR_CELLS];
+        for (std::size_t cell = firstCell; cell < lastCell; ++cell)
+        {
+            const unsigned int nbNeighborCells = m_cellGrid.getNeighborCells(cell, neighborCells);
+            for (std::size_t k = m_cellGrid.cellBegin(cell); k < m_cellGrid.cellEnd(cell); ++k)
+            {
+                const unsigned int i = sorted[k];
+                const Coord& ri = x[i];
+                sofa::helper::vector< std::pair<int,Real> >& neighbors = particles[i].neighbors;
+                neighbors.clear();
+                for (unsigned int c = 0; c < nbNeighborCells; ++c)
+                {
+                    const std::size_t end = m_cellGrid.cellEnd(neighborCells[c]);
+                    for (std::size_t k2 = m_cellGrid.cellBegin(neighborCells[c]); k2 < end; ++k2)
+                    {
+                        const unsigned int j = sorted[k2];
+                        if (j == i) continue;
+                        Real r2 = (x[j]-ri).norm2();
+                        if (r2 < h2)
+                            neighbors.push_back(std::make_pair((int)j, (Real)sqrt(r2/h2)));
+                    }
+                }
+            }
+        }
+    });
+}
+
+template<class DataTypes> template<class TKd, class TKp, class TKv, class TKc>
+void SPHFluidForceField<DataTypes>::computeForceParallel(DataVecDeriv& d_f, const DataVecCoord& d_x, const DataVecDeriv& d_v)
+{
+    helper::WriteAccessor<DataVecDeriv> f = d_f;
+    helper::ReadAccessor<DataVecCoord> x = d_x;
+    helper::ReadAccessor<DataVecDeriv> v = d_v;
+
+    const Real h = particleRadius.getValue();
+    const Real h2 = h*h;
+    const Real m = particleMass.getValue();
+    const Real m2 = m*m;
+    const Real d0 = density0.getValue();
+    const Real k = pressureStiffness.getValue();
+    const Real time = (Real)this->getContext()->getTime();
+    const Real viscosity = this->viscosity.getValue();
+    const int viscosityT = (viscosity == 0) ? 0 : viscosityType.getValue();
+    const Real surfaceTension = this->surfaceTension.getValue();
+    const int surfaceTensionT = (surfaceTension <= 0) ? 0 : surfaceTensionType.getValue();
+    lastTime = time;
+
+    const std::size_t n = x.size();
+    f.resize(n);
+    dforces.clear();
+    particles.resize(n);
+
+    TKd Kd(h);
+    TKp Kp(h);
+    TKv Kv(h);
+    TKc Kc(h);
+
+    // The particles are visited in the order of the grid for memory locality.
+    // Each particle gathers the contributions of all its neighbors, instead of
+    // scattering them to both particles of a pair as in computeForce.
+    const helper::vector<unsigned int>& sorted = m_cellGrid.getSortedIndices();
+    simulation::TaskScheduler* scheduler = simulation::TaskScheduler::getInstance();
+    const std::size_t grainSize = std::max(d_parallelGrainSize.getValue(), 1u);
+
+    // Compute density and pressure
+    simulation::parallelFor(scheduler, 0, n, grainSize, [&](std::size_t first, std::size_t last)
+    {
+        for (std::size_t s=first; s<last; s++)
+        {
+            Particle& Pi = particles[sorted[s]];
+            Real density = m*Kd.W(0); // density from current particle
+            for (typename std::vector< std::pair<int,Real> >::const_iterator it = Pi.neighbors.begin(); it != Pi.neighbors.end(); ++it)
+                density += m*Kd.W(it->second);
+            Pi.density = density;
+            Pi.pressure = k*(density - d0);
+            Pi.normal.clear();
+            Pi.curvature = 0;
+        }
+    });
+
+    // Compute surface normal and curvature
+    if (surfaceTensionType.getValue() == 1)
+    {
+        simulation::parallelFor(scheduler, 0, n, grainSize, [&](std::size_t first, std::size_t last)
+        {
+            for (std::size_t s=first; s<last; s++)
+            {
+                const int i = sorted[s];
+                Particle& Pi = particles[i];
+                for (typename std::vector< std::pair<int,Real> >::const_iterator it = Pi.neighbors.begin(); it != Pi.neighbors.end(); ++it)
+                {
+                    const int j = it->first;
+                    const Real r_h = it->second;
+                    const Particle& Pj = particles[j];
+                    // same sign convention as computeForce, where the pair is stored by the lowest index
+                    Deriv n = Kc.gradW(x[i]-x[j],r_h) * (m / Pj.density - m / Pi.density);
+                    if (i < j)
+                        Pi.normal += n;
+                    else
+                        Pi.normal -= n;
+                    Pi.curvature += Kc.laplacianW(r_h) * (m / Pj.density - m / Pi.density);
+                }
+            }
+        });
+    }
+
+    // Compute the forces
+    simulation::parallelFor(scheduler, 0, n, grainSize, [&](std::size_t first, std::size_t last)
+    {
+        for (std::size_t s=first; s<last; s++)
+        {
+            const int i = sorted[s];
+            const Particle& Pi = particles[i];
+            Deriv fi;
+
+            for (typename std::vector< std::pair<int,Real> >::const_iterator it = Pi.neighbors.begin(); it != Pi.neighbors.end(); ++it)
+            {
+                const int j = it->first;
+                const Real r_h = it->second;
+                const Particle& Pj = particles[j];
+                // Pressure
+
+                Real pressureFV = ( - m2 * (Pi.pressure / (Pi.density*Pi.density) + Pj.pressure / (Pj.density*Pj.density)) );
+
+                // Viscosity
+                switch(viscosityT)
+                {
+                case 0: break;
+                case 1:
+                {
+                    fi += ( v[j] - v[i] ) * ( m2 * viscosity / (Pi.density * Pj.density) * Kv.laplacianW(r_h) );
+                    break;
+                }
+                case 2:
+                {
+                    Real vx = dot(v[i]-v[j],x[i]-x[j]);
+                    if (vx < 0)
+                    {
+                        pressureFV += (vx * viscosity * h * m / ((r_h*r_h + 0.01f*h2)*(Pi.density+Pj.density)*0.5f));
+                    }
+                    break;
+                }
+                default:
+                    break;
+                }
+
+                fi += Kp.gradW(x[i]-x[j],r_h) * pressureFV;
+            }
+
+            if (surfaceTensionT == 1)
+            {
+                Real n = Pi.normal.norm();
+                if (n > 0.000001)
+                    fi += Pi.normal * ( - m * surfaceTension * Pi.curvature / n );
+            }
+            f[i] += fi;
+        }
+    });
+}
+
 template<class DataTypes>
 void SPHFluidForceField<DataTypes>::addDForce(const core::MechanicalParams* mparams, DataVecDeriv& d_df, const DataVecDeriv& d_dx)
 {
@@ -0,0 +1,181 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/helper/testing/BaseTest.h>
+using sofa::helper::testing::BaseTest ;
+
+#include <SofaSphFluid/CompactCellGrid.h>
+using sofa::component::container::CompactCellGrid ;
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+
+namespace sofa
+{
+namespace component
+{
+namespace container
+{
+namespace _compactcellgrid_
+{
+using sofa::defaulttype::Vec3Types ;
+using sofa::defaulttype::Vector3 ;
+
+struct CompactCellGrid_test : public BaseTest
+{
+    typedef CompactCellGrid<Vec3Types> Grid ;
+    typedef Vec3Types::VecCoord VecCoord ;
+    typedef std::set< std::pair<unsigned int, unsigned int> > PairSet ;
+
+    /// Pairs of particles closer than h, by brute force
+    static PairSet bruteForceNeighbors(const VecCoord& x, SReal h)
+    {
+        PairSet pairs ;
+        for (unsigned int i=0; i<x.size(); ++i)
+            for (unsigned int j=0; j<x.size(); ++j)
+                if (i != j && (x[j]-x[i]).norm2() < h*h)
+                    pairs.insert(std::make_pair(i, j)) ;
+        return pairs ;
+    }
+
+    /// Pairs of particles closer than h, among the particles of the neighbor cells
+    static PairSet gridNeighbors(const Grid& grid, const VecCoord& x, SReal h)
+    {
+        PairSet pairs ;
+        const helper::vector<unsigned int>& sorted = grid.getSortedIndices() ;
+        std::size_t neighborCells[Grid::MAX_NEIGHBOR_CELLS] ;
+        for (std::size_t cell=0; cell<grid.getNbCells(); ++cell)
+        {
+            const unsigned int nbNeighborCells = grid.getNeighborCells(cell, neighborCells) ;
+            for (std::size_t k=grid.cellBegin(cell); k<grid.cellEnd(cell); ++k)
+            {
+                const unsigned int i = sorted[k] ;
+                for (unsigned int c=0; c<nbNeighborCells; ++c)
+                {
+                    for (std::size_t k2=grid.cellBegin(neighborCells[c]); k2<grid.cellEnd(neighborCells[c]); ++k2)
+                    {
+                        const unsigned int j = sorted[k2] ;
+                        if (i != j && (x[j]-x[i]).norm2() < h*h)
+                            pairs.insert(std::make_pair(i, j)) ;
+                    }
+                }
+            }
+        }
+        return pairs ;
+    }
+
+    void checkGrid(const VecCoord& x, SReal h)
+    {
+        Grid grid ;
+        grid.build(x, h) ;
+
+        // each particle is in exactly one cell, and the cells are sorted by key
+        ASSERT_EQ(grid.getNbParticles(), x.size()) ;
+        helper::vector<unsigned int> sorted = grid.getSortedIndices() ;
+        std::sort(sorted.begin(), sorted.end()) ;
+        for (unsigned int i=0; i<sorted.size(); ++i)
+        {
+            ASSERT_EQ(sorted[i], i) ;
+        }
+        EXPECT_EQ(grid.cellBegin(0), 0u) ;
+        EXPECT_EQ(grid.cellEnd(grid.getNbCells()-1), x.size()) ;
+
+        const PairSet expected = bruteForceNeighbors(x, h) ;
+        const PairSet found = gridNeighbors(grid, x, h) ;
+        EXPECT_EQ(expected.size(), found.size()) ;
+        for (PairSet::const_iterator it=expected.begin(); it!=expected.end(); ++it)
+        {
+            EXPECT_TRUE(found.count(*it)) << "pair " << it->first << " " << it->second << " not found" ;
+        }
+    }
+
+    /// Particles on a lattice of step h/2, so that every other particle lies on a cell border,
+    /// with coordinates exactly representable so that the border cases are exact
+    void checkNeighborsOnCellBorders()
+    {
+        const SReal h = 0.25 ;
+        VecCoord x ;
+        for (int i=0; i<6; ++i)
+            for (int j=0; j<5; ++j)
+                for (int k=0; k<4; ++k)
+                    x.push_back(Vector3(-1 + i*h/2, 2 + j*h/2, k*h/2)) ;
+        // particles at exactly h from a lattice particle, in the next cell
+        x.push_back(Vector3(-1 + 6*h/2, 2, 0)) ;
+        x.push_back(Vector3(-1, 2 + 5*h/2, 0)) ;
+        checkGrid(x, h) ;
+    }
+
+    /// Random particles, some of them in the same cells
+    void checkNeighborsOfRandomParticles()
+    {
+        const SReal h = 0.3 ;
+        VecCoord x ;
+        for (int i=0; i<300; ++i)
+            x.push_back(Vector3(std::sin(1.3*i), std::cos(0.7*i), std::sin(0.1*i*i)) * 1.5) ;
+        checkGrid(x, h) ;
+    }
+
+    /// Particles further than 2^KEY_BITS cells from the origin are clamped to the last cells
+    void checkNeighborsOfClampedFarParticles()
+    {
+        const SReal h = 0.25 ;
+        const SReal far = h * (SReal)(((Grid::Key)1) << Grid::KEY_BITS) * 4 ;
+        VecCoord x ;
+        for (int i=0; i<4; ++i)
+            for (int j=0; j<4; ++j)
+                x.push_back(Vector3(i*h/2, j*h/2, 0)) ;
+        // a far cluster, and a far particle alone
+        x.push_back(Vector3(far, far, 0)) ;
+        x.push_back(Vector3(far + h/2, far, 0)) ;
+        x.push_back(Vector3(far, far + h/4, h/4)) ;
+        x.push_back(Vector3(0, far, 2*far)) ;
+        checkGrid(x, h) ;
+
+        Grid grid ;
+        grid.build(x, h) ;
+        // the far cluster is clamped in a single cell, which holds the three particles
+        bool foundClampedCell = false ;
+        for (std::size_t cell=0; cell<grid.getNbCells(); ++cell)
+            foundClampedCell |= (grid.cellEnd(cell) - grid.cellBegin(cell) == 3) ;
+        EXPECT_TRUE(foundClampedCell) ;
+    }
+};
+
+TEST_F(CompactCellGrid_test, checkNeighborsOnCellBorders)
+{
+    this->checkNeighborsOnCellBorders() ;
+}
+
+TEST_F(CompactCellGrid_test, checkNeighborsOfRandomParticles)
+{
+    this->checkNeighborsOfRandomParticles() ;
+}
+
+TEST_F(CompactCellGrid_test, checkNeighborsOfClampedFarParticles)
+{
+    this->checkNeighborsOfClampedFarParticles() ;
+}
+
+} // namespace _compactcellgrid_
+} // namespace container
+} // namespace component
+} // namespace sofa
@@ -0,0 +1,142 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaSphFluid/SPHFluidForceField.h>
+#include <sofa/helper/testing/BaseTest.h>
+using sofa::helper::testing::BaseTest ;
+
+#include <SofaSimulationGraph/DAGSimulation.h>
+using sofa::simulation::Node ;
+using sofa::simulation::graph::DAGSimulation ;
+
+#include <SofaSimulationCommon/SceneLoaderXML.h>
+using sofa::simulation::SceneLoaderXML ;
+using sofa::core::ExecParams ;
+
+#include <sofa/simulation/TaskScheduler.h>
+using sofa::simulation::TaskScheduler ;
+
+#include <cmath>
+
+namespace sofa
+{
+namespace component
+{
+namespace forcefield
+{
+namespace _sphfluidforcefield_
+{
+using sofa::defaulttype::Vec3Types ;
+
+struct SPHFluidForceField_test : public BaseTest
+{
+    typedef SPHFluidForceField<Vec3Types> ForceType ;
+    typedef Vec3Types::VecCoord VecCoord ;
+    typedef Vec3Types::VecDeriv VecDeriv ;
+    typedef Vec3Types::Coord Coord ;
+
+    void SetUp() override
+    {
+        if (simulation::getSimulation() == nullptr)
+            simulation::setSimulation(new DAGSimulation()) ;
+    }
+
+    /// The parallel addForce, using the compact cell grid, must give the same forces as the sequential one
+    void checkParallelForcesMatchSequential(int viscosityType)
+    {
+        std::stringstream scene ;
+        scene << "<?xml version='1.0'?>"
+                 "<Node 	name='Root' dt='0.01'>                     \n"
+                 "  <Node name='fluid'>                                 \n"
+                 "    <MechanicalObject template='Vec3d'/>              \n"
+                 "    <SPHFluidForceField name='sph' radius='0.5' mass='0.1' pressure='100' density='1' "
+                 "                        viscosity='0.5' viscosityType='" << viscosityType << "' "
+                 "                        surfaceTension='2' surfaceTensionType='1' parallelGrainSize='5'/>\n"
+                 "  </Node>                                             \n"
+                 "</Node>                                               \n" ;
+
+        Node::SPtr root = SceneLoaderXML::loadFromMemory ("testscene",
+                                                          scene.str().c_str(),
+                                                          scene.str().size()) ;
+        ASSERT_NE(root.get(), nullptr) ;
+        root->init(ExecParams::defaultInstance()) ;
+
+        ForceType* sph = dynamic_cast<ForceType*>(root->getTreeNode("fluid")->getObject("sph")) ;
+        ASSERT_NE(sph, nullptr) ;
+
+        // a block of particles, a bit more than one radius apart, with some noise on positions and velocities
+        VecCoord x ;
+        VecDeriv v ;
+        for (int i=0; i<6; ++i)
+            for (int j=0; j<5; ++j)
+                for (int k=0; k<4; ++k)
+                {
+                    const int p = (int)x.size() ;
+                    x.push_back(Coord(0.3*i + 0.05*std::sin(1.3*p), 0.3*j + 0.05*std::cos(0.7*p), 0.3*k + 0.05*std::sin(0.1*p*p))) ;
+                    v.push_back(Coord(std::cos(0.9*p), std::sin(0.4*p), std::cos(0.2*p*p))) ;
+                }
+
+        core::objectmodel::Data<VecCoord> dataX ; dataX.setValue(x) ;
+        core::objectmodel::Data<VecDeriv> dataV ; dataV.setValue(v) ;
+        core::MechanicalParams mparams ;
+
+        TaskScheduler* scheduler = TaskScheduler::getInstance() ;
+        scheduler->init(4) ;
+
+        core::objectmodel::Data<VecDeriv> sequentialF, parallelF ;
+        sph->d_parallel.setValue(false) ;
+        sph->addForce(&mparams, sequentialF, dataX, dataV) ;
+
+        sph->d_parallel.setValue(true) ;
+        sph->addForce(&mparams, parallelF, dataX, dataV) ;
+
+        scheduler->stop() ;
+
+        // the contributions of the neighbors are summed in another order
+        ASSERT_EQ(sequentialF.getValue().size(), parallelF.getValue().size()) ;
+        SReal maxForce = 0 ;
+        for (std::size_t i=0; i<x.size(); ++i)
+            maxForce = std::max(maxForce, (SReal)sequentialF.getValue()[i].norm()) ;
+        EXPECT_GT(maxForce, 0) ;
+        for (std::size_t i=0; i<x.size(); ++i)
+        {
+            for (std::size_t j=0; j<3; ++j)
+            {
+                EXPECT_NEAR(sequentialF.getValue()[i][j], parallelF.getValue()[i][j], 1e-10 * maxForce) ;
+            }
+        }
+    }
+};
+
+TEST_F(SPHFluidForceField_test, checkParallelForcesMatchSequentialWithViscosity)
+{
+    this->checkParallelForcesMatchSequential(1) ;
+}
+
+TEST_F(SPHFluidForceField_test, checkParallelForcesMatchSequentialWithArtificialViscosity)
+{
+    this->checkParallelForcesMatchSequential(2) ;
+}
+
+} // namespace _sphfluidforcefield_
+} // namespace forcefield
+} // namespace component
+} // namespace sofa
@@ -41,6 +41,7 @@
 #include <sofa/core/objectmodel/Event.h>
 #include <sofa/core/behavior/MechanicalState.h>
 #include <sofa/helper/rmath.h>
+#include <SofaSphFluid/CompactCellGrid.h>
 #include <list>
 
 
@@ -338,6 +339,7 @@ public:
     Data<bool> d_showGrid; ///< activate rendering of the grid
     Data<bool> d_autoUpdate; ///< Automatically update the grid at each iteration.
     Data<bool> d_sortPoints; ///< Sort points depending on which cell they are in the grid. This is required for efficient collision detection.
+    Data<unsigned int> d_sortPeriod; ///< Number of time steps between two sortings of the points, when sortPoints is true.
 
     /// Pre-construction check method called by ObjectFactory.
     /// Check that DataTypes matches the MechanicalState.
@@ -383,6 +385,9 @@ public:
     }
 protected:
     core::behavior::MechanicalState<DataTypes>* mstate;
+    /// the points are sorted in the Z-order of the cells of this grid
+    CompactCellGrid<DataTypes> m_sortGrid;
+    unsigned int m_stepsSinceSort;
 };
 
 #if  !defined(SOFA_COMPONENT_CONTAINER_SPATIALGRIDCONTAINER_CPP)
@@ -35,6 +35,7 @@
 #define SOFA_COMPONENT_CONTAINER_SPATIALGRIDCONTAINER_INL
 
 #include <SofaSphFluid/SpatialGridContainer.h>
+#include <SofaSphFluid/CompactCellGrid.inl>
 #include <sofa/core/visual/VisualParams.h>
 
 #include <sofa/core/topology/TopologyChange.h>
@@ -679,7 +680,9 @@ SpatialGridContainer<DataTypes>::SpatialGridContainer()
     , d_showGrid(initData(&d_showGrid, false, "showGrid", "activate rendering of the grid"))
     , d_autoUpdate(initData(&d_autoUpdate, false, "autoUpdate", "Automatically update the grid at each iteration."))
     , d_sortPoints(initData(&d_sortPoints, false, "sortPoints", "Sort points depending on which cell they are in the grid. This is required for efficient collision detection."))
+    , d_sortPeriod(initData(&d_sortPeriod, (unsigned int)1, "sortPeriod", "Number of time steps between two sortings of the points, when sortPoints is true. The points are sorted in the Z-order (Morton order) of the cells, which keeps close points close in memory."))
     , mstate(NULL)
+    , m_stepsSinceSort(0)
 {
     this->f_listening.setValue(true);
 }
@@ -712,13 +715,14 @@ void SpatialGridContainer<DataTypes>::reinit()
 template<class DataTypes>
 bool SpatialGridContainer<DataTypes>::sortPoints()
 {
-    if (mstate)
-        updateGrid(mstate->read(core::ConstVecCoordId::position())->getValue());
+    if (!mstate)
+        return false;
 
     msg_info() << "sortPoints(): sorting...";
 
     helper::vector<unsigned int> old2new, new2old;
-    grid->reorderIndices(&old2new, &new2old);
+    m_sortGrid.build(mstate->read(core::ConstVecCoordId::position())->getValue(), d_cellWidth.getValue());
+    m_sortGrid.reorderIndices(&old2new, &new2old);
     // check if the mapping actually changed something
     bool identity = true;
     for (unsigned int i=0; i<old2new.size(); ++i)
@@ -730,6 +734,7 @@ bool SpatialGridContainer<DataTypes>::sortPoints()
     if (identity)
     {
         msg_info() << "sortPoints(): no changes." ;
+        updateGrid(mstate->read(core::ConstVecCoordId::position())->getValue());
         return false;
     }
 
@@ -770,6 +775,7 @@ bool SpatialGridContainer<DataTypes>::sortPoints()
             msg_info() << "sortPoints(): no external object supporting renumbering!";
         }
     }
+    updateGrid(mstate->read(core::ConstVecCoordId::position())->getValue());
     return true;
 }
 template<class DataTypes>
@@ -778,11 +784,12 @@ void SpatialGridContainer<DataTypes>::handleEvent(sofa::core::objectmodel::Event
     if (/* simulation::AnimateBeginEvent* ev = */simulation::AnimateBeginEvent::checkEventType(event))
         //if (simulation::AnimateEndEvent* ev =simulation::AnimateEndEvent::checkEventType(event))
     {
-        if (d_sortPoints.getValue())
+        if (d_sortPoints.getValue() && ++m_stepsSinceSort >= d_sortPeriod.getValue())
         {
+            m_stepsSinceSort = 0;
             sortPoints();
         }
-        else if (d_autoUpdate.getValue())
+        else if (d_sortPoints.getValue() || d_autoUpdate.getValue())
         {
             if (mstate)
                 updateGrid(mstate->read(core::ConstVecCoordId::position())->getValue());
@@ -26,6 +26,7 @@
 #include <sofa/helper/AdvancedTimer.h>
 #include <sofa/core/ObjectFactory.h>
 #include "ConstraintStoreLambdaVisitor.h"
+#include <sofa/simulation/ParallelFor.h>
 #include <algorithm>
 
 namespace sofa
@@ -77,6 +78,10 @@ GenericConstraintSolver::GenericConstraintSolver()
     , d_computeConstraintForces(initData(&d_computeConstraintForces,false,
                                         "computeConstraintForces",
                                         "enable the storage of the constraintForces (default = False)."))
+    , d_parallelColoring(initData(&d_parallelColoring, false, "parallelColoring",
+                                  "Color the constraint groups coupled by the compliance and solve the groups of each color in parallel with the task scheduler (not used with unbuilt)"))
+    , d_coloringGrainSize(initData(&d_coloringGrainSize, (unsigned int)16, "coloringGrainSize",
+                                   "Number of constraint groups solved by each task when parallelColoring is enabled"))
     , current_cp(&m_cpBuffer[0])
     , last_cp(NULL)
 {
@@ -365,6 +370,8 @@ bool GenericConstraintSolver::solveSystem(const core::ConstraintParams * /*cPara
     current_cp->allVerified = allVerified.getValue();
     current_cp->sor = sor.getValue();
     current_cp->unbuilt = unbuilt.getValue();
+    current_cp->parallelColoring = d_parallelColoring.getValue();
+    current_cp->coloringGrainSize = std::max(d_coloringGrainSize.getValue(), 1u);
 
     if (unbuilt.getValue())
     {
@@ -600,13 +607,174 @@ void GenericConstraintProblem::solveTimed(double tol, int maxIt, double timeout)
     double tempTol = tolerance;
     int tempMaxIt = maxIterations;
 
+    bool tempParallelColoring = parallelColoring;
+
     tolerance = tol;
     maxIterations = maxIt;
+    parallelColoring = false; // solveTimed can be called from another thread than the task scheduler
 
     gaussSeidel(timeout);
 
     tolerance = tempTol;
     maxIterations = tempMaxIt;
+    parallelColoring = tempParallelColoring;
+}
+
+void GenericConstraintProblem::buildConstraintColors()
+{
+    double **w = getW();
+
+    groupBegin.clear();
+    lineGroup.resize(dimension);
+    for(int j=0; j<dimension; )
+    {
+        const int nb = constraintsResolutions[j]->getNbLines();
+        for(int l=0; l<nb; l++)
+            lineGroup[j+l] = (int)groupBegin.size();
+        groupBegin.push_back(j);
+        j += nb;
+    }
+    const int nbGroups = (int)groupBegin.size();
+    groupBegin.push_back(dimension);
+
+    // the nonzero columns of the lines of each group are the only forces used to compute its violation
+    groupCouplings.resize(nbGroups);
+    simulation::parallelFor(simulation::TaskScheduler::getInstance(), 0, nbGroups, coloringGrainSize, [&](std::size_t first, std::size_t last)
+    {
+        for(std::size_t g=first; g<last; g++)
+        {
+            std::vector<int>& couplings = groupCouplings[g];
+            couplings.clear();
+            for(int k=0; k<dimension; k++)
+            {
+                for(int l=groupBegin[g]; l<groupBegin[g+1]; l++)
+                {
+                    if(w[l][k] != 0.0)
+                    {
+                        couplings.push_back(k);
+                        break;
+                    }
+                }
+            }
+        }
+    });
+
+    // conflict graph between the groups, made symmetric in case W is not
+    std::vector< std::vector<int> > conflicts(nbGroups);
+    for(int g=0; g<nbGroups; g++)
+    {
+        for(int k : groupCouplings[g])
+        {
+            const int h = lineGroup[k];
+            if(h != g)
+            {
+                conflicts[g].push_back(h);
+                conflicts[h].push_back(g);
+            }
+        }
+    }
+
+    // greedy coloring in the order of the groups: each group takes the first color not used by a conflicting group
+    groupColor.assign(nbGroups, -1);
+    std::vector<int> forbidden;
+    int nbColors = 0;
+    for(int g=0; g<nbGroups; g++)
+    {
+        for(int h : conflicts[g])
+        {
+            if(groupColor[h] >= 0)
+                forbidden[groupColor[h]] = g;
+        }
+        int c = 0;
+        while(c < nbColors && forbidden[c] == g)
+            c++;
+        if(c == nbColors)
+        {
+            forbidden.push_back(-1);
+            nbColors++;
+        }
+        groupColor[g] = c;
+    }
+
+    // groups sorted by color, keeping their order within each color
+    colorBegin.assign(nbColors+1, 0);
+    for(int g=0; g<nbGroups; g++)
+        colorBegin[groupColor[g]+1]++;
+    for(int c=0; c<nbColors; c++)
+        colorBegin[c+1] += colorBegin[c];
+    colorGroups.resize(nbGroups);
+    std::vector<int> colorCount(colorBegin.begin(), colorBegin.end()-1);
+    for(int g=0; g<nbGroups; g++)
+        colorGroups[colorCount[groupColor[g]]++] = g;
+}
+
+double GenericConstraintProblem::solveConstraintGroup(int j, double tol, bool& verified, const std::vector<int>* couplings)
+{
+    double *dfree = getDfree();
+    double *force = getF();
+    double **w = getW();
+    double *d = _d.ptr();
+
+    //1. nbLines provide the dimension of the constraint
+    const int nb = constraintsResolutions[j]->getNbLines();
+
+    //2. for each line we compute the actual value of d
+    //   (a)d is set to dfree
+
+    std::vector<double> errF(&force[j], &force[j+nb]);
+    std::copy_n(&dfree[j], nb, &d[j]);
+
+    //   (b) contribution of forces are added to d
+    if(couplings)
+    {
+        for(int k : *couplings)
+            for(int l=0; l<nb; l++)
+                d[j+l] += w[j+l][k] * force[k];
+    }
+    else
+    {
+        for(int k=0; k<dimension; k++)
+            for(int l=0; l<nb; l++)
+                d[j+l] += w[j+l][k] * force[k];
+    }
+
+    //3. the specific resolution of the constraint(s) is called
+    constraintsResolutions[j]->resolution(j, w, d, force, dfree);
+
+    //4. the error is measured (displacement due to the new resolution (i.e. due to the new force))
+    double contraintError = 0.0;
+    if(nb > 1)
+    {
+        for(int l=0; l<nb; l++)
+        {
+            double lineError = 0.0;
+            for (int m=0; m<nb; m++)
+            {
+                double dofError = w[j+l][j+m] * (force[j+m] - errF[m]);
+                lineError += dofError * dofError;
+            }
+            lineError = sqrt(lineError);
+            if(lineError > tol)
+                verified = false;
+
+            contraintError += lineError;
+        }
+    }
+    else
+    {
+        contraintError = fabs(w[j][j] * (force[j] - errF[0]));
+        if(contraintError > tol)
+            verified = false;
+    }
+
+    if(constraintsResolutions[j]->getTolerance())
+    {
+        if(contraintError > constraintsResolutions[j]->getTolerance())
+            verified = false;
+        contraintError *= tol / constraintsResolutions[j]->getTolerance();
+    }
+
+    return contraintError;
 }
 
 // Debug is only available when called directly by the solver (not in haptic thread)
@@ -622,14 +790,13 @@ void GenericConstraintProblem::gaussSeidel(double timeout, GenericConstraintSolv
     double t0 = (double)sofa::helper::system::thread::CTime::getTime() ;
     double timeScale = 1.0 / (double)sofa::helper::system::thread::CTime::getTicksPerSec();
 
-    double *dfree = getDfree();
     double *force = getF();
     double **w = getW();
     double tol = tolerance;
 
     double *d = _d.ptr();
 
-    int i, j, k, l, nb;
+    int i, j, nb;
 
     double error=0.0;
 
@@ -680,6 +847,17 @@ void GenericConstraintProblem::gaussSeidel(double timeout, GenericConstraintSolv
         tabErrors.resize(dimension);
     }
 
+    // the groups of a same color do not use the forces of each other and are solved in parallel
+    sofa::helper::vector<double> groupErrors;
+    sofa::helper::vector<char> groupVerified;
+    if(parallelColoring)
+    {
+        buildConstraintColors();
+        groupErrors.resize(groupColor.size());
+        groupVerified.resize(groupColor.size());
+    }
+    simulation::TaskScheduler* scheduler = parallelColoring ? simulation::TaskScheduler::getInstance() : nullptr;
+
     for(i=0; i<maxIterations; i++)
     {
         bool constraintsAreVerified = true;
@@ -689,63 +867,46 @@ void GenericConstraintProblem::gaussSeidel(double timeout, GenericConstraintSolv
         }
 
         error=0.0;
-        for(j=0; j<dimension; ) // increment of j realized at the end of the loop
+        if(parallelColoring)
         {
-            //1. nbLines provide the dimension of the constraint
-            nb = constraintsResolutions[j]->getNbLines();
-
-            //2. for each line we compute the actual value of d
-            //   (a)d is set to dfree
-            
-            std::vector<double> errF(&force[j], &force[j+nb]);
-            std::copy_n(&dfree[j], nb, &d[j]);
-
-            //   (b) contribution of forces are added to d     => TODO => optimization (no computation when force= 0 !!)
-            for(k=0; k<dimension; k++)
-                for(l=0; l<nb; l++)
-                    d[j+l] += w[j+l][k] * force[k];
-
-            //3. the specific resolution of the constraint(s) is called
-            constraintsResolutions[j]->resolution(j, w, d, force, dfree);
-
-            //4. the error is measured (displacement due to the new resolution (i.e. due to the new force))
-            double contraintError = 0.0;
-            if(nb > 1)
+            for(std::size_t c=0; c+1<colorBegin.size(); c++)
             {
-                for(l=0; l<nb; l++)
+                simulation::parallelFor(scheduler, colorBegin[c], colorBegin[c+1], coloringGrainSize, [&](std::size_t first, std::size_t last)
                 {
-                    double lineError = 0.0;
-                    for (int m=0; m<nb; m++)
+                    for(std::size_t p=first; p<last; p++)
                     {
-                        double dofError = w[j+l][j+m] * (force[j+m] - errF[m]);
-                        lineError += dofError * dofError;
+                        const int g = colorGroups[p];
+                        bool verified = true;
+                        groupErrors[g] = solveConstraintGroup(groupBegin[g], tol, verified, &groupCouplings[g]);
+                        groupVerified[g] = verified;
                     }
-                    lineError = sqrt(lineError);
-                    if(lineError > tol)
-                        constraintsAreVerified = false;
-
-                    contraintError += lineError;
-                }
-            }
-            else
-            {
-                contraintError = fabs(w[j][j] * (force[j] - errF[0]));
-                if(contraintError > tol)
-                    constraintsAreVerified = false;
+                });
             }
 
-            if(constraintsResolutions[j]->getTolerance())
+            // the errors are summed in the order of the groups, as in the sequential version
+            for(std::size_t g=0; g<groupErrors.size(); g++)
             {
-                if(contraintError > constraintsResolutions[j]->getTolerance())
+                if(!groupVerified[g])
                     constraintsAreVerified = false;
-                contraintError *= tol / constraintsResolutions[j]->getTolerance();
+                error += groupErrors[g];
+                if(solver)
+                    tabErrors[groupBegin[g]] = groupErrors[g];
             }
+        }
+        else
+        {
+            for(j=0; j<dimension; ) // increment of j realized at the end of the loop
+            {
+                nb = constraintsResolutions[j]->getNbLines();
 
-            error += contraintError;
-            if(solver)
-                tabErrors[j] = contraintError;
+                double contraintError = solveConstraintGroup(j, tol, constraintsAreVerified);
 
-            j += nb;
+                error += contraintError;
+                if(solver)
+                    tabErrors[j] = contraintError;
+
+                j += nb;
+            }
         }
 
         if(showGraphs)
@@ -59,10 +59,20 @@ public:
 
     std::vector< ConstraintCorrections > cclist_elems;
 
+    // For colored version :
+    bool parallelColoring;
+    unsigned int coloringGrainSize;
+    std::vector<int> groupBegin; ///< first line of each constraint group, followed by the dimension
+    std::vector<int> lineGroup; ///< constraint group of each line
+    std::vector< std::vector<int> > groupCouplings; ///< lines with a nonzero compliance with the lines of each group
+    std::vector<int> groupColor;
+    std::vector<int> colorGroups; ///< constraint groups sorted by color
+    std::vector<int> colorBegin; ///< first entry of each color in colorGroups, followed by the number of groups
+
 
     GenericConstraintProblem() : scaleTolerance(true), allVerified(false), sor(1.0)
       , sceneTime(0.0), currentError(0.0), currentIterations(0)
-      , change_sequence(false) {}
+      , change_sequence(false), parallelColoring(false), coloringGrainSize(16) {}
     ~GenericConstraintProblem() override { freeConstraintResolutions(); }
 
     void clear(int nbConstraints) override;
@@ -72,6 +82,14 @@ public:
     void gaussSeidel(double timeout=0, GenericConstraintSolver* solver = nullptr);
     void unbuiltGaussSeidel(double timeout=0, GenericConstraintSolver* solver = nullptr);
 
+    /// Color the constraint groups so that the groups of a same color are not coupled by W:
+    /// they can then be solved in parallel within a Gauss-Seidel iteration.
+    void buildConstraintColors();
+
+    /// Solve the constraint group starting at line j with the current forces of the other groups, and return its error.
+    /// If couplings is given, only these columns of W are used to compute the violation.
+    double solveConstraintGroup(int j, double tol, bool& verified, const std::vector<int>* couplings = nullptr);
+
     int getNumConstraints();
     int getNumConstraintGroups();
 };
@@ -123,6 +141,8 @@ public:
     Data<bool> reverseAccumulateOrder; ///< True to accumulate constraints from nodes in reversed order (can be necessary when using multi-mappings or interaction constraints not following the node hierarchy)
     Data<helper::vector< double >> d_constraintForces; ///< OUTPUT: The Data constraintForces is used to provide the intensities of constraint forces in the simulation. The user can easily check the constraint forces from the GenericConstraint component interface.
     Data<bool> d_computeConstraintForces; ///< The indices of the constraintForces to store in the constraintForce data field.
+    Data<bool> d_parallelColoring; ///< Color the constraint groups coupled by the compliance and solve the groups of each color in parallel
+    Data<unsigned int> d_coloringGrainSize; ///< Number of constraint groups solved by each task when parallelColoring is enabled
 
     sofa::core::MultiVecDerivId getLambda() const override;
     sofa::core::MultiVecDerivId getDx() const override;
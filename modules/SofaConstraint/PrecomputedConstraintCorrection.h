@@ -31,6 +31,10 @@
 #include <sofa/defaulttype/Mat.h>
 #include <sofa/defaulttype/Vec.h>
 
+#include <sofa/helper/system/MappedFile.h>
+
+#include <cstdint>
+
 namespace sofa
 {
 
@@ -128,7 +132,8 @@ public:
     {
         Real* data;
         int nbref;
-        InverseStorage() : data(NULL), nbref(0) {}
+        helper::system::MappedFile* mappedFile; ///< file mapped read-only holding data, if loaded from a compliance file with header
+        InverseStorage() : data(NULL), nbref(0), mappedFile(NULL) {}
     };
 
     std::string invName;
@@ -183,10 +188,38 @@ protected:
     bool loadCompliance(std::string fileName);
 
     /**
-     * @brief Save compliance matrix into a file.
+     * @brief Save compliance matrix into a file, with a ComplianceFileHeader.
      */
     void saveCompliance(const std::string& fileName);
 
+    /**
+     * @brief Load the compliance matrix from a file. A file with a ComplianceFileHeader is memory-mapped
+     * read-only, so that its pages are shared by all the processes using it, and is rejected if it does not
+     * match the current model. A file without header is read as the raw matrix.
+     *
+     * @return Loading success.
+     */
+    bool loadComplianceFile(const std::string& filePath);
+
+    /**
+     * @brief Hash of the rest positions and of the parameters of the force fields and masses,
+     * identifying the model for which the compliance is computed.
+     */
+    std::uint64_t computeComplianceHash();
+
+    /// Header of the compliance files, followed by the nbRows * nbCols values of the matrix
+    struct ComplianceFileHeader
+    {
+        char magic[8]; ///< "SOFACOMP"
+        std::uint32_t version;
+        std::uint32_t realSize; ///< sizeof(Real)
+        std::uint64_t nbRows, nbCols;
+        double dt;
+        std::uint64_t hash; ///< computeComplianceHash()
+    };
+
+    std::uint64_t complianceHash;
+
     /**
      * @brief Builds the compliance file name using the SOFA component internal data.
      */
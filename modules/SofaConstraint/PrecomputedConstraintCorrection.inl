@@ -37,6 +37,7 @@
 #include <SofaSimpleFem/TetrahedronFEMForceField.inl>
 
 #include <sofa/core/behavior/RotationFinder.h>
+#include <sofa/core/behavior/BaseForceField.h>
 
 #include <sofa/helper/system/FileRepository.h>
 #include <sofa/helper/Quater.h>
@@ -44,6 +45,9 @@
 #include <SofaConstraint/LMConstraintSolver.h>
 #include <sofa/simulation/Node.h>
 
+#include <chrono>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
 #include <sstream>
 #include <list>
@@ -72,6 +76,7 @@ PrecomputedConstraintCorrection<DataTypes>::PrecomputedConstraintCorrection(sofa
     , invM(NULL)
     , appCompliance(NULL)
     , nbRows(0), nbCols(0), dof_on_node(0), nbNodes(0)
+    , complianceHash(0)
 {
     this->addAlias(&f_fileCompliance, "filePrefix");
 }
@@ -104,7 +109,8 @@ void PrecomputedConstraintCorrection<DataTypes>::releaseInverse(std::string name
     std::map< std::string, InverseStorage >& registry = getInverseMap();
     if (--inv->nbref == 0)
     {
-        if (inv->data) delete[] inv->data;
+        if (inv->mappedFile) delete inv->mappedFile;
+        else if (inv->data) delete[] inv->data;
         registry.erase(name);
     }
 }
@@ -144,35 +150,13 @@ bool PrecomputedConstraintCorrection<DataTypes>::loadCompliance(std::string file
         std::string dir = fileDir.getValue();
         if (!dir.empty())
         {
-            std::ifstream compFileIn((dir + "/" + fileName).c_str(), std::ifstream::binary);
-            if (compFileIn.is_open())
-            {
-                invM->data = new Real[nbRows * nbCols];
-
-                msg_info(this) << "File " << dir + "/" + fileName << " found. Loading..." ;
-
-                compFileIn.read((char*)invM->data, nbCols * nbRows * sizeof(double));
-                compFileIn.close();
-
-                return true;
-            }
-            else
-                return false;
+            return loadComplianceFile(dir + "/" + fileName);
         }
         else if (recompute.getValue() == false)
         {
             if(sofa::helper::system::DataRepository.findFile(fileName))
             {
-                invM->data = new Real[nbRows * nbCols];
-
-                std::ifstream compFileIn(fileName.c_str(), std::ifstream::binary);
-
-                msg_info(this) << "File " << fileName << " found. Loading..." ;
-
-                compFileIn.read((char*)invM->data, nbCols * nbRows * sizeof(double));
-                compFileIn.close();
-
-                return true;
+                return loadComplianceFile(fileName);
             }
         }
 
@@ -196,9 +180,128 @@ void PrecomputedConstraintCorrection<DataTypes>::saveCompliance(const std::strin
     else
         filePathInSofaShare  = sofa::helper::system::DataRepository.getFirstPath() + "/" + fileName;
 
-    std::ofstream compFileOut(filePathInSofaShare.c_str(), std::fstream::out | std::fstream::binary);
-    compFileOut.write((char*)invM->data, nbCols * nbRows * sizeof(double));
+    ComplianceFileHeader header;
+    std::memcpy(header.magic, "SOFACOMP", sizeof(header.magic));
+    header.version = 1;
+    header.realSize = sizeof(Real);
+    header.nbRows = nbRows;
+    header.nbCols = nbCols;
+    header.dt = this->getContext()->getDt();
+    header.hash = complianceHash;
+
+    // the file is written aside then renamed, as other processes may have mapped the previous one
+    std::stringstream tmpPath;
+    tmpPath << filePathInSofaShare << "." << std::chrono::steady_clock::now().time_since_epoch().count() << "." << this << ".tmp";
+
+    std::ofstream compFileOut(tmpPath.str().c_str(), std::fstream::out | std::fstream::binary);
+    compFileOut.write((const char*)&header, sizeof(header));
+    compFileOut.write((const char*)invM->data, nbCols * nbRows * sizeof(Real));
     compFileOut.close();
+
+    if (!compFileOut)
+    {
+        msg_error(this) << "Unable to write the compliance in " << tmpPath.str();
+        std::remove(tmpPath.str().c_str());
+        return;
+    }
+
+    std::remove(filePathInSofaShare.c_str()); // rename does not replace an existing file on Windows
+    if (std::rename(tmpPath.str().c_str(), filePathInSofaShare.c_str()) != 0)
+    {
+        msg_error(this) << "Unable to write the compliance in " << filePathInSofaShare;
+        std::remove(tmpPath.str().c_str());
+    }
+}
+
+
+
+template<class DataTypes>
+bool PrecomputedConstraintCorrection<DataTypes>::loadComplianceFile(const std::string& filePath)
+{
+    helper::system::MappedFile* file = new helper::system::MappedFile;
+    if (!file->open(filePath))
+    {
+        delete file;
+        return false;
+    }
+
+    msg_info(this) << "File " << filePath << " found. Loading..." ;
+
+    const std::size_t dataSize = nbRows * nbCols * sizeof(Real);
+    if (file->size() >= sizeof(ComplianceFileHeader) && std::memcmp(file->data(), "SOFACOMP", 8) == 0)
+    {
+        ComplianceFileHeader header;
+        std::memcpy(&header, file->data(), sizeof(header));
+
+        if (header.version != 1 || header.realSize != sizeof(Real)
+                || header.nbRows != nbRows || header.nbCols != nbCols
+                || header.dt != this->getContext()->getDt() || header.hash != complianceHash
+                || file->size() != sizeof(header) + dataSize)
+        {
+            msg_warning(this) << "Compliance file " << filePath << " does not match the current model, the compliance will be recomputed";
+            delete file;
+            return false;
+        }
+
+        // the matrix is only read once loaded, it is used directly from the shared pages
+        invM->mappedFile = file;
+        invM->data = reinterpret_cast<Real*>(const_cast<char*>(file->data() + sizeof(header)));
+        return true;
+    }
+
+    // file without header, holding only the matrix
+    if (file->size() != dataSize)
+    {
+        msg_warning(this) << "Compliance file " << filePath << " does not have the size of the current model, the compliance will be recomputed";
+        delete file;
+        return false;
+    }
+    invM->data = new Real[nbRows * nbCols];
+    std::memcpy(invM->data, file->data(), dataSize);
+    delete file;
+    return true;
+}
+
+
+
+template<class DataTypes>
+std::uint64_t PrecomputedConstraintCorrection<DataTypes>::computeComplianceHash()
+{
+    // FNV-1a, which gives the same value in all the processes
+    std::uint64_t hash = 14695981039346656037ULL;
+    auto hashBytes = [&hash](const void* bytes, std::size_t size)
+    {
+        const unsigned char* b = static_cast<const unsigned char*>(bytes);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            hash ^= b[i];
+            hash *= 1099511628211ULL;
+        }
+    };
+
+    const VecCoord& x0 = this->mstate->read(core::ConstVecCoordId::restPosition())->getValue();
+    hashBytes(x0.data(), x0.size() * sizeof(Coord));
+
+    // parameters set in the scene for the force fields and masses
+    helper::vector<core::behavior::BaseForceField*> forceFields;
+    this->getContext()->template get<core::behavior::BaseForceField>(&forceFields, core::objectmodel::BaseContext::SearchDown);
+    for (core::behavior::BaseForceField* ff : forceFields)
+    {
+        const std::string className = ff->getClassName();
+        hashBytes(className.data(), className.size());
+
+        for (core::objectmodel::BaseData* data : ff->getDataFields())
+        {
+            const std::string& dataName = data->getName();
+            if (!data->isSet() || dataName == "name" || dataName == "printLog" || dataName == "tags" || dataName == "listening")
+                continue;
+            const std::string value = data->getValueString();
+            hashBytes(dataName.data(), dataName.size());
+            hashBytes(value.data(), value.size());
+        }
+    }
+
+    return hash;
 }
 
 
@@ -226,6 +329,7 @@ void PrecomputedConstraintCorrection<DataTypes>::bwdInit()
     double dt = this->getContext()->getDt();
 
     invName = f_fileCompliance.getFullPath().empty() ? buildFileName() : f_fileCompliance.getFullPath();
+    complianceHash = computeComplianceHash();
 
     if (!loadCompliance(invName))
     {
@@ -25,6 +25,12 @@ using sofa::helper::testing::BaseSimulationTest;
 #include <SofaSimulationGraph/SimpleApi.h>
 using namespace sofa::simpleapi;
 
+#include <SofaConstraint/GenericConstraintSolver.h>
+using sofa::component::constraintset::GenericConstraintProblem;
+
+#include <SofaConstraint/UnilateralInteractionConstraint.h>
+using sofa::component::constraintset::UnilateralConstraintResolution;
+
 namespace
 {
 
@@ -59,6 +65,63 @@ struct GenericConstraintSolver_test : BaseSimulationTest
         ASSERT_NE(solver, nullptr);
         ASSERT_STREQ(solver->findData("constraintForces")->getValueString().c_str(), "");
     }
+
+    /// Unilateral contacts along a chain: each constraint is coupled to its neighbours only
+    void fillChainProblem(GenericConstraintProblem& problem, int n)
+    {
+        problem.clear(n);
+        problem.tolerance = 1e-10;
+        problem.maxIterations = 10000;
+        problem.scaleTolerance = false;
+        double** w = problem.getW();
+        double* dfree = problem.getDfree();
+        for(int i=0; i<n; i++)
+        {
+            for(int j=0; j<n; j++)
+                w[i][j] = 0.0;
+            w[i][i] = 4.0;
+            if(i > 0) w[i][i-1] = -1.0;
+            if(i+1 < n) w[i][i+1] = -1.0;
+            dfree[i] = (i % 3 == 0) ? 0.5 : -1.0 - 0.1 * i;
+            problem.getF()[i] = 0.0;
+            problem.constraintsResolutions[i] = new UnilateralConstraintResolution();
+        }
+    }
+
+    void coloredGaussSeidelMatchesGaussSeidel()
+    {
+        const int n = 50;
+        GenericConstraintProblem sequential, colored;
+        fillChainProblem(sequential, n);
+        fillChainProblem(colored, n);
+        colored.parallelColoring = true;
+        colored.coloringGrainSize = 4;
+
+        sequential.gaussSeidel();
+        colored.gaussSeidel();
+
+        // a chain needs two colors, and the groups of a color must not be coupled
+        ASSERT_EQ(colored.colorBegin.size(), 3u);
+        for(int g=0; g<n; g++)
+        {
+            for(int k : colored.groupCouplings[g])
+            {
+                if(k != g)
+                {
+                    EXPECT_NE(colored.groupColor[g], colored.groupColor[k]);
+                }
+            }
+        }
+
+        EXPECT_LT(sequential.currentError, 1e-10);
+        EXPECT_LT(colored.currentError, 1e-10);
+        EXPECT_GT(colored.currentIterations, 0);
+        for(int i=0; i<n; i++)
+        {
+            EXPECT_NEAR(sequential.getF()[i], colored.getF()[i], 1e-8);
+            EXPECT_GE(colored.getF()[i], 0.0);
+        }
+    }
 };
 
 /// run the tests
@@ -68,12 +131,9 @@ TEST_F(GenericConstraintSolver_test, checkConstraintForce)
     enableConstraintForce();
 }
 
+TEST_F(GenericConstraintSolver_test, coloredGaussSeidelMatchesGaussSeidel)
+{
+    coloredGaussSeidelMatchesGaussSeidel();
+}
 
 } /// namespace sofa
-
-
-
-
-
-
-
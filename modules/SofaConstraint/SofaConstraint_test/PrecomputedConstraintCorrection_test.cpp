@@ -0,0 +1,165 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaSimulationGraph/testing/BaseSimulationTest.h>
+using sofa::helper::testing::BaseSimulationTest;
+
+#include <SofaConstraint/PrecomputedConstraintCorrection.h>
+using sofa::component::constraintset::PrecomputedConstraintCorrection;
+
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+namespace
+{
+
+typedef PrecomputedConstraintCorrection<sofa::defaulttype::Vec3Types> PrecomputedConstraintCorrection3;
+
+/** Test the compliance files written and read by PrecomputedConstraintCorrection */
+struct PrecomputedConstraintCorrection_test : public BaseSimulationTest
+{
+    /// name built by the component from the node name, the number of rows and the time step
+    const std::string complianceFile = "./precomputedBody-9-0.01.comp";
+
+    void SetUp() override
+    {
+        importPlugin("SofaAllCommonComponents");
+        std::remove(complianceFile.c_str());
+    }
+
+    void TearDown() override
+    {
+        std::remove(complianceFile.c_str());
+    }
+
+    static std::string scene(const std::string& positions)
+    {
+        return  "<Node name='root' dt='0.01' gravity='0 0 0'>\n"
+                "   <RequiredPlugin name='SofaAllCommonComponents'/>\n"
+                "   <Node name='precomputedBody'>\n"
+                "       <EulerImplicitSolver rayleighStiffness='0' rayleighMass='0'/>\n"
+                "       <CGLinearSolver iterations='100' tolerance='1e-10' threshold='1e-10'/>\n"
+                "       <MechanicalObject position='" + positions + "'/>\n"
+                "       <UniformMass totalMass='3'/>\n"
+                "       <PrecomputedConstraintCorrection name='correction' fileDir='.'/>\n"
+                "   </Node>\n"
+                "</Node>\n";
+    }
+
+    /// Load and init the scene, then return the compliance matrix and whether it was mapped from a file
+    std::vector<double> initCompliance(const std::string& positions, bool& mapped)
+    {
+        SceneInstance sceneinstance("xml", scene(positions));
+        sceneinstance.initScene();
+
+        PrecomputedConstraintCorrection3* correction = nullptr;
+        sceneinstance.root->get(correction, sofa::core::objectmodel::BaseContext::SearchDown);
+        if (correction == nullptr || correction->invM == nullptr || correction->invM->data == nullptr)
+        {
+            ADD_FAILURE() << "The compliance was not built";
+            return std::vector<double>();
+        }
+        mapped = correction->invM->mappedFile != nullptr;
+        const std::size_t size = correction->nbRows * correction->nbCols;
+        return std::vector<double>(correction->invM->data, correction->invM->data + size);
+    }
+
+    static void writeFile(const std::string& filename, const char* bytes, std::size_t size)
+    {
+        std::ofstream out(filename.c_str(), std::ios::binary);
+        out.write(bytes, size);
+    }
+
+    static std::vector<char> readFile(const std::string& filename)
+    {
+        std::ifstream in(filename.c_str(), std::ios::binary);
+        return std::vector<char>((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    }
+};
+
+const std::string positions = "0 0 0  1 0 0  0 1 0";
+
+/// the compliance computed at the first init is saved, then mapped by the next one
+TEST_F(PrecomputedConstraintCorrection_test, saveThenLoad)
+{
+    bool mapped = true;
+    const std::vector<double> computed = initCompliance(positions, mapped);
+    EXPECT_FALSE(mapped);
+    ASSERT_EQ(computed.size(), 81u);
+    EXPECT_NE(computed[0], 0.0);
+
+    const std::vector<double> loaded = initCompliance(positions, mapped);
+    EXPECT_TRUE(mapped);
+    EXPECT_EQ(loaded, computed);
+}
+
+/// a file computed for other rest positions is rejected and replaced
+TEST_F(PrecomputedConstraintCorrection_test, changedModelIsRecomputed)
+{
+    bool mapped = true;
+    initCompliance(positions, mapped);
+    ASSERT_FALSE(mapped);
+
+    const std::vector<char> previousFile = readFile(complianceFile);
+    initCompliance("0 0 0  2 0 0  0 2 0", mapped);
+    EXPECT_FALSE(mapped);
+    EXPECT_NE(readFile(complianceFile), previousFile);
+
+    initCompliance("0 0 0  2 0 0  0 2 0", mapped);
+    EXPECT_TRUE(mapped);
+}
+
+/// a file with a header whose matrix is truncated is rejected
+TEST_F(PrecomputedConstraintCorrection_test, truncatedFileIsRecomputed)
+{
+    bool mapped = true;
+    const std::vector<double> computed = initCompliance(positions, mapped);
+    ASSERT_FALSE(mapped);
+
+    const std::vector<char> file = readFile(complianceFile);
+    writeFile(complianceFile, file.data(), file.size() - sizeof(double));
+
+    const std::vector<double> recomputed = initCompliance(positions, mapped);
+    EXPECT_FALSE(mapped);
+    EXPECT_EQ(recomputed, computed);
+}
+
+/// a file without header is read as the raw matrix if it has the size of the model, and rejected otherwise
+TEST_F(PrecomputedConstraintCorrection_test, headerlessFile)
+{
+    bool mapped = true;
+    const std::vector<double> computed = initCompliance(positions, mapped);
+    ASSERT_EQ(computed.size(), 81u);
+
+    const std::vector<double> raw(computed.size(), 42.0);
+    writeFile(complianceFile, (const char*)raw.data(), raw.size() * sizeof(double));
+    EXPECT_EQ(initCompliance(positions, mapped), raw);
+    EXPECT_FALSE(mapped);
+
+    writeFile(complianceFile, (const char*)raw.data(), (raw.size() - 1) * sizeof(double));
+    {
+        EXPECT_MSG_EMIT(Warning);
+        EXPECT_EQ(initCompliance(positions, mapped), computed);
+    }
+}
+
+}
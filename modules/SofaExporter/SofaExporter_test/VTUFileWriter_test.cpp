@@ -0,0 +1,161 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaExporter/VTUFileWriter.h>
+using sofa::component::misc::VTUFileData;
+using sofa::component::misc::VTUBackgroundWriter;
+using sofa::component::misc::writeVTUFile;
+
+#include <sofa/helper/testing/BaseTest.h>
+using sofa::helper::testing::BaseTest;
+
+#ifdef SOFA_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace
+{
+
+template<class T>
+VTUFileData::Array makeArray(const std::string& name, const std::string& type, unsigned int nbComponents, const std::vector<T>& values)
+{
+    VTUFileData::Array array;
+    array.name = name;
+    array.type = type;
+    array.nbComponents = nbComponents;
+    array.bytes.resize(values.size()*sizeof(T));
+    std::memcpy(array.bytes.data(), values.data(), array.bytes.size());
+    return array;
+}
+
+class VTUFileWriter_test : public BaseTest
+{
+public:
+    std::vector<std::string> m_files;
+
+    void TearDown() override
+    {
+        for (const std::string& f : m_files)
+            std::remove(f.c_str());
+    }
+
+    /// Two triangles with a scalar point field
+    VTUFileData makeData(const std::string& filename, float shift)
+    {
+        VTUFileData data;
+        data.filename = filename;
+        data.nbPoints = 4;
+        data.nbCells = 2;
+        data.points = makeArray<float>("Points", "Float32", 3, {shift,0,0, 1,0,0, 1,1,0, 0,1,0});
+        data.connectivity = makeArray<std::int32_t>("connectivity", "Int32", 1, {0,1,2, 0,2,3});
+        data.offsets = makeArray<std::int32_t>("offsets", "Int32", 1, {3, 6});
+        data.types = makeArray<std::uint8_t>("types", "UInt8", 1, {5, 5});
+        data.pointData.push_back(makeArray<double>("temperature", "Float64", 1, {1.0, 2.0, 3.0, shift}));
+        m_files.push_back(filename);
+        return data;
+    }
+
+    /// Decode the appended block of the DataArray with the given name
+    std::vector<char> readArray(const std::string& filename, const std::string& name)
+    {
+        std::ifstream in(filename.c_str(), std::ios::binary);
+        const std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+        const std::size_t appended = content.find("<AppendedData encoding=\"raw\">");
+        const std::size_t start = content.find('_', appended) + 1;
+        std::size_t pos = content.find("Name=\"" + name + "\"");
+        EXPECT_LT(pos, appended);
+        pos = content.find("offset=\"", pos) + 8;
+        const std::uint64_t offset = std::stoull(content.substr(pos, content.find('"', pos) - pos));
+        const char* block = content.data() + start + offset;
+
+        std::vector<char> bytes;
+        if (content.find("compressor=\"vtkZLibDataCompressor\"") == std::string::npos)
+        {
+            std::uint64_t size;
+            std::memcpy(&size, block, sizeof(size));
+            bytes.assign(block + sizeof(size), block + sizeof(size) + size);
+        }
+#ifdef SOFA_HAVE_ZLIB
+        else
+        {
+            std::uint64_t header[4];
+            std::memcpy(header, block, sizeof(header));
+            EXPECT_EQ(1u, header[0]);
+            bytes.resize(header[1]);
+            uLongf size = uLongf(header[1]);
+            EXPECT_EQ(Z_OK, uncompress(reinterpret_cast<Bytef*>(bytes.data()), &size,
+                                       reinterpret_cast<const Bytef*>(block + sizeof(header)), uLong(header[3])));
+        }
+#endif
+        return bytes;
+    }
+
+    void checkFile(const VTUFileData& expected)
+    {
+        EXPECT_EQ(expected.points.bytes, readArray(expected.filename, "Points"));
+        EXPECT_EQ(expected.connectivity.bytes, readArray(expected.filename, "connectivity"));
+        EXPECT_EQ(expected.offsets.bytes, readArray(expected.filename, "offsets"));
+        EXPECT_EQ(expected.types.bytes, readArray(expected.filename, "types"));
+        EXPECT_EQ(expected.pointData[0].bytes, readArray(expected.filename, "temperature"));
+    }
+};
+
+TEST_F(VTUFileWriter_test, writeRawAppendedData)
+{
+    VTUFileData data = makeData("VTUFileWriter_test_raw.vtu", 0.5f);
+    ASSERT_TRUE(writeVTUFile(data, 0));
+    checkFile(data);
+}
+
+#ifdef SOFA_HAVE_ZLIB
+TEST_F(VTUFileWriter_test, writeCompressedAppendedData)
+{
+    VTUFileData data = makeData("VTUFileWriter_test_zlib.vtu", 0.5f);
+    ASSERT_TRUE(writeVTUFile(data, 6));
+    checkFile(data);
+}
+#endif
+
+TEST_F(VTUFileWriter_test, writeInBackground)
+{
+    std::vector<VTUFileData> expected;
+    {
+        VTUBackgroundWriter writer(0);
+        for (int i = 0; i < 10; ++i)
+        {
+            VTUFileData data = makeData("VTUFileWriter_test_async" + std::to_string(i) + ".vtu", float(i));
+            expected.push_back(data);
+            writer.submit(data);
+        }
+        writer.flush();
+    }
+    for (const VTUFileData& data : expected)
+        checkFile(data);
+}
+
+}
@@ -34,6 +34,7 @@
 #include <SofaBaseMechanics/MechanicalObject.h>
 #include <SofaBaseMechanics/UniformMass.h>
 #include <SofaExporter/WriteState.h>
+#include <SofaGeneralLoader/ReadState.h>
 
 namespace sofa {
 
@@ -61,6 +62,8 @@ namespace sofa {
         simulation::Simulation* simulation=nullptr;
         /// MechanicalObject
         typename MechanicalObject::SPtr mecaObj=NULL;
+        /// WriteState
+        sofa::component::misc::WriteState::SPtr writeState=NULL;
         /// Time step
         double timeStep=0.01;
         /// Gravity
@@ -105,7 +108,7 @@ namespace sofa {
             mass->setTotalMass(1.0);
             childNode->addObject(mass);
 
-            sofa::component::misc::WriteState::SPtr writeState =New<sofa::component::misc::WriteState>();
+            writeState = New<sofa::component::misc::WriteState>();
             helper::vector<double> time;
             time.resize(1);
             time[0] = 0.0;
@@ -216,6 +219,55 @@ namespace sofa {
         }
 
 
+        /// Write the positions and velocities in a binary file, then replay them with ReadState
+        bool binary_round_trip_test()
+        {
+            const std::string filename = std::string(SOFAEXPORTER_BUILD_DIR)+"particleGravityXV.bin";
+            writeState->d_filename.setValue(filename);
+            writeState->d_binary.setValue(true);
+            writeState->d_writeX.setValue(true);
+            writeState->d_writeV.setValue(true);
+            initScene();
+
+            // WriteState exports the state at the beginning of each step
+            std::vector<VecCoord> positions;
+            std::vector<VecDeriv> velocities;
+            for(int i=0; i<7; i++)
+            {
+                positions.push_back(mecaObj->x.getValue());
+                velocities.push_back(mecaObj->v.getValue());
+                sofa::simulation::getSimulation()->animate(root.get(),timeStep);
+            }
+
+            // the time index is written when the writer is destroyed
+            sofa::simulation::getSimulation()->unload(root);
+            root.reset();
+            writeState.reset();
+            mecaObj.reset();
+
+            // no solver: the state only changes when ReadState applies a chunk
+            root = simulation::getSimulation()->createNewGraph("root");
+            root->setGravity(Coord(0.0,0.0,0.0));
+            root->setDt(timeStep);
+            simulation::Node::SPtr childNode = root->createChild("Particle");
+            mecaObj = New<MechanicalObject>();
+            mecaObj->resize(1);
+            childNode->addObject(mecaObj);
+            sofa::component::misc::ReadState::SPtr readState = New<sofa::component::misc::ReadState>();
+            readState->d_filename.setValue(filename);
+            childNode->addObject(readState);
+            initScene();
+
+            for(int i=0; i<7; i++)
+            {
+                sofa::simulation::getSimulation()->animate(root.get(),timeStep);
+                EXPECT_EQ(mecaObj->x.getValue().size(), positions[i].size());
+                EXPECT_EQ(mecaObj->x.getValue()[0], positions[i][0]) << "step " << i;
+                EXPECT_EQ(mecaObj->v.getValue()[0], velocities[i][0]) << "step " << i;
+            }
+            return true;
+        }
+
         /// Unload the scene
         void TearDown()
         {
@@ -256,4 +308,14 @@ namespace sofa {
         ASSERT_TRUE( this->test_export(false) );
         this->TearDown();
     }
+
+    // Test 3 : write positions and velocities in a binary file and read them back with ReadState
+    TYPED_TEST( WriteState_test , test_binary_round_trip)
+    {
+        this->SetUp();
+        this->createScene(true);
+
+        ASSERT_TRUE( this->binary_round_trip_test() );
+        this->TearDown();
+    }
 }
@@ -28,6 +28,8 @@
 
 #include "VTKExporter.h"
 
+#include <cstdint>
+#include <cstring>
 #include <sstream>
 
 #include <sofa/core/ObjectFactory.h>
@@ -67,6 +69,10 @@ VTKExporter::VTKExporter()
     , exportAtBegin( initData(&exportAtBegin, false, "exportAtBegin", "export file at the initialization"))
     , exportAtEnd( initData(&exportAtEnd, false, "exportAtEnd", "export file when the simulation is finished"))
     , overwrite( initData(&overwrite, false, "overwrite", "overwrite the file, otherwise create a new file at each export, with suffix in the filename"))
+    , d_binary( initData(&d_binary, false, "binary", "write the XML file with raw binary arrays in an appended section"))
+    , d_compressionLevel( initData(&d_compressionLevel, 0, "compressionLevel", "zlib compression level of the binary arrays (0 to disable)"))
+    , d_asynchronous( initData(&d_asynchronous, false, "asynchronous", "write the binary XML files on a background thread, from a snapshot of the positions and data fields"))
+    , m_backgroundWriter(nullptr)
 {
 }
 
@@ -74,6 +80,8 @@ VTKExporter::~VTKExporter()
 {
     if (outfile)
         delete outfile;
+    // waits for the pending files to be written
+    delete m_backgroundWriter;
 }
 
 void VTKExporter::init()
@@ -110,6 +118,15 @@ void VTKExporter::init()
         fetchDataFields(cellsData, cellsDataObject, cellsDataField, cellsDataName);
     }
 
+    delete m_backgroundWriter;
+    m_backgroundWriter = nullptr;
+    if (d_asynchronous.getValue())
+    {
+        if (d_binary.getValue() && fileFormat.getValue())
+            m_backgroundWriter = new VTUBackgroundWriter(d_compressionLevel.getValue());
+        else
+            msg_warning() << "asynchronous export is only available with XMLformat and binary, files will be written synchronously";
+    }
 }
 
 void VTKExporter::fetchDataFields(const helper::vector<std::string>& strData, helper::vector<std::string>& objects, helper::vector<std::string>& fields, helper::vector<std::string>& names)
@@ -564,6 +581,13 @@ void VTKExporter::writeVTKXML()
         filename += ".vtu";
     }
 
+    if (d_binary.getValue())
+    {
+        writeVTKXMLBinary(filename);
+        ++nbFiles;
+        return;
+    }
+
     outfile = new std::ofstream(filename.c_str());
     if( !outfile->is_open() )
     {
@@ -762,6 +786,165 @@ void VTKExporter::writeVTKXML()
     msg_info() << "Export VTK XML in file " << filename << "  done.";
 }
 
+namespace
+{
+
+/// Copy the values of a vector Data into a VTU array, if the Data has the given type
+template<class T>
+bool copyDataArray(core::objectmodel::BaseData* field, const char* type, unsigned int nbComponents, VTUFileData::Array& array)
+{
+    const Data< helper::vector<T> >* data = dynamic_cast<const Data< helper::vector<T> >*>(field);
+    if (!data)
+        return false;
+    const helper::vector<T>& values = data->getValue();
+    array.type = type;
+    array.nbComponents = nbComponents;
+    array.bytes.resize(values.size()*sizeof(T));
+    if (!values.empty())
+        std::memcpy(array.bytes.data(), values.data(), array.bytes.size());
+    return true;
+}
+
+template<class T>
+void appendValue(std::vector<char>& bytes, const T& value)
+{
+    const std::size_t size = bytes.size();
+    bytes.resize(size + sizeof(T));
+    std::memcpy(bytes.data() + size, &value, sizeof(T));
+}
+
+template<class Elements>
+void appendCells(const Elements& elements, std::uint8_t cellType, VTUFileData& data, std::int32_t& offset)
+{
+    for (std::size_t i = 0; i < elements.size(); ++i)
+    {
+        for (std::size_t j = 0; j < elements[i].size(); ++j)
+            appendValue(data.connectivity.bytes, std::int32_t(elements[i][j]));
+        offset += std::int32_t(elements[i].size());
+        appendValue(data.offsets.bytes, offset);
+        appendValue(data.types.bytes, cellType);
+    }
+}
+
+} // anonymous namespace
+
+void VTKExporter::copyDataArrays(const helper::vector<std::string>& objects, const helper::vector<std::string>& fields, const helper::vector<std::string>& names, std::vector<VTUFileData::Array>& arrays)
+{
+    sofa::core::objectmodel::BaseContext* context = this->getContext();
+
+    arrays.resize(objects.size());
+    std::size_t nbArrays = 0;
+    for (unsigned int i=0 ; i<objects.size() ; i++)
+    {
+        core::objectmodel::BaseObject* obj = context->get<core::objectmodel::BaseObject> (objects[i]);
+        core::objectmodel::BaseData* field = obj ? obj->findData(fields[i]) : nullptr;
+        if (!field)
+        {
+            msg_error() << "VTKExporter : error while fetching data field '" << fields[i] << "' of object '" << objects[i] << "'";
+            continue;
+        }
+
+        // same types as writeDataArray
+        VTUFileData::Array& array = arrays[nbArrays];
+        if (copyDataArray<int>(field, "Int32", 1, array)
+                || copyDataArray<unsigned int>(field, "UInt32", 1, array)
+                || copyDataArray<float>(field, "Float32", 1, array)
+                || copyDataArray<double>(field, "Float64", 1, array)
+                || copyDataArray<defaulttype::Vec1f>(field, "Float32", 1, array)
+                || copyDataArray<defaulttype::Vec1d>(field, "Float64", 1, array)
+                || copyDataArray<defaulttype::Vec2f>(field, "Float32", 2, array)
+                || copyDataArray<defaulttype::Vec2d>(field, "Float64", 2, array)
+                || copyDataArray<defaulttype::Vec3f>(field, "Float32", 3, array)
+                || copyDataArray<defaulttype::Vec3d>(field, "Float64", 3, array))
+        {
+            array.name = names[i];
+            ++nbArrays;
+        }
+        else
+        {
+            msg_error() << "VTKExporter : unsupported type for binary export of data field '" << fields[i] << "' of object '" << objects[i] << "'";
+        }
+    }
+    arrays.resize(nbArrays);
+}
+
+void VTKExporter::writeVTKXMLBinary(const std::string& filename)
+{
+    VTUFileData& data = m_vtuData;
+    data.filename = filename;
+
+    copyDataArrays(pointsDataObject, pointsDataField, pointsDataName, data.pointData);
+    copyDataArrays(cellsDataObject, cellsDataField, cellsDataName, data.cellData);
+
+    // points, as Float32 like the ascii export
+    helper::ReadAccessor<Data<defaulttype::Vec3Types::VecCoord> > pointsPos = position;
+    const size_t nbp = (!pointsPos.empty()) ? pointsPos.size() : topology->getNbPoints();
+    data.nbPoints = nbp;
+    data.points.name = "Points";
+    data.points.type = "Float32";
+    data.points.nbComponents = 3;
+    data.points.bytes.resize(3*nbp*sizeof(float));
+    float* p = reinterpret_cast<float*>(data.points.bytes.data());
+    if (!pointsPos.empty())
+    {
+        for (size_t i = 0; i < nbp; i++)
+            for (unsigned int c = 0; c < 3; ++c)
+                *p++ = float(pointsPos[i][c]);
+    }
+    else if (mstate && mstate->getSize() == nbp)
+    {
+        for (size_t i = 0; i < nbp; i++)
+        {
+            *p++ = float(mstate->getPX(i));
+            *p++ = float(mstate->getPY(i));
+            *p++ = float(mstate->getPZ(i));
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < nbp; i++)
+        {
+            *p++ = float(topology->getPX(i));
+            *p++ = float(topology->getPY(i));
+            *p++ = float(topology->getPZ(i));
+        }
+    }
+
+    // cells
+    data.connectivity.name = "connectivity";
+    data.connectivity.type = "Int32";
+    data.connectivity.bytes.clear();
+    data.offsets.name = "offsets";
+    data.offsets.type = "Int32";
+    data.offsets.bytes.clear();
+    data.types.name = "types";
+    data.types.type = "UInt8";
+    data.types.bytes.clear();
+    std::int32_t offset = 0;
+    if (writeEdges.getValue())
+        appendCells(topology->getEdges(), 3, data, offset);
+    if (writeTriangles.getValue())
+        appendCells(topology->getTriangles(), 5, data, offset);
+    if (writeQuads.getValue())
+        appendCells(topology->getQuads(), 9, data, offset);
+    if (writeTetras.getValue())
+        appendCells(topology->getTetrahedra(), 10, data, offset);
+    if (writeHexas.getValue())
+        appendCells(topology->getHexahedra(), 12, data, offset);
+    data.nbCells = data.types.bytes.size();
+
+    if (m_backgroundWriter)
+    {
+        // m_vtuData gets back an already written snapshot, whose memory is reused next time
+        m_backgroundWriter->submit(data);
+        msg_info() << "Export VTK XML in file " << filename << " queued.";
+    }
+    else if (writeVTUFile(data, d_compressionLevel.getValue()))
+    {
+        msg_info() << "Export VTK XML in file " << filename << "  done.";
+    }
+}
+
 void VTKExporter::writeParallelFile()
 {
     std::string filename = vtkFilename.getFullPath();
@@ -998,6 +1181,8 @@ void VTKExporter::cleanup()
 {
     if (exportAtEnd.getValue())
         (fileFormat.getValue()) ? writeVTKXML() : writeVTKSimple();
+    if (m_backgroundWriter)
+        m_backgroundWriter->flush();
 
 }
 
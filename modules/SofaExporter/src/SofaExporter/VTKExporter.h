@@ -35,6 +35,7 @@
 #include <sofa/core/objectmodel/DataFileName.h>
 #include <sofa/core/topology/BaseMeshTopology.h>
 #include <sofa/core/behavior/BaseMechanicalState.h>
+#include <SofaExporter/VTUFileWriter.h>
 
 #include <fstream>
 
@@ -65,6 +66,10 @@ protected:
     void writeParallelFile();
     void writeData(const helper::vector<std::string>& objects, const helper::vector<std::string>& fields, const helper::vector<std::string>& names);
     void writeDataArray(const helper::vector<std::string>& objects, const helper::vector<std::string>& fields, const helper::vector<std::string>& names);
+    /// Write the XML file with binary appended arrays, possibly on the background writer thread
+    void writeVTKXMLBinary(const std::string& filename);
+    /// Copy the given data fields into the arrays of a VTU snapshot
+    void copyDataArrays(const helper::vector<std::string>& objects, const helper::vector<std::string>& fields, const helper::vector<std::string>& names, std::vector<VTUFileData::Array>& arrays);
     std::string segmentString(std::string str, unsigned int n);
 
 public:
@@ -82,6 +87,9 @@ public:
     Data<bool> exportAtBegin; ///< export file at the initialization
     Data<bool> exportAtEnd; ///< export file when the simulation is finished
     Data<bool> overwrite; ///< overwrite the file, otherwise create a new file at each export, with suffix in the filename
+    Data<bool> d_binary; ///< write the XML file with raw binary arrays in an appended section
+    Data<int> d_compressionLevel; ///< zlib compression level of the binary arrays (0 to disable)
+    Data<bool> d_asynchronous; ///< write the binary XML files on a background thread
 
     int nbFiles;
 
@@ -93,6 +101,9 @@ public:
     helper::vector<std::string> cellsDataField;
     helper::vector<std::string> cellsDataName;
 protected:
+    VTUFileData m_vtuData;
+    VTUBackgroundWriter* m_backgroundWriter;
+
     VTKExporter();
     ~VTKExporter() override;
 public:
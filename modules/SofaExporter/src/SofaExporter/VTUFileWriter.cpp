@@ -0,0 +1,246 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include "VTUFileWriter.h"
+
+#include <sofa/helper/logging/Messaging.h>
+
+#ifdef SOFA_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace misc
+{
+
+void VTUFileData::swap(VTUFileData& other)
+{
+    filename.swap(other.filename);
+    std::swap(nbPoints, other.nbPoints);
+    std::swap(nbCells, other.nbCells);
+    pointData.swap(other.pointData);
+    cellData.swap(other.cellData);
+    std::swap(points, other.points);
+    std::swap(connectivity, other.connectivity);
+    std::swap(offsets, other.offsets);
+    std::swap(types, other.types);
+}
+
+namespace
+{
+
+/// Encode an array as a block of the appended section: a UInt64 header giving the byte
+/// count, or the vtkZLibDataCompressor header followed by a single compressed block.
+void encodeBlock(const std::vector<char>& bytes, int compressionLevel, std::vector<char>& block)
+{
+    block.clear();
+#ifdef SOFA_HAVE_ZLIB
+    if (compressionLevel > 0)
+    {
+        uLongf compressedSize = compressBound(uLong(bytes.size()));
+        block.resize(4*sizeof(std::uint64_t) + compressedSize);
+        if (!bytes.empty())
+        {
+            compress2(reinterpret_cast<Bytef*>(block.data() + 4*sizeof(std::uint64_t)), &compressedSize,
+                      reinterpret_cast<const Bytef*>(bytes.data()), uLong(bytes.size()), compressionLevel);
+        }
+        else
+        {
+            compressedSize = 0;
+        }
+        // number of blocks, block size, last block size, compressed size of each block
+        const std::uint64_t header[4] = { bytes.empty() ? 0u : 1u, bytes.size(), bytes.size(), compressedSize };
+        std::memcpy(block.data(), header, sizeof(header));
+        block.resize(bytes.empty() ? 3*sizeof(std::uint64_t) : sizeof(header) + compressedSize);
+        return;
+    }
+#else
+    (void)compressionLevel;
+#endif
+    const std::uint64_t size = bytes.size();
+    block.resize(sizeof(size) + bytes.size());
+    std::memcpy(block.data(), &size, sizeof(size));
+    if (!bytes.empty())
+        std::memcpy(block.data() + sizeof(size), bytes.data(), bytes.size());
+}
+
+bool isLittleEndian()
+{
+    const std::uint16_t one = 1;
+    return *reinterpret_cast<const char*>(&one) == 1;
+}
+
+} // anonymous namespace
+
+bool writeVTUFile(const VTUFileData& data, int compressionLevel)
+{
+#ifndef SOFA_HAVE_ZLIB
+    compressionLevel = 0;
+#endif
+    std::ofstream file(data.filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        msg_error("VTKExporter") << "Error creating file " << data.filename;
+        return false;
+    }
+
+    // encode the blocks first to know their offsets in the appended section
+    std::vector<const VTUFileData::Array*> arrays;
+    for (const VTUFileData::Array& a : data.pointData) arrays.push_back(&a);
+    for (const VTUFileData::Array& a : data.cellData) arrays.push_back(&a);
+    arrays.push_back(&data.points);
+    arrays.push_back(&data.connectivity);
+    arrays.push_back(&data.offsets);
+    arrays.push_back(&data.types);
+
+    std::vector< std::vector<char> > blocks(arrays.size());
+    std::vector<std::uint64_t> offsets(arrays.size());
+    std::uint64_t offset = 0;
+    for (std::size_t i = 0; i < arrays.size(); ++i)
+    {
+        encodeBlock(arrays[i]->bytes, compressionLevel, blocks[i]);
+        offsets[i] = offset;
+        offset += blocks[i].size();
+    }
+
+    std::size_t index = 0;
+    auto writeArray = [&](const VTUFileData::Array& a)
+    {
+        file << "        <DataArray type=\"" << a.type << "\"";
+        if (!a.name.empty())
+            file << " Name=\"" << a.name << "\"";
+        if (a.nbComponents > 1)
+            file << " NumberOfComponents=\"" << a.nbComponents << "\"";
+        file << " format=\"appended\" offset=\"" << offsets[index++] << "\"/>\n";
+    };
+
+    file << "<?xml version=\"1.0\"?>\n";
+    file << "<VTKFile type=\"UnstructuredGrid\" version=\"1.0\" byte_order=\""
+         << (isLittleEndian() ? "LittleEndian" : "BigEndian") << "\" header_type=\"UInt64\"";
+    if (compressionLevel > 0)
+        file << " compressor=\"vtkZLibDataCompressor\"";
+    file << ">\n";
+    file << "  <UnstructuredGrid>\n";
+    file << "    <Piece NumberOfPoints=\"" << data.nbPoints << "\" NumberOfCells=\"" << data.nbCells << "\">\n";
+    if (!data.pointData.empty())
+    {
+        file << "      <PointData>\n";
+        for (const VTUFileData::Array& a : data.pointData) writeArray(a);
+        file << "      </PointData>\n";
+    }
+    if (!data.cellData.empty())
+    {
+        file << "      <CellData>\n";
+        for (const VTUFileData::Array& a : data.cellData) writeArray(a);
+        file << "      </CellData>\n";
+    }
+    file << "      <Points>\n";
+    writeArray(data.points);
+    file << "      </Points>\n";
+    file << "      <Cells>\n";
+    writeArray(data.connectivity);
+    writeArray(data.offsets);
+    writeArray(data.types);
+    file << "      </Cells>\n";
+    file << "    </Piece>\n";
+    file << "  </UnstructuredGrid>\n";
+    file << "  <AppendedData encoding=\"raw\">\n   _";
+    for (const std::vector<char>& block : blocks)
+        file.write(block.data(), std::streamsize(block.size()));
+    file << "\n  </AppendedData>\n";
+    file << "</VTKFile>\n";
+
+    if (!file)
+    {
+        msg_error("VTKExporter") << "Error writing file " << data.filename;
+        return false;
+    }
+    return true;
+}
+
+VTUBackgroundWriter::VTUBackgroundWriter(int compressionLevel)
+    : m_compressionLevel(compressionLevel)
+    , m_thread(&VTUBackgroundWriter::run, this)
+{
+}
+
+VTUBackgroundWriter::~VTUBackgroundWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_condition.notify_all();
+    m_thread.join();
+}
+
+void VTUBackgroundWriter::submit(VTUFileData& data)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_condition.wait(lock, [this] { return !m_hasPending; });
+    m_pending.swap(data);
+    m_hasPending = true;
+    lock.unlock();
+    m_condition.notify_all();
+}
+
+void VTUBackgroundWriter::flush()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_condition.wait(lock, [this] { return !m_hasPending && !m_busy; });
+}
+
+void VTUBackgroundWriter::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;)
+    {
+        m_condition.wait(lock, [this] { return m_hasPending || m_stop; });
+        if (!m_hasPending)
+            break; // stopping, and everything was written
+        m_writing.swap(m_pending);
+        m_hasPending = false;
+        m_busy = true;
+        lock.unlock();
+        m_condition.notify_all();
+
+        writeVTUFile(m_writing, m_compressionLevel);
+
+        lock.lock();
+        m_busy = false;
+        m_condition.notify_all();
+    }
+}
+
+} // namespace misc
+
+} // namespace component
+
+} // namespace sofa
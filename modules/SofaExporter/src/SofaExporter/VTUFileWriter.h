@@ -0,0 +1,104 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_COMPONENT_MISC_VTUFILEWRITER_H
+#define SOFA_COMPONENT_MISC_VTUFILEWRITER_H
+#include "config.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace misc
+{
+
+/// Snapshot of everything written in a VTK XML unstructured grid (.vtu) file,
+/// taken on the simulation thread so that the file can be written later.
+struct SOFA_SOFAEXPORTER_API VTUFileData
+{
+    struct Array
+    {
+        std::string name;
+        std::string type; ///< VTK type name (Float32, Int32, ...)
+        unsigned int nbComponents {1};
+        std::vector<char> bytes;
+    };
+
+    std::string filename;
+    std::size_t nbPoints {0};
+    std::size_t nbCells {0};
+    std::vector<Array> pointData;
+    std::vector<Array> cellData;
+    Array points;
+    Array connectivity;
+    Array offsets;
+    Array types;
+
+    void swap(VTUFileData& other);
+};
+
+/// Write the snapshot as a .vtu file, with all arrays in a raw appended section.
+/// Arrays are zlib compressed (vtkZLibDataCompressor) if compressionLevel > 0 and zlib is available.
+SOFA_SOFAEXPORTER_API bool writeVTUFile(const VTUFileData& data, int compressionLevel);
+
+/// Write VTUFileData snapshots on a background thread.
+/// The simulation thread only waits if a snapshot is still queued when the next one is submitted.
+class SOFA_SOFAEXPORTER_API VTUBackgroundWriter
+{
+public:
+    explicit VTUBackgroundWriter(int compressionLevel);
+    ~VTUBackgroundWriter();
+
+    /// Queue the snapshot. data is swapped with a free buffer, so that its memory can be reused.
+    void submit(VTUFileData& data);
+
+    /// Wait until all submitted snapshots are written
+    void flush();
+
+protected:
+    void run();
+
+    const int m_compressionLevel;
+    VTUFileData m_pending;
+    VTUFileData m_writing;
+    bool m_hasPending {false};
+    bool m_busy {false};
+    bool m_stop {false};
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::thread m_thread;
+};
+
+} // namespace misc
+
+} // namespace component
+
+} // namespace sofa
+
+#endif // SOFA_COMPONENT_MISC_VTUFILEWRITER_H
@@ -31,6 +31,7 @@
 #include <sofa/simulation/AnimateEndEvent.h>
 #include <sofa/defaulttype/DataTypeInfo.h>
 #include <sofa/simulation/Visitor.h>
+#include <sofa/helper/io/BinaryStateFile.h>
 
 #ifdef SOFA_HAVE_ZLIB
 #include <zlib.h>
@@ -52,6 +53,11 @@ namespace misc
  * The DoFs to print can be chosen using DOFsX and DOFsV
  * Stop to write the state if the kinematic energy reach a given threshold (stopAt)
  * The energy will be measured at each period determined by keperiod
+ *
+ * With binary=true, each exported time step is written as one chunk of a helper::io::BinaryStateFileWriter
+ * file, which ReadState can seek into directly. A chunk holds one record per written vector:
+ * uint32 vector (0=X, 1=X0, 2=V, 3=F), uint32 scalars per DOF, uint32 scalar size, uint32 reserved,
+ * uint64 number of DOFs, followed by the raw scalar values.
 */
 class SOFA_SOFAEXPORTER_API WriteState: public core::objectmodel::BaseObject
 {
@@ -69,6 +75,8 @@ public:
     Data < helper::vector<unsigned int> > d_DOFsV; ///< set the velocity DOFs to write
     Data < double > d_stopAt; ///< stop the simulation when the given threshold is reached
     Data < double > d_keperiod; ///< set the period to measure the kinetic energy increase
+    Data < bool > d_binary; ///< write a binary file with a time index instead of a text file
+    Data < int > d_compressionLevel; ///< zlib compression level of each binary chunk (0 to disable)
 
 protected:
     core::behavior::BaseMechanicalState* mmodel;
@@ -76,6 +84,8 @@ protected:
 #ifdef SOFA_HAVE_ZLIB
     gzFile gzfile;
 #endif
+    helper::io::BinaryStateFileWriter* binaryfile;
+    std::vector<char> binaryChunk;
     unsigned int nextIteration;
     double lastTime;
     bool kineticEnergyThresholdReached;
@@ -98,6 +108,11 @@ public:
 
     void handleEvent(sofa::core::objectmodel::Event* event) override;
 
+protected:
+    /// Append the binary record of the given vector to binaryChunk
+    void appendBinaryVec(helper::io::BinaryStateVector vector, core::ConstVecId v);
+
+public:
 
     /// Pre-construction check method called by ObjectFactory.
     /// Check that DataTypes matches the MechanicalState.
@@ -27,6 +27,7 @@
 #include <sofa/simulation/Node.h>
 #include <sofa/core/objectmodel/DataFileName.h>
 
+#include <cstring>
 #include <fstream>
 #include <sstream>
 
@@ -52,11 +53,14 @@ WriteState::WriteState()
     , d_DOFsV( initData(&d_DOFsV, helper::vector<unsigned int>(0), "DOFsV", "set the velocity DOFs to write"))
     , d_stopAt( initData(&d_stopAt, 0.0, "stopAt", "stop the simulation when the given threshold is reached"))
     , d_keperiod( initData(&d_keperiod, 0.0, "keperiod", "set the period to measure the kinetic energy increase"))
+    , d_binary( initData(&d_binary, false, "binary", "write a binary file with a time index, that ReadState can seek into, instead of a text file"))
+    , d_compressionLevel( initData(&d_compressionLevel, 0, "compressionLevel", "zlib compression level of each binary chunk (0 to disable)"))
     , mmodel(nullptr)
     , outfile(nullptr)
 #ifdef SOFA_HAVE_ZLIB
     , gzfile(nullptr)
 #endif
+    , binaryfile(nullptr)
     , nextIteration(0)
     , lastTime(0)
     , kineticEnergyThresholdReached(false)
@@ -75,6 +79,8 @@ WriteState::~WriteState()
     if (gzfile)
         gzclose(gzfile);
 #endif
+    if (binaryfile)
+        delete binaryfile;
 }
 
 
@@ -92,7 +98,17 @@ void WriteState::init()
     ///////////// end of the tests.
 
     const std::string& filename = d_filename.getFullPath();
-    if (!filename.empty())
+    if (!filename.empty() && d_binary.getValue())
+    {
+        binaryfile = new helper::io::BinaryStateFileWriter;
+        if (!binaryfile->open(filename, d_compressionLevel.getValue()))
+        {
+            msg_error() << "Error creating binary file "<<filename;
+            delete binaryfile;
+            binaryfile = nullptr;
+        }
+    }
+    else if (!filename.empty())
     {
 #ifdef SOFA_HAVE_ZLIB
         if (filename.size() >= 3 && filename.substr(filename.size()-3)==".gz")
@@ -233,6 +249,11 @@ if (outfile)
 if (gzfile)
     gzclose(gzfile);
 #endif
+if (binaryfile)
+{
+    delete binaryfile;
+    binaryfile = nullptr;
+}
 init();
 }
 void WriteState::reset()
@@ -257,6 +278,7 @@ void WriteState::handleEvent(sofa::core::objectmodel::Event* event)
 #ifdef SOFA_HAVE_ZLIB
             && !gzfile
 #endif
+            && !binaryfile
            )
             return;
 
@@ -325,6 +347,20 @@ void WriteState::handleEvent(sofa::core::objectmodel::Event* event)
         }
         if (writeCurrent)
         {
+            if (binaryfile)
+            {
+                binaryChunk.clear();
+                if (d_writeX.getValue())
+                    appendBinaryVec(helper::io::BINARY_X, core::VecId::position());
+                if (d_writeX0.getValue())
+                    appendBinaryVec(helper::io::BINARY_X0, core::VecId::restPosition());
+                if (d_writeV.getValue())
+                    appendBinaryVec(helper::io::BINARY_V, core::VecId::velocity());
+                if (d_writeF.getValue())
+                    appendBinaryVec(helper::io::BINARY_F, core::VecId::force());
+                binaryfile->writeChunk(time, binaryChunk);
+            }
+            else
 #ifdef SOFA_HAVE_ZLIB
             if (gzfile)
             {
@@ -392,6 +428,22 @@ void WriteState::handleEvent(sofa::core::objectmodel::Event* event)
     }
 }
 
+void WriteState::appendBinaryVec(helper::io::BinaryStateVector vector, core::ConstVecId v)
+{
+    const std::uint32_t dim = std::uint32_t(v.type == core::V_COORD ? mmodel->getCoordDimension() : mmodel->getDerivDimension());
+    const std::uint64_t nbDofs = mmodel->getSize();
+    const std::uint32_t header[4] = { std::uint32_t(vector), dim, std::uint32_t(sizeof(SReal)), 0 };
+
+    const std::size_t offset = binaryChunk.size();
+    const std::size_t nbScalars = std::size_t(nbDofs*dim);
+    binaryChunk.resize(offset + sizeof(header) + sizeof(nbDofs) + nbScalars*sizeof(SReal));
+    char* out = binaryChunk.data() + offset;
+    std::memcpy(out, header, sizeof(header));
+    std::memcpy(out + sizeof(header), &nbDofs, sizeof(nbDofs));
+    if (nbScalars)
+        mmodel->copyToBuffer(reinterpret_cast<SReal*>(out + sizeof(header) + sizeof(nbDofs)), v, (unsigned int)nbScalars);
+}
+
 } // namespace misc
 
 } // namespace component
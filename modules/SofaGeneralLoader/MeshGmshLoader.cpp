@@ -23,8 +23,9 @@
 #include <SofaGeneralLoader/MeshGmshLoader.h>
 #include <sofa/core/visual/VisualParams.h>
 #include <iostream>
-#include <fstream>
+#include <sstream>
 #include <sofa/helper/io/Mesh.h>
+#include <sofa/helper/io/MappedFile.h>
 
 
 namespace sofa
@@ -46,31 +47,30 @@ int MeshGmshLoaderClass = core::RegisterObject("Specific mesh loader for Gmsh fi
 
 bool MeshGmshLoader::load()
 {
-    string cmd;
     bool fileRead = false;
     unsigned int gmshFormat = 0;
 
     // -- Loading file
     const char* filename = m_filename.getFullPath().c_str();
-    std::ifstream file(filename);
+    helper::io::MappedFile file(filename);
 
     if (!canLoad())
         return false;
 
+    helper::io::TextTokenizer tokenizer(file.begin(), file.end());
+
     // -- Looking for Gmsh version of this file.
-    std::getline(file, cmd); //Version
-    std::istringstream versionReader(cmd);
     string version;
-    versionReader >> version;
+    tokenizer.nextWordInLine(version);
+    tokenizer.skipLine(); //Version
+    string node = version;
     if (version == "$MeshFormat") // Reading gmsh 2.0 file
     {
         gmshFormat = 2;
-        string line;
-        std::getline(file, line); // we don't need this line (2 0 8)
-        std::getline(file, cmd); // end Version
-        std::istringstream endMeshReader(cmd);
+        tokenizer.skipLine(); // we don't need this line (2 0 8)
         string endMesh;
-        endMeshReader >> endMesh;
+        tokenizer.nextWordInLine(endMesh);
+        tokenizer.skipLine(); // end Version
 
         if (endMesh != string("$EndMeshFormat") ) // it should end with $EndMeshFormat
         {
@@ -80,7 +80,9 @@ bool MeshGmshLoader::load()
         }
         else
         {
-            std::getline(file, cmd); // First Command
+            node.clear();
+            tokenizer.nextWordInLine(node);
+            tokenizer.skipLine(); // First Command
         }
     }
     else
@@ -88,9 +90,6 @@ bool MeshGmshLoader::load()
         gmshFormat = 1;
     }
 
-    std::istringstream nodeReader(cmd);
-    string node;
-    nodeReader >> node;
     // -- Reading file
     if (node == "$NOD" || node == "$Nodes") // Gmsh format
     {
@@ -140,7 +139,7 @@ void MeshGmshLoader::normalizeGroup(helper::vector< sofa::core::loader::Primitiv
     }
 }
 
-bool MeshGmshLoader::readGmsh(std::ifstream &file, const unsigned int gmshFormat)
+bool MeshGmshLoader::readGmsh(helper::io::TextTokenizer& file, const unsigned int gmshFormat)
 {
     dmsg_info() << "Reading Gmsh file: " << gmshFormat;
 
@@ -180,7 +179,6 @@ bool MeshGmshLoader::readGmsh(std::ifstream &file, const unsigned int gmshFormat
     if (cmd != "$ENDNOD" && cmd != "$EndNodes")
     {
         msg_error() << "'$ENDNOD' or '$EndNodes' expected, found '" << cmd << "'";
-        file.close();
         return false;
     }
 
@@ -190,7 +188,6 @@ bool MeshGmshLoader::readGmsh(std::ifstream &file, const unsigned int gmshFormat
     if (cmd != "$ELM" && cmd != "$Elements")
     {
         msg_error() << "'$ELM' or '$Elements' expected, found '" << cmd << "'";
-        file.close();
         return false;
     }
 
@@ -369,8 +366,7 @@ bool MeshGmshLoader::readGmsh(std::ifstream &file, const unsigned int gmshFormat
             break;
         default:
             //if the type is not handled, skip rest of the line
-            string tmp;
-            std::getline(file, tmp);
+            file.skipLine();
         }
     }
 
@@ -395,11 +391,9 @@ bool MeshGmshLoader::readGmsh(std::ifstream &file, const unsigned int gmshFormat
     if (cmd != "$ENDELM" && cmd!="$EndElements")
     {
         msg_error() << "'$ENDELM' or '$EndElements' expected, found '" << cmd << "'";
-        file.close();
         return false;
     }
 
-    file.close();
     return true;
 }
 
@@ -24,6 +24,7 @@
 #include "config.h"
 
 #include <sofa/core/loader/MeshLoader.h>
+#include <sofa/helper/io/TextTokenizer.h>
 
 namespace sofa
 {
@@ -50,7 +51,7 @@ public:
 
 protected:
 
-    bool readGmsh(std::ifstream &file, const unsigned int gmshFormat);
+    bool readGmsh(helper::io::TextTokenizer& file, const unsigned int gmshFormat);
 
     void addInGroup(helper::vector< sofa::core::loader::PrimitiveGroup>& group,int tag,int eid);
 
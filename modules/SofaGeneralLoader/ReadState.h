@@ -26,6 +26,7 @@
 #include <sofa/simulation/AnimateBeginEvent.h>
 #include <sofa/simulation/AnimateEndEvent.h>
 #include <sofa/simulation/Visitor.h>
+#include <sofa/helper/io/BinaryStateFile.h>
 
 #ifdef SOFA_HAVE_ZLIB
 #include <zlib.h>
@@ -43,6 +44,9 @@ namespace misc
 {
 
 /** Read State vectors from file at each timestep
+ *
+ * Both the text files and the binary files written by WriteState are supported. Binary files
+ * are detected from their header, and the chunk to apply is found directly from their time index.
 */
 class SOFA_GENERAL_LOADER_API ReadState: public core::objectmodel::BaseObject
 {
@@ -61,6 +65,9 @@ protected:
 #ifdef SOFA_HAVE_ZLIB
     gzFile gzfile;
 #endif
+    helper::io::BinaryStateFileReader* binaryfile;
+    std::vector<char> binaryChunk;
+    int binaryChunkIndex;
     double nextTime;
     double lastTime;
     double loopTime;
@@ -83,6 +90,9 @@ public:
     /// Read the next values in the file corresponding to the last timestep before the given time
     bool readNext(double time, std::vector<std::string>& lines);
 
+    /// Apply the last chunk of the binary file before the given time, returns true if the state changed
+    bool readBinary(double time);
+
     /// Pre-construction check method called by ObjectFactory.
     /// Check that DataTypes matches the MechanicalState.
     template<class T>
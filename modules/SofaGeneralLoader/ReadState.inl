@@ -27,6 +27,7 @@
 #include <sofa/simulation/MechanicalVisitor.h>
 #include <sofa/simulation/UpdateMappingVisitor.h>
 
+#include <cmath>
 #include <cstring>
 #include <sstream>
 
@@ -50,6 +51,8 @@ ReadState::ReadState()
 #ifdef SOFA_HAVE_ZLIB
     , gzfile(nullptr)
 #endif
+    , binaryfile(nullptr)
+    , binaryChunkIndex(-1)
     , nextTime(0)
     , lastTime(0)
     , loopTime(0)
@@ -65,6 +68,8 @@ ReadState::~ReadState()
     if (gzfile)
         gzclose(gzfile);
 #endif
+    if (binaryfile)
+        delete binaryfile;
 }
 
 void ReadState::init()
@@ -87,12 +92,28 @@ void ReadState::reset()
         gzfile = nullptr;
     }
 #endif
+    if (binaryfile)
+    {
+        delete binaryfile;
+        binaryfile = nullptr;
+    }
+    binaryChunkIndex = -1;
 
     const std::string& filename = d_filename.getFullPath();
     if (filename.empty())
     {
         msg_error() << "ERROR: empty filename";
     }
+    else if (helper::io::BinaryStateFileReader::isBinaryStateFile(filename))
+    {
+        binaryfile = new helper::io::BinaryStateFileReader;
+        if (!binaryfile->open(filename))
+        {
+            msg_error() << "Error opening binary file "<<filename;
+            delete binaryfile;
+            binaryfile = nullptr;
+        }
+    }
 #ifdef SOFA_HAVE_ZLIB
     else if (filename.size() >= 3 && filename.substr(filename.size()-3)==".gz")
     {
@@ -134,6 +155,12 @@ void ReadState::handleEvent(sofa::core::objectmodel::Event* event)
 
 void ReadState::setTime(double time)
 {
+    if (binaryfile)
+    {
+        // binary files are indexed, the next read seeks directly to the right chunk
+        binaryChunkIndex = -1;
+        return;
+    }
     if (time+getContext()->getDt()*0.5 < lastTime) {reset();}
 }
 
@@ -219,28 +246,124 @@ bool ReadState::readNext(double time, std::vector<std::string>& validLines)
     return true;
 }
 
-void ReadState::processReadState()
+bool ReadState::readBinary(double time)
 {
-    double time = getContext()->getTime() + d_shift.getValue();
-    std::vector<std::string> validLines;
-    if (!readNext(time, validLines)) return;
+    if (!mmodel || !binaryfile || !binaryfile->getNbChunks()) return false;
+    lastTime = time;
+
+    // when looping, the recording is replayed every "last chunk time"
+    const double duration = binaryfile->getChunkTime(binaryfile->getNbChunks()-1);
+    if (d_loop.getValue() && duration > 0 && time > duration)
+        loopTime = std::floor(time / duration) * duration;
+    else
+        loopTime = 0;
+
+    const int index = binaryfile->findChunk(time - loopTime);
+    if (index < 0 || index == binaryChunkIndex) return false;
+    binaryChunkIndex = index;
+    if (!binaryfile->readChunk(std::size_t(index), binaryChunk))
+    {
+        msg_error() << "Error reading chunk " << index << " of " << d_filename.getFullPath();
+        return false;
+    }
+
     bool updated = false;
-    for (std::vector<std::string>::iterator it=validLines.begin(); it!=validLines.end(); ++it)
+    std::vector<SReal> converted;
+    std::size_t offset = 0;
+    while (offset + 4*sizeof(std::uint32_t) + sizeof(std::uint64_t) <= binaryChunk.size())
     {
-        std::istringstream str(*it);
-        std::string cmd;
-        str >> cmd;
-        if (cmd == "X=")
+        std::uint32_t header[4];
+        std::uint64_t nbDofs;
+        std::memcpy(header, binaryChunk.data() + offset, sizeof(header));
+        std::memcpy(&nbDofs, binaryChunk.data() + offset + sizeof(header), sizeof(nbDofs));
+        offset += sizeof(header) + sizeof(nbDofs);
+
+        const std::uint32_t vector = header[0], dim = header[1], scalarSize = header[2];
+        const std::size_t nbScalars = std::size_t(nbDofs*dim);
+        if ((scalarSize != sizeof(float) && scalarSize != sizeof(double)) || offset + nbScalars*scalarSize > binaryChunk.size())
         {
-            mmodel->readVec(core::VecId::position(), str);            
-            mmodel->applyScale(d_scalePos.getValue(), d_scalePos.getValue(), d_scalePos.getValue());
+            msg_error() << "Invalid record in chunk " << index << " of " << d_filename.getFullPath();
+            return updated;
+        }
+        const char* values = binaryChunk.data() + offset;
+        offset += nbScalars*scalarSize;
+
+        // only positions and velocities are read back, as in text files
+        const bool isX = (vector == helper::io::BINARY_X), isV = (vector == helper::io::BINARY_V);
+        if (!isX && !isV) continue;
+        if (dim != (isX ? mmodel->getCoordDimension() : mmodel->getDerivDimension()))
+        {
+            msg_error() << "DOF dimension " << dim << " in " << d_filename.getFullPath() << " does not match " << mmodel->getName();
+            continue;
+        }
+
+        const SReal* src = reinterpret_cast<const SReal*>(values);
+        if (scalarSize != sizeof(SReal))
+        {
+            converted.resize(nbScalars);
+            for (std::size_t i = 0; i < nbScalars; ++i)
+            {
+                if (scalarSize == sizeof(float))
+                {
+                    float v;
+                    std::memcpy(&v, values + i*sizeof(float), sizeof(float));
+                    converted[i] = SReal(v);
+                }
+                else
+                {
+                    double v;
+                    std::memcpy(&v, values + i*sizeof(double), sizeof(double));
+                    converted[i] = SReal(v);
+                }
+            }
+            src = converted.data();
+        }
 
-            updated = true;
+        if (mmodel->getSize() != nbDofs)
+            mmodel->resize(std::size_t(nbDofs));
+        if (isX)
+        {
+            mmodel->copyFromBuffer(core::VecId::position(), src, (unsigned int)nbScalars);
+            mmodel->applyScale(d_scalePos.getValue(), d_scalePos.getValue(), d_scalePos.getValue());
         }
-        else if (cmd == "V=")
+        else
+        {
+            mmodel->copyFromBuffer(core::VecId::velocity(), src, (unsigned int)nbScalars);
+        }
+        updated = true;
+    }
+    return updated;
+}
+
+void ReadState::processReadState()
+{
+    double time = getContext()->getTime() + d_shift.getValue();
+    bool updated = false;
+    if (binaryfile)
+    {
+        updated = readBinary(time);
+    }
+    else
+    {
+        std::vector<std::string> validLines;
+        if (!readNext(time, validLines)) return;
+        for (std::vector<std::string>::iterator it=validLines.begin(); it!=validLines.end(); ++it)
         {
-            mmodel->readVec(core::VecId::velocity(), str);
-            updated = true;
+            std::istringstream str(*it);
+            std::string cmd;
+            str >> cmd;
+            if (cmd == "X=")
+            {
+                mmodel->readVec(core::VecId::position(), str);
+                mmodel->applyScale(d_scalePos.getValue(), d_scalePos.getValue(), d_scalePos.getValue());
+
+                updated = true;
+            }
+            else if (cmd == "V=")
+            {
+                mmodel->readVec(core::VecId::velocity(), str);
+                updated = true;
+            }
         }
     }
 
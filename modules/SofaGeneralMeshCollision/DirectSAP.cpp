@@ -28,6 +28,8 @@
 #include <SofaMeshCollision/Point.h>
 #include <sofa/helper/FnDispatcher.h>
 #include <sofa/core/ObjectFactory.h>
+#include <sofa/simulation/ParallelFor.h>
+#include <cstring>
 #include <map>
 #include <queue>
 #include <stack>
@@ -45,12 +47,6 @@ namespace collision
 
 
 
-inline void DSAPBox::update(int axis, double alarmDist){
-    min->value = (cube.minVect())[axis] - alarmDist;
-    max->value = (cube.maxVect())[axis] + alarmDist;
-}
-
-
 inline double DSAPBox::squaredDistance(const DSAPBox & other,int axis)const{
     const defaulttype::Vector3 & min0 = this->cube.minVect();
     const defaulttype::Vector3 & max0 = this->cube.maxVect();
@@ -88,15 +84,14 @@ inline bool DSAPBox::overlaps(const DSAPBox &other, int axis, double alarmDist)
 DirectSAP::DirectSAP()
     : bDraw(initData(&bDraw, false, "draw", "enable/disable display of results"))
     , box(initData(&box, "box", "if not empty, objects that do not intersect this bounding-box will be ignored"))
+    , _cur_axis(-1)
+    , d_parallelSort(initData(&d_parallelSort, false, "parallelSort", "True if the radix sort of end points should run in parallel using the task scheduler"))
 {
 }
 
 
 DirectSAP::~DirectSAP()
 {
-
-    for(unsigned int i = 0 ; i < _to_del.size() ; ++i)
-        delete[] _to_del[i];
 }
 
 
@@ -152,31 +147,16 @@ void DirectSAP::endBroadPhase()
     }
 
     _boxes.reserve(_boxes.size() + n);
-    EndPoint * end_pts = new EndPoint[2*n];
-    _to_del.push_back(end_pts);
-
-    int cur_EndPtID = 0;
-    int cur_boxID = _boxes.size();
     for(unsigned int i = 0 ; i < cube_models.size() ; ++i){
         CubeModel * cm = cube_models[i];
-        for(int j = 0 ; j < cm->getSize() ; ++j){
-            EndPoint * min = &end_pts[cur_EndPtID];
-            ++cur_EndPtID;
-            EndPoint * max = &end_pts[cur_EndPtID];
-            ++cur_EndPtID;
-
-            min->setBoxID(cur_boxID);
-            max->setBoxID(cur_boxID);
-            max->setMax();
-
-            _end_points.push_back(min);
-            _end_points.push_back(max);
-
-            _boxes.push_back(DSAPBox(Cube(cm,j),min,max));
-            ++cur_boxID;
-        }
+        for(int j = 0 ; j < cm->getSize() ; ++j)
+            _boxes.push_back(DSAPBox(Cube(cm,j)));
     }
 
+    //the end points are rebuilt and fully sorted at the next step
+    _end_points.resize(2*_boxes.size());
+    _cur_axis = -1;
+
     _new_cm.clear();
 }
 
@@ -239,9 +219,145 @@ int DirectSAP::greatestVarianceAxis()const{
 
 
 void DirectSAP::update(){
+    const int previous_axis = _cur_axis;
     _cur_axis = greatestVarianceAxis();
+
+    _box_min.resize(_boxes.size());
+    _box_max.resize(_boxes.size());
     for(unsigned int i = 0 ; i < _boxes.size() ; ++i){
-        _boxes[i].update(_cur_axis,_alarmDist_d2);
+        _box_min[i] = (_boxes[i].cube.minVect())[_cur_axis] - _alarmDist_d2;
+        _box_max[i] = (_boxes[i].cube.maxVect())[_cur_axis] + _alarmDist_d2;
+    }
+
+    sortEndPoints(previous_axis == _cur_axis);
+}
+
+namespace
+{
+
+/// Unsigned integer with the same order as the given value (-0 and +0 being equal, as for CompPEndPoint)
+inline std::uint64_t radixKey(double value){
+    value += 0.0;
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return (bits >> 63) ? ~bits : (bits | (std::uint64_t(1) << 63));
+}
+
+const std::size_t radixBuckets = 256;
+const std::size_t radixChunkSize = 4096;
+
+}
+
+template<class Function>
+void DirectSAP::forEachSortChunk(std::size_t nbChunks, const Function& function){
+    if(d_parallelSort.getValue()){
+        simulation::parallelFor(simulation::TaskScheduler::getInstance(), 0, nbChunks, 1, [&](std::size_t begin, std::size_t end){
+            for(std::size_t c = begin ; c < end ; ++c)
+                function(c);
+        });
+    }
+    else{
+        for(std::size_t c = 0 ; c < nbChunks ; ++c)
+            function(c);
+    }
+}
+
+void DirectSAP::sortEndPoints(bool sameAxis){
+    if(sameAxis){
+        for(EndPointList::iterator it = _end_points.begin() ; it != _end_points.end() ; ++it)
+            it->value = it->max() ? _box_max[it->boxID()] : _box_min[it->boxID()];
+
+        //with temporal coherence, only a few end points move
+        sofa::helper::AdvancedTimer::stepBegin("Direct SAP insertion sort");
+        const bool sorted = insertionSortEndPoints(4 * _end_points.size() + 64);
+        sofa::helper::AdvancedTimer::stepEnd("Direct SAP insertion sort");
+        if(sorted)
+            return;
+    }
+
+    sofa::helper::AdvancedTimer::stepBegin("Direct SAP radix sort");
+    radixSortEndPoints();
+    sofa::helper::AdvancedTimer::stepEnd("Direct SAP radix sort");
+}
+
+bool DirectSAP::insertionSortEndPoints(std::size_t maxMoves){
+    CompPEndPoint comp;
+    std::size_t nbMoves = 0;
+    for(std::size_t i = 1 ; i < _end_points.size() ; ++i){
+        if(!comp(&_end_points[i], &_end_points[i-1]))
+            continue;
+
+        const EndPoint moved = _end_points[i];
+        std::size_t j = i;
+        do{
+            _end_points[j] = _end_points[j-1];
+            --j;
+        }while(j > 0 && comp(&moved, &_end_points[j-1]));
+        _end_points[j] = moved;
+
+        nbMoves += i - j;
+        if(nbMoves > maxMoves)
+            return false;
+    }
+
+    return true;
+}
+
+void DirectSAP::radixSortEndPoints(){
+    const std::size_t n = _end_points.size();
+
+    //end points in (box, min/max) order: as the radix sort is stable, they are then sorted with the same order as CompPEndPoint
+    _keys.resize(n);
+    for(std::size_t i = 0 ; i < _boxes.size() ; ++i){
+        _end_points[2*i].value = _box_min[i];
+        _end_points[2*i].setMinAndBoxID((int)i);
+        _end_points[2*i+1].value = _box_max[i];
+        _end_points[2*i+1].setMaxAndBoxID((int)i);
+        _keys[2*i] = radixKey(_box_min[i]);
+        _keys[2*i+1] = radixKey(_box_max[i]);
+    }
+
+    _end_points_buffer.resize(n);
+    _keys_buffer.resize(n);
+    const std::size_t nbChunks = std::max<std::size_t>(1, n / radixChunkSize);
+    _radix_counts.resize(nbChunks * radixBuckets);
+
+    for(int shift = 0 ; shift < 64 ; shift += 8){
+        //histogram of the digit in each chunk
+        forEachSortChunk(nbChunks, [&](std::size_t c){
+            std::size_t * counts = &_radix_counts[c * radixBuckets];
+            std::fill(counts, counts + radixBuckets, 0);
+            for(std::size_t i = c * n / nbChunks ; i < (c + 1) * n / nbChunks ; ++i)
+                ++counts[(_keys[i] >> shift) & 0xFF];
+        });
+
+        //first position of each (digit, chunk) in the output; passes where all keys share the digit are skipped
+        std::size_t offset = 0;
+        bool sameDigit = false;
+        for(std::size_t b = 0 ; b < radixBuckets ; ++b){
+            const std::size_t bucketBegin = offset;
+            for(std::size_t c = 0 ; c < nbChunks ; ++c){
+                const std::size_t count = _radix_counts[c * radixBuckets + b];
+                _radix_counts[c * radixBuckets + b] = offset;
+                offset += count;
+            }
+            if(offset - bucketBegin == n)
+                sameDigit = true;
+        }
+        if(sameDigit)
+            continue;
+
+        forEachSortChunk(nbChunks, [&](std::size_t c){
+            std::size_t * positions = &_radix_counts[c * radixBuckets];
+            for(std::size_t i = c * n / nbChunks ; i < (c + 1) * n / nbChunks ; ++i){
+                const std::size_t pos = positions[(_keys[i] >> shift) & 0xFF]++;
+                _keys_buffer[pos] = _keys[i];
+                _end_points_buffer[pos] = _end_points[i];
+            }
+        });
+
+        _keys.swap(_keys_buffer);
+        _end_points.swap(_end_points_buffer);
     }
 }
 
@@ -252,17 +368,13 @@ void DirectSAP::beginNarrowPhase()
     _sq_alarmDist = _alarmDist * _alarmDist;
     _alarmDist_d2 = _alarmDist/2.0;
 
+    sofa::helper::AdvancedTimer::stepBegin("Direct SAP sort");
     update();
-
-    CompPEndPoint comp;
-
-    sofa::helper::AdvancedTimer::stepBegin("Direct SAP std::sort");
-    std::sort(_end_points.begin(),_end_points.end(),comp);
-    sofa::helper::AdvancedTimer::stepEnd("Direct SAP std::sort");
+    sofa::helper::AdvancedTimer::stepEnd("Direct SAP sort");
 
     sofa::helper::AdvancedTimer::stepBegin("Direct SAP intersection");
 
-    std::deque<int> active_boxes;//active boxes are the one that we encoutered only their min (end point), so if there are two boxes b0 and b1,
+    std::vector<int> active_boxes;//active boxes are the one that we encoutered only their min (end point), so if there are two boxes b0 and b1,
                                  //if we encounter b1_min as b0_min < b1_min, on the current axis, the two boxes intersect :  b0_min--------------------b0_max
                                  //                                                                                                      b1_min---------------------b1_max
                                  //once we encouter b0_max, b0 will not intersect with nothing (trivial), so we delete it from active_boxes.
@@ -271,12 +383,12 @@ void DirectSAP::beginNarrowPhase()
                                  //                 -every time we encounter a max end point of a box, we are sure that we encountered min end point of a box because _end_points is sorted,
                                  //                  so, we delete the owner box, of this max end point from the active boxes
     for(EndPointList::iterator it = _end_points.begin() ; it != _end_points.end() ; ++it){
-        if((**it).max()){//erase it from the active_boxes
-            assert(std::find(active_boxes.begin(),active_boxes.end(),(**it).boxID()) != active_boxes.end());
-            active_boxes.erase(std::find(active_boxes.begin(),active_boxes.end(),(**it).boxID()));
+        if((*it).max()){//erase it from the active_boxes
+            assert(std::find(active_boxes.begin(),active_boxes.end(),(*it).boxID()) != active_boxes.end());
+            active_boxes.erase(std::find(active_boxes.begin(),active_boxes.end(),(*it).boxID()));
         }
         else{//we encounter a min possible intersection between it and active_boxes
-            int new_box = (**it).boxID();
+            int new_box = (*it).boxID();
 
             DSAPBox & box0 = _boxes[new_box];
             for(unsigned int i = 0 ; i < active_boxes.size() ; ++i){
@@ -30,6 +30,7 @@
 #include <SofaBaseCollision/CubeModel.h>
 #include <SofaMeshCollision/EndPoint.h>
 #include <sofa/defaulttype/Vec.h>
+#include <cstdint>
 #include <set>
 #include <map>
 #include <deque>
@@ -44,20 +45,13 @@ namespace component
 namespace collision
 {
 
-class EndPoint;
-
 /**
   *SAPBox is a simple bounding box. It contains a Cube which contains only one final
-  *CollisionElement and pointers to min and max EndPoints. min and max end points
-  *are respectively min and max coordinates of the cube on a coordinate axis.
-  *min and max are updated with the method update(int i), so min and max have
-  *min/max values on the i-th axis after the method update(int i).
+  *CollisionElement.
   */
 class SOFA_GENERAL_MESH_COLLISION_API DSAPBox{
 public:
-    DSAPBox(Cube c,EndPoint * mi = nullptr,EndPoint * ma = nullptr) : cube(c),min(mi),max(ma){}
-
-    void update(int axis,double alarmDist);
+    DSAPBox(Cube c) : cube(c){}
 
     bool overlaps(const DSAPBox & other,int axis,double alarmDist)const;
 
@@ -72,14 +66,16 @@ public:
     void show() const;
 
     Cube cube;
-    EndPoint * min;
-    EndPoint * max;
 };
 
 /**
   *This class is an implementation of sweep and prune in its "direct" version, i.e. at each step
   *it sorts all the primitives along an axis (not checking the moving ones) and computes overlaping pairs without
   *saving it. But the memory used to save these primitives is created just once, the first time we add CollisionModels.
+  *
+  *End points are stored by value in a flat array which stays sorted from one step to the next: as primitives
+  *usually move little between two steps, it is sorted again with an insertion sort. When this would move too
+  *many end points (or when the sweep axis changes), a radix sort is used instead.
   */
 class SOFA_GENERAL_MESH_COLLISION_API DirectSAP :
     public core::collision::BroadPhaseDetection,
@@ -88,7 +84,7 @@ class SOFA_GENERAL_MESH_COLLISION_API DirectSAP :
 public:
     SOFA_CLASS2(DirectSAP, core::collision::BroadPhaseDetection, core::collision::NarrowPhaseDetection);
 
-    typedef std::vector<EndPoint*> EndPointList;
+    typedef std::vector<EndPoint> EndPointList;
 
     typedef DSAPBox SAPBox;
 
@@ -111,6 +107,27 @@ private:
       */
     void update();
 
+    /**
+      *Sorts the end points along the current axis: insertion sort if they are still sorted along the same axis
+      *and only few of them moved, radix sort otherwise.
+      */
+    void sortEndPoints(bool sameAxis);
+
+    /**
+      *Insertion sort of _end_points. Returns false, leaving _end_points partially sorted, if more than maxMoves
+      *end points swaps are needed.
+      */
+    bool insertionSortEndPoints(std::size_t maxMoves);
+
+    /**
+      *Rebuilds _end_points from _boxes and sorts them with a stable LSD radix sort on their values.
+      */
+    void radixSortEndPoints();
+
+    /// Calls function(chunk) for each chunk in [0, nbChunks), in parallel if d_parallelSort is set
+    template<class Function>
+    void forEachSortChunk(std::size_t nbChunks, const Function& function);
+
     Data<bool> bDraw; ///< enable/disable display of results
 
     Data< helper::fixed_array<defaulttype::Vector3,2> > box; ///< if not empty, objects that do not intersect this bounding-box will be ignored
@@ -118,8 +135,14 @@ private:
     CubeModel::SPtr boxModel;
 
     std::vector<DSAPBox> _boxes;//boxes
-    EndPointList _end_points;//end points of _boxes
-    int _cur_axis;//the current greatest variance axis
+    std::vector<double> _box_min;//min of each box on the current axis, minus half the alarm distance
+    std::vector<double> _box_max;//max of each box on the current axis, plus half the alarm distance
+    EndPointList _end_points;//end points of _boxes, sorted along _cur_axis
+    EndPointList _end_points_buffer;//radix sort buffers
+    std::vector<std::uint64_t> _keys;
+    std::vector<std::uint64_t> _keys_buffer;
+    std::vector<std::size_t> _radix_counts;
+    int _cur_axis;//the current greatest variance axis, -1 if _end_points are not sorted
 
     std::set<core::CollisionModel*> collisionModels;//used to check if a collision model is added
     std::vector<core::CollisionModel*> _new_cm;//eventual new collision models to  add at a step
@@ -132,8 +155,9 @@ protected:
 
     ~DirectSAP() override;
 
-    std::vector<EndPoint*> _to_del;//EndPoint arrays to delete when deleting DirectSAP
 public:
+    Data<bool> d_parallelSort; ///< True if the radix sort of end points should run in parallel using the task scheduler
+
     void setDraw(bool val) { bDraw.setValue(val); }
 
     void init() override;
@@ -58,6 +58,7 @@ class BoyceAndArruda : public HyperelasticMaterial<DataTypes>{
     typedef defaulttype::Mat<6,6,Real> Matrix6;
     typedef defaulttype::MatSym<3,Real> MatrixSym;
 
+public:
   virtual Real getStrainEnergy(StrainInformation<DataTypes> *sinfo, const MaterialParameters<DataTypes> &param) {
 		Real I1=sinfo->trC;
 		Real mu=param.parameterArray[0];
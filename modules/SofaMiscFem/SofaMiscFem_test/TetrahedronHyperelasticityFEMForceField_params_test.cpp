@@ -30,6 +30,7 @@
 #include <SofaMiscFem/TetrahedronHyperelasticityFEMForceField.h>
 
 #include <sofa/defaulttype/Vec.h>
+#include <sofa/simulation/TaskScheduler.h>
 
 #include <iostream>
 #include <fstream>
@@ -128,6 +129,64 @@ struct TetrahedronHyperelasticityFEMForceField_params_test : public Sofa_test<ty
         sofa::core::objectmodel::BaseObject* hefem = root->getTreeNode("Hyperelastic-Liver")->getObject("FEM") ;
         EXPECT_NE(hefem, nullptr) ;
     }
+
+    /// compute the forces and the force derivatives of a deformed liver, sequentially and in parallel
+    void run_test_parallel_matches_sequential(const std::string& materialName, const sofa::helper::vector<Real>& param_vector)
+    {
+        this->scene_load();
+
+        typename TetrahedronHyperelasticityFEMForceField::SPtr FF = sofa::core::objectmodel::New< TetrahedronHyperelasticityFEMForceField >();
+        hyperelasticNode->addObject(FF);
+        FF->setName("FEM");
+        FF->setMaterialName(materialName);
+        FF->setparameter(param_vector);
+        FF->findData("parallelGrainSize")->read("16");
+
+        sofa::simulation::getSimulation()->init(this->root.get());
+        dof = hyperelasticNode->get<DOF>(hyperelasticNode->SearchDown);
+        ASSERT_NE(dof.get(), nullptr);
+
+        VecCoord x = dof->readPositions().ref();
+        VecDeriv dx(x.size());
+        for (std::size_t i=0; i<x.size(); ++i)
+        {
+            for (unsigned int j=0; j<3; ++j)
+            {
+                x[i][j] += (Real)0.02*(Real)sin(3.0*i+j);
+                dx[i][j] = (Real)0.001*(Real)cos(5.0*i+j);
+            }
+        }
+        core::objectmodel::Data<VecCoord> d_x;
+        d_x.setValue(x);
+        core::objectmodel::Data<VecDeriv> d_dx;
+        d_dx.setValue(dx);
+        const core::MechanicalParams* mparams = core::MechanicalParams::defaultInstance();
+
+        VecDeriv force[2], dforce[2];
+        simulation::TaskScheduler::getInstance()->init(4);
+        for (unsigned int parallel=0; parallel<2; ++parallel)
+        {
+            FF->findData("parallel")->read(parallel ? "1" : "0");
+            core::objectmodel::Data<VecDeriv> d_f;
+            d_f.setValue(VecDeriv(x.size()));
+            FF->addForce(mparams, d_f, d_x, d_dx);
+            force[parallel] = d_f.getValue();
+            core::objectmodel::Data<VecDeriv> d_df;
+            d_df.setValue(VecDeriv(x.size()));
+            FF->addDForce(mparams, d_df, d_dx);
+            dforce[parallel] = d_df.getValue();
+        }
+        simulation::TaskScheduler::getInstance()->stop();
+
+        Real forceNorm = 0;
+        for (std::size_t i=0; i<x.size(); ++i)
+        {
+            forceNorm += force[0][i].norm();
+            EXPECT_EQ(force[0][i], force[1][i]) << materialName << " force of vertex " << i;
+            EXPECT_EQ(dforce[0][i], dforce[1][i]) << materialName << " force derivative of vertex " << i;
+        }
+        EXPECT_GT(forceNorm, 0) << materialName;
+    }
 };
 
 
@@ -149,6 +208,24 @@ TYPED_TEST( TetrahedronHyperelasticityFEMForceField_params_test , extension )
     this->run_test_params_mooney_case();
 }
 
+TYPED_TEST( TetrahedronHyperelasticityFEMForceField_params_test , parallelMatchesSequential )
+{
+    EXPECT_MSG_NOEMIT(Error) ;
+    this->debug = false;
+
+    typedef typename TestFixture::Real Real;
+    sofa::helper::vector<Real> mooney(3), neoHookean(2), stVenantKirchhoff(2), ogden(3);
+    mooney[0] = 151065.460; mooney[1] = 101709.668; mooney[2] = 1e07;
+    neoHookean[0] = 1000; neoHookean[1] = 10000;
+    stVenantKirchhoff[0] = 1000; stVenantKirchhoff[1] = 10000;
+    ogden[0] = 10000; ogden[1] = 1000; ogden[2] = 2;
+
+    this->run_test_parallel_matches_sequential("MooneyRivlin", mooney);
+    this->run_test_parallel_matches_sequential("NeoHookean", neoHookean);
+    this->run_test_parallel_matches_sequential("StVenantKirchhoff", stVenantKirchhoff);
+    this->run_test_parallel_matches_sequential("Ogden", ogden);
+}
+
 
 } // namespace sofa
 
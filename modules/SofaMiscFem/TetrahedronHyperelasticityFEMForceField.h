@@ -156,6 +156,8 @@ public :
     Data<string> d_materialName; ///< the name of the material
     Data<SetParameterArray> d_parameterSet; ///< The global parameters specifying the material
     Data<SetAnisotropyDirectionArray> d_anisotropySet; ///< The global directions of anisotropy of the material
+    Data<bool> d_parallel; ///< compute the element forces and the tangent matrix on the task scheduler (results are identical to the sequential computation)
+    Data<unsigned int> d_parallelGrainSize; ///< number of tetrahedra processed by each task in parallel mode
 
     TetrahedronData<sofa::helper::vector<TetrahedronRestInformation> > m_tetrahedronInfo; ///< Internal tetrahedron data
     EdgeData<sofa::helper::vector<EdgeInformation> > m_edgeInfo; ///< Internal edge data
@@ -218,10 +220,47 @@ public:
     fem::HyperelasticMaterial<DataTypes> *m_myMaterial;
     TetrahedronHandler* m_tetrahedronHandler;
 
+    /// the 6 edges of a tetrahedron, with the local indices of their vertices ordered as in the global edge
+    class TetrahedronEdges
+    {
+    public:
+        EdgesInTetrahedron edges;
+        unsigned char vertex[6][2];
+    };
+
+    typedef void (TetrahedronHyperelasticityFEMForceField<DataTypes>::*ElementForceKernel)(helper::vector<TetrahedronRestInformation>&, const VecCoord&, std::size_t, std::size_t);
+    typedef void (TetrahedronHyperelasticityFEMForceField<DataTypes>::*ElementTangentKernel)(helper::vector<TetrahedronRestInformation>&, std::size_t, std::size_t);
+
+    /// element kernels instantiated for the concrete type of m_myMaterial, see setMaterial()
+    ElementForceKernel m_elementForceKernel;
+    ElementTangentKernel m_elementTangentKernel;
+
+    /// per tetrahedron results of the kernels, accumulated afterwards in the element order
+    helper::vector<Deriv> m_elementForces;
+    helper::vector<MatrixList> m_elementEdgeStiffnesses;
+    helper::vector<TetrahedronEdges> m_tetrahedronEdges;
+
     void testDerivatives();
     void saveMesh( const char *filename );
 
     void updateTangentMatrix();
+
+    /// Set the material and the element kernels calling its constitutive law without virtual dispatch
+    template<class Material>
+    void setMaterial(Material* material);
+
+    /// Compute the deformation gradient, the second Piola-Kirchhoff stress and the 4 nodal forces
+    /// of the tetrahedra [first,last)
+    template<class Material>
+    void computeElementForces(helper::vector<TetrahedronRestInformation>& tetrahedronInf, const VecCoord& x, std::size_t first, std::size_t last);
+
+    /// Compute the stiffness of the 6 edges of the tetrahedra [first,last)
+    template<class Material>
+    void computeElementTangents(helper::vector<TetrahedronRestInformation>& tetrahedronInf, std::size_t first, std::size_t last);
+
+    /// Run an element kernel over all tetrahedra, in parallel if requested
+    template<class Kernel>
+    void runElementKernel(std::size_t nbTetrahedra, const Kernel& kernel);
 };
 
 using sofa::defaulttype::Vec3dTypes;
@@ -41,6 +41,7 @@
 #include <iostream> //for debugging
 #include <sofa/core/behavior/ForceField.inl>
 #include <SofaBaseTopology/TopologyData.inl>
+#include <sofa/simulation/ParallelFor.h>
 #include <algorithm>
 #include <iterator>
 namespace sofa
@@ -117,9 +118,14 @@ template <class DataTypes> TetrahedronHyperelasticityFEMForceField<DataTypes>::T
     , d_materialName(initData(&d_materialName,std::string("ArrudaBoyce"),"materialName","the name of the material to be used"))
     , d_parameterSet(initData(&d_parameterSet,"ParameterSet","The global parameters specifying the material"))
     , d_anisotropySet(initData(&d_anisotropySet,"AnisotropyDirections","The global directions of anisotropy of the material"))
+    , d_parallel(initData(&d_parallel,false,"parallel","compute the element forces and the tangent matrix in parallel using the task scheduler. Results are identical to the sequential computation"))
+    , d_parallelGrainSize(initData(&d_parallelGrainSize,(unsigned int)256,"parallelGrainSize","number of tetrahedra processed by each task when parallel is true"))
     , m_tetrahedronInfo(initData(&m_tetrahedronInfo, "tetrahedronInfo", "Internal tetrahedron data"))
     , m_edgeInfo(initData(&m_edgeInfo, "edgeInfo", "Internal edge data"))
+    , m_myMaterial(NULL)
     , m_tetrahedronHandler(NULL)
+    , m_elementForceKernel(NULL)
+    , m_elementTangentKernel(NULL)
 {
     m_tetrahedronHandler = new TetrahedronHandler(this,&m_tetrahedronInfo);
 }
@@ -157,35 +163,35 @@ template <class DataTypes> void TetrahedronHyperelasticityFEMForceField<DataType
     if (material=="ArrudaBoyce")
     {
         fem::BoyceAndArruda<DataTypes> *BoyceAndArrudaMaterial = new fem::BoyceAndArruda<DataTypes>;
-        m_myMaterial = BoyceAndArrudaMaterial;
+        setMaterial(BoyceAndArrudaMaterial);
         if (this->f_printLog.getValue())
             msg_info()<<"The model is "<<material;
     }
     else if (material=="StVenantKirchhoff")
     {
         fem::STVenantKirchhoff<DataTypes> *STVenantKirchhoffMaterial = new fem::STVenantKirchhoff<DataTypes>;
-        m_myMaterial = STVenantKirchhoffMaterial;
+        setMaterial(STVenantKirchhoffMaterial);
         if (this->f_printLog.getValue())
             msg_info()<<"The model is "<<material;
     }
     else if (material=="NeoHookean")
     {
         fem::NeoHookean<DataTypes> *NeoHookeanMaterial = new fem::NeoHookean<DataTypes>;
-        m_myMaterial = NeoHookeanMaterial;
+        setMaterial(NeoHookeanMaterial);
         if (this->f_printLog.getValue())
             msg_info()<<"The model is "<<material;
     }
     else if (material=="MooneyRivlin")
     {
         fem::MooneyRivlin<DataTypes> *MooneyRivlinMaterial = new fem::MooneyRivlin<DataTypes>;
-        m_myMaterial = MooneyRivlinMaterial;
+        setMaterial(MooneyRivlinMaterial);
         if (this->f_printLog.getValue())
             msg_info()<<"The model is "<<material;
     }
     else if (material=="VerondaWestman")
     {
         fem::VerondaWestman<DataTypes> *VerondaWestmanMaterial = new fem::VerondaWestman<DataTypes>;
-        m_myMaterial = VerondaWestmanMaterial;
+        setMaterial(VerondaWestmanMaterial);
         if (this->f_printLog.getValue())
             msg_info()<<"The model is "<<material;
     }
@@ -193,14 +199,14 @@ template <class DataTypes> void TetrahedronHyperelasticityFEMForceField<DataType
     else if (material=="Costa")
     {
         fem::Costa<DataTypes> *CostaMaterial = new fem::Costa<DataTypes>;
-        m_myMaterial = CostaMaterial;
+        setMaterial(CostaMaterial);
         if (this->f_printLog.getValue())
             msg_info()<<"The model is "<<material;
     }
     else if (material=="Ogden")
     {
         fem::Ogden<DataTypes> *OgdenMaterial = new fem::Ogden<DataTypes>;
-        m_myMaterial = OgdenMaterial;
+        setMaterial(OgdenMaterial);
         if (this->f_printLog.getValue())
             msg_info()<<"The model is "<<material;
     }
@@ -268,23 +274,140 @@ void TetrahedronHyperelasticityFEMForceField<DataTypes>::addForce(const core::Me
         printf( "Mesh saved.\n" );
         m_meshSaved = true;
     }
-    unsigned int i=0,j=0,k=0,l=0;
+    unsigned int i=0,l=0;
     unsigned int nbTetrahedra=m_topology->getNbTetrahedra();
 
     helper::vector<TetrahedronRestInformation>& tetrahedronInf = *(m_tetrahedronInfo.beginEdit());
 
+    assert(this->mstate);
 
-    TetrahedronRestInformation *tetInfo;
+    if (!m_elementForceKernel)
+    {
+        m_tetrahedronInfo.endEdit();
+        d_f.endEdit();
+        return;
+    }
 
-    assert(this->mstate);
+    m_elementForces.resize(4*nbTetrahedra);
+    runElementKernel(nbTetrahedra, [&](std::size_t first, std::size_t last)
+    {
+        (this->*m_elementForceKernel)(tetrahedronInf, x, first, last);
+    });
 
-    Coord dp[3],x0,sv;
+    const VecElement& tetrahedronArray = m_topology->getTetrahedra();
+    for(i=0; i<nbTetrahedra; i++ )
+    {
+        const Tetrahedron &ta= tetrahedronArray[i];
+        for(l=0;l<4;++l)
+        {
+            f[ta[l]]-=m_elementForces[4*i+l];
+        }
+    }
+
+
+    /// indicates that the next call to addDForce will need to update the stiffness matrix
+    m_updateMatrix=true;
+    m_tetrahedronInfo.endEdit();
+
+    d_f.endEdit();
+}
+
+template <class DataTypes>
+void TetrahedronHyperelasticityFEMForceField<DataTypes>::updateTangentMatrix()
+{
+    unsigned int i=0,j=0,k=0,l=0;
+    unsigned int nbEdges=m_topology->getNbEdges();
+    const vector< Edge> &edgeArray=m_topology->getEdges() ;
 
+    helper::vector<EdgeInformation>& edgeInf = *(m_edgeInfo.beginEdit());
+    helper::vector<TetrahedronRestInformation>& tetrahedronInf = *(m_tetrahedronInfo.beginEdit());
 
+    unsigned int nbTetrahedra=m_topology->getNbTetrahedra();
+    const std::vector< Tetrahedron> &tetrahedronArray=m_topology->getTetrahedra() ;
+
+    /// orient the edges of each tetrahedron as the global edges, before the element kernels are run
+    Edge localEdges[6];
+    for(j=0;j<6;j++) localEdges[j]=m_topology->getLocalEdgesInTetrahedron(j);
+    m_tetrahedronEdges.resize(nbTetrahedra);
     for(i=0; i<nbTetrahedra; i++ )
+    {
+        TetrahedronEdges &tetEdges=m_tetrahedronEdges[i];
+        tetEdges.edges=m_topology->getEdgesInTetrahedron(i);
+
+        /// describe the jth vertex index of triangle no i
+        const Tetrahedron &ta= tetrahedronArray[i];
+        for(j=0;j<6;j++) {
+            k=localEdges[j][0];
+            l=localEdges[j][1];
+            if (edgeArray[tetEdges.edges[j]][0]!=ta[k]) {
+                k=localEdges[j][1];
+                l=localEdges[j][0];
+            }
+            tetEdges.vertex[j][0]=(unsigned char)k;
+            tetEdges.vertex[j][1]=(unsigned char)l;
+        }
+    }
+
+    m_elementEdgeStiffnesses.resize(nbTetrahedra);
+    if (m_elementTangentKernel)
+    {
+        runElementKernel(nbTetrahedra, [&](std::size_t first, std::size_t last)
+        {
+            (this->*m_elementTangentKernel)(tetrahedronInf, first, last);
+        });
+    }
+
+    for(l=0; l<nbEdges; l++ )edgeInf[l].DfDx.clear();
+    if (m_elementTangentKernel)
+    {
+        for(i=0; i<nbTetrahedra; i++ )
+        {
+            for(j=0;j<6;j++)
+                edgeInf[m_tetrahedronEdges[i].edges[j]].DfDx += m_elementEdgeStiffnesses[i].data[j];
+        }
+    }
+    m_updateMatrix=false;
+}
+
+template <class DataTypes>
+template <class Material>
+void TetrahedronHyperelasticityFEMForceField<DataTypes>::setMaterial(Material* material)
+{
+    m_myMaterial = material;
+    m_elementForceKernel = &TetrahedronHyperelasticityFEMForceField<DataTypes>::template computeElementForces<Material>;
+    m_elementTangentKernel = &TetrahedronHyperelasticityFEMForceField<DataTypes>::template computeElementTangents<Material>;
+}
+
+template <class DataTypes>
+template <class Kernel>
+void TetrahedronHyperelasticityFEMForceField<DataTypes>::runElementKernel(std::size_t nbTetrahedra, const Kernel& kernel)
+{
+    if (d_parallel.getValue())
+    {
+        const std::size_t grainSize = std::max(d_parallelGrainSize.getValue(), 1u);
+        simulation::parallelFor(simulation::TaskScheduler::getInstance(), 0, nbTetrahedra, grainSize, kernel);
+    }
+    else
+    {
+        kernel(0, nbTetrahedra);
+    }
+}
+
+template <class DataTypes>
+template <class Material>
+void TetrahedronHyperelasticityFEMForceField<DataTypes>::computeElementForces(helper::vector<TetrahedronRestInformation>& tetrahedronInf, const VecCoord& x, std::size_t first, std::size_t last)
+{
+    /// the constitutive law is called with a qualified name so that it is resolved at compile time and inlined
+    Material* material = static_cast<Material*>(m_myMaterial);
+    const VecElement& tetrahedronArray = m_topology->getTetrahedra();
+    unsigned int j=0,k=0,l=0;
+    TetrahedronRestInformation *tetInfo;
+    Coord dp[3],x0,sv;
+
+    for(std::size_t i=first; i<last; i++ )
     {
         tetInfo=&tetrahedronInf[i];
-        const Tetrahedron &ta= m_topology->getTetrahedron(i);
+        const Tetrahedron &ta= tetrahedronArray[i];
 
         x0=x[ta[0]];
 
@@ -329,58 +452,32 @@ void TetrahedronHyperelasticityFEMForceField<DataTypes>::addForce(const core::Me
         tetInfo->J = dot( areaVec, dp[0] ) * tetInfo->m_volScale;
         tetInfo->trC = (Real)( tetInfo->deformationTensor(0,0) + tetInfo->deformationTensor(1,1) + tetInfo->deformationTensor(2,2));
         tetInfo->m_SPKTensorGeneral.clear();
-        m_myMaterial->deriveSPKTensor(tetInfo,globalParameters,tetInfo->m_SPKTensorGeneral);
+        material->Material::deriveSPKTensor(tetInfo,globalParameters,tetInfo->m_SPKTensorGeneral);
         for(l=0;l<4;++l)
         {
-            f[ta[l]]-=tetInfo->m_deformationGradient*(tetInfo->m_SPKTensorGeneral*tetInfo->m_shapeVector[l])*tetInfo->m_restVolume;
+            m_elementForces[4*i+l]=tetInfo->m_deformationGradient*(tetInfo->m_SPKTensorGeneral*tetInfo->m_shapeVector[l])*tetInfo->m_restVolume;
         }
     }
-
-
-    /// indicates that the next call to addDForce will need to update the stiffness matrix
-    m_updateMatrix=true;
-    m_tetrahedronInfo.endEdit();
-
-    d_f.endEdit();
 }
 
 template <class DataTypes>
-void TetrahedronHyperelasticityFEMForceField<DataTypes>::updateTangentMatrix()
+template <class Material>
+void TetrahedronHyperelasticityFEMForceField<DataTypes>::computeElementTangents(helper::vector<TetrahedronRestInformation>& tetrahedronInf, std::size_t first, std::size_t last)
 {
-    unsigned int i=0,j=0,k=0,l=0;
-    unsigned int nbEdges=m_topology->getNbEdges();
-    const vector< Edge> &edgeArray=m_topology->getEdges() ;
-
-    helper::vector<EdgeInformation>& edgeInf = *(m_edgeInfo.beginEdit());
-    helper::vector<TetrahedronRestInformation>& tetrahedronInf = *(m_tetrahedronInfo.beginEdit());
-
-    EdgeInformation *einfo;
+    Material* material = static_cast<Material*>(m_myMaterial);
+    unsigned int j=0,k=0,l=0;
     TetrahedronRestInformation *tetInfo;
-    unsigned int nbTetrahedra=m_topology->getNbTetrahedra();
-    const std::vector< Tetrahedron> &tetrahedronArray=m_topology->getTetrahedra() ;
 
-    for(l=0; l<nbEdges; l++ )edgeInf[l].DfDx.clear();
-    for(i=0; i<nbTetrahedra; i++ )
+    for(std::size_t i=first; i<last; i++ )
     {
         tetInfo=&tetrahedronInf[i];
-        Matrix3 &df=tetInfo->m_deformationGradient;
-//			Matrix3 Tdf=df.transposed();
-        BaseMeshTopology::EdgesInTetrahedron te=m_topology->getEdgesInTetrahedron(i);
+        const Matrix3 &df=tetInfo->m_deformationGradient;
+        const TetrahedronEdges &tetEdges=m_tetrahedronEdges[i];
+        MatrixList &edgeStiffness=m_elementEdgeStiffnesses[i];
 
-        /// describe the jth vertex index of triangle no i
-        const Tetrahedron &ta= tetrahedronArray[i];
         for(j=0;j<6;j++) {
-            einfo= &edgeInf[te[j]];
-            Edge e=m_topology->getLocalEdgesInTetrahedron(j);
-
-            k=e[0];
-            l=e[1];
-            if (edgeArray[te[j]][0]!=ta[k]) {
-                k=e[1];
-                l=e[0];
-            }
-            Matrix3 &edgeDfDx = einfo->DfDx;
-
+            k=tetEdges.vertex[j][0];
+            l=tetEdges.vertex[j][1];
 
             Coord svl=tetInfo->m_shapeVector[l];
             Coord svk=tetInfo->m_shapeVector[k];
@@ -388,9 +485,7 @@ void TetrahedronHyperelasticityFEMForceField<DataTypes>::updateTangentMatrix()
             Matrix3  M, N;
             MatrixSym outputTensor;
             N.clear();
-            vector<MatrixSym> inputTensor;
-            inputTensor.resize(3);
-            //	MatrixSym input1,input2,input3,outputTensor;
+            MatrixSym inputTensor[3];
             for(int m=0; m<3;m++){
                 for (int n=m;n<3;n++){
                     inputTensor[0](m,n)=svl[m]*df[0][n]+df[0][m]*svl[n];
@@ -401,10 +496,9 @@ void TetrahedronHyperelasticityFEMForceField<DataTypes>::updateTangentMatrix()
 
             for(int m=0; m<3; m++){
 
-                m_myMaterial->applyElasticityTensor(tetInfo,globalParameters,inputTensor[m],outputTensor);
+                material->Material::applyElasticityTensor(tetInfo,globalParameters,inputTensor[m],outputTensor);
                 Coord vectortemp=df*(outputTensor*svk);
                 Matrix3 Nv;
-                //Nv.clear();
                 for(int u=0; u<3;u++){
                     Nv[u][m]=vectortemp[u];
                 }
@@ -420,12 +514,9 @@ void TetrahedronHyperelasticityFEMForceField<DataTypes>::updateTangentMatrix()
             M[0][1]=M[0][2]=M[1][0]=M[1][2]=M[2][0]=M[2][1]=0;
             M[0][0]=M[1][1]=M[2][2]=(Real)productSD;
 
-            edgeDfDx += (M+N)*tetInfo->m_restVolume;
-
-
+            edgeStiffness.data[j]=(M+N)*tetInfo->m_restVolume;
         }// end of for j
     }//end of for i
-    m_updateMatrix=false;
 }
 
 
@@ -0,0 +1,181 @@
+/******************************************************************************
+*       SOFA, Simulation Open-Framework Architecture, development version     *
+*                (c) 2006-2019 INRIA, USTL, UJF, CNRS, MGH                    *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+
+#include <SofaSparseSolver/SparseLDLSolver.h>
+
+#include <sofa/helper/testing/BaseTest.h>
+using sofa::helper::testing::BaseTest ;
+
+namespace sofa{
+namespace {
+using core::objectmodel::New;
+using component::linearsolver::CompressedRowSparseMatrix;
+using component::linearsolver::FullVector;
+
+typedef CompressedRowSparseMatrix<double> Matrix;
+typedef FullVector<double> Vector;
+typedef component::linearsolver::SparseLDLSolver<Matrix,Vector> Solver;
+
+struct SparseLDLSolver_test : public BaseTest
+{
+    static const int gridSize = 8;
+
+    /// Symmetric positive definite matrix of a 5-point stencil on a grid, with a few extra couplings when coupled is true.
+    /// The values of the off-diagonal entries are multiplied by scale, so the pattern does not depend on it.
+    static void buildMatrix(Matrix& M, double scale, bool coupled)
+    {
+        const int n = gridSize * gridSize;
+        M.resize(n, n);
+        for (int i = 0 ; i < n ; ++i)
+        {
+            const int x = i % gridSize, y = i / gridSize;
+            M.set(i, i, 5.0 + 0.01 * i);
+            if (x > 0) M.set(i, i-1, -scale);
+            if (x < gridSize-1) M.set(i, i+1, -scale);
+            if (y > 0) M.set(i, i-gridSize, -scale * 0.5);
+            if (y < gridSize-1) M.set(i, i+gridSize, -scale * 0.5);
+        }
+        if (coupled)
+        {
+            for (int i = 0 ; i + 2*gridSize + 3 < n ; i += 7)
+            {
+                M.set(i, i + 2*gridSize + 3, -0.25 * scale);
+                M.set(i + 2*gridSize + 3, i, -0.25 * scale);
+            }
+        }
+        M.compress();
+    }
+
+    static Solver::SPtr createSolver(bool supernodal)
+    {
+        Solver::SPtr solver = New<Solver>();
+        solver->d_supernodal.setValue(supernodal);
+        return solver;
+    }
+
+    static void buildRhs(Vector& b, int n)
+    {
+        b.resize(n);
+        for (int i = 0 ; i < n ; ++i)
+            b[i] = std::sin(0.3 * i) + 0.1;
+    }
+
+    /// Factorize M with the solver, solve M x = b and check the residual
+    void solveAndCheck(Solver* solver, Matrix& M, Vector& x)
+    {
+        const int n = M.rowSize();
+        Vector b;
+        buildRhs(b, n);
+        x.resize(n);
+        solver->invert(M);
+        solver->solve(M, x, b);
+
+        for (int i = 0 ; i < n ; ++i)
+        {
+            double r = b[i];
+            for (int j = 0 ; j < n ; ++j)
+                r -= M.element(i, j) * x[j];
+            EXPECT_NEAR(r, 0.0, 1e-12) << "row " << i;
+        }
+    }
+
+    void checkSameSolution(const Vector& x0, const Vector& x1)
+    {
+        ASSERT_EQ(x0.size(), x1.size());
+        for (int i = 0 ; i < (int)x0.size() ; ++i)
+            EXPECT_NEAR(x0[i], x1[i], 1e-12) << "entry " << i;
+    }
+
+    static Solver::InvertData* invertData(Solver* solver, Matrix& M)
+    {
+        return (Solver::InvertData*) solver->getMatrixInvertData(&M);
+    }
+
+    void checkSupernodalMatchesColumnFactorization(bool coupled)
+    {
+        Matrix M;
+        buildMatrix(M, 1.0, coupled);
+
+        Solver::SPtr column = createSolver(false);
+        Solver::SPtr supernodal = createSolver(true);
+        Vector x0, x1;
+        solveAndCheck(column.get(), M, x0);
+        solveAndCheck(supernodal.get(), M, x1);
+        checkSameSolution(x0, x1);
+
+        // the supernodal factorization uses groups of several columns
+        Solver::InvertData* data = invertData(supernodal.get(), M);
+        EXPECT_LT(data->superBegin.size(), (std::size_t)data->n + 1);
+    }
+
+    void checkSymbolicFactorizationIsCached()
+    {
+        Solver::SPtr column = createSolver(false);
+        Solver::SPtr supernodal = createSolver(true);
+        Matrix M0, M1;
+        Vector x0, x1;
+
+        buildMatrix(M0, 1.0, false);
+        buildMatrix(M1, 1.0, false);
+        solveAndCheck(column.get(), M0, x0);
+        solveAndCheck(supernodal.get(), M1, x1);
+        EXPECT_TRUE(invertData(supernodal.get(), M1)->new_factorization_needed);
+
+        // same pattern, new values: the ordering, the pattern of L and the supernodes are reused
+        Solver::InvertData* data = invertData(supernodal.get(), M1);
+        const helper::vector<int> perm = data->perm;
+        const helper::vector<int> superBegin = data->superBegin;
+        buildMatrix(M0, 1.5, false);
+        buildMatrix(M1, 1.5, false);
+        solveAndCheck(column.get(), M0, x0);
+        solveAndCheck(supernodal.get(), M1, x1);
+        EXPECT_FALSE(data->new_factorization_needed);
+        EXPECT_EQ(perm, data->perm);
+        EXPECT_EQ(superBegin, data->superBegin);
+        checkSameSolution(x0, x1);
+
+        // new pattern: the symbolic factorization is computed again
+        const int L_nnz = data->L_nnz;
+        buildMatrix(M0, 1.5, true);
+        buildMatrix(M1, 1.5, true);
+        solveAndCheck(column.get(), M0, x0);
+        solveAndCheck(supernodal.get(), M1, x1);
+        EXPECT_TRUE(data->new_factorization_needed);
+        EXPECT_NE(L_nnz, data->L_nnz);
+        EXPECT_EQ((std::size_t)data->n, data->columnSuper.size());
+        checkSameSolution(x0, x1);
+    }
+};
+
+TEST_F(SparseLDLSolver_test, checkSupernodalMatchesColumnFactorization)
+{
+    this->checkSupernodalMatchesColumnFactorization(false);
+    this->checkSupernodalMatchesColumnFactorization(true);
+}
+
+TEST_F(SparseLDLSolver_test, checkSymbolicFactorizationIsCached)
+{
+    this->checkSymbolicFactorizationIsCached();
+}
+
+}// namespace
+}// namespace sofa
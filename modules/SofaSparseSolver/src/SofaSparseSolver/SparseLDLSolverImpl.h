@@ -25,6 +25,7 @@
 
 #include <sofa/core/behavior/LinearSolver.h>
 #include <SofaBaseLinearSolver/MatrixLinearSolver.h>
+#include <algorithm>
 
 extern "C" {
 #include <metis.h>
@@ -48,6 +49,9 @@ public :
     VecInt perm, invperm;
     VecReal P_values,L_values,LT_values,invD;
     helper::vector<int> Parent;
+    VecInt L_tranpos; ///< position in LT of each entry of L
+    helper::vector<int> superBegin; ///< first column of each supernode, followed by n
+    helper::vector<int> columnSuper; ///< supernode of each column
     bool new_factorization_needed;
 };
 
@@ -81,6 +85,45 @@ inline void CSPARSE_symbolic (int n,int * M_colptr,int * M_rowind,int * colptr,i
     for (int k = 0 ; k < n ; k++) colptr[k+1] = colptr[k] + Lnz[k] ;
 }
 
+/// Compute the row indices of each column of L (sorted by increasing row), using the elimination tree computed by CSPARSE_symbolic
+inline void CSPARSE_symbolic_pattern(int n,int * M_colptr,int * M_rowind,int * colptr,int * rowind,int * perm,int * invperm,int * Parent, int * Flag, int * Lnz)
+{
+    for (int k = 0 ; k < n ; k++)
+    {
+        Flag [k] = k ;		    /* mark node k as visited */
+        Lnz [k] = 0 ;		    /* count of nonzeros in column k of L */
+        int kk = perm[k];  /* kth original, or permuted, column */
+        for (int p = M_colptr[kk] ; p < M_colptr[kk+1] ; p++)
+        {
+            int i = invperm[M_rowind[p]];
+            if (i < k)
+            {
+                /* the path from i to the flagged node in the etree is the pattern of row k */
+                for ( ; Flag [i] != k ; i = Parent [i])
+                {
+                    rowind[colptr[i] + Lnz[i]++] = k ;	/* L (k,i) is nonzero */
+                    Flag [i] = k ;
+                }
+            }
+        }
+    }
+}
+
+/// Split the columns of L in supernodes: sets of consecutive columns j where the pattern of column j-1 is the pattern of column j plus the row j.
+/// The entries of the columns of a supernode below its diagonal block then have the same rows, and can be processed as dense blocks.
+inline void CSPARSE_supernodes(int n,int * colptr,int * Parent,helper::vector<int>& superBegin,helper::vector<int>& columnSuper)
+{
+    superBegin.clear();
+    columnSuper.resize(n);
+    for (int j = 0 ; j < n ; j++)
+    {
+        const bool sameSupernode = j > 0 && Parent[j-1] == j && colptr[j] - colptr[j-1] == colptr[j+1] - colptr[j] + 1;
+        if (!sameSupernode) superBegin.push_back(j);
+        columnSuper[j] = (int)superBegin.size() - 1;
+    }
+    superBegin.push_back(n);
+}
+
 template<class Real>
 inline void CSPARSE_numeric(int n,int * M_colptr,int * M_rowind,Real * M_values,int * colptr,int * rowind,Real * values,Real * D,int * perm,int * invperm,int * Parent, int * Flag, int * Lnz, int * Pattern, Real * Y)
 {
@@ -134,6 +177,106 @@ inline void CSPARSE_numeric(int n,int * M_colptr,int * M_rowind,Real * M_values,
     }
 }
 
+/// Supernodal left-looking numeric factorization, using the pattern of L (colptr, rowind), of its transpose (LT_colptr, LT_rowind) and the supernodes.
+/// The columns of each supernode are computed together: the updates from each descendant supernode are computed as a dense block,
+/// then scattered into the supernode, which is finally factorized with dense column operations.
+/// Map must have one entry per column, Mark one entry per supernode, and Update is resized as needed.
+template<class Real>
+inline void CSPARSE_numeric_supernodal(int * M_colptr,int * M_rowind,Real * M_values,int * colptr,int * rowind,Real * values,Real * D,int * perm,int * invperm,
+                                       int * LT_colptr,int * LT_rowind,const helper::vector<int>& superBegin,const helper::vector<int>& columnSuper,
+                                       int * Map, int * Mark, helper::vector<Real>& Update)
+{
+    const int nbSuper = (int)superBegin.size() - 1;
+    for (int s = 0 ; s < nbSuper ; s++) Mark[s] = -1;
+
+    for (int s = 0 ; s < nbSuper ; s++)
+    {
+        const int f = superBegin[s], l = superBegin[s+1] - 1, ns = l - f + 1;
+
+        /* rows of the supernode: its diagonal block [f,l], then the rows below l, which are the rows of column l */
+        for (int t = 0 ; t < ns ; t++) Map[f+t] = t;
+        for (int p = colptr[l] ; p < colptr[l+1] ; p++) Map[rowind[p]] = ns + p - colptr[l];
+        /* the entry of row r in column j of the supernode is values[colptr[j] + Map[r] - (j-f) - 1] */
+
+        /* scatter the lower part of A */
+        for (int j = f ; j <= l ; j++)
+        {
+            D[j] = 0.0;
+            for (int p = colptr[j] ; p < colptr[j+1] ; p++) values[p] = 0.0;
+            const int jj = perm[j];
+            for (int p = M_colptr[jj] ; p < M_colptr[jj+1] ; p++)
+            {
+                const int i = invperm[M_rowind[p]];
+                if (i == j) D[j] += M_values[p];
+                else if (i > j) values[colptr[j] + Map[i] - (j-f) - 1] += M_values[p];
+            }
+        }
+
+        /* updates from the descendant supernodes, i.e. the supernodes of the nonzeros of the rows [f,l] of L */
+        for (int j = f ; j <= l ; j++)
+        {
+            for (int pt = LT_colptr[j] ; pt < LT_colptr[j+1] && LT_rowind[pt] < f ; pt++)
+            {
+                const int d = columnSuper[LT_rowind[pt]];
+                if (Mark[d] == s) continue;
+                Mark[d] = s;
+
+                const int fd = superBegin[d], ld = superBegin[d+1] - 1;
+                const int * R = rowind + colptr[ld]; /* rows below the diagonal block of d */
+                const int nR = colptr[ld+1] - colptr[ld];
+                const int p0 = (int)(std::lower_bound(R, R + nR, f) - R);
+                const int p1 = (int)(std::upper_bound(R + p0, R + nR, l) - R);
+                const int m = nR - p0, nq = p1 - p0;
+
+                /* dense update C(p,q) = sum_k L(R[p0+p],k) D(k) L(R[p0+q],k), for p >= q */
+                Update.resize(m * nq);
+                std::fill(Update.begin(), Update.end(), Real(0.0));
+                for (int k = fd ; k <= ld ; k++)
+                {
+                    const Real * B = values + colptr[k] + (ld - k) + p0; /* rows R[p0..nR) of column k are contiguous */
+                    for (int q = 0 ; q < nq ; q++)
+                    {
+                        const Real w = B[q] * D[k];
+                        Real * C = Update.data() + q * m;
+                        for (int p = q ; p < m ; p++) C[p] += B[p] * w;
+                    }
+                }
+
+                /* scatter the update into the columns R[p0..p1) of the supernode */
+                for (int q = 0 ; q < nq ; q++)
+                {
+                    const int jq = R[p0+q];
+                    const Real * C = Update.data() + q * m;
+                    D[jq] -= C[q];
+                    Real * Lj = values + colptr[jq] - (jq-f) - 1;
+                    for (int p = q+1 ; p < m ; p++) Lj[Map[R[p0+p]]] -= C[p];
+                }
+            }
+        }
+
+        /* dense factorization of the supernode */
+        for (int j = f ; j <= l ; j++)
+        {
+            Real * Lj = values + colptr[j];
+            const int len = colptr[j+1] - colptr[j];
+            for (int k = f ; k < j ; k++)
+            {
+                const Real * Lk = values + colptr[k] + (j - k); /* rows below j of column k */
+                const Real ljk = Lk[-1];
+                const Real w = ljk * D[k];
+                D[j] -= ljk * w;
+                for (int p = 0 ; p < len ; p++) Lj[p] -= Lk[p] * w;
+            }
+            if (D[j] == 0.0)
+            {
+                msg_error("SparseLDLSolver") << "Failed to factorize, D(k,k) is zero" ;
+                return;
+            }
+            for (int p = 0 ; p < len ; p++) Lj[p] /= D[j];
+        }
+    }
+}
+
 inline bool CSPARSE_need_symbolic_factorization(int s_M, int * M_colptr,int * M_rowind, int s_P, int * P_colptr,int * P_rowind) {
     if (s_M != s_P) return true;
     if (M_colptr[s_M] != P_colptr[s_M] ) return true;
@@ -162,9 +305,14 @@ public:
     typedef TThreadManager ThreadManager;
     typedef typename TMatrix::Real Real;
 
+    Data<bool> d_supernodal; ///< compute the numeric factorization by supernodes with dense kernels
+
 protected :
 
-    SparseLDLSolverImpl() : Inherit() {}
+    SparseLDLSolverImpl()
+        : Inherit()
+        , d_supernodal(initData(&d_supernodal, false, "supernodal", "Compute the numeric factorization by supernodes, i.e. groups of columns of L sharing the same structure, with dense kernels"))
+    {}
 
     template<class VecInt,class VecReal>
     void solve_cpu(Real * x,const Real * b,SparseLDLImplInvertData<VecInt,VecReal> * data) {
@@ -278,6 +426,14 @@ protected :
         CSPARSE_numeric<Real>(n,M_colptr,M_rowind,M_values,colptr,rowind,values,D,perm,invperm,Parent,Flag.data(),Lnz.data(),Pattern.data(),Y.data());
     }
 
+    void LDL_numeric_supernodal(int n,int * M_colptr,int * M_rowind,Real * M_values,int * colptr,int * rowind,Real * values,Real * D,int * perm,int * invperm,
+                                int * LT_colptr,int * LT_rowind,const helper::vector<int>& superBegin,const helper::vector<int>& columnSuper) {
+        Map.resize(n);
+        Mark.resize(superBegin.size());
+
+        CSPARSE_numeric_supernodal<Real>(M_colptr,M_rowind,M_values,colptr,rowind,values,D,perm,invperm,LT_colptr,LT_rowind,superBegin,columnSuper,Map.data(),Mark.data(),Update);
+    }
+
     template<class VecInt,class VecReal>
     void factorize(int n,int * M_colptr, int * M_rowind, Real * M_values, SparseLDLImplInvertData<VecInt,VecReal> * data) {
         data->new_factorization_needed = data->P_colptr.size() == 0 || data->P_rowind.size() == 0 || CSPARSE_need_symbolic_factorization(n, M_colptr, M_rowind, data->n,
@@ -319,27 +475,18 @@ protected :
             data->L_values.clear();data->L_values.fastResize(data->L_nnz);
             data->LT_rowind.clear();data->LT_rowind.fastResize(data->L_nnz);
             data->LT_values.clear();data->LT_values.fastResize(data->L_nnz);
-        }
+            data->L_tranpos.clear();data->L_tranpos.fastResize(data->L_nnz);
 
-        Real * D = data->invD.data();
-        int * rowind = data->L_rowind.data();
-        int * colptr = data->L_colptr.data();
-        Real * values = data->L_values.data();
-        int * tran_rowind = data->LT_rowind.data();
-        int * tran_colptr = data->LT_colptr.data();
-        Real * tran_values = data->LT_values.data();
-
-        //Numeric Factorization
-        LDL_numeric(data->n,M_colptr,M_rowind,M_values,colptr,rowind,values,D,
-                    data->perm.data(),data->invperm.data(),data->Parent.data());
-
-        //inverse the diagonal
-        for (int i=0;i<data->n;i++) D[i] = 1.0/D[i];
+            //pattern of L, which only depends on the structure of the matrix
+            CSPARSE_symbolic_pattern(data->n,M_colptr,M_rowind,data->L_colptr.data(),data->L_rowind.data(),
+                                     data->perm.data(),data->invperm.data(),data->Parent.data(),Flag.data(),Lnz.data());
 
-        // split the bloc diag in data->Bdiag
+            //pattern of LT, and position in LT of each entry of L, so the values are copied without rebuilding the transpose
+            int * rowind = data->L_rowind.data();
+            int * colptr = data->L_colptr.data();
+            int * tran_rowind = data->LT_rowind.data();
+            int * tran_colptr = data->LT_colptr.data();
 
-        if (data->new_factorization_needed) {
-            //Compute transpose in tran_colptr, tran_rowind, tran_values, tran_D
             tran_countvec.clear();
             tran_countvec.resize(data->n);
 
@@ -349,20 +496,44 @@ protected :
             //Now we make a scan to build tran_colptr
             tran_colptr[0] = 0;
             for (int j=0;j<data->n;j++) tran_colptr[j+1] = tran_colptr[j] + tran_countvec[j];
-        }
 
-        //we clear tran_countvec becaus we use it now to stro hown many value are written on each line
-        tran_countvec.clear();
-        tran_countvec.resize(data->n);
-
-        for (int j=0;j<data->n;j++) {
-          for (int i=colptr[j];i<colptr[j+1];i++) {
-            int line = rowind[i];
-            tran_rowind[tran_colptr[line] + tran_countvec[line]] = j;
-            tran_values[tran_colptr[line] + tran_countvec[line]] = values[i];
-            tran_countvec[line]++;
-          }
+            //we clear tran_countvec becaus we use it now to stro hown many value are written on each line
+            tran_countvec.clear();
+            tran_countvec.resize(data->n);
+
+            for (int j=0;j<data->n;j++) {
+              for (int i=colptr[j];i<colptr[j+1];i++) {
+                int line = rowind[i];
+                int pos = tran_colptr[line] + tran_countvec[line];
+                tran_rowind[pos] = j;
+                data->L_tranpos[i] = pos;
+                tran_countvec[line]++;
+              }
+            }
+
+            CSPARSE_supernodes(data->n,colptr,data->Parent.data(),data->superBegin,data->columnSuper);
         }
+
+        Real * D = data->invD.data();
+        int * rowind = data->L_rowind.data();
+        int * colptr = data->L_colptr.data();
+        Real * values = data->L_values.data();
+        Real * tran_values = data->LT_values.data();
+        const int * tranpos = data->L_tranpos.data();
+
+        //Numeric Factorization
+        if (d_supernodal.getValue())
+            LDL_numeric_supernodal(data->n,M_colptr,M_rowind,M_values,colptr,rowind,values,D,
+                                   data->perm.data(),data->invperm.data(),data->LT_colptr.data(),data->LT_rowind.data(),data->superBegin,data->columnSuper);
+        else
+            LDL_numeric(data->n,M_colptr,M_rowind,M_values,colptr,rowind,values,D,
+                        data->perm.data(),data->invperm.data(),data->Parent.data());
+
+        //inverse the diagonal
+        for (int i=0;i<data->n;i++) D[i] = 1.0/D[i];
+
+        //the pattern of LT is computed with the symbolic factorization, only the values are copied
+        for (int i=0;i<data->L_nnz;i++) tran_values[tranpos[i]] = values[i];
     }
 
     helper::vector<Real> Tmp;
@@ -371,6 +542,8 @@ protected : //the folowing variables are used during the factorization they cann
     helper::vector<Real> Y;
     helper::vector<int> Lnz,Flag,Pattern;
     helper::vector<int> tran_countvec;
+    helper::vector<int> Map,Mark;
+    helper::vector<Real> Update;
 
 //    helper::vector<int> perm, invperm; //premutation inverse
 